@@ -38,6 +38,9 @@
 #include "gegl-buffer-iterator.h"
 #include "gegl-buffer-cl-cache.h"
 #include "gegl-config.h"
+#include "gegl-scheduler.h"
+#include "gegl-tile-handler-empty.h"
+#include "gegl-trace.h"
 
 static void gegl_buffer_iterate_read_fringed (GeglBuffer          *buffer,
                                               const GeglRectangle *roi,
@@ -431,6 +434,7 @@ gegl_buffer_iterate_write (GeglBuffer          *buffer,
 
           if (fish)
             {
+              GEGL_TRACE_START();
               for (row = offsety;
                    row < tile_height &&
                      y < height &&
@@ -448,6 +452,7 @@ gegl_buffer_iterate_write (GeglBuffer          *buffer,
                   tp += tile_stride;
                   bp += buf_stride;
                 }
+              GEGL_TRACE_END ("babl", babl_get_name (fish));
             }
           else
             {
@@ -612,17 +617,31 @@ gegl_buffer_iterate_read_simple (GeglBuffer          *buffer,
           tp        = ((guchar *) tile_base) + (offsety * tile_width + offsetx) * px_size;
 
           y = bufy;
-          for (row = offsety;
-               row < tile_height && y < height;
-               row++, y++)
+          if (fish)
             {
-              if (fish)
-                babl_process (fish, tp, bp, pixels);
-              else
-                memcpy (bp, tp, pixels * px_size);
+              GEGL_TRACE_START();
+              for (row = offsety;
+                   row < tile_height && y < height;
+                   row++, y++)
+                {
+                  babl_process (fish, tp, bp, pixels);
 
-              tp += tile_stride;
-              bp += buf_stride;
+                  tp += tile_stride;
+                  bp += buf_stride;
+                }
+              GEGL_TRACE_END ("babl", babl_get_name (fish));
+            }
+          else
+            {
+              for (row = offsety;
+                   row < tile_height && y < height;
+                   row++, y++)
+                {
+                  memcpy (bp, tp, pixels * px_size);
+
+                  tp += tile_stride;
+                  bp += buf_stride;
+                }
             }
 
           gegl_tile_unref (tile);
@@ -1556,6 +1575,198 @@ gegl_buffer_sample_cleanup (GeglBuffer *buffer)
     }
 }
 
+/* Bulk operations on buffers are split into bands along the tile rows of
+ * the destination, which are processed by the worker threads.
+ */
+#define GEGL_BUFFER_BULK_MIN_AREA (256 * 256)
+
+typedef void (*GeglBufferBandFunc) (const GeglRectangle *band,
+                                    gpointer             data);
+
+typedef struct
+{
+  GeglBufferBandFunc  func;
+  gpointer            data;
+  GeglRectangle       band;
+} BandTask;
+
+static void
+band_task (gpointer data)
+{
+  BandTask *task = data;
+
+  task->func (&task->band, task->data);
+}
+
+static void
+gegl_buffer_foreach_band (GeglBuffer          *buffer,
+                          const GeglRectangle *rect,
+                          GeglBufferBandFunc   func,
+                          gpointer             data)
+{
+  gint           tile_height = buffer->tile_height;
+  gint           first_row;
+  gint           n_bands;
+  BandTask      *tasks;
+  GeglTaskGroup *group;
+  gint           i;
+
+  if (rect->width <= 0 || rect->height <= 0)
+    return;
+
+  first_row = gegl_tile_indice (rect->y + buffer->shift_y, tile_height);
+  n_bands   = gegl_tile_indice (rect->y + rect->height - 1 + buffer->shift_y,
+                                tile_height) - first_row + 1;
+
+  if (gegl_config_threads () < 2 || n_bands < 2 ||
+      (gint64) rect->width * rect->height < GEGL_BUFFER_BULK_MIN_AREA)
+    {
+      func (rect, data);
+      return;
+    }
+
+  tasks = g_new (BandTask, n_bands);
+
+  for (i = 0; i < n_bands; i++)
+    {
+      gint y0 = (first_row + i) * tile_height - buffer->shift_y;
+      gint y1 = y0 + tile_height;
+
+      y0 = MAX (y0, rect->y);
+      y1 = MIN (y1, rect->y + rect->height);
+
+      tasks[i].func        = func;
+      tasks[i].data        = data;
+      tasks[i].band        = *rect;
+      tasks[i].band.y      = y0;
+      tasks[i].band.height = y1 - y0;
+    }
+
+  group = gegl_task_group_new ();
+  for (i = 1; i < n_bands; i++)
+    gegl_task_group_add (group, band_task, &tasks[i]);
+  band_task (&tasks[0]);
+
+  gegl_task_group_join (group);
+
+  g_free (tasks);
+}
+
+/* Split @rect into the part covering whole tiles of @buffer, and the
+ * fringes around it. Returns FALSE when there are no whole tiles, in which
+ * case the first fringe is all of @rect.
+ */
+static gboolean
+gegl_buffer_split_tiles (GeglBuffer          *buffer,
+                         const GeglRectangle *rect,
+                         GeglRectangle       *tiles,
+                         GeglRectangle        fringes[4])
+{
+  gint tile_width  = buffer->tile_width;
+  gint tile_height = buffer->tile_height;
+  gint x0, y0, x1, y1;
+
+  x0 = gegl_tile_indice (rect->x + buffer->shift_x + tile_width - 1,
+                         tile_width) * tile_width - buffer->shift_x;
+  y0 = gegl_tile_indice (rect->y + buffer->shift_y + tile_height - 1,
+                         tile_height) * tile_height - buffer->shift_y;
+  x1 = gegl_tile_indice (rect->x + rect->width + buffer->shift_x,
+                         tile_width) * tile_width - buffer->shift_x;
+  y1 = gegl_tile_indice (rect->y + rect->height + buffer->shift_y,
+                         tile_height) * tile_height - buffer->shift_y;
+
+  if (x1 <= x0 || y1 <= y0)
+    {
+      fringes[0] = *rect;
+      gegl_rectangle_set (&fringes[1], 0, 0, 0, 0);
+      gegl_rectangle_set (&fringes[2], 0, 0, 0, 0);
+      gegl_rectangle_set (&fringes[3], 0, 0, 0, 0);
+      return FALSE;
+    }
+
+  gegl_rectangle_set (tiles, x0, y0, x1 - x0, y1 - y0);
+
+  /* top, bottom, left and right */
+  gegl_rectangle_set (&fringes[0], rect->x, rect->y,
+                      rect->width, y0 - rect->y);
+  gegl_rectangle_set (&fringes[1], rect->x, y1,
+                      rect->width, rect->y + rect->height - y1);
+  gegl_rectangle_set (&fringes[2], rect->x, y0,
+                      x0 - rect->x, y1 - y0);
+  gegl_rectangle_set (&fringes[3], x1, y0,
+                      rect->x + rect->width - x1, y1 - y0);
+
+  return TRUE;
+}
+
+/* Replace the tiles of @buffer covered by the tile aligned @rect with
+ * copies sharing the data of @tile.
+ */
+static void
+gegl_buffer_fill_tiles (GeglBuffer          *buffer,
+                        const GeglRectangle *rect,
+                        GeglTile            *tile)
+{
+  GeglTileStorage *storage     = buffer->tile_storage;
+  gint             tile_width  = buffer->tile_width;
+  gint             tile_height = buffer->tile_height;
+  gint             tx0 = gegl_tile_indice (rect->x + buffer->shift_x, tile_width);
+  gint             ty0 = gegl_tile_indice (rect->y + buffer->shift_y, tile_height);
+  gint             tx1 = tx0 + rect->width / tile_width;
+  gint             ty1 = ty0 + rect->height / tile_height;
+  gint             tx, ty;
+
+  if (gegl_cl_is_accelerated ())
+    gegl_buffer_cl_cache_invalidate (buffer, rect);
+
+  for (ty = ty0; ty < ty1; ty++)
+    for (tx = tx0; tx < tx1; tx++)
+      {
+        GeglTile *dst_tile = gegl_tile_dup (tile);
+        gint      x, y, z;
+
+        dst_tile->rev++;
+        gegl_tile_handler_cache_insert (storage->cache, dst_tile, tx, ty, 0);
+        gegl_tile_unref (dst_tile);
+
+        /* the mipmap levels computed from the tile are out of date */
+        for (z = 1, x = tx / 2, y = ty / 2; z <= storage->seen_zoom;
+             z++, x /= 2, y /= 2)
+          gegl_tile_source_void (GEGL_TILE_SOURCE (storage), x, y, z);
+      }
+
+  gegl_buffer_emit_changed_signal (buffer, rect);
+}
+
+typedef struct
+{
+  GeglBuffer      *src;
+  GeglBuffer      *dst;
+  gint             offset_x;
+  gint             offset_y;
+  GeglAbyssPolicy  repeat_mode;
+} CopyData;
+
+static void
+copy_band (const GeglRectangle *band,
+           gpointer             data)
+{
+  CopyData           *copy = data;
+  GeglBufferIterator *i;
+
+  i = gegl_buffer_iterator_new (copy->dst, band, 0, copy->dst->soft_format,
+                                GEGL_ACCESS_WRITE, copy->repeat_mode);
+  while (gegl_buffer_iterator_next (i))
+    {
+      GeglRectangle src_rect = i->roi[0];
+      src_rect.x += copy->offset_x;
+      src_rect.y += copy->offset_y;
+      gegl_buffer_iterate_read_dispatch (copy->src, &src_rect, i->data[0], 0,
+                                         copy->dst->soft_format, 0,
+                                         copy->repeat_mode);
+    }
+}
+
 static void
 gegl_buffer_copy2 (GeglBuffer          *src,
                    const GeglRectangle *src_rect,
@@ -1581,23 +1792,24 @@ gegl_buffer_copy2 (GeglBuffer          *src,
 
     {
       GeglRectangle dest_rect_r = *dst_rect;
-      GeglBufferIterator *i;
-      gint offset_x = src_rect->x - dst_rect->x;
-      gint offset_y = src_rect->y - dst_rect->y;
+      CopyData      copy;
 
       dest_rect_r.width = src_rect->width;
       dest_rect_r.height = src_rect->height;
 
-      i = gegl_buffer_iterator_new (dst, &dest_rect_r, 0, dst->soft_format,
-                                    GEGL_ACCESS_WRITE, repeat_mode);
-      while (gegl_buffer_iterator_next (i))
-        {
-          GeglRectangle src_rect = i->roi[0];
-          src_rect.x += offset_x;
-          src_rect.y += offset_y;
-          gegl_buffer_iterate_read_dispatch (src, &src_rect, i->data[0], 0,
-                                             dst->soft_format, 0, repeat_mode);
-        }
+      copy.src         = src;
+      copy.dst         = dst;
+      copy.offset_x    = src_rect->x - dst_rect->x;
+      copy.offset_y    = src_rect->y - dst_rect->y;
+      copy.repeat_mode = repeat_mode;
+
+      /* the bands could read what other bands write when copying within
+       * the same storage
+       */
+      if (src->tile_storage == dst->tile_storage)
+        copy_band (&dest_rect_r, &copy);
+      else
+        gegl_buffer_foreach_band (dst, &dest_rect_r, copy_band, &copy);
     }
 }
 
@@ -1766,12 +1978,25 @@ gegl_buffer_copy (GeglBuffer          *src,
 }
 
 static void
-gegl_buffer_clear2 (GeglBuffer          *dst,
-                    const GeglRectangle *dst_rect)
+clear_band (const GeglRectangle *band,
+            gpointer             data)
 {
+  GeglBuffer         *dst    = data;
+  gint                pxsize = babl_format_get_bytes_per_pixel (dst->soft_format);
   GeglBufferIterator *i;
-  gint                pxsize;
 
+  i = gegl_buffer_iterator_new (dst, band, 0, dst->soft_format,
+                                GEGL_ACCESS_WRITE, GEGL_ABYSS_NONE);
+  while (gegl_buffer_iterator_next (i))
+    {
+      memset (((guchar*)(i->data[0])), 0, i->length * pxsize);
+    }
+}
+
+static void
+gegl_buffer_clear2 (GeglBuffer          *dst,
+                    const GeglRectangle *dst_rect)
+{
   g_return_if_fail (GEGL_IS_BUFFER (dst));
 
   if (!dst_rect)
@@ -1782,26 +2007,21 @@ gegl_buffer_clear2 (GeglBuffer          *dst,
       dst_rect->height == 0)
     return;
 
-  pxsize = babl_format_get_bytes_per_pixel (dst->soft_format);
-
   if (gegl_cl_is_accelerated ())
     gegl_buffer_cl_cache_invalidate (dst, dst_rect);
 
-  /* FIXME: this can be even further optimized by special casing it so
-   * that fully voided tiles are dropped.
-   */
-  i = gegl_buffer_iterator_new (dst, dst_rect, 0, dst->soft_format,
-                                GEGL_ACCESS_WRITE, GEGL_ABYSS_NONE);
-  while (gegl_buffer_iterator_next (i))
-    {
-      memset (((guchar*)(i->data[0])), 0, i->length * pxsize);
-    }
+  gegl_buffer_foreach_band (dst, dst_rect, clear_band, dst);
 }
 
 void
 gegl_buffer_clear (GeglBuffer          *dst,
                    const GeglRectangle *dst_rect)
 {
+  GeglRectangle rect;
+  GeglRectangle tiles;
+  GeglRectangle fringes[4];
+  gint          i;
+
   g_return_if_fail (GEGL_IS_BUFFER (dst));
 
   if (!dst_rect)
@@ -1809,98 +2029,29 @@ gegl_buffer_clear (GeglBuffer          *dst,
       dst_rect = gegl_buffer_get_extent (dst);
     }
 
-#if 0
-  /* cow for clearing is currently broken */
-  if (!g_object_get_data (G_OBJECT (dst), "is-linear"))
+  /* whole tiles are replaced by empty tiles instead of being written to,
+   * only within the abyss, as the tiles might be shared with a parent
+   * buffer
+   */
+  if (g_object_get_data (G_OBJECT (dst), "is-linear") ||
+      !gegl_rectangle_intersect (&rect, dst_rect, &dst->abyss) ||
+      !gegl_buffer_split_tiles (dst, &rect, &tiles, fringes))
     {
-      gint tile_width = dst->tile_width;
-      gint tile_height = dst->tile_height;
-
-      {
-        GeglRectangle cow_rect = *dst_rect;
-
-        /* adjust origin until we match the start of tile alignment */
-        while ( (cow_rect.x + dst->shift_x) % tile_width)
-          {
-            cow_rect.x ++;
-            cow_rect.width --;
-          }
-        while ( (cow_rect.y + dst->shift_y) % tile_height)
-          {
-            cow_rect.y ++;
-            cow_rect.height --;
-          }
-        /* adjust size of rect to match multiple of tiles */
-
-        cow_rect.width  = cow_rect.width  - (cow_rect.width  % tile_width);
-        cow_rect.height = cow_rect.height - (cow_rect.height % tile_height);
-
-
-        g_assert (cow_rect.width >= 0);
-        g_assert (cow_rect.height >= 0);
-
-        {
-          GeglRectangle top, bottom, left, right;
-
-          /* iterate over rectangle that can be cow copied, duplicating
-           * one and one tile
-           */
-          {
-            /* first we do a dumb copy,. but with fetched tiles */
-
-            gint dst_x, dst_y;
-
-            for (dst_y = cow_rect.y + dst->shift_y; dst_y < cow_rect.y + dst->shift_y + cow_rect.height; dst_y += tile_height)
-            for (dst_x = cow_rect.x + dst->shift_x; dst_x < cow_rect.x + dst->shift_x + cow_rect.width; dst_x += tile_width)
-              {
-                gint dtx, dty;
-
-                dtx = gegl_tile_indice (dst_x, tile_width);
-                dty = gegl_tile_indice (dst_y, tile_height);
-
-                if(gegl_tile_source_void ((GeglTileSource*)dst, dtx, dty, 0));
-              }
-          }
-
-          top = *dst_rect;
-          top.height = (cow_rect.y - dst_rect->y);
-
-
-          left = *dst_rect;
-          left.y = cow_rect.y;
-          left.height = cow_rect.height;
-          left.width = (cow_rect.x - dst_rect->x);
-
-          bottom = *dst_rect;
-          bottom.y = (cow_rect.y + cow_rect.height);
-          bottom.height = (dst_rect->y + dst_rect->height) -
-                          (cow_rect.y  + cow_rect.height);
-
-          if (bottom.height < 0)
-            bottom.height = 0;
+      gegl_buffer_clear2 (dst, dst_rect);
+      return;
+    }
 
-          right  =  *dst_rect;
-          right.x = (cow_rect.x + cow_rect.width);
-          right.width = (dst_rect->x + dst_rect->width) -
-                          (cow_rect.x  + cow_rect.width);
-          right.y = cow_rect.y;
-          right.height = cow_rect.height;
+  {
+    GeglTile *empty;
 
-          if (right.width < 0)
-            right.width = 0;
+    empty = gegl_tile_handler_empty_new_tile (dst->tile_storage->tile_size);
+    gegl_buffer_fill_tiles (dst, &tiles, empty);
+    gegl_tile_unref (empty);
+  }
 
-          if (top.height)     gegl_buffer_clear2 (dst, &top);
-          if (bottom.height)  gegl_buffer_clear2 (dst, &bottom);
-          if (left.width)     gegl_buffer_clear2 (dst, &left);
-          if (right.width)    gegl_buffer_clear2 (dst, &right);
-        }
-      }
-    }
-  else
-#endif
-    {
-      gegl_buffer_clear2 (dst, dst_rect);
-    }
+  for (i = 0; i < 4; i++)
+    if (!gegl_rectangle_is_empty (&fringes[i]))
+      gegl_buffer_clear2 (dst, &fringes[i]);
 }
 
 void
@@ -2005,19 +2156,46 @@ gegl_buffer_set_pattern (GeglBuffer          *buffer,
   gegl_free (pattern_data);
 }
 
+typedef struct
+{
+  GeglBuffer *dst;
+  gchar       pixel[128];
+  gint        bpp;
+} SetColorData;
+
+static void
+set_color_band (const GeglRectangle *band,
+                gpointer             data)
+{
+  SetColorData       *set_color = data;
+  GeglBufferIterator *i;
+
+  i = gegl_buffer_iterator_new (set_color->dst, band, 0,
+                                set_color->dst->soft_format,
+                                GEGL_ACCESS_WRITE, GEGL_ABYSS_NONE);
+  while (gegl_buffer_iterator_next (i))
+    {
+      gegl_memset_pattern (i->data[0], set_color->pixel, set_color->bpp,
+                           i->length);
+    }
+}
+
 void
 gegl_buffer_set_color (GeglBuffer          *dst,
                        const GeglRectangle *dst_rect,
                        GeglColor           *color)
 {
-  GeglBufferIterator *i;
-  gchar               pixel[128];
-  gint                bpp;
+  SetColorData  set_color;
+  GeglRectangle rect;
+  GeglRectangle tiles;
+  GeglRectangle fringes[4];
+  gint          i;
 
   g_return_if_fail (GEGL_IS_BUFFER (dst));
   g_return_if_fail (color);
 
-  gegl_color_get_pixel (color, dst->soft_format, pixel);
+  set_color.dst = dst;
+  gegl_color_get_pixel (color, dst->soft_format, set_color.pixel);
 
   if (!dst_rect)
     {
@@ -2027,17 +2205,31 @@ gegl_buffer_set_color (GeglBuffer          *dst,
       dst_rect->height == 0)
     return;
 
-  bpp = babl_format_get_bytes_per_pixel (dst->soft_format);
+  set_color.bpp = babl_format_get_bytes_per_pixel (dst->soft_format);
 
-  /* FIXME: this can be even further optimized by special casing it so
-   * that fully filled tiles are shared.
+  /* whole tiles share the data of a single filled tile, like in
+   * gegl_buffer_clear ()
    */
-  i = gegl_buffer_iterator_new (dst, dst_rect, 0, dst->soft_format,
-                                GEGL_ACCESS_WRITE, GEGL_ABYSS_NONE);
-  while (gegl_buffer_iterator_next (i))
+  if (g_object_get_data (G_OBJECT (dst), "is-linear") ||
+      !gegl_rectangle_intersect (&rect, dst_rect, &dst->abyss) ||
+      !gegl_buffer_split_tiles (dst, &rect, &tiles, fringes))
     {
-      gegl_memset_pattern (i->data[0], pixel, bpp, i->length);
+      gegl_buffer_foreach_band (dst, dst_rect, set_color_band, &set_color);
+      return;
     }
+
+  {
+    GeglTile *tile = gegl_tile_new (dst->tile_storage->tile_size);
+
+    gegl_memset_pattern (gegl_tile_get_data (tile), set_color.pixel,
+                         set_color.bpp, dst->tile_width * dst->tile_height);
+    gegl_buffer_fill_tiles (dst, &tiles, tile);
+    gegl_tile_unref (tile);
+  }
+
+  for (i = 0; i < 4; i++)
+    if (!gegl_rectangle_is_empty (&fringes[i]))
+      gegl_buffer_foreach_band (dst, &fringes[i], set_color_band, &set_color);
 }
 
 GeglBuffer *
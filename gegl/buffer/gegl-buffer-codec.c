@@ -0,0 +1,324 @@
+/* This file is part of GEGL.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include <glib.h>
+
+#include "gegl-buffer-codec.h"
+
+/* The compressed data is a sequence of literal runs and back references,
+ * told apart by their first byte:
+ *
+ *   000LLLLL                  a run of L + 1 literal bytes follows
+ *   LLLOOOOO OOOOOOOO         copy L + 2 bytes from O + 1 bytes back
+ *   111OOOOO LLLLLLLL OOOOOOOO  the same, with a length of L + 9
+ */
+#define LZ_HASH_LOG  14
+#define LZ_HASH_SIZE (1 << LZ_HASH_LOG)
+#define LZ_MAX_LIT   (1 << 5)
+#define LZ_MAX_OFF   (1 << 13)
+#define LZ_MAX_REF   ((1 << 8) + (1 << 3))
+
+/* tiles have to shrink by at least this fraction to be stored compressed */
+#define MIN_SAVING   8
+
+static inline guint
+lz_hash (const guchar *p)
+{
+  guint32 v = (p[0] << 16) | (p[1] << 8) | p[2];
+
+  return (v * 2654435761u) >> (32 - LZ_HASH_LOG);
+}
+
+void
+gegl_buffer_codec_shuffle (const guchar *src,
+                           guchar       *dst,
+                           gint          size,
+                           gint          element_size)
+{
+  gint n = size / element_size;
+  gint i, b;
+
+  for (b = 0; b < element_size; b++)
+    for (i = 0; i < n; i++)
+      dst[b * n + i] = src[i * element_size + b];
+
+  memcpy (dst + n * element_size, src + n * element_size,
+          size - n * element_size);
+}
+
+void
+gegl_buffer_codec_unshuffle (const guchar *src,
+                             guchar       *dst,
+                             gint          size,
+                             gint          element_size)
+{
+  gint n = size / element_size;
+  gint i, b;
+
+  for (b = 0; b < element_size; b++)
+    for (i = 0; i < n; i++)
+      dst[i * element_size + b] = src[b * n + i];
+
+  memcpy (dst + n * element_size, src + n * element_size,
+          size - n * element_size);
+}
+
+gint
+gegl_buffer_codec_lz_compress (const guchar *src,
+                               gint          size,
+                               guchar       *dst,
+                               gint          max_size)
+{
+  const guchar **table;
+  const guchar  *ip      = src;
+  const guchar  *in_end  = src + size;
+  guchar        *op      = dst;
+  guchar        *out_end = dst + max_size;
+  gint           lit     = 0;
+
+  if (max_size < 2)
+    return 0;
+
+  table = g_new0 (const guchar *, LZ_HASH_SIZE);
+
+  /* leave room for the length of the first literal run */
+  op++;
+
+  while (ip < in_end - 2)
+    {
+      guint         hash = lz_hash (ip);
+      const guchar *ref  = table[hash];
+      gsize         off;
+
+      table[hash] = ip;
+
+      if (ref &&
+          (off = ip - ref - 1) < LZ_MAX_OFF &&
+          ref[0] == ip[0] && ref[1] == ip[1] && ref[2] == ip[2])
+        {
+          gint len    = 2;
+          gint maxlen = MIN (in_end - ip - len, LZ_MAX_REF);
+
+          if (op + 4 >= out_end)
+            goto full;
+
+          /* terminate the literal run, or drop it when empty */
+          op[- lit - 1] = lit - 1;
+          op -= !lit;
+
+          do
+            len++;
+          while (len < maxlen && ref[len] == ip[len]);
+
+          ip  += len;
+          len -= 2;
+
+          if (len < 7)
+            {
+              *op++ = (off >> 8) + (len << 5);
+            }
+          else
+            {
+              *op++ = (off >> 8) + (7 << 5);
+              *op++ = len - 7;
+            }
+          *op++ = off;
+
+          lit = 0;
+          op++;
+
+          if (ip < in_end - 2)
+            table[lz_hash (ip - 1)] = ip - 1;
+        }
+      else
+        {
+          if (op + 1 >= out_end)
+            goto full;
+
+          lit++;
+          *op++ = *ip++;
+
+          if (lit == LZ_MAX_LIT)
+            {
+              op[- lit - 1] = lit - 1;
+              lit = 0;
+              op++;
+            }
+        }
+    }
+
+  while (ip < in_end)
+    {
+      if (op + 1 >= out_end)
+        goto full;
+
+      lit++;
+      *op++ = *ip++;
+
+      if (lit == LZ_MAX_LIT)
+        {
+          op[- lit - 1] = lit - 1;
+          lit = 0;
+          op++;
+        }
+    }
+
+  op[- lit - 1] = lit - 1;
+  op -= !lit;
+
+  g_free (table);
+  return op - dst;
+
+full:
+  g_free (table);
+  return 0;
+}
+
+gboolean
+gegl_buffer_codec_lz_decompress (const guchar *src,
+                                 gint          size,
+                                 guchar       *dst,
+                                 gint          dst_size)
+{
+  const guchar *ip      = src;
+  const guchar *in_end  = src + size;
+  guchar       *op      = dst;
+  guchar       *out_end = dst + dst_size;
+
+  while (ip < in_end)
+    {
+      guint ctrl = *ip++;
+
+      if (ctrl < LZ_MAX_LIT)
+        {
+          ctrl++;
+
+          if (op + ctrl > out_end || ip + ctrl > in_end)
+            return FALSE;
+
+          memcpy (op, ip, ctrl);
+          op += ctrl;
+          ip += ctrl;
+        }
+      else
+        {
+          guint         len = ctrl >> 5;
+          const guchar *ref = op - ((ctrl & 0x1f) << 8) - 1;
+
+          if (len == 7)
+            {
+              if (ip >= in_end)
+                return FALSE;
+              len += *ip++;
+            }
+
+          if (ip >= in_end)
+            return FALSE;
+          ref -= *ip++;
+          len += 2;
+
+          if (op + len > out_end || ref < dst)
+            return FALSE;
+
+          /* the reference may overlap the output, for runs */
+          while (len--)
+            *op++ = *ref++;
+        }
+    }
+
+  return op == out_end;
+}
+
+const guchar *
+gegl_buffer_codec_encode (GeglBufferTableEntry *entry,
+                          const guchar         *data,
+                          gint                  tile_size,
+                          gint                  element_size,
+                          guchar               *scratch)
+{
+  const guchar *src = data;
+  gint          size;
+
+  entry->shuffle = 0;
+
+  if (element_size > 1)
+    {
+      gegl_buffer_codec_shuffle (data, scratch + tile_size, tile_size,
+                                 element_size);
+      src = scratch + tile_size;
+      entry->shuffle = element_size;
+    }
+
+  size = gegl_buffer_codec_lz_compress (src, tile_size, scratch,
+                                        tile_size - tile_size / MIN_SAVING);
+
+  if (size > 0)
+    {
+      entry->codec = GEGL_TILE_CODEC_LZ;
+      entry->size  = size;
+      return scratch;
+    }
+
+  entry->codec   = GEGL_TILE_CODEC_NONE;
+  entry->shuffle = 0;
+  entry->size    = tile_size;
+  return data;
+}
+
+gboolean
+gegl_buffer_codec_decode (const GeglBufferTableEntry *entry,
+                          const guchar               *src,
+                          guchar                     *dst,
+                          gint                        tile_size)
+{
+  switch (entry->codec)
+    {
+      case GEGL_TILE_CODEC_NONE:
+        if (entry->size != tile_size)
+          return FALSE;
+
+        if (entry->shuffle > 1)
+          gegl_buffer_codec_unshuffle (src, dst, tile_size, entry->shuffle);
+        else
+          memcpy (dst, src, tile_size);
+        return TRUE;
+
+      case GEGL_TILE_CODEC_LZ:
+        if (entry->shuffle > 1)
+          {
+            guchar   *planes = g_malloc (tile_size);
+            gboolean  ret;
+
+            ret = gegl_buffer_codec_lz_decompress (src, entry->size,
+                                                   planes, tile_size);
+            if (ret)
+              gegl_buffer_codec_unshuffle (planes, dst, tile_size,
+                                           entry->shuffle);
+            g_free (planes);
+            return ret;
+          }
+
+        return gegl_buffer_codec_lz_decompress (src, entry->size,
+                                                dst, tile_size);
+
+      default:
+        return FALSE;
+    }
+}
@@ -0,0 +1,75 @@
+/* This file is part of GEGL.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GEGL_BUFFER_CODEC_H__
+#define __GEGL_BUFFER_CODEC_H__
+
+#include <glib.h>
+#include "gegl-buffer-index.h"
+
+G_BEGIN_DECLS
+
+/***
+ * The compression of the tiles stored in buffer files. Tiles are
+ * compressed with a small LZ77 coder (in the style of LZF), which is
+ * fast enough to not slow down loading from disk. For pixel formats with
+ * components of more than one byte, the bytes are first shuffled so that
+ * the bytes of the same significance of all components follow each other,
+ * which makes the slowly varying high bytes of float data compress well.
+ */
+
+/* shuffle the bytes of the elements of @src into planes */
+void     gegl_buffer_codec_shuffle       (const guchar *src,
+                                          guchar       *dst,
+                                          gint          size,
+                                          gint          element_size);
+void     gegl_buffer_codec_unshuffle     (const guchar *src,
+                                          guchar       *dst,
+                                          gint          size,
+                                          gint          element_size);
+
+/* returns the size of the compressed data, or 0 if it doesn't fit in
+ * @max_size bytes
+ */
+gint     gegl_buffer_codec_lz_compress   (const guchar *src,
+                                          gint          size,
+                                          guchar       *dst,
+                                          gint          max_size);
+gboolean gegl_buffer_codec_lz_decompress (const guchar *src,
+                                          gint          size,
+                                          guchar       *dst,
+                                          gint          dst_size);
+
+/* compress a tile of @tile_size bytes and fill in the size, codec and
+ * shuffle of @entry, @scratch has to have room for twice the tile size.
+ * Returns the data to store, either in @scratch or @data itself when the
+ * tile doesn't compress.
+ */
+const guchar *gegl_buffer_codec_encode   (GeglBufferTableEntry *entry,
+                                          const guchar         *data,
+                                          gint                  tile_size,
+                                          gint                  element_size,
+                                          guchar               *scratch);
+
+/* decode the data stored for @entry into @dst of @tile_size bytes */
+gboolean gegl_buffer_codec_decode        (const GeglBufferTableEntry *entry,
+                                          const guchar               *src,
+                                          guchar                     *dst,
+                                          gint                        tile_size);
+
+G_END_DECLS
+
+#endif
@@ -10,10 +10,18 @@ GeglBuffer on disk representation
 
 /* Increase this number when the structures change.*/
 #define GEGL_FILE_SPEC_REV     0
+
+/* Files written by gegl_buffer_save() have this revision, they store the
+ * index as a single table and the tiles compressed, see
+ * GeglBufferTableEntry. The file backend creates revision 0 files, and
+ * rewrites the table of revision 1 files it modifies.
+ */
+#define GEGL_FILE_SPEC_REV_TABLE  1
 #define GEGL_MAGIC             {'G','E','G','L'}
 
 #define GEGL_FLAG_TILE         1
 #define GEGL_FLAG_FREE_TILE    0xf+2
+#define GEGL_FLAG_TILE_TABLE   3
 
 /* a VOID message, indicating that the specified tile has been rewritten */
 #define GEGL_FLAG_INVALIDATED  2
@@ -99,6 +107,26 @@ typedef struct {
                             own state when revision differs. */
 } GeglBufferTile;
 
+/* In revision 1 files the header points to a single block flagged as
+ * GEGL_FLAG_TILE_TABLE, which is followed by one entry per tile, the
+ * length of the block includes the entries.
+ */
+typedef struct {
+  guint64 offset;        /* offset into file for the data of this tile */
+  guint32 size;          /* number of bytes stored for the tile        */
+  guint16 codec;         /* GEGL_TILE_CODEC_ the data is stored with   */
+  guint16 shuffle;       /* if more than 1, the size of the elements the
+                            bytes were shuffled into planes by before
+                            compression */
+  gint32  x;             /* upperleft of tile % tile_width coordinates */
+  gint32  y;
+  gint32  z;             /* mipmap subdivision level of tile (0=100%)  */
+  guint32 rev;
+} GeglBufferTableEntry;
+
+#define GEGL_TILE_CODEC_NONE   0
+#define GEGL_TILE_CODEC_LZ     1
+
 /* A convenience union to allow quick and simple casting */
 typedef union {
   guint32          length;
@@ -129,6 +157,13 @@ GeglBufferItem *gegl_buffer_read_header(int      i,
 GList          *gegl_buffer_read_index (int      i,
                                         goffset *offset);
 
+/* read the index of a file of either revision as a table, revision 0
+ * entries are stored uncompressed
+ */
+GeglBufferTableEntry *gegl_buffer_read_table (int                     i,
+                                              const GeglBufferHeader *header,
+                                              gint                   *n_entries);
+
 #define struct_check_padding(type, size) \
   if (sizeof (type) != size) \
     {\
@@ -141,7 +176,8 @@ GList          *gegl_buffer_read_index (int      i,
     }
 #define GEGL_BUFFER_STRUCT_CHECK_PADDING \
   {struct_check_padding (GeglBufferBlock, 16);\
-  struct_check_padding (GeglBufferHeader, 256);}
+  struct_check_padding (GeglBufferHeader, 256);\
+  struct_check_padding (GeglBufferTableEntry, 32);}
 #define GEGL_BUFFER_SANITY {static gboolean done=FALSE;if(!done){GEGL_BUFFER_STRUCT_CHECK_PADDING;done=TRUE;}}
 
 #endif
@@ -30,6 +30,9 @@
 #include "gegl-types-internal.h"
 #include "gegl-buffer-private.h"
 #include "gegl-buffer-index.h"
+#include "gegl-buffer-codec.h"
+#include "gegl-tile-storage.h"
+#include "gegl-tile-backend-mmap.h"
 #include "gegl-debug.h"
 
 #include <glib/gprintf.h>
@@ -37,15 +40,16 @@
 
 typedef struct
 {
-  GeglBufferHeader header;
-  GList           *tiles;
-  gchar           *path;
-  int              i;
-  gint             tile_size;
-  const Babl      *format;
-  goffset          offset;
-  goffset          next_block;
-  gboolean         got_header;
+  GeglBufferHeader      header;
+  GeglBufferTableEntry *table;
+  gint                  n_entries;
+  gchar                *path;
+  int                   i;
+  gint                  tile_size;
+  const Babl           *format;
+  goffset               offset;
+  goffset               next_block;
+  gboolean              got_header;
 } LoadInfo;
 
 static void seekto(LoadInfo *info, gint offset)
@@ -67,16 +71,7 @@ load_info_destroy (LoadInfo *info)
     g_free (info->path);
   if (info->i != -1)
     close (info->i);
-  if (info->tiles != NULL)
-    {
-      GList *iter;
-      for (iter = info->tiles; iter; iter = iter->next)
-        {
-          g_free (iter->data);
-        }
-      g_list_free (info->tiles);
-      info->tiles = NULL;
-    }
+  g_free (info->table);
   g_slice_free (LoadInfo, info);
 }
 
@@ -224,6 +219,87 @@ gegl_buffer_read_index (int           i,
   return ret;
 }
 
+static gboolean
+read_at (int      i,
+         gpointer data,
+         gsize    size,
+         goffset  offset)
+{
+#ifdef HAVE_PREAD
+  return pread (i, data, size, offset) == (gssize) size;
+#else
+  if (lseek (i, offset, SEEK_SET) == -1)
+    return FALSE;
+  return read (i, data, size) == (gssize) size;
+#endif
+}
+
+GeglBufferTableEntry *
+gegl_buffer_read_table (int                     i,
+                        const GeglBufferHeader *header,
+                        gint                   *n_entries)
+{
+  GeglBufferTableEntry *table;
+  GeglBufferBlock       block;
+
+  *n_entries = 0;
+
+  if (gegl_buffer_header_get_rev (header) < GEGL_FILE_SPEC_REV_TABLE)
+    {
+      GList   *tiles;
+      GList   *iter;
+      goffset  offset    = header->next;
+      gint     tile_size = header->tile_width * header->tile_height *
+                           header->bytes_per_pixel;
+      gint     n;
+
+      tiles = gegl_buffer_read_index (i, &offset);
+      table = g_new0 (GeglBufferTableEntry, MAX (g_list_length (tiles), 1));
+
+      for (iter = tiles, n = 0; iter; iter = iter->next, n++)
+        {
+          GeglBufferTile *tile = iter->data;
+
+          table[n].offset = tile->offset;
+          table[n].size   = tile_size;
+          table[n].codec  = GEGL_TILE_CODEC_NONE;
+          table[n].x      = tile->x;
+          table[n].y      = tile->y;
+          table[n].z      = tile->z;
+          table[n].rev    = tile->rev;
+        }
+
+      g_list_free_full (tiles, g_free);
+      *n_entries = n;
+      return table;
+    }
+
+  /* the table is read in one go */
+  if (!read_at (i, &block, sizeof (GeglBufferBlock), header->next) ||
+      block.flags != GEGL_FLAG_TILE_TABLE ||
+      block.length < sizeof (GeglBufferBlock))
+    {
+      g_warning ("%s: no tile table found", G_STRFUNC);
+      return NULL;
+    }
+
+  *n_entries = (block.length - sizeof (GeglBufferBlock)) /
+               sizeof (GeglBufferTableEntry);
+  table = g_new (GeglBufferTableEntry, MAX (*n_entries, 1));
+
+  if (!read_at (i, table, *n_entries * sizeof (GeglBufferTableEntry),
+                header->next + sizeof (GeglBufferBlock)))
+    {
+      g_warning ("%s: failed reading the tile table", G_STRFUNC);
+      g_free (table);
+      *n_entries = 0;
+      return NULL;
+    }
+
+  GEGL_NOTE (GEGL_DEBUG_BUFFER_LOAD, "read table of %i tiles", *n_entries);
+
+  return table;
+}
 
 static void sanity(void) { GEGL_BUFFER_SANITY; }
 
@@ -246,8 +322,28 @@ GeglBuffer *
 gegl_buffer_load (const gchar *path)
 {
   GeglBuffer *ret;
+  LoadInfo   *info;
+
+  /* serve the tiles straight from the file when it can be mapped, so
+   * loading only has to read the index
+   */
+  {
+    GeglBufferHeader  header;
+    GeglTileBackend  *backend = gegl_tile_backend_mmap_new (path, &header);
+
+    if (backend)
+      {
+        ret = g_object_new (GEGL_TYPE_BUFFER,
+                            "backend", backend,
+                            "height", header.height,
+                            "width", header.width,
+                            NULL);
+        g_object_unref (backend);
+        return ret;
+      }
+  }
 
-  LoadInfo *info = g_slice_new0 (LoadInfo);
+  info = g_slice_new0 (LoadInfo);
 
   info->path = g_strdup (path);
   info->i = g_open (info->path, O_RDONLY, 0770);
@@ -285,49 +381,63 @@ gegl_buffer_load (const gchar *path)
   */
   g_assert (babl_format_get_bytes_per_pixel (info->format) == info->header.bytes_per_pixel);
 
-  info->tiles = gegl_buffer_read_index (info->i, &info->offset);
+  info->table = gegl_buffer_read_table (info->i, &info->header,
+                                        &info->n_entries);
 
   /* load each tile */
   {
-    GList *iter;
-    gint   i = 0;
-    for (iter = info->tiles; iter; iter = iter->next)
-      {
-        GeglBufferTile *entry = iter->data;
-        guchar         *data;
-        GeglTile       *tile;
+    guchar *stored = g_malloc (info->tile_size);
+    gint    i;
 
+    for (i = 0; i < info->n_entries; i++)
+      {
+        GeglBufferTableEntry *entry = &info->table[i];
+        GeglTile             *tile;
 
-        tile = gegl_tile_source_get_tile (GEGL_TILE_SOURCE (ret),
-                                          entry->x,
-                                          entry->y,
-                                          entry->z);
+        if (entry->size > info->tile_size)
+          {
+            g_warning ("%s: skipping tile %i,%i,%i of %s",
+                       G_STRFUNC, entry->x, entry->y, entry->z, info->path);
+            continue;
+          }
 
         if (info->offset != entry->offset)
           {
             seekto (info, entry->offset);
           }
-        /*g_assert (info->offset == entry->offset);*/
-
-
-        g_assert (tile);
-        gegl_tile_lock (tile);
-
-        data = gegl_tile_get_data (tile);
-        g_assert (data);
 
         {
-          ssize_t sz_read = read (info->i, data, info->tile_size);
+          ssize_t sz_read = read (info->i, stored, entry->size);
           if(sz_read != -1)
             info->offset += sz_read;
         }
-        /*g_assert (info->offset == entry->offset + info->tile_size);*/
 
-        gegl_tile_unlock (tile);
+        tile = gegl_tile_new (info->tile_size);
+        tile->tile_storage = ret->tile_storage;
+        tile->x = entry->x;
+        tile->y = entry->y;
+        tile->z = entry->z;
+        tile->rev++;
+
+        if (!gegl_buffer_codec_decode (entry, stored,
+                                       gegl_tile_get_data (tile),
+                                       info->tile_size))
+          {
+            g_warning ("%s: corrupt tile %i,%i,%i in %s",
+                       G_STRFUNC, entry->x, entry->y, entry->z, info->path);
+            memset (gegl_tile_get_data (tile), 0, info->tile_size);
+          }
+
+        if (entry->z > ret->tile_storage->seen_zoom)
+          ret->tile_storage->seen_zoom = entry->z;
+
+        gegl_tile_handler_cache_insert (ret->tile_storage->cache, tile,
+                                        entry->x, entry->y, entry->z);
         gegl_tile_unref (tile);
-        i++;
       }
-    GEGL_NOTE (GEGL_DEBUG_BUFFER_LOAD, "%i tiles loaded",i);
+
+    g_free (stored);
+    GEGL_NOTE (GEGL_DEBUG_BUFFER_LOAD, "%i tiles loaded", info->n_entries);
   }
   GEGL_NOTE (GEGL_DEBUG_BUFFER_LOAD, "buffer loaded %s", info->path);
 
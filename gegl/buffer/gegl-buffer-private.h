@@ -94,6 +94,19 @@ void              gegl_tile_cache_init    (void);
 
 void              gegl_tile_cache_destroy (void);
 
+/* selects the eviction policy of the tile cache by name, "2q" for an
+ * unknown name; called when the tile-cache-policy property is set.
+ */
+void              gegl_tile_cache_set_policy (const gchar *name);
+
+/* returns the tile cache statistics gathered while @policy ("2q" or "lru")
+ * was the active tile-cache-policy, FALSE for an unknown policy.
+ */
+gboolean          gegl_tile_cache_get_stats (const gchar *policy,
+                                             guint64     *hits,
+                                             guint64     *misses,
+                                             guint64     *evictions);
+
 void              gegl_tile_backend_swap_cleanup (void);
 
 GeglTileBackend * gegl_buffer_backend     (GeglBuffer *buffer);
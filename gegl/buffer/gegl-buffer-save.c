@@ -36,21 +36,17 @@
 #include "gegl-tile-storage.h"
 #include "gegl-tile.h"
 #include "gegl-buffer-index.h"
+#include "gegl-buffer-codec.h"
 
 typedef struct
 {
   GeglBufferHeader header;
-  GList           *tiles;
+  GArray          *tiles;  /* GeglBufferTableEntry of the tiles to write */
   gchar           *path;
   gint             o;
 
   gint             tile_size;
-  gint             offset;
-  gint             entry_count;
-  GeglBufferBlock *in_holding; /* we need to write one block added behind
-                                * to be able to recompute the forward pointing
-                                * link from one entry to the next.
-                                */
+  goffset          offset;
 } SaveInfo;
 
 
@@ -75,30 +71,28 @@ gegl_tile_entry_destroy (GeglBufferTile *entry)
   g_free (entry);
 }
 
-static gsize write_block (SaveInfo        *info,
-                          GeglBufferBlock *block)
+static void
+write_data (SaveInfo      *info,
+            gconstpointer  data,
+            gsize          size)
 {
-   gssize ret = 0;
-
-   if (info->in_holding)
-     {
-       glong allocated_pos = info->offset + info->in_holding->length;
-       info->in_holding->next = allocated_pos;
-
-       if (block == NULL)
-         info->in_holding->next = 0;
-
-       ret = write (info->o, info->in_holding, info->in_holding->length);
-	   if (ret == -1)
-         ret = 0;
-       info->offset += ret;
-       g_assert (allocated_pos == info->offset);
-     }
-  /* write block should also allocate the block and update the
-   * previously added blocks next pointer
-   */
-   info->in_holding = block;
-   return ret;
+  ssize_t ret = write (info->o, data, size);
+
+  if (ret != -1)
+    info->offset += ret;
+}
+
+/* pad the file so the data written next is aligned for any pixel type,
+ * which allows using uncompressed tiles in place when the file is mapped
+ */
+static void
+write_padding (SaveInfo *info)
+{
+  static const guchar zeros[8] = { 0, };
+  gint                padding  = (8 - info->offset % 8) % 8;
+
+  if (padding)
+    write_data (info, zeros, padding);
 }
 
 static void
@@ -111,19 +105,13 @@ save_info_destroy (SaveInfo *info)
   if (info->o != -1)
     close (info->o);
   if (info->tiles != NULL)
-    {
-      GList *iter;
-      for (iter = info->tiles; iter; iter = iter->next)
-        gegl_tile_entry_destroy (iter->data);
-      g_list_free (info->tiles);
-      info->tiles = NULL;
-    }
+    g_array_free (info->tiles, TRUE);
   g_slice_free (SaveInfo, info);
 }
 
 
 
-static glong z_order (const GeglBufferTile *entry)
+static glong z_order (const GeglBufferTableEntry *entry)
 {
   glong value;
 
@@ -153,10 +141,10 @@ static glong z_order (const GeglBufferTile *entry)
 static gint z_order_compare (gconstpointer a,
                              gconstpointer b)
 {
-  const GeglBufferTile *entryA = a;
-  const GeglBufferTile *entryB = b;
+  glong valueA = z_order (a);
+  glong valueB = z_order (b);
 
-  return z_order (entryB) - z_order (entryA);
+  return (valueB > valueA) - (valueB < valueA);
 }
 
 
@@ -194,8 +182,9 @@ gegl_buffer_save (GeglBuffer          *buffer,
 {
   SaveInfo *info = g_slice_new0 (SaveInfo);
 
-  glong prediction = 0;
   gint bpp;
+  gint n_components;
+  gint element_size;
   gint tile_width;
   gint tile_height;
 
@@ -216,6 +205,10 @@ gegl_buffer_save (GeglBuffer          *buffer,
   info->path = g_strdup (path);
 
 #ifndef G_OS_WIN32
+  /* replace rather than truncate the file, buffers loaded from it may
+   * still have it mapped, possibly the one being saved
+   */
+  g_unlink (info->path);
   info->o    = g_open (info->path, O_RDWR|O_CREAT|O_TRUNC, S_IRUSR|S_IWUSR|S_IRGRP|S_IWGRP|S_IROTH|S_IWOTH);
 #else
   info->o    = g_open (info->path, O_RDWR|O_CREAT|O_TRUNC, S_IRUSR|S_IWUSR);
@@ -238,127 +231,124 @@ gegl_buffer_save (GeglBuffer          *buffer,
                            bpp,
                            buffer->tile_storage->format
                            );
-  info->header.next = (prediction += sizeof (GeglBufferHeader));
+  info->header.flags = GEGL_FLAG_FLUSHED |
+                       GEGL_FLAG_IS_HEADER |
+                       GEGL_FILE_SPEC_REV_TABLE;
   info->tile_size = tile_width * tile_height * bpp;
 
   g_assert (info->tile_size % 16 == 0);
 
+  /* shuffle the bytes of multi-byte components into planes */
+  n_components = babl_format_get_n_components (buffer->tile_storage->format);
+  element_size = bpp % n_components ? 1 : bpp / n_components;
+
   GEGL_NOTE (GEGL_DEBUG_BUFFER_SAVE,
              "collecting list of tiles to be written");
+  info->tiles = g_array_new (FALSE, TRUE, sizeof (GeglBufferTableEntry));
   {
     gint z;
-    gint factor = 1;
 
-    for (z = 0; z < 1; z++)
+    /* the mipmap levels that have been computed for the buffer are
+     * stored as well
+     */
+    for (z = 0; z <= buffer->tile_storage->seen_zoom; z++)
       {
-        gint bufy = roi->y;
-        while (bufy < roi->y + roi->height)
-          {
-            gint tiledy  = roi->y + bufy;
-            gint offsety = gegl_tile_offset (tiledy, tile_height);
-            gint bufx    = roi->x;
-
-            while (bufx < roi->x + roi->width)
+        gint first_tx = gegl_tile_indice (roi->x, tile_width << z);
+        gint first_ty = gegl_tile_indice (roi->y, tile_height << z);
+        gint last_tx  = gegl_tile_indice (roi->x + roi->width - 1,
+                                          tile_width << z);
+        gint last_ty  = gegl_tile_indice (roi->y + roi->height - 1,
+                                          tile_height << z);
+        gint tx, ty;
+
+        for (ty = first_ty; ty <= last_ty; ty++)
+          for (tx = first_tx; tx <= last_tx; tx++)
+            if (gegl_tile_source_exist (GEGL_TILE_SOURCE (buffer), tx, ty, z))
               {
-                gint tiledx  = roi->x + bufx;
-                gint offsetx = gegl_tile_offset (tiledx, tile_width);
-
-                gint tx = gegl_tile_indice (tiledx / factor, tile_width);
-                gint ty = gegl_tile_indice (tiledy / factor, tile_height);
-
-                if (gegl_tile_source_exist (GEGL_TILE_SOURCE (buffer), tx, ty, z))
-                  {
-                    GeglBufferTile *entry;
+                GeglBufferTableEntry entry = { 0, };
 
-                    GEGL_NOTE (GEGL_DEBUG_BUFFER_SAVE,
-                               "Found tile to save, tx, ty, z = %d, %d, %d",
-                               tx, ty, z);
+                GEGL_NOTE (GEGL_DEBUG_BUFFER_SAVE,
+                           "Found tile to save, tx, ty, z = %d, %d, %d",
+                           tx, ty, z);
 
-                    entry = gegl_tile_entry_new (tx, ty, z);
-                    info->tiles = g_list_prepend (info->tiles, entry);
-                    info->entry_count++;
-                  }
-                bufx += (tile_width - offsetx) * factor;
+                entry.x = tx;
+                entry.y = ty;
+                entry.z = z;
+                g_array_append_val (info->tiles, entry);
               }
-            bufy += (tile_height - offsety) * factor;
-          }
-        factor *= 2;
       }
   GEGL_NOTE (GEGL_DEBUG_BUFFER_SAVE,
              "size of list of tiles to be written: %d",
-             g_list_length (info->tiles));
+             info->tiles->len);
   }
 
   /* sort the list of tiles into zorder */
-  info->tiles = g_list_sort (info->tiles, z_order_compare);
-
-  /* set the offset in the file each tile will be stored on */
-  {
-    GList *iter;
-    gint   predicted_offset = sizeof (GeglBufferHeader) +
-                              sizeof (GeglBufferTile) * (info->entry_count);
-    for (iter = info->tiles; iter; iter = iter->next)
-      {
-        GeglBufferTile *entry = iter->data;
-        entry->block.next = iter->next?
-                            (prediction += sizeof (GeglBufferTile)):0;
-        entry->offset = predicted_offset;
-        predicted_offset += info->tile_size;
-      }
-  }
-
-  /* save the header */
-  {
-    ssize_t ret = write (info->o, &info->header, sizeof (GeglBufferHeader));
-	if (ret != -1)
-      info->offset += ret;
-  }
-  g_assert (info->offset == info->header.next);
+  g_array_sort (info->tiles, z_order_compare);
 
-  /* save the index */
-  {
-    GList *iter;
-    for (iter = info->tiles; iter; iter = iter->next)
-      {
-        GeglBufferItem *item = iter->data;
-
-        write_block (info, &item->block);
-
-      }
-  }
-  write_block (info, NULL); /* terminate the index */
-
-  /* update header to point to start of new index (already done for
-   * this serial saver, and the header is already written.
+  /* save the header, it is written again once the position of the
+   * table is known
    */
+  write_data (info, &info->header, sizeof (GeglBufferHeader));
 
   /* save each tile */
   {
-    GList *iter;
-    gint   i = 0;
-    for (iter = info->tiles; iter; iter = iter->next)
+    guchar *scratch = g_malloc (info->tile_size * 2);
+    guint   i;
+
+    for (i = 0; i < info->tiles->len; i++)
       {
-        GeglBufferTile *entry = iter->data;
-        guchar          *data;
-        GeglTile        *tile;
+        GeglBufferTableEntry *entry = &g_array_index (info->tiles,
+                                                      GeglBufferTableEntry, i);
+        const guchar         *stored;
+        GeglTile             *tile;
 
         tile = gegl_tile_source_get_tile (GEGL_TILE_SOURCE (buffer),
                                           entry->x,
                                           entry->y,
                                           entry->z);
         g_assert (tile);
-        data = gegl_tile_get_data (tile);
-        g_assert (data);
-
-        g_assert (info->offset == entry->offset);
-        {
-          ssize_t ret = write (info->o, data, info->tile_size);
-	      if (ret != -1)
-            info->offset += ret;
-        }
+
+        stored = gegl_buffer_codec_encode (entry, gegl_tile_get_data (tile),
+                                           info->tile_size, element_size,
+                                           scratch);
+
+        write_padding (info);
+        entry->offset = info->offset;
+        write_data (info, stored, entry->size);
+
         gegl_tile_unref (tile);
-        i++;
       }
+
+    g_free (scratch);
   }
+
+  /* save the index as one table */
+  {
+    GeglBufferBlock block;
+
+    write_padding (info);
+    info->header.next = info->offset;
+
+    block.length = sizeof (GeglBufferBlock) +
+                   info->tiles->len * sizeof (GeglBufferTableEntry);
+    block.flags  = GEGL_FLAG_TILE_TABLE;
+    block.next   = 0;
+
+    write_data (info, &block, sizeof (GeglBufferBlock));
+    write_data (info, info->tiles->data,
+                info->tiles->len * sizeof (GeglBufferTableEntry));
+
+    GEGL_NOTE (GEGL_DEBUG_BUFFER_SAVE, "wrote %i tiles in %i bytes",
+               info->tiles->len, (gint) info->offset);
+  }
+
+  /* update the header to point to the table */
+  if (lseek (info->o, 0, SEEK_SET) != -1)
+    {
+      ssize_t ret = write (info->o, &info->header, sizeof (GeglBufferHeader));
+      if (ret == -1)
+        g_warning ("%s: failed writing the header of '%s'", G_STRFUNC, info->path);
+    }
+
   save_info_destroy (info);
 }
@@ -46,6 +46,7 @@
 #include "gegl-tile-backend-file.h"
 #include "gegl-tile-backend-swap.h"
 #include "gegl-tile-backend-ram.h"
+#include "gegl-tile-backend-mmap.h"
 #include "gegl-types-internal.h"
 #include "gegl-config.h"
 #include "gegl-buffer-cl-cache.h"
@@ -577,6 +578,16 @@ gegl_buffer_constructor (GType                  type,
         }
 
       source = GEGL_TILE_SOURCE (gegl_tile_storage_new (backend));
+
+      /* stored mipmap levels have to be voided when the tiles below them
+       * change
+       */
+      if (GEGL_IS_TILE_BACKEND_MMAP (backend))
+        GEGL_TILE_STORAGE (source)->seen_zoom =
+          GEGL_TILE_BACKEND_MMAP (backend)->max_z;
+      else if (GEGL_IS_TILE_BACKEND_FILE (backend))
+        GEGL_TILE_STORAGE (source)->seen_zoom =
+          gegl_tile_backend_file_get_max_z (GEGL_TILE_BACKEND_FILE (backend));
       gegl_tile_handler_set_source ((GeglTileHandler*)(buffer), source);
       g_object_unref (source);
     }
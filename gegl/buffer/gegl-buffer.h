@@ -545,6 +545,35 @@ void              gegl_sampler_get            (GeglSampler    *sampler,
                                                void           *output,
                                                GeglAbyssPolicy repeat_mode);
 
+/**
+ * gegl_sampler_get_span: (skip)
+ * @sampler: a GeglSampler gotten from gegl_buffer_sampler_new
+ * @x: x coordinate of the first sample
+ * @y: y coordinate of the first sample
+ * @dx: step in x between consecutive samples
+ * @dy: step in y between consecutive samples
+ * @scale: matrix representing extent of sampling area in source buffer.
+ * @output: memory location for @n_samples consecutive pixels of output data.
+ * @n_samples: number of samples to take
+ * @repeat_mode: how requests outside the buffer extent are handled.
+ *
+ * Perform @n_samples samplings along a line, such as the inverse image of
+ * an output row under an affine transformation, with the provided
+ * @sampler. The result is the same as calling the function returned by
+ * gegl_sampler_get_fun() for each sample, adding @dx and @dy to the
+ * coordinates after each one, but samplers with a span implementation
+ * avoid the per sample overhead.
+ */
+void              gegl_sampler_get_span       (GeglSampler    *sampler,
+                                               gdouble         x,
+                                               gdouble         y,
+                                               gdouble         dx,
+                                               gdouble         dy,
+                                               GeglMatrix2    *scale,
+                                               void           *output,
+                                               gint            n_samples,
+                                               GeglAbyssPolicy repeat_mode);
+
 /* code template utility, updates the jacobian matrix using
  * a user defined mapping function for displacement, example
  * with an identity transform (note that for the identity
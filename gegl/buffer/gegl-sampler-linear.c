@@ -37,6 +37,15 @@ static void gegl_sampler_linear_get (      GeglSampler* restrict  self,
                                            GeglMatrix2           *scale,
                                            void*        restrict  output,
                                            GeglAbyssPolicy        repeat_mode);
+static void gegl_sampler_linear_get_span (GeglSampler     *self,
+                                          gdouble          x,
+                                          gdouble          y,
+                                          gdouble          dx,
+                                          gdouble          dy,
+                                          GeglMatrix2     *scale,
+                                          void            *output,
+                                          gint             n_samples,
+                                          GeglAbyssPolicy  repeat_mode);
 
 G_DEFINE_TYPE (GeglSamplerLinear, gegl_sampler_linear, GEGL_TYPE_SAMPLER)
 
@@ -45,7 +54,8 @@ gegl_sampler_linear_class_init (GeglSamplerLinearClass *klass)
 {
   GeglSamplerClass *sampler_class = GEGL_SAMPLER_CLASS (klass);
 
-  sampler_class->get = gegl_sampler_linear_get;
+  sampler_class->get      = gegl_sampler_linear_get;
+  sampler_class->get_span = gegl_sampler_linear_get_span;
 }
 
 /*
@@ -200,3 +210,72 @@ gegl_sampler_linear_get (      GeglSampler*    restrict  self,
     babl_process (self->fish, newval, output, 1);
   }
 }
+
+/*
+ * Same interpolation as gegl_sampler_linear_get, with the four channels
+ * of a sample computed in one loop and the samples converted to the
+ * output format a chunk at a time.
+ */
+static void
+gegl_sampler_linear_get_span (GeglSampler     *self,
+                              gdouble          x,
+                              gdouble          y,
+                              gdouble          dx,
+                              gdouble          dy,
+                              GeglMatrix2     *scale,
+                              void            *output,
+                              gint             n_samples,
+                              GeglAbyssPolicy  repeat_mode)
+{
+  const gint  bot_offset = GEGL_SAMPLER_MAXIMUM_WIDTH * 4;
+  const gint  bpp        = babl_format_get_bytes_per_pixel (self->format);
+  guchar     *out        = output;
+  gfloat      newval[GEGL_SAMPLER_SPAN_CHUNK * 4];
+
+  while (n_samples > 0)
+    {
+      const gint chunk = MIN (n_samples, GEGL_SAMPLER_SPAN_CHUNK);
+      gint       i, c;
+
+      for (i = 0; i < chunk; i++)
+        {
+          const float iabsolute_x = (float) x - 0.5;
+          const float iabsolute_y = (float) y - 0.5;
+
+          const gint ix = floorf (iabsolute_x);
+          const gint iy = floorf (iabsolute_y);
+
+          const gfloat* restrict top =
+            gegl_sampler_get_ptr (self, ix, iy, repeat_mode);
+          const gfloat* restrict bot = top + bot_offset;
+
+          const gfloat fx = iabsolute_x - ix;
+          const gfloat fy = iabsolute_y - iy;
+
+          const gfloat x_times_y = fx * fy;
+          const gfloat w_times_y = fy - x_times_y;
+          const gfloat x_times_z = fx - x_times_y;
+          const gfloat w_times_z = (gfloat) 1. - ( fx + w_times_y );
+
+          gfloat *val = newval + i * 4;
+
+          for (c = 0; c < 4; c++)
+            val[c] =
+              x_times_y * bot[4 + c]
+              +
+              w_times_y * bot[c]
+              +
+              x_times_z * top[4 + c]
+              +
+              w_times_z * top[c];
+
+          x += dx;
+          y += dy;
+        }
+
+      babl_process (self->fish, newval, out, chunk);
+
+      out       += chunk * bpp;
+      n_samples -= chunk;
+    }
+}
@@ -46,6 +46,17 @@ gegl_sampler_nearest_get (GeglSampler*    restrict self,
 static void
 gegl_sampler_nearest_prepare (GeglSampler*    restrict self);
 
+static void
+gegl_sampler_nearest_get_span (GeglSampler     *self,
+                               gdouble          x,
+                               gdouble          y,
+                               gdouble          dx,
+                               gdouble          dy,
+                               GeglMatrix2     *scale,
+                               void            *output,
+                               gint             n_samples,
+                               GeglAbyssPolicy  repeat_mode);
+
 G_DEFINE_TYPE (GeglSamplerNearest, gegl_sampler_nearest, GEGL_TYPE_SAMPLER)
 
 static void
@@ -55,6 +66,7 @@ gegl_sampler_nearest_class_init (GeglSamplerNearestClass *klass)
 
   sampler_class->get = gegl_sampler_nearest_get;
   sampler_class->prepare = gegl_sampler_nearest_prepare;
+  sampler_class->get_span = gegl_sampler_nearest_get_span;
 }
 
 /*
@@ -220,6 +232,79 @@ gegl_sampler_nearest_get (      GeglSampler*    restrict  sampler,
 #endif
 }
 
+/*
+ * Unlike gegl_sampler_nearest_get, this doesn't go through the hot tile of
+ * the buffer, so it is safe to use from several threads at once. When the
+ * requested format is the interpolation format the pixels are copied from
+ * the cache of the sampler, otherwise runs of horizontally adjacent samples
+ * are fetched with a single gegl_buffer_get each.
+ */
+static void
+gegl_sampler_nearest_get_span (GeglSampler     *self,
+                               gdouble          x,
+                               gdouble          y,
+                               gdouble          dx,
+                               gdouble          dy,
+                               GeglMatrix2     *scale,
+                               void            *output,
+                               gint             n_samples,
+                               GeglAbyssPolicy  repeat_mode)
+{
+  guchar *out = output;
+
+  if (self->format == self->interpolate_format)
+    {
+      gint i;
+
+      for (i = 0; i < n_samples; i++)
+        {
+          const gfloat *in_bptr =
+            gegl_sampler_get_ptr (self,
+                                  (gint) floorf ((double) x),
+                                  (gint) floorf ((double) y),
+                                  repeat_mode);
+
+          memcpy (out, in_bptr, GEGL_SAMPLER_BPP);
+          out += GEGL_SAMPLER_BPP;
+          x   += dx;
+          y   += dy;
+        }
+    }
+  else
+    {
+      const gint    bpp = babl_format_get_bytes_per_pixel (self->format);
+      GeglRectangle run = {(gint) floorf ((double) x),
+                           (gint) floorf ((double) y), 1, 1};
+      gint          i;
+
+      for (i = 1; i < n_samples; i++)
+        {
+          gint ix, iy;
+
+          x += dx;
+          y += dy;
+          ix = floorf ((double) x);
+          iy = floorf ((double) y);
+
+          if (iy == run.y && ix == run.x + run.width)
+            {
+              run.width++;
+              continue;
+            }
+
+          gegl_buffer_get (self->buffer, &run, 1.0, self->format, out,
+                           GEGL_AUTO_ROWSTRIDE, repeat_mode);
+          out += run.width * bpp;
+
+          run.x     = ix;
+          run.y     = iy;
+          run.width = 1;
+        }
+
+      gegl_buffer_get (self->buffer, &run, 1.0, self->format, out,
+                       GEGL_AUTO_ROWSTRIDE, repeat_mode);
+    }
+}
 
 static void
 gegl_sampler_nearest_prepare (GeglSampler* restrict sampler)
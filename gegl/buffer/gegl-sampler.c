@@ -92,6 +92,7 @@ gegl_sampler_class_init (GeglSamplerClass *klass)
   klass->prepare    = NULL;
   klass->get        = NULL;
   klass->set_buffer = set_buffer;
+  klass->get_span   = NULL;
 
   object_class->set_property = set_property;
   object_class->get_property = get_property;
@@ -173,6 +174,46 @@ gegl_sampler_get (GeglSampler     *self,
   self->get (self, x, y, scale, output, repeat_mode);
 }
 
+void
+gegl_sampler_get_span (GeglSampler     *self,
+                       gdouble          x,
+                       gdouble          y,
+                       gdouble          dx,
+                       gdouble          dy,
+                       GeglMatrix2     *scale,
+                       void            *output,
+                       gint             n_samples,
+                       GeglAbyssPolicy  repeat_mode)
+{
+  GeglSamplerClass *klass = GEGL_SAMPLER_GET_CLASS (self);
+  guchar           *out   = output;
+  gint              bpp;
+  gint              i;
+
+  if (n_samples <= 0)
+    return;
+
+  if (gegl_cl_is_accelerated ())
+    gegl_buffer_cl_cache_flush (self->buffer, NULL);
+
+  if (klass->get_span)
+    {
+      klass->get_span (self, x, y, dx, dy, scale, output, n_samples,
+                       repeat_mode);
+      return;
+    }
+
+  bpp = babl_format_get_bytes_per_pixel (self->format);
+
+  for (i = 0; i < n_samples; i++)
+    {
+      self->get (self, x, y, scale, out, repeat_mode);
+      out += bpp;
+      x   += dx;
+      y   += dy;
+    }
+}
+
 void
 gegl_sampler_prepare (GeglSampler *self)
 {
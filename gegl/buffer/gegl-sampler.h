@@ -45,6 +45,12 @@ G_BEGIN_DECLS
 #define GEGL_SAMPLER_BPP 16
 #define GEGL_SAMPLER_ROWSTRIDE (GEGL_SAMPLER_MAXIMUM_WIDTH * GEGL_SAMPLER_BPP)
 
+/*
+ * Number of samples span implementations interpolate into a local
+ * buffer before converting them to the output format in one go.
+ */
+#define GEGL_SAMPLER_SPAN_CHUNK 64
+
 typedef struct _GeglSamplerClass GeglSamplerClass;
 
 typedef struct GeglSamplerLevel
@@ -84,6 +90,15 @@ struct _GeglSamplerClass
   GeglSamplerGetFun   get;
   void  (*set_buffer) (GeglSampler     *self,
                        GeglBuffer      *buffer);
+  void  (*get_span)   (GeglSampler     *self,
+                       gdouble          x,
+                       gdouble          y,
+                       gdouble          dx,
+                       gdouble          dy,
+                       GeglMatrix2     *scale,
+                       void            *output,
+                       gint             n_samples,
+                       GeglAbyssPolicy  repeat_mode);
 };
 
 GType gegl_sampler_get_type    (void) G_GNUC_CONST;
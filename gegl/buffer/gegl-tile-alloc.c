@@ -0,0 +1,170 @@
+/* This file is part of GEGL.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Allocation of tile data.
+ *
+ * While a graph is processed, buffers for intermediate results are created
+ * and destroyed all the time, and with them a lot of tiles, which only come
+ * in the few sizes given by the tile dimensions and pixel formats in use.
+ * Freed tile data is kept on a free list per size and thread, up to a total
+ * amount of memory, and handed out again by the next allocation of that size
+ * in the same thread rather than going through malloc.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include <glib-object.h>
+
+#include "gegl.h"
+#include "gegl-tile-alloc.h"
+
+#define N_SIZES    8
+#define KEEP_BYTES (32 * 1024 * 1024)
+
+typedef struct
+{
+  gsize    size;  /* the size of the blocks, 0 for an unused entry */
+  gpointer free;  /* freed blocks, linked through their first bytes */
+} FreeList;
+
+static void free_lists_destroy (gpointer data);
+
+/* every thread has its own free lists, so that the threads processing a
+ * graph don't contend for them, only the amount of memory kept is shared
+ */
+static GPrivate free_lists_private = G_PRIVATE_INIT (free_lists_destroy);
+static gint     kept_bytes;
+
+static void
+free_lists_destroy (gpointer data)
+{
+  FreeList *free_lists = data;
+  gint      i;
+
+  for (i = 0; i < N_SIZES; i++)
+    {
+      while (free_lists[i].free)
+        {
+          gpointer block = free_lists[i].free;
+
+          free_lists[i].free = *(gpointer *) block;
+          g_atomic_int_add (&kept_bytes, - (gint) free_lists[i].size);
+          gegl_free (block);
+        }
+    }
+
+  g_free (free_lists);
+}
+
+static inline FreeList *
+free_lists_get (void)
+{
+  FreeList *free_lists = g_private_get (&free_lists_private);
+
+  if (G_UNLIKELY (!free_lists))
+    {
+      free_lists = g_new0 (FreeList, N_SIZES);
+      g_private_set (&free_lists_private, free_lists);
+    }
+
+  return free_lists;
+}
+
+gpointer
+gegl_tile_alloc (gsize size)
+{
+  FreeList *free_lists = free_lists_get ();
+  gpointer  data       = NULL;
+  gint      i;
+
+  for (i = 0; i < N_SIZES && free_lists[i].size; i++)
+    {
+      if (free_lists[i].size == size)
+        {
+          data = free_lists[i].free;
+
+          if (data)
+            {
+              free_lists[i].free = *(gpointer *) data;
+              g_atomic_int_add (&kept_bytes, - (gint) size);
+            }
+          break;
+        }
+    }
+
+  if (!data)
+    data = gegl_malloc (size);
+
+  return data;
+}
+
+gpointer
+gegl_tile_alloc0 (gsize size)
+{
+  gpointer data = gegl_tile_alloc (size);
+
+  memset (data, 0, size);
+
+  return data;
+}
+
+void
+gegl_tile_free (gpointer data,
+                gsize    size)
+{
+  FreeList *free_lists;
+  gint      i;
+
+  if (size < sizeof (gpointer) || size > KEEP_BYTES)
+    {
+      gegl_free (data);
+      return;
+    }
+
+  free_lists = free_lists_get ();
+
+  for (i = 0; i < N_SIZES; i++)
+    {
+      if (free_lists[i].size == 0)
+        free_lists[i].size = size;
+
+      if (free_lists[i].size == size)
+        {
+          if (g_atomic_int_add (&kept_bytes, size) + (gint) size > KEEP_BYTES)
+            {
+              g_atomic_int_add (&kept_bytes, - (gint) size);
+              break;
+            }
+
+          *(gpointer *) data = free_lists[i].free;
+          free_lists[i].free = data;
+          return;
+        }
+    }
+
+  gegl_free (data);
+}
+
+void
+gegl_tile_alloc_cleanup (void)
+{
+  /* the lists of other threads are freed as they exit, the scheduler
+   * joins its workers before this is called
+   */
+  g_private_replace (&free_lists_private, NULL);
+}
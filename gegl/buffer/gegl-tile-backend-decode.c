@@ -0,0 +1,157 @@
+/* This file is part of GEGL.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include <glib-object.h>
+
+#include "gegl-buffer-backend.h"
+#include "gegl-tile-backend.h"
+#include "gegl-tile-backend-decode.h"
+
+G_DEFINE_TYPE (GeglTileBackendDecode, gegl_tile_backend_decode, GEGL_TYPE_TILE_BACKEND_RAM)
+#define parent_class gegl_tile_backend_decode_parent_class
+
+static inline gboolean
+in_image (GeglTileBackendDecode *self,
+          gint                   x,
+          gint                   y,
+          gint                   z)
+{
+  return z == 0 &&
+         x >= 0 && x < self->columns &&
+         y >= 0 && y < self->rows;
+}
+
+static GeglTile *
+decode_tile (GeglTileBackendDecode *self,
+             gint                   x,
+             gint                   y)
+{
+  GeglTileBackend *backend   = GEGL_TILE_BACKEND (self);
+  gint             tile_size = gegl_tile_backend_get_tile_size (backend);
+  GeglTile        *tile;
+
+  tile = gegl_tile_new (tile_size);
+
+  if (!self->decode (x, y, gegl_tile_get_data (tile), self->user_data))
+    memset (gegl_tile_get_data (tile), 0, tile_size);
+
+  /* the file holds the tile, there is nothing to store */
+  gegl_tile_mark_as_stored (tile);
+
+  return tile;
+}
+
+static gpointer
+gegl_tile_backend_decode_command (GeglTileSource  *tile_store,
+                                  GeglTileCommand  command,
+                                  gint             x,
+                                  gint             y,
+                                  gint             z,
+                                  gpointer         data)
+{
+  GeglTileBackendDecode *self = GEGL_TILE_BACKEND_DECODE (tile_store);
+
+  switch (command)
+    {
+      case GEGL_TILE_GET:
+        {
+          /* tiles written to the buffer take precedence */
+          GeglTile *tile = self->ram_command (tile_store, command,
+                                              x, y, z, data);
+
+          if (!tile && in_image (self, x, y, z))
+            tile = decode_tile (self, x, y);
+
+          return tile;
+        }
+
+      case GEGL_TILE_EXIST:
+        if (in_image (self, x, y, z))
+          return GINT_TO_POINTER (TRUE);
+        break;
+
+      default:
+        break;
+    }
+
+  return self->ram_command (tile_store, command, x, y, z, data);
+}
+
+static void
+gegl_tile_backend_decode_finalize (GObject *object)
+{
+  GeglTileBackendDecode *self = GEGL_TILE_BACKEND_DECODE (object);
+
+  if (self->destroy_notify)
+    self->destroy_notify (self->user_data);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
+static void
+gegl_tile_backend_decode_class_init (GeglTileBackendDecodeClass *klass)
+{
+  GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+
+  gobject_class->finalize = gegl_tile_backend_decode_finalize;
+}
+
+static void
+gegl_tile_backend_decode_init (GeglTileBackendDecode *self)
+{
+  /* the ram backend keeps the tiles written to the buffer */
+  self->ram_command = GEGL_TILE_SOURCE (self)->command;
+
+  GEGL_TILE_SOURCE (self)->command = gegl_tile_backend_decode_command;
+}
+
+GeglTileBackend *
+gegl_tile_backend_decode_new (gint                width,
+                              gint                height,
+                              gint                tile_width,
+                              gint                tile_height,
+                              const Babl         *format,
+                              GeglTileDecodeFunc  decode,
+                              gpointer            user_data,
+                              GDestroyNotify      destroy_notify)
+{
+  GeglTileBackendDecode *self;
+  GeglRectangle          extent = {0, 0, width, height};
+
+  g_return_val_if_fail (tile_width > 0 && tile_height > 0, NULL);
+  g_return_val_if_fail (format != NULL, NULL);
+  g_return_val_if_fail (decode != NULL, NULL);
+
+  self = g_object_new (GEGL_TYPE_TILE_BACKEND_DECODE,
+                       "tile-width",  tile_width,
+                       "tile-height", tile_height,
+                       "format",      format,
+                       NULL);
+
+  self->columns        = (width  + tile_width  - 1) / tile_width;
+  self->rows           = (height + tile_height - 1) / tile_height;
+  self->decode         = decode;
+  self->user_data      = user_data;
+  self->destroy_notify = destroy_notify;
+
+  gegl_tile_backend_set_extent (GEGL_TILE_BACKEND (self), &extent);
+
+  return GEGL_TILE_BACKEND (self);
+}
@@ -0,0 +1,102 @@
+/* This file is part of GEGL.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GEGL_TILE_BACKEND_DECODE_H__
+#define __GEGL_TILE_BACKEND_DECODE_H__
+
+#include "gegl-tile-backend-ram.h"
+
+/***
+ * GeglTileBackendDecode is a GeglTileBackend for the tiles of an image file,
+ * used by loaders. A tile is decoded from the file the first time it is
+ * asked for, tiles written to the buffer are kept in RAM.
+ */
+
+G_BEGIN_DECLS
+
+#define GEGL_TYPE_TILE_BACKEND_DECODE            (gegl_tile_backend_decode_get_type ())
+#define GEGL_TILE_BACKEND_DECODE(obj)            (G_TYPE_CHECK_INSTANCE_CAST ((obj), GEGL_TYPE_TILE_BACKEND_DECODE, GeglTileBackendDecode))
+#define GEGL_TILE_BACKEND_DECODE_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST ((klass),  GEGL_TYPE_TILE_BACKEND_DECODE, GeglTileBackendDecodeClass))
+#define GEGL_IS_TILE_BACKEND_DECODE(obj)         (G_TYPE_CHECK_INSTANCE_TYPE ((obj), GEGL_TYPE_TILE_BACKEND_DECODE))
+#define GEGL_IS_TILE_BACKEND_DECODE_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE ((klass),  GEGL_TYPE_TILE_BACKEND_DECODE))
+#define GEGL_TILE_BACKEND_DECODE_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS ((obj),  GEGL_TYPE_TILE_BACKEND_DECODE, GeglTileBackendDecodeClass))
+
+typedef struct _GeglTileBackendDecode      GeglTileBackendDecode;
+typedef struct _GeglTileBackendDecodeClass GeglTileBackendDecodeClass;
+
+/* Fills @data with the pixels of the tile at column @x and row @y, laid
+ * out like the tiles of the backend. Returns FALSE when the tile could not
+ * be decoded, it is then left transparent.
+ */
+typedef gboolean (* GeglTileDecodeFunc) (gint     x,
+                                         gint     y,
+                                         guchar  *data,
+                                         gpointer user_data);
+
+struct _GeglTileBackendDecode
+{
+  GeglTileBackendRam  parent_instance;
+
+  gpointer          (*ram_command) (GeglTileSource  *source,
+                                    GeglTileCommand  command,
+                                    gint             x,
+                                    gint             y,
+                                    gint             z,
+                                    gpointer         data);
+
+  gint                columns;
+  gint                rows;
+
+  GeglTileDecodeFunc  decode;
+  gpointer            user_data;
+  GDestroyNotify      destroy_notify;
+};
+
+struct _GeglTileBackendDecodeClass
+{
+  GeglTileBackendRamClass parent_class;
+};
+
+GType gegl_tile_backend_decode_get_type (void) G_GNUC_CONST;
+
+/**
+ * gegl_tile_backend_decode_new:
+ * @width: width of the image
+ * @height: height of the image
+ * @tile_width: width of the tiles in the file
+ * @tile_height: height of the tiles in the file
+ * @format: the format of the decoded pixels
+ * @decode: the function decoding a tile
+ * @user_data: passed to @decode
+ * @destroy_notify: called on @user_data when the backend is finalized
+ *
+ * Creates a backend covering @width × @height pixels with tiles of the
+ * size of those in the file, for use with gegl_buffer_new_for_backend().
+ * Tiles are decoded with @decode on demand, and not kept by the backend;
+ * a tile dropped from the tile cache is decoded again.
+ */
+GeglTileBackend * gegl_tile_backend_decode_new (gint                width,
+                                                gint                height,
+                                                gint                tile_width,
+                                                gint                tile_height,
+                                                const Babl         *format,
+                                                GeglTileDecodeFunc  decode,
+                                                gpointer            user_data,
+                                                GDestroyNotify      destroy_notify);
+
+G_END_DECLS
+
+#endif
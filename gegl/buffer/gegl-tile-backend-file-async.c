@@ -49,6 +49,7 @@
 #include "gegl-tile-backend.h"
 #include "gegl-tile-backend-file.h"
 #include "gegl-buffer-index.h"
+#include "gegl-buffer-codec.h"
 #include "gegl-buffer-types.h"
 #include "gegl-debug.h"
 #include "gegl-config.h"
@@ -91,6 +92,9 @@ struct _GeglTileBackendFile
   /* offset to next pre allocated tile slot */
   guint            next_pre_alloc;
 
+  /* the highest mipmap level of the tiles in the file */
+  gint             max_z;
+
   /* revision of last index sync, for cooperated sharing of a buffer
    * file
    */
@@ -115,9 +119,6 @@ struct _GeglTileBackendFile
    */
   GeglFileBackendEntry *in_holding;
 
-  /* loading buffer */
-  GList           *tiles;
-
   /* GFile refering to our buffer */
   GFile           *file;
 
@@ -311,9 +312,12 @@ gegl_tile_backend_file_entry_read (GeglTileBackendFile  *self,
                                    GeglFileBackendEntry *entry,
                                    guchar               *dest)
 {
-  gint    tile_size  = gegl_tile_backend_get_tile_size (GEGL_TILE_BACKEND (self));
-  gint    to_be_read = tile_size;
-  goffset offset     = entry->tile->offset;
+  gint     tile_size  = gegl_tile_backend_get_tile_size (GEGL_TILE_BACKEND (self));
+  gint     length     = tile_size;
+  gint     to_be_read;
+  goffset  offset     = entry->tile->offset;
+  gboolean encoded;
+  guchar  *data;
 
   gegl_tile_backend_file_ensure_exist (self);
 
@@ -330,7 +334,7 @@ gegl_tile_backend_file_entry_read (GeglTileBackendFile  *self,
 
       if (queued_op)
         {
-          memcpy (dest, queued_op->source, to_be_read);
+          memcpy (dest, queued_op->source, tile_size);
           g_mutex_unlock (&mutex);
 
           GEGL_NOTE (GEGL_DEBUG_TILE_BACKEND, "read entry %i,%i,%i from queue", entry->tile->x, entry->tile->y, entry->tile->z);
@@ -341,11 +345,28 @@ gegl_tile_backend_file_entry_read (GeglTileBackendFile  *self,
       g_mutex_unlock (&mutex);
     }
 
+  /* compressed or shuffled tiles are read whole and decoded into dest */
+  encoded = entry->codec != GEGL_TILE_CODEC_NONE || entry->shuffle > 1;
+
+  if (encoded)
+    {
+      length = entry->size;
+      data   = g_malloc (length);
+    }
+  else
+    {
+      data = dest;
+    }
+
+  to_be_read = length;
+
   if (self->in_offset != offset)
     {
       if (lseek (self->i, offset, SEEK_SET) < 0)
         {
           g_warning ("unable to seek to tile in buffer: %s", g_strerror (errno));
+          if (encoded)
+            g_free (data);
           return;
         }
       self->in_offset = offset;
@@ -356,18 +377,38 @@ gegl_tile_backend_file_entry_read (GeglTileBackendFile  *self,
       GError *error = NULL;
       gint    byte_read;
 
-      byte_read = read (self->i, dest + tile_size - to_be_read, to_be_read);
+      byte_read = read (self->i, data + length - to_be_read, to_be_read);
       if (byte_read <= 0)
         {
           g_message ("unable to read tile data from self: "
                      "%s (%d/%d bytes read) %s",
                      g_strerror (errno), byte_read, to_be_read, error?error->message:"--");
+          if (encoded)
+            g_free (data);
           return;
         }
       to_be_read      -= byte_read;
       self->in_offset += byte_read;
     }
 
+  if (encoded)
+    {
+      GeglBufferTableEntry stored = { 0, };
+
+      stored.size    = entry->size;
+      stored.codec   = entry->codec;
+      stored.shuffle = entry->shuffle;
+
+      if (!gegl_buffer_codec_decode (&stored, data, dest, tile_size))
+        {
+          g_warning ("%s: corrupt tile %i,%i,%i", G_STRFUNC,
+                     entry->tile->x, entry->tile->y, entry->tile->z);
+          memset (dest, 0, tile_size);
+        }
+
+      g_free (data);
+    }
+
   GEGL_NOTE (GEGL_DEBUG_TILE_BACKEND, "read entry %i,%i,%i at %i", entry->tile->x, entry->tile->y, entry->tile->z, (gint)offset);
 }
 
@@ -430,30 +471,27 @@ gegl_tile_backend_file_file_entry_create (gint x,
   return entry;
 }
 
-static inline GeglFileBackendEntry *
-gegl_tile_backend_file_file_entry_new (GeglTileBackendFile *self)
+static guint64
+gegl_tile_backend_file_alloc_slot (GeglTileBackendFile *self)
 {
-  GeglFileBackendEntry *entry = gegl_tile_backend_file_file_entry_create (0,0,0);
-
-  GEGL_NOTE (GEGL_DEBUG_TILE_BACKEND, "Creating new entry");
-
-  gegl_tile_backend_file_ensure_exist (self);
+  guint64 offset;
 
   if (self->free_list)
     {
-      guint64 offset = *(guint64*)self->free_list->data;
+      guint64 *slot = self->free_list->data;
 
-      entry->tile->offset = offset;
-      self->free_list = g_slist_remove (self->free_list, self->free_list->data);
+      offset          = *slot;
+      self->free_list = g_slist_remove (self->free_list, slot);
+      g_free (slot);
 
-      GEGL_NOTE (GEGL_DEBUG_TILE_BACKEND, "  set offset %i from free list", ((gint)entry->tile->offset));
+      GEGL_NOTE (GEGL_DEBUG_TILE_BACKEND, "  set offset %i from free list", ((gint)offset));
     }
   else
     {
       gint tile_size = gegl_tile_backend_get_tile_size (GEGL_TILE_BACKEND (self));
 
-      entry->tile->offset = self->next_pre_alloc;
-      GEGL_NOTE (GEGL_DEBUG_TILE_BACKEND, "  set offset %i (next allocation)", (gint)entry->tile->offset);
+      offset = self->next_pre_alloc;
+      GEGL_NOTE (GEGL_DEBUG_TILE_BACKEND, "  set offset %i (next allocation)", (gint)offset);
       self->next_pre_alloc += tile_size;
 
       if (self->next_pre_alloc >= self->total) /* automatic growing ensuring that
@@ -474,7 +512,26 @@ gegl_tile_backend_file_file_entry_new (GeglTileBackendFile *self)
           self->in_offset = self->out_offset = -1;
         }
     }
-  gegl_tile_backend_file_dbg_alloc (gegl_tile_backend_get_tile_size (GEGL_TILE_BACKEND (self)));
+
+  return offset;
+}
+
+static inline GeglFileBackendEntry *
+gegl_tile_backend_file_file_entry_new (GeglTileBackendFile *self)
+{
+  GeglFileBackendEntry *entry = gegl_tile_backend_file_file_entry_create (0,0,0);
+  gint                  tile_size = gegl_tile_backend_get_tile_size (GEGL_TILE_BACKEND (self));
+
+  GEGL_NOTE (GEGL_DEBUG_TILE_BACKEND, "Creating new entry");
+
+  gegl_tile_backend_file_ensure_exist (self);
+
+  entry->tile->offset = gegl_tile_backend_file_alloc_slot (self);
+  entry->size         = tile_size;
+  entry->codec        = GEGL_TILE_CODEC_NONE;
+  entry->shuffle      = 0;
+
+  gegl_tile_backend_file_dbg_alloc (tile_size);
   return entry;
 }
 
@@ -482,8 +539,7 @@ static void
 gegl_tile_backend_file_file_entry_destroy (GeglTileBackendFile  *self,
                                            GeglFileBackendEntry *entry)
 {
-  guint64 *offset = g_new (guint64, 1);
-  *offset = entry->tile->offset;
+  gint tile_size = gegl_tile_backend_get_tile_size (GEGL_TILE_BACKEND (self));
 
   if (entry->tile_link || entry->block_link)
     {
@@ -509,10 +565,17 @@ gegl_tile_backend_file_file_entry_destroy (GeglTileBackendFile  *self,
       g_mutex_unlock (&mutex);
     }
 
-  self->free_list = g_slist_prepend (self->free_list, offset);
+  /* the space of a compressed tile is too small to hold another tile */
+  if (entry->size >= tile_size)
+    {
+      guint64 *offset = g_new (guint64, 1);
+      *offset = entry->tile->offset;
+
+      self->free_list = g_slist_prepend (self->free_list, offset);
+    }
   g_hash_table_remove (self->index, entry);
 
-  gegl_tile_backend_file_dbg_dealloc (gegl_tile_backend_get_tile_size (GEGL_TILE_BACKEND (self)));
+  gegl_tile_backend_file_dbg_dealloc (tile_size);
 
   g_free (entry->tile);
   g_free (entry);
@@ -553,6 +616,56 @@ gegl_tile_backend_file_write_header (GeglTileBackendFile *self)
   return TRUE;
 }
 
+static void
+gegl_tile_backend_file_write_table (GeglTileBackendFile *self,
+                                    GList               *tiles)
+{
+  GeglFileBackendThreadParams *params;
+  GeglBufferBlock             *block;
+  GeglBufferTableEntry        *table;
+  GList                       *iter;
+  gint                         length;
+  gint                         i;
+
+  length = sizeof (GeglBufferBlock) +
+           g_list_length (tiles) * sizeof (GeglBufferTableEntry);
+  block  = g_malloc0 (length);
+  table  = (GeglBufferTableEntry *) (block + 1);
+
+  block->length = length;
+  block->flags  = GEGL_FLAG_TILE_TABLE;
+  block->next   = 0;
+
+  for (iter = tiles, i = 0; iter; iter = iter->next, i++)
+    {
+      GeglFileBackendEntry *entry = iter->data;
+
+      table[i].offset  = entry->tile->offset;
+      table[i].size    = entry->size;
+      table[i].codec   = entry->codec;
+      table[i].shuffle = entry->shuffle;
+      table[i].x       = entry->tile->x;
+      table[i].y       = entry->tile->y;
+      table[i].z       = entry->tile->z;
+      table[i].rev     = entry->tile->rev;
+    }
+
+  /* the table follows the tiles, aligned as gegl_buffer_save () does */
+  self->header.next = (self->next_pre_alloc + 7) & ~7;
+
+  params            = g_new0 (GeglFileBackendThreadParams, 1);
+  params->operation = OP_WRITE;
+  params->source    = (guchar *) block;
+  params->offset    = self->header.next;
+  params->length    = length;
+  params->file      = self;
+
+  gegl_tile_backend_file_push_queue (params);
+
+  GEGL_NOTE (GEGL_DEBUG_TILE_BACKEND, "pushed write of table of %i tiles at offset %i",
+             i, (gint)self->header.next);
+}
+
 static gboolean
 gegl_tile_backend_file_write_block (GeglTileBackendFile  *self,
                                     GeglFileBackendEntry *item)
@@ -732,7 +845,18 @@ gegl_tile_backend_file_set_tile (GeglTileSource *self,
       entry->tile->z = z;
       g_hash_table_insert (tile_backend_file->index, entry, entry);
     }
+  else if (entry->size < gegl_tile_backend_get_tile_size (backend))
+    {
+      /* the tile was stored compressed and its space is too small for the
+       * raw data, which is written to a new slot instead, the old space
+       * stays unused until the buffer is saved anew
+       */
+      entry->tile->offset = gegl_tile_backend_file_alloc_slot (tile_backend_file);
+    }
   entry->tile->rev = gegl_tile_get_rev (tile);
+  entry->size      = gegl_tile_backend_get_tile_size (backend);
+  entry->codec     = GEGL_TILE_CODEC_NONE;
+  entry->shuffle   = 0;
 
   gegl_tile_backend_file_entry_write (tile_backend_file, entry, gegl_tile_get_data (tile));
   gegl_tile_mark_as_stored (tile);
@@ -804,7 +928,14 @@ gegl_tile_backend_file_flush (GeglTileSource *source,
                                                out headers from*/
   tiles = g_hash_table_get_keys (self->index);
 
-  if (tiles == NULL)
+  if (gegl_buffer_header_get_rev (&self->header) >= GEGL_FILE_SPEC_REV_TABLE)
+    {
+      /* files written by gegl_buffer_save () keep their layout, with the
+       * index as one table
+       */
+      gegl_tile_backend_file_write_table (self, tiles);
+    }
+  else if (tiles == NULL)
     self->header.next = 0;
   else
     {
@@ -816,8 +947,8 @@ gegl_tile_backend_file_flush (GeglTileSource *source,
           gegl_tile_backend_file_write_block (self, item);
         }
       gegl_tile_backend_file_write_block (self, NULL); /* terminate the index */
-      g_list_free (tiles);
     }
+  g_list_free (tiles);
 
   gegl_tile_backend_file_write_header (self);
 
@@ -1028,12 +1159,13 @@ static void
 gegl_tile_backend_file_load_index (GeglTileBackendFile *self,
                                    gboolean             block)
 {
-  GeglBufferHeader  new_header;
-  GList            *iter;
-  GeglTileBackend  *backend;
-  goffset           offset = 0;
-  goffset           max    = 0;
-  gint              tile_size;
+  GeglBufferHeader      new_header;
+  GeglBufferTableEntry *table;
+  GeglTileBackend      *backend;
+  goffset               offset = 0;
+  goffset               max    = 0;
+  gint                  n_entries;
+  gint                  i;
 
   /* compute total from and next pre alloc by monitoring tiles as they
    * are added here
@@ -1058,29 +1190,30 @@ gegl_tile_backend_file_load_index (GeglTileBackendFile *self,
       GEGL_NOTE(GEGL_DEBUG_TILE_BACKEND, "loading index: %s", self->path);
     }
 
-  tile_size       = gegl_tile_backend_get_tile_size (GEGL_TILE_BACKEND (self));
-  offset          = self->header.next;
-  self->tiles     = gegl_buffer_read_index (self->i, &offset);
+  /* the index of either revision is read as a table, the entries of
+   * revision 0 files are stored uncompressed
+   */
+  table           = gegl_buffer_read_table (self->i, &self->header, &n_entries);
   self->in_offset = self->out_offset = -1;
   backend         = GEGL_TILE_BACKEND (self);
 
-  for (iter = self->tiles; iter; iter=iter->next)
+  for (i = 0; i < n_entries; i++)
     {
-      GeglBufferItem       *item     = iter->data;
+      GeglBufferTableEntry *item     = &table[i];
       GeglFileBackendEntry *new;
       GeglFileBackendEntry *existing =
-        gegl_tile_backend_file_lookup_entry (self, item->tile.x, item->tile.y, item->tile.z);
+        gegl_tile_backend_file_lookup_entry (self, item->x, item->y, item->z);
+
+      if (item->offset + item->size > max)
+        max = item->offset + item->size;
 
-      if (item->tile.offset > max)
-        max = item->tile.offset + tile_size;
+      self->max_z = MAX (self->max_z, item->z);
 
       if (existing)
         {
-          if (existing->tile->rev == item->tile.rev)
+          if (existing->tile->rev == item->rev)
             {
-              g_assert (existing->tile->offset == item->tile.offset);
-              *existing->tile = item->tile;
-              g_free (item);
+              g_assert (existing->tile->offset == item->offset);
               continue;
             }
           else
@@ -1108,15 +1241,25 @@ gegl_tile_backend_file_load_index (GeglTileBackendFile *self,
               g_signal_emit_by_name (storage, "changed", &rect, NULL);
             }
         }
-      new = gegl_tile_backend_file_file_entry_create (0, 0, 0);
-      new->tile = iter->data;
+      new = gegl_tile_backend_file_file_entry_create (item->x, item->y, item->z);
+      new->tile->offset = item->offset;
+      new->tile->rev    = item->rev;
+      new->size         = item->size;
+      new->codec        = item->codec;
+      new->shuffle      = item->shuffle;
       g_hash_table_insert (self->index, new, new);
     }
-  g_list_free (self->tiles);
+  g_free (table);
+
+  /* new tiles are appended with the alignment gegl_buffer_save () gives
+   * them
+   */
+  if (gegl_buffer_header_get_rev (&self->header) >= GEGL_FILE_SPEC_REV_TABLE)
+    max = (max + 7) & ~7;
+
   gegl_tile_backend_file_free_free_list (self);
   self->next_pre_alloc = max; /* if bigger than own? */
   self->total          = max;
-  self->tiles          = NULL;
 }
 
 static void
@@ -1328,3 +1471,9 @@ gegl_tile_backend_file_unlock (GeglTileBackendFile *self)
 
   return TRUE;
 }
+
+gint
+gegl_tile_backend_file_get_max_z (GeglTileBackendFile *self)
+{
+  return self->max_z;
+}
@@ -54,6 +54,11 @@ typedef struct
      tile data or a GeglBufferBlock*/
   GList          *tile_link;
   GList          *block_link;
+  /* the number of bytes stored for the tile and how they are encoded,
+     tiles in files written by gegl_buffer_save() can be compressed */
+  guint32         size;
+  guint16         codec;
+  guint16         shuffle;
 } GeglFileBackendEntry;
 
 typedef struct
@@ -79,6 +84,8 @@ void  gegl_tile_backend_file_stats    (void);
 gboolean gegl_tile_backend_file_try_lock (GeglTileBackendFile *file);
 gboolean gegl_tile_backend_file_unlock   (GeglTileBackendFile *file);
 
+gint     gegl_tile_backend_file_get_max_z (GeglTileBackendFile *file);
+
 G_END_DECLS
 
 #endif
@@ -0,0 +1,372 @@
+/* This file is part of GEGL.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <string.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+#ifdef HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#endif
+
+#include <glib-object.h>
+#include <glib/gstdio.h>
+
+#include "gegl.h"
+#include "gegl-buffer-backend.h"
+#include "gegl-tile-backend.h"
+#include "gegl-tile-backend-mmap.h"
+#include "gegl-buffer-codec.h"
+#include "gegl-debug.h"
+
+/* We need the private header to hand out tiles attached to the storage */
+#include "gegl-buffer-private.h"
+
+typedef struct
+{
+  gint     ref_count;
+  guchar  *data;
+  gsize    size;
+} MmapMapping;
+
+typedef struct
+{
+  GeglBufferTableEntry  stored;  /* where and how the tile is stored */
+  GeglTile             *anchor;  /* shares the mapped data with the tiles
+                                  * handed out, for uncompressed tiles */
+} MmapEntry;
+
+G_DEFINE_TYPE (GeglTileBackendMmap, gegl_tile_backend_mmap, GEGL_TYPE_TILE_BACKEND_RAM)
+#define parent_class gegl_tile_backend_mmap_parent_class
+
+static guint
+mmap_entry_hash (gconstpointer key)
+{
+  const MmapEntry *e = key;
+
+  return (e->stored.x * 73856093) ^ (e->stored.y * 19349663) ^
+         (e->stored.z * 83492791);
+}
+
+static gboolean
+mmap_entry_equal (gconstpointer a,
+                  gconstpointer b)
+{
+  const MmapEntry *ea = a;
+  const MmapEntry *eb = b;
+
+  return ea->stored.x == eb->stored.x &&
+         ea->stored.y == eb->stored.y &&
+         ea->stored.z == eb->stored.z;
+}
+
+static MmapEntry *
+lookup_entry (GeglTileBackendMmap *self,
+              gint                 x,
+              gint                 y,
+              gint                 z)
+{
+  MmapEntry key;
+
+  key.stored.x = x;
+  key.stored.y = y;
+  key.stored.z = z;
+
+  return g_hash_table_lookup (self->entries, &key);
+}
+
+static void
+mapping_unref (gpointer data)
+{
+  MmapMapping *mapping = data;
+
+  if (!g_atomic_int_dec_and_test (&mapping->ref_count))
+    return;
+
+#ifdef HAVE_SYS_MMAN_H
+  munmap (mapping->data, mapping->size);
+#endif
+  g_slice_free (MmapMapping, mapping);
+}
+
+static void
+mmap_entry_free (gpointer data)
+{
+  MmapEntry *entry = data;
+
+  if (entry->anchor)
+    gegl_tile_unref (entry->anchor);
+  g_slice_free (MmapEntry, entry);
+}
+
+static GeglTile *
+get_tile (GeglTileSource *source,
+          gint            x,
+          gint            y,
+          gint            z)
+{
+  GeglTileBackendMmap *self = GEGL_TILE_BACKEND_MMAP (source);
+  GeglTileBackend     *backend = GEGL_TILE_BACKEND (source);
+  MmapMapping         *mapping = self->mapping;
+  MmapEntry           *entry;
+  GeglTile            *tile;
+  gint                 tile_size;
+
+  /* tiles that have been written take precedence over the file */
+  tile = self->ram_command (source, GEGL_TILE_GET, x, y, z, NULL);
+  if (tile)
+    return tile;
+
+  entry = lookup_entry (self, x, y, z);
+  if (!entry)
+    return NULL;
+
+  tile_size = gegl_tile_backend_get_tile_size (backend);
+
+  /* the tiles are used in place when their data is aligned for any
+   * pixel type
+   */
+  if (entry->stored.codec != GEGL_TILE_CODEC_NONE ||
+      entry->stored.shuffle > 1 ||
+      entry->stored.offset % sizeof (gdouble))
+    {
+      tile = gegl_tile_new (tile_size);
+
+      if (!gegl_buffer_codec_decode (&entry->stored,
+                                     mapping->data + entry->stored.offset,
+                                     gegl_tile_get_data (tile), tile_size))
+        {
+          g_warning ("%s: corrupt tile %i,%i,%i", G_STRFUNC, x, y, z);
+          memset (gegl_tile_get_data (tile), 0, tile_size);
+        }
+
+      return tile;
+    }
+
+  if (!entry->anchor)
+    {
+      entry->anchor = gegl_tile_new_bare ();
+      g_atomic_int_inc (&mapping->ref_count);
+      gegl_tile_set_data_full (entry->anchor,
+                               mapping->data + entry->stored.offset,
+                               tile_size, mapping_unref, mapping);
+    }
+
+  /* the tile shares its data with the anchor, so locking it for writing
+   * makes a private copy instead of touching the read-only mapping. It is
+   * attached to the storage right away, since attaching it later locks
+   * it.
+   */
+  tile = gegl_tile_dup (entry->anchor);
+  tile->tile_storage =
+    (GeglTileStorage *) gegl_tile_backend_peek_storage (backend);
+
+  return tile;
+}
+
+static gboolean
+exist_tile (GeglTileSource *source,
+            gint            x,
+            gint            y,
+            gint            z)
+{
+  GeglTileBackendMmap *self = GEGL_TILE_BACKEND_MMAP (source);
+
+  if (self->ram_command (source, GEGL_TILE_EXIST, x, y, z, NULL))
+    return TRUE;
+
+  return lookup_entry (self, x, y, z) != NULL;
+}
+
+static void
+void_tile (GeglTileSource *source,
+           GeglTile       *tile,
+           gint            x,
+           gint            y,
+           gint            z)
+{
+  GeglTileBackendMmap *self = GEGL_TILE_BACKEND_MMAP (source);
+
+  MmapEntry            key;
+
+  self->ram_command (source, GEGL_TILE_VOID, x, y, z, tile);
+
+  key.stored.x = x;
+  key.stored.y = y;
+  key.stored.z = z;
+  g_hash_table_remove (self->entries, &key);
+}
+
+static gpointer
+gegl_tile_backend_mmap_command (GeglTileSource  *tile_store,
+                                GeglTileCommand  command,
+                                gint             x,
+                                gint             y,
+                                gint             z,
+                                gpointer         data)
+{
+  GeglTileBackendMmap *self = GEGL_TILE_BACKEND_MMAP (tile_store);
+
+  switch (command)
+    {
+      case GEGL_TILE_GET:
+        return get_tile (tile_store, x, y, z);
+
+      case GEGL_TILE_VOID:
+        void_tile (tile_store, data, x, y, z);
+        return NULL;
+
+      case GEGL_TILE_EXIST:
+        return GINT_TO_POINTER (exist_tile (tile_store, x, y, z));
+
+      default:
+        return self->ram_command (tile_store, command, x, y, z, data);
+    }
+}
+
+static void
+gegl_tile_backend_mmap_finalize (GObject *object)
+{
+  GeglTileBackendMmap *self = GEGL_TILE_BACKEND_MMAP (object);
+
+  g_hash_table_unref (self->entries);
+
+  if (self->mapping)
+    mapping_unref (self->mapping);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
+static void
+gegl_tile_backend_mmap_class_init (GeglTileBackendMmapClass *klass)
+{
+  GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+
+  gobject_class->finalize = gegl_tile_backend_mmap_finalize;
+}
+
+static void
+gegl_tile_backend_mmap_init (GeglTileBackendMmap *self)
+{
+  /* keep the command of the ram backend for the tiles written to us */
+  self->ram_command = GEGL_TILE_SOURCE (self)->command;
+  GEGL_TILE_SOURCE (self)->command = gegl_tile_backend_mmap_command;
+
+  self->entries = g_hash_table_new_full (mmap_entry_hash, mmap_entry_equal,
+                                         NULL, mmap_entry_free);
+}
+
+GeglTileBackend *
+gegl_tile_backend_mmap_new (const gchar      *path,
+                            GeglBufferHeader *header)
+{
+#ifdef HAVE_SYS_MMAN_H
+  GeglTileBackendMmap  *self;
+  GeglBufferItem       *item;
+  GeglBufferTableEntry *table;
+  MmapMapping          *mapping;
+  struct stat           st;
+  goffset               offset;
+  gpointer              data;
+  gint                  n_entries;
+  gint                  tile_size;
+  gint                  fd;
+  gint                  i;
+
+  fd = g_open (path, O_RDONLY, 0);
+  if (fd == -1)
+    return NULL;
+
+  if (fstat (fd, &st) == -1 || st.st_size < sizeof (GeglBufferHeader))
+    {
+      close (fd);
+      return NULL;
+    }
+
+  item = gegl_buffer_read_header (fd, &offset);
+  *header = item->header;
+  g_free (item);
+
+  if (strncmp (header->magic, "GEGL", 4))
+    {
+      close (fd);
+      return NULL;
+    }
+
+  table = gegl_buffer_read_table (fd, header, &n_entries);
+
+  data = mmap (NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close (fd);
+
+  if (!table || data == MAP_FAILED)
+    {
+      GEGL_NOTE (GEGL_DEBUG_BUFFER_LOAD, "failed to map %s", path);
+      if (data != MAP_FAILED)
+        munmap (data, st.st_size);
+      g_free (table);
+      return NULL;
+    }
+
+  mapping = g_slice_new (MmapMapping);
+  mapping->ref_count = 1;
+  mapping->data      = data;
+  mapping->size      = st.st_size;
+
+  self = g_object_new (GEGL_TYPE_TILE_BACKEND_MMAP,
+                       "tile-width",  header->tile_width,
+                       "tile-height", header->tile_height,
+                       "format",      babl_format (header->description),
+                       NULL);
+  self->mapping = mapping;
+
+  tile_size = gegl_tile_backend_get_tile_size (GEGL_TILE_BACKEND (self));
+
+  for (i = 0; i < n_entries; i++)
+    {
+      MmapEntry *entry;
+
+      if (table[i].size > tile_size ||
+          table[i].offset + table[i].size > mapping->size)
+        {
+          g_warning ("%s: can't map tile %i,%i,%i of %s",
+                     G_STRFUNC, table[i].x, table[i].y, table[i].z, path);
+          continue;
+        }
+
+      entry = g_slice_new (MmapEntry);
+      entry->stored = table[i];
+      entry->anchor = NULL;
+      g_hash_table_insert (self->entries, entry, entry);
+
+      self->max_z = MAX (self->max_z, table[i].z);
+    }
+
+  g_free (table);
+
+  GEGL_NOTE (GEGL_DEBUG_BUFFER_LOAD, "mapped %i tiles of %s",
+             g_hash_table_size (self->entries), path);
+
+  return GEGL_TILE_BACKEND (self);
+#else
+  return NULL;
+#endif
+}
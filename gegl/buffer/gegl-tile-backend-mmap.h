@@ -0,0 +1,77 @@
+/* This file is part of GEGL.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GEGL_TILE_BACKEND_MMAP_H__
+#define __GEGL_TILE_BACKEND_MMAP_H__
+
+#include "gegl-tile-backend-ram.h"
+#include "gegl-buffer-index.h"
+
+/***
+ * GeglTileBackendMmap serves the tiles of a GeglBuffer file straight out of
+ * a read-only memory mapping of the file. Only the index of the file is
+ * read up front. Uncompressed tiles handed out share the mapped data
+ * copy-on-write, so the data is only copied when a tile is modified,
+ * compressed tiles are decompressed when they are requested. Modified tiles are
+ * kept in memory like with GeglTileBackendRam, the file is never written to.
+ * Truncating the file while it is mapped makes accesses to the tiles that
+ * weren't modified fail, gegl_buffer_save() replaces files instead.
+ */
+
+G_BEGIN_DECLS
+
+#define GEGL_TYPE_TILE_BACKEND_MMAP            (gegl_tile_backend_mmap_get_type ())
+#define GEGL_TILE_BACKEND_MMAP(obj)            (G_TYPE_CHECK_INSTANCE_CAST ((obj), GEGL_TYPE_TILE_BACKEND_MMAP, GeglTileBackendMmap))
+#define GEGL_TILE_BACKEND_MMAP_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST ((klass),  GEGL_TYPE_TILE_BACKEND_MMAP, GeglTileBackendMmapClass))
+#define GEGL_IS_TILE_BACKEND_MMAP(obj)         (G_TYPE_CHECK_INSTANCE_TYPE ((obj), GEGL_TYPE_TILE_BACKEND_MMAP))
+#define GEGL_IS_TILE_BACKEND_MMAP_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE ((klass),  GEGL_TYPE_TILE_BACKEND_MMAP))
+#define GEGL_TILE_BACKEND_MMAP_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS ((obj),  GEGL_TYPE_TILE_BACKEND_MMAP, GeglTileBackendMmapClass))
+
+typedef struct _GeglTileBackendMmap      GeglTileBackendMmap;
+typedef struct _GeglTileBackendMmapClass GeglTileBackendMmapClass;
+
+struct _GeglTileBackendMmap
+{
+  GeglTileBackendRam  parent_instance;
+
+  gpointer          (*ram_command) (GeglTileSource  *source,
+                                    GeglTileCommand  command,
+                                    gint             x,
+                                    gint             y,
+                                    gint             z,
+                                    gpointer         data);
+  gpointer            mapping;  /* the shared, reference counted mapping */
+  GHashTable         *entries;  /* the tiles of the file, by coordinates */
+  gint                max_z;    /* the highest mipmap level in the file */
+};
+
+struct _GeglTileBackendMmapClass
+{
+  GeglTileBackendRamClass parent_class;
+};
+
+GType             gegl_tile_backend_mmap_get_type (void) G_GNUC_CONST;
+
+/* Maps the GeglBuffer file at @path and reads its index, returns NULL when
+ * the file can't be mapped. @header is filled in with the header of the
+ * file.
+ */
+GeglTileBackend * gegl_tile_backend_mmap_new      (const gchar      *path,
+                                                   GeglBufferHeader *header);
+
+G_END_DECLS
+
+#endif
@@ -23,6 +23,11 @@
 #ifdef HAVE_UNISTD_H
 #include <unistd.h>
 #endif
+#ifdef HAVE_SYS_UIO_H
+#include <sys/uio.h>
+#endif
+#include <limits.h>
+#include <stdlib.h>
 #include <string.h>
 #include <errno.h>
 
@@ -42,6 +47,7 @@
 #include "gegl-tile-backend-swap.h"
 #include "gegl-debug.h"
 #include "gegl-config.h"
+#include "gegl-trace.h"
 
 
 #ifndef HAVE_FSYNC
@@ -52,6 +58,20 @@
 
 #endif
 
+/* the maximum number of queued writes the writer thread takes at once */
+#define SWAP_WRITE_BATCH 64
+
+#if defined (IOV_MAX) && IOV_MAX < SWAP_WRITE_BATCH
+#define SWAP_MAX_IOV IOV_MAX
+#else
+#define SWAP_MAX_IOV SWAP_WRITE_BATCH
+#endif
+
+/* the number of tiles following a tile read from the swap file, in the
+ * same row, that the kernel is asked to read ahead
+ */
+#define SWAP_READAHEAD 4
+
 
 G_DEFINE_TYPE (GeglTileBackendSwap, gegl_tile_backend_swap, GEGL_TYPE_TILE_BACKEND)
 
@@ -76,6 +96,7 @@ typedef struct
 typedef struct
 {
   SwapEntry *entry;
+  guint64    offset; /* the offset of the entry when the write started */
   gint       length;
   GeglTile  *tile;
   ThreadOp   operation;
@@ -89,11 +110,15 @@ typedef struct
 
 
 static void        gegl_tile_backend_swap_push_queue    (ThreadParams *params);
-static void        gegl_tile_backend_swap_write         (ThreadParams *params);
+static void        gegl_tile_backend_swap_write         (ThreadParams **batch,
+                                                         gint           n_params);
 static gpointer    gegl_tile_backend_swap_writer_thread (gpointer ignored);
 static void        gegl_tile_backend_swap_entry_read    (GeglTileBackendSwap   *self,
                                                          SwapEntry             *entry,
                                                          guchar                *dest);
+static void        gegl_tile_backend_swap_readahead     (GeglTileBackendSwap   *self,
+                                                         SwapEntry             *entry,
+                                                         gint                   tile_size);
 static void        gegl_tile_backend_swap_entry_write   (GeglTileBackendSwap   *self,
                                                          SwapEntry             *entry,
                                                          GeglTile              *tile);
@@ -149,14 +174,20 @@ void               gegl_tile_backend_swap_cleanup       (void);
 static gchar   *path       = NULL;
 static gint     in_fd      = -1;
 static gint     out_fd     = -1;
+#ifndef HAVE_PREAD
 static guint64  in_offset  = 0;
+static GMutex   read_mutex;
+#endif
+#ifndef HAVE_PWRITEV
 static guint64  out_offset = 0;
+#endif
 static GList   *gap_list   = NULL;
 static guint64  total      = 0;
 
 static GThread      *writer_thread = NULL;
 static GQueue       *queue         = NULL;
-static ThreadParams *in_progress   = NULL;
+static ThreadParams *in_progress[SWAP_WRITE_BATCH]; /* the batch being written */
+static gint          n_in_progress = 0;
 static gboolean      exit_thread   = FALSE;
 static GMutex        mutex;
 static GCond         queue_cond;
@@ -178,42 +209,144 @@ gegl_tile_backend_swap_push_queue (ThreadParams *params)
   g_mutex_unlock (&mutex);
 }
 
+#ifdef HAVE_PWRITEV
+/* write tiles that are adjacent in the swap file with a single syscall */
 static void
-gegl_tile_backend_swap_write (ThreadParams *params)
+gegl_tile_backend_swap_write_run (ThreadParams **run,
+                                  gint           n_params)
 {
-  gint    to_be_written = params->length;
-  guint64 offset        = params->entry->offset;
+  struct iovec  iov[SWAP_MAX_IOV];
+  struct iovec *vec    = iov;
+  gint          n_vec  = n_params;
+  guint64       offset = run[0]->offset;
+  gint          i;
+
+  for (i = 0; i < n_params; i++)
+    {
+      iov[i].iov_base = gegl_tile_get_data (run[i]->tile);
+      iov[i].iov_len  = run[i]->length;
+    }
 
-  if (out_offset != offset)
+  while (n_vec > 0)
     {
-      if (lseek (out_fd, offset, SEEK_SET) < 0)
+      gssize wrote = pwritev (out_fd, vec, n_vec, offset);
+
+      if (wrote <= 0)
         {
-          g_warning ("unable to seek to tile in buffer: %s", g_strerror (errno));
+          g_message ("unable to write tile data to self: "
+                     "%s (%d bytes written)",
+                     g_strerror (errno), (gint) wrote);
           return;
         }
-      out_offset = offset;
+
+      offset += wrote;
+
+      /* skip the written vectors, and the written part of a partially
+       * written one
+       */
+      while (n_vec > 0 && wrote >= (gssize) vec->iov_len)
+        {
+          wrote -= vec->iov_len;
+          vec++;
+          n_vec--;
+        }
+
+      if (n_vec > 0)
+        {
+          vec->iov_base  = (guchar *) vec->iov_base + wrote;
+          vec->iov_len  -= wrote;
+        }
+    }
+
+  GEGL_NOTE (GEGL_DEBUG_TILE_BACKEND, "writer thread wrote %i tiles at %i",
+             n_params, (gint) run[0]->offset);
+}
+#else
+static void
+gegl_tile_backend_swap_write_run (ThreadParams **run,
+                                  gint           n_params)
+{
+  gint i;
+
+  for (i = 0; i < n_params; i++)
+    {
+      ThreadParams *params        = run[i];
+      gint          to_be_written = params->length;
+      guint64       offset        = params->offset;
+
+      if (out_offset != offset)
+        {
+          if (lseek (out_fd, offset, SEEK_SET) < 0)
+            {
+              g_warning ("unable to seek to tile in buffer: %s", g_strerror (errno));
+              return;
+            }
+          out_offset = offset;
+        }
+
+      while (to_be_written > 0)
+        {
+          gint wrote;
+          wrote = write (out_fd,
+                         gegl_tile_get_data (params->tile) + params->length
+                         - to_be_written,
+                         to_be_written);
+          if (wrote <= 0)
+            {
+              g_message ("unable to write tile data to self: "
+                         "%s (%d/%d bytes written)",
+                         g_strerror (errno), wrote, to_be_written);
+              break;
+            }
+
+          to_be_written -= wrote;
+          out_offset    += wrote;
+        }
+
+      GEGL_NOTE (GEGL_DEBUG_TILE_BACKEND, "writer thread wrote at %i", (gint)offset);
     }
+}
+#endif
 
-  while (to_be_written > 0)
+/* write a batch of tiles sorted by offset, coalescing the tiles that are
+ * contiguous in the swap file into one write
+ */
+static void
+gegl_tile_backend_swap_write (ThreadParams **batch,
+                              gint           n_params)
+{
+  gint i = 0;
+
+  while (i < n_params)
     {
-      gint wrote;
-      wrote = write (out_fd,
-                     gegl_tile_get_data (params->tile) + params->length
-                     - to_be_written,
-                     to_be_written);
-      if (wrote <= 0)
+      guint64 end = batch[i]->offset + batch[i]->length;
+      gint    n   = 1;
+
+      while (i + n < n_params && n < SWAP_MAX_IOV &&
+             batch[i + n]->offset == end)
         {
-          g_message ("unable to write tile data to self: "
-                     "%s (%d/%d bytes written)",
-                     g_strerror (errno), wrote, to_be_written);
-          break;
+          end += batch[i + n]->length;
+          n++;
         }
 
-      to_be_written -= wrote;
-      out_offset    += wrote;
+      GEGL_TRACE_START();
+      gegl_tile_backend_swap_write_run (batch + i, n);
+      GEGL_TRACE_END ("swap", "write");
+      i += n;
     }
+}
 
-  GEGL_NOTE (GEGL_DEBUG_TILE_BACKEND, "writer thread wrote at %i", (gint)offset);
+static gint
+gegl_tile_backend_swap_compare_offset (gconstpointer a,
+                                       gconstpointer b)
+{
+  const ThreadParams *pa = *(ThreadParams * const *) a;
+  const ThreadParams *pb = *(ThreadParams * const *) b;
+
+  if (pa->offset < pb->offset)
+    return -1;
+
+  return pa->offset > pb->offset;
 }
 
 static gpointer
@@ -222,6 +355,7 @@ gegl_tile_backend_swap_writer_thread (gpointer ignored)
   while (TRUE)
     {
       ThreadParams *params;
+      gint          i;
 
       g_mutex_lock (&mutex);
 
@@ -235,34 +369,47 @@ gegl_tile_backend_swap_writer_thread (gpointer ignored)
           return NULL;
         }
 
-      params = (ThreadParams *)g_queue_pop_head (queue);
-      if (params->operation == OP_WRITE)
+      params = (ThreadParams *)g_queue_peek_head (queue);
+      if (params->operation == OP_TRUNCATE)
         {
-          in_progress = params;
-          params->entry->link = NULL;
-        }
-
-      g_mutex_unlock (&mutex);
+          g_queue_pop_head (queue);
+          g_mutex_unlock (&mutex);
 
-      switch (params->operation)
-        {
-        case OP_WRITE:
-          gegl_tile_backend_swap_write (params);
-          break;
-        case OP_TRUNCATE:
           if (ftruncate (out_fd, total) != 0)
             g_warning ("failed to resize swap file: %s", g_strerror (errno));
-          break;
+
+          g_slice_free (ThreadParams, params);
+          continue;
         }
 
-      g_mutex_lock (&mutex);
+      /* take the writes queued up to the next resize, they stay readable
+       * through in_progress until they are written
+       */
+      while (n_in_progress < SWAP_WRITE_BATCH &&
+             (params = g_queue_peek_head (queue)) &&
+             params->operation == OP_WRITE)
+        {
+          g_queue_pop_head (queue);
+          params->entry->link = NULL;
+          params->offset      = params->entry->offset;
+          in_progress[n_in_progress++] = params;
+        }
+
+      qsort (in_progress, n_in_progress, sizeof (ThreadParams *),
+             gegl_tile_backend_swap_compare_offset);
 
-      in_progress = NULL;
+      g_mutex_unlock (&mutex);
 
-      if (params->operation == OP_WRITE)
-        gegl_tile_unref (params->tile);
+      gegl_tile_backend_swap_write (in_progress, n_in_progress);
 
-      g_slice_free (ThreadParams, params);
+      g_mutex_lock (&mutex);
+
+      for (i = 0; i < n_in_progress; i++)
+        {
+          gegl_tile_unref (in_progress[i]->tile);
+          g_slice_free (ThreadParams, in_progress[i]);
+        }
+      n_in_progress = 0;
 
       g_mutex_unlock (&mutex);
     }
@@ -281,15 +428,19 @@ gegl_tile_backend_swap_entry_read (GeglTileBackendSwap *self,
 
   gegl_tile_backend_swap_ensure_exist ();
 
-  if (entry->link || in_progress)
+  if (entry->link || n_in_progress)
     {
       ThreadParams *queued_op = NULL;
+      gint          i;
+
       g_mutex_lock (&mutex);
 
       if (entry->link)
         queued_op = entry->link->data;
-      else if (in_progress && in_progress->entry == entry)
-        queued_op = in_progress;
+      else
+        for (i = 0; i < n_in_progress; i++)
+          if (in_progress[i]->entry == entry)
+            queued_op = in_progress[i];
 
       if (queued_op)
         {
@@ -304,10 +455,30 @@ gegl_tile_backend_swap_entry_read (GeglTileBackendSwap *self,
       g_mutex_unlock (&mutex);
     }
 
+#ifdef HAVE_PREAD
+  while (to_be_read > 0)
+    {
+      gssize byte_read;
+
+      byte_read = pread (in_fd, dest + tile_size - to_be_read, to_be_read,
+                         offset + tile_size - to_be_read);
+      if (byte_read <= 0)
+        {
+          g_message ("unable to read tile data from swap: "
+                     "%s (%d/%d bytes read)",
+                     g_strerror (errno), (gint) byte_read, to_be_read);
+          return;
+        }
+      to_be_read -= byte_read;
+    }
+#else
+  g_mutex_lock (&read_mutex);
+
   if (in_offset != offset)
     {
       if (lseek (in_fd, offset, SEEK_SET) < 0)
         {
+          g_mutex_unlock (&read_mutex);
           g_warning ("unable to seek to tile in buffer: %s", g_strerror (errno));
           return;
         }
@@ -316,22 +487,69 @@ gegl_tile_backend_swap_entry_read (GeglTileBackendSwap *self,
 
   while (to_be_read > 0)
     {
-      GError *error = NULL;
-      gint    byte_read;
+      gint byte_read;
 
       byte_read = read (in_fd, dest + tile_size - to_be_read, to_be_read);
       if (byte_read <= 0)
         {
+          g_mutex_unlock (&read_mutex);
           g_message ("unable to read tile data from swap: "
-                     "%s (%d/%d bytes read) %s",
-                     g_strerror (errno), byte_read, to_be_read, error?error->message:"--");
+                     "%s (%d/%d bytes read)",
+                     g_strerror (errno), byte_read, to_be_read);
           return;
         }
       to_be_read -= byte_read;
       in_offset  += byte_read;
     }
 
+  g_mutex_unlock (&read_mutex);
+#endif
+
   GEGL_NOTE(GEGL_DEBUG_TILE_BACKEND, "read entry %i, %i, %i from %i", entry->x, entry->y, entry->z, (gint)offset);
+
+  gegl_tile_backend_swap_readahead (self, entry, tile_size);
+}
+
+/* a tile was read from the swap file, hint the kernel to start reading the
+ * tiles to the right of it, which are likely to be asked for next
+ */
+static void
+gegl_tile_backend_swap_readahead (GeglTileBackendSwap *self,
+                                  SwapEntry           *entry,
+                                  gint                 tile_size)
+{
+#if defined (HAVE_POSIX_FADVISE) && defined (POSIX_FADV_WILLNEED)
+  guint64 start = 0;
+  guint64 end   = 0;
+  gint    i;
+
+  for (i = 1; i <= SWAP_READAHEAD; i++)
+    {
+      SwapEntry *next = gegl_tile_backend_swap_lookup_entry (self,
+                                                             entry->x + i,
+                                                             entry->y,
+                                                             entry->z);
+
+      /* tiles with a pending write are read from the queue */
+      if (next == NULL || next->link)
+        continue;
+
+      if (next->offset == end)
+        {
+          end += tile_size;
+          continue;
+        }
+
+      if (end > start)
+        posix_fadvise (in_fd, start, end - start, POSIX_FADV_WILLNEED);
+
+      start = next->offset;
+      end   = start + tile_size;
+    }
+
+  if (end > start)
+    posix_fadvise (in_fd, start, end - start, POSIX_FADV_WILLNEED);
+#endif
 }
 
 static void
@@ -600,7 +818,9 @@ gegl_tile_backend_swap_get_tile (GeglTileSource *self,
   tile      = gegl_tile_new (tile_size);
   gegl_tile_mark_as_stored (tile);
 
+  GEGL_TRACE_START();
   gegl_tile_backend_swap_entry_read (tile_backend_swap, entry, gegl_tile_get_data (tile));
+  GEGL_TRACE_END ("swap", "read");
 
   return tile;
 }
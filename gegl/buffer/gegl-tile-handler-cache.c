@@ -18,6 +18,8 @@
 
 #include "config.h"
 
+#include <string.h>
+
 #include <glib.h>
 #include <glib-object.h>
 
@@ -30,19 +32,19 @@
 #include "gegl-tile-handler-cache.h"
 #include "gegl-tile-storage.h"
 #include "gegl-debug.h"
+#include "gegl-trace.h"
 
 #include "gegl-buffer-cl-cache.h"
 
-/*
-#define GEGL_DEBUG_CACHE_HITS
-*/
-
 typedef struct CacheItem
 {
   GeglTileHandlerCache *handler; /* The specific handler that cached this item*/
   GeglTile *tile;                /* The tile */
-  GList     link;                /*  Link in the cache_queue, to avoid
+  GList     link;                /*  Link in the shard queue, to avoid
                                   *  queue lookups involving g_list_find() */
+  GList     handler_link;        /*  Link in the handler's item list */
+  gint      queue;               /* The shard queue the item is in */
+  guint     stamp;               /* The stamp of the handler, for ghosts */
 
   gint      x;                   /* The coordinates this tile was cached for */
   gint      y;
@@ -52,6 +54,63 @@ typedef struct CacheItem
 #define LINK_GET_ITEM(link) \
         ((CacheItem *) ((guchar *) link - G_STRUCT_OFFSET (CacheItem, link)))
 
+#define HANDLER_LINK_GET_ITEM(link) \
+        ((CacheItem *) ((guchar *) link - G_STRUCT_OFFSET (CacheItem, handler_link)))
+
+enum
+{
+  CACHE_QUEUE_RECENT,   /* the LRU queue, or the A1in FIFO of 2Q */
+  CACHE_QUEUE_FREQUENT, /* the Am LRU queue of 2Q */
+  CACHE_N_QUEUES
+};
+
+enum
+{
+  CACHE_POLICY_2Q,
+  CACHE_POLICY_LRU,
+  CACHE_N_POLICIES
+};
+
+typedef struct CacheStats
+{
+  guint64     hits;
+  guint64     misses;
+  guint64     evictions;
+} CacheStats;
+
+/* Each shard is an independent cache with its own lock; a tile lives
+ * in the shard picked by the hash of its coordinates.  The tile cache size
+ * is a global budget, shards that have grown beyond their fair share of it
+ * are trimmed first when the budget is exceeded.
+ */
+typedef struct CacheShard
+{
+  GMutex      mutex;
+  GQueue      queues[CACHE_N_QUEUES];       /* most recently used items at the head */
+  guint64     queue_totals[CACHE_N_QUEUES]; /* bytes stored in each queue */
+  GHashTable *ht;
+  guint64     total;                        /* bytes stored in this shard */
+  GQueue      ghosts;                       /* tiles recently evicted from the
+                                               recent queue, without data */
+  GHashTable *ghost_ht;
+  CacheStats  stats[CACHE_N_POLICIES];
+} CacheShard;
+
+/* The eviction policy decides which queue an inserted or hit item goes in,
+ * and which item of a shard gets evicted when it is trimmed.  Every policy
+ * works on the same shard queues, so the policy can be switched at any time.
+ */
+typedef struct CachePolicy
+{
+  const gchar *name;
+  void       (*insert) (CacheShard *shard,
+                        CacheItem  *item);
+  void       (*hit)    (CacheShard *shard,
+                        CacheItem  *item);
+  CacheItem *(*victim) (CacheShard *shard,
+                        guint64     fair_share);
+} CachePolicy;
+
 
 static void       gegl_tile_handler_cache_dispose    (GObject              *object);
 static gboolean   gegl_tile_handler_cache_wash       (GeglTileHandlerCache *cache);
@@ -64,7 +123,8 @@ static gpointer   gegl_tile_handler_cache_command    (GeglTileSource       *tile
 static GeglTile * gegl_tile_handler_cache_get_tile   (GeglTileHandlerCache *cache,
                                                       gint                  x,
                                                       gint                  y,
-                                                      gint                  z);
+                                                      gint                  z,
+                                                      gboolean              count_stats);
 static gboolean   gegl_tile_handler_cache_has_tile   (GeglTileHandlerCache *cache,
                                                       gint                  x,
                                                       gint                  y,
@@ -82,17 +142,251 @@ static void       gegl_tile_handler_cache_invalidate (GeglTileHandlerCache *cach
                                                       gint                  x,
                                                       gint                  y,
                                                       gint                  z);
+static guint      gegl_tile_handler_cache_hashfunc   (gconstpointer         key);
+static void       cache_2q_insert                    (CacheShard           *shard,
+                                                      CacheItem            *item);
+static void       cache_2q_hit                       (CacheShard           *shard,
+                                                      CacheItem            *item);
+static CacheItem *cache_2q_victim                    (CacheShard           *shard,
+                                                      guint64               fair_share);
+static void       cache_lru_insert                   (CacheShard           *shard,
+                                                      CacheItem            *item);
+static void       cache_lru_hit                      (CacheShard           *shard,
+                                                      CacheItem            *item);
+static CacheItem *cache_lru_victim                   (CacheShard           *shard,
+                                                      guint64               fair_share);
+
+
+static CacheShard   shards[GEGL_TILE_CACHE_SHARDS];
+static gint         cache_wash_percentage = 20;
+static volatile gsize cache_total         = 0; /* approximate amount of bytes stored */
+static gint         cache_victim          = 0; /* round-robin trim cursor */
+static gint         cache_wash_shard      = 0; /* round-robin wash cursor */
+static gint         cache_stamp           = 0; /* last handed out cache stamp */
 
+static const CachePolicy cache_policies[CACHE_N_POLICIES] =
+{
+  { "2q",  cache_2q_insert,  cache_2q_hit,  cache_2q_victim  },
+  { "lru", cache_lru_insert, cache_lru_hit, cache_lru_victim }
+};
 
-static GMutex       mutex                 = { 0, };
-static GQueue      *cache_queue           = NULL;
-static GHashTable  *cache_ht              = NULL;
-static gint         cache_wash_percentage = 20;
-static guint64      cache_total           = 0; /* approximate amount of bytes stored */
-#ifdef GEGL_DEBUG_CACHE_HITS
-static gint         cache_hits            = 0;
-static gint         cache_misses          = 0;
-#endif
+
+static inline void
+cache_total_add (gssize bytes)
+{
+  g_atomic_pointer_add (&cache_total, bytes);
+}
+
+static inline guint64
+cache_total_get (void)
+{
+  return GPOINTER_TO_SIZE (g_atomic_pointer_get (&cache_total));
+}
+
+static inline guint
+cache_shard_index (GeglTileHandlerCache *cache,
+                   gint                  x,
+                   gint                  y,
+                   gint                  z)
+{
+  CacheItem key;
+  guint     hash;
+
+  key.x       = x;
+  key.y       = y;
+  key.z       = z;
+  key.handler = cache;
+
+  /* scramble the morton ordered hash, so that neighbouring tiles, which
+   * are likely to be accessed by different threads, end up in different
+   * shards
+   */
+  hash = gegl_tile_handler_cache_hashfunc (&key) * 2654435761u;
+
+  return (hash >> 16) % GEGL_TILE_CACHE_SHARDS;
+}
+
+
+/* the index of the eviction policy selected by the tile-cache-policy
+ * property, set by gegl_tile_cache_set_policy()
+ */
+static gint cache_policy = CACHE_POLICY_2Q;
+
+static inline const CachePolicy *
+cache_policy_get (void)
+{
+  return &cache_policies[g_atomic_int_get (&cache_policy)];
+}
+
+void
+gegl_tile_cache_set_policy (const gchar *name)
+{
+  gint i;
+
+  for (i = 0; i < CACHE_N_POLICIES; i++)
+    if (name && !strcmp (name, cache_policies[i].name))
+      break;
+
+  if (i == CACHE_N_POLICIES)
+    {
+      if (name && name[0])
+        g_warning ("unknown tile cache policy \"%s\", using \"%s\"",
+                   name, cache_policies[CACHE_POLICY_2Q].name);
+      i = CACHE_POLICY_2Q;
+    }
+
+  g_atomic_int_set (&cache_policy, i);
+}
+
+static inline void
+cache_shard_push (CacheShard *shard,
+                  CacheItem  *item,
+                  gint        queue)
+{
+  item->queue = queue;
+  g_queue_push_head_link (&shard->queues[queue], &item->link);
+  shard->queue_totals[queue] += item->tile->size;
+}
+
+static inline void
+cache_shard_unlink (CacheShard *shard,
+                    CacheItem  *item)
+{
+  g_queue_unlink (&shard->queues[item->queue], &item->link);
+  shard->queue_totals[item->queue] -= item->tile->size;
+}
+
+static void
+cache_ghost_remove (CacheShard *shard,
+                    CacheItem  *ghost)
+{
+  g_queue_unlink (&shard->ghosts, &ghost->link);
+  g_hash_table_remove (shard->ghost_ht, ghost);
+  g_slice_free (CacheItem, ghost);
+}
+
+/* remember the coordinates of an item evicted from the recent queue; ghosts
+ * are cheap, so we keep twice as many of them as the shard holds tiles.
+ */
+static void
+cache_ghost_add (CacheShard *shard,
+                 CacheItem  *item)
+{
+  CacheItem *ghost      = g_hash_table_lookup (shard->ghost_ht, item);
+  guint      max_ghosts = 16 + 2 * (g_queue_get_length (&shard->queues[CACHE_QUEUE_RECENT]) +
+                                    g_queue_get_length (&shard->queues[CACHE_QUEUE_FREQUENT]));
+
+  if (ghost)
+    cache_ghost_remove (shard, ghost);
+
+  ghost = g_slice_new0 (CacheItem);
+  ghost->handler   = item->handler;
+  ghost->stamp     = item->handler->stamp;
+  ghost->link.data = ghost;
+  ghost->x         = item->x;
+  ghost->y         = item->y;
+  ghost->z         = item->z;
+
+  g_queue_push_head_link (&shard->ghosts, &ghost->link);
+  g_hash_table_insert (shard->ghost_ht, ghost, ghost);
+
+  while (g_queue_get_length (&shard->ghosts) > max_ghosts)
+    cache_ghost_remove (shard, LINK_GET_ITEM (g_queue_peek_tail_link (&shard->ghosts)));
+}
+
+/* 2Q: new tiles enter a FIFO, and only tiles that are asked for again after
+ * having been evicted from it are considered part of the working set and
+ * kept in an LRU queue.  A single pass over a large buffer thus only cycles
+ * through the FIFO and does not evict the working set.
+ */
+#define CACHE_2Q_RECENT_SHARE 4 /* the FIFO gets a quarter of the fair share */
+
+static void
+cache_2q_insert (CacheShard *shard,
+                 CacheItem  *item)
+{
+  CacheItem *ghost    = g_hash_table_lookup (shard->ghost_ht, item);
+  gboolean   frequent = FALSE;
+
+  if (ghost)
+    {
+      /* ghosts left behind by a freed cache don't count */
+      frequent = ghost->stamp == item->handler->stamp;
+      cache_ghost_remove (shard, ghost);
+    }
+
+  cache_shard_push (shard, item, frequent ? CACHE_QUEUE_FREQUENT
+                                          : CACHE_QUEUE_RECENT);
+}
+
+static void
+cache_2q_hit (CacheShard *shard,
+              CacheItem  *item)
+{
+  /* hits in the FIFO are correlated references, like consecutive rows
+   * being read from the same tile, and don't promote the tile
+   */
+  if (item->queue == CACHE_QUEUE_FREQUENT)
+    {
+      cache_shard_unlink (shard, item);
+      cache_shard_push (shard, item, CACHE_QUEUE_FREQUENT);
+    }
+}
+
+static CacheItem *
+cache_2q_victim (CacheShard *shard,
+                 guint64     fair_share)
+{
+  GList *link;
+
+  if (shard->queue_totals[CACHE_QUEUE_RECENT] > fair_share / CACHE_2Q_RECENT_SHARE ||
+      g_queue_is_empty (&shard->queues[CACHE_QUEUE_FREQUENT]))
+    {
+      link = g_queue_peek_tail_link (&shard->queues[CACHE_QUEUE_RECENT]);
+
+      if (link)
+        {
+          cache_ghost_add (shard, LINK_GET_ITEM (link));
+          return LINK_GET_ITEM (link);
+        }
+    }
+
+  link = g_queue_peek_tail_link (&shard->queues[CACHE_QUEUE_FREQUENT]);
+
+  return link ? LINK_GET_ITEM (link) : NULL;
+}
+
+/* LRU: plain least recently used eviction, the items that were promoted
+ * while a different policy was in use are evicted last.
+ */
+static void
+cache_lru_insert (CacheShard *shard,
+                  CacheItem  *item)
+{
+  cache_shard_push (shard, item, CACHE_QUEUE_RECENT);
+}
+
+static void
+cache_lru_hit (CacheShard *shard,
+               CacheItem  *item)
+{
+  gint queue = item->queue;
+
+  cache_shard_unlink (shard, item);
+  cache_shard_push (shard, item, queue);
+}
+
+static CacheItem *
+cache_lru_victim (CacheShard *shard,
+                  guint64     fair_share)
+{
+  GList *link = g_queue_peek_tail_link (&shard->queues[CACHE_QUEUE_RECENT]);
+
+  if (!link)
+    link = g_queue_peek_tail_link (&shard->queues[CACHE_QUEUE_FREQUENT]);
+
+  return link ? LINK_GET_ITEM (link) : NULL;
+}
 
 
 G_DEFINE_TYPE (GeglTileHandlerCache, gegl_tile_handler_cache, GEGL_TYPE_TILE_HANDLER)
@@ -110,14 +404,14 @@ static void
 gegl_tile_handler_cache_init (GeglTileHandlerCache *cache)
 {
   ((GeglTileSource*)cache)->command = gegl_tile_handler_cache_command;
+  cache->stamp = (guint) g_atomic_int_add (&cache_stamp, 1) + 1;
   gegl_tile_cache_init ();
 }
 
 static void
 gegl_tile_handler_cache_reinit (GeglTileHandlerCache *cache)
 {
-  CacheItem            *item;
-  GSList               *iter;
+  gint s;
 
   if (cache->tile_storage->hot_tile)
     {
@@ -125,29 +419,33 @@ gegl_tile_handler_cache_reinit (GeglTileHandlerCache *cache)
       cache->tile_storage->hot_tile = NULL;
     }
 
-  if (!cache->count)
+  if (!g_atomic_int_get (&cache->count))
     return;
 
-  g_mutex_lock (&mutex);
-  {
-    for (iter = cache->items; iter; iter = cache->items)
+  for (s = 0; s < GEGL_TILE_CACHE_SHARDS; s++)
     {
-      item = iter->data;
-      if (item->tile)
+      CacheShard *shard   = &shards[s];
+      gssize      removed = 0;
+      GList      *link;
+
+      g_mutex_lock (&shard->mutex);
+      while ((link = g_queue_pop_head_link (&cache->items[s])))
         {
-          cache_total -= item->tile->size;
-          gegl_tile_mark_as_stored (item->tile); // to avoid saving 
+          CacheItem *item = HANDLER_LINK_GET_ITEM (link);
+
+          cache_shard_unlink (shard, item);
+          g_hash_table_remove (shard->ht, item);
+          removed += item->tile->size;
+          gegl_tile_mark_as_stored (item->tile); // to avoid saving
           gegl_tile_unref (item->tile);
-          cache->count--;
+          g_atomic_int_add (&cache->count, -1);
+          g_slice_free (CacheItem, item);
         }
-      g_queue_unlink (cache_queue, &item->link);
-      cache->items = g_slist_remove (cache->items, item);
-      g_hash_table_remove (cache_ht, item);
-      g_slice_free (CacheItem, item);
-    }
-  }
+      shard->total -= removed;
+      g_mutex_unlock (&shard->mutex);
 
-  g_mutex_unlock (&mutex);
+      cache_total_add (-removed);
+    }
 }
 
 static void
@@ -157,7 +455,7 @@ gegl_tile_handler_cache_dispose (GObject *object)
 
   gegl_tile_handler_cache_reinit (cache);
 
-  if (cache->count < 0)
+  if (cache->count != 0)
     {
       g_warning ("cache-handler tile balance not zero: %i\n", cache->count);
     }
@@ -178,17 +476,9 @@ gegl_tile_handler_cache_get_tile_command (GeglTileSource *tile_store,
   if (G_UNLIKELY (gegl_cl_is_accelerated ()))
     gegl_buffer_cl_cache_flush2 (cache, NULL);
 
-  tile = gegl_tile_handler_cache_get_tile (cache, x, y, z);
+  tile = gegl_tile_handler_cache_get_tile (cache, x, y, z, TRUE);
   if (tile)
-    {
-#ifdef GEGL_DEBUG_CACHE_HITS
-      cache_hits++;
-#endif
-      return tile;
-    }
-#ifdef GEGL_DEBUG_CACHE_HITS
-  cache_misses++;
-#endif
+    return tile;
 
   if (source)
     tile = gegl_tile_source_get_tile (source, x, y, z);
@@ -214,24 +504,39 @@ gegl_tile_handler_cache_command (GeglTileSource  *tile_store,
     {
       case GEGL_TILE_FLUSH:
         {
+          GSList    *dirty = NULL;
+          GSList    *iter;
           GList     *link;
+          gint       s;
 
           if (gegl_cl_is_accelerated ())
             gegl_buffer_cl_cache_flush2 (cache, NULL);
 
-          if (cache->count)
+          if (g_atomic_int_get (&cache->count))
             {
-              for (link = g_queue_peek_head_link (cache_queue); link; link = link->next)
+              /* collect the dirty tiles under the shard locks, and store
+               * them without holding any lock
+               */
+              for (s = 0; s < GEGL_TILE_CACHE_SHARDS; s++)
                 {
-                  CacheItem *item = LINK_GET_ITEM (link);
-                  GeglTile  *tile = item->tile;
-
-                  if (tile != NULL &&
-                      item->handler == cache)
+                  g_mutex_lock (&shards[s].mutex);
+                  for (link = g_queue_peek_head_link (&cache->items[s]); link; link = link->next)
                     {
-                      gegl_tile_store (tile);
+                      CacheItem *item = HANDLER_LINK_GET_ITEM (link);
+                      GeglTile  *tile = item->tile;
+
+                      if (tile != NULL && !gegl_tile_is_stored (tile))
+                        dirty = g_slist_prepend (dirty, gegl_tile_ref (tile));
                     }
+                  g_mutex_unlock (&shards[s].mutex);
+                }
+
+              for (iter = dirty; iter; iter = iter->next)
+                {
+                  gegl_tile_store (iter->data);
+                  gegl_tile_unref (iter->data);
                 }
+              g_slist_free (dirty);
             }
         }
         break;
@@ -275,40 +580,58 @@ gegl_tile_handler_cache_command (GeglTileSource  *tile_store,
 }
 
 /* write the least recently used dirty tile to disk if it
- * is in the wash_percentage (20%) least recently used tiles,
- * calling this function in an idle handler distributes the
- * tile flushing overhead over time.
+ * is in the wash_percentage (20%) least recently used tiles
+ * of a shard queue, calling this function in an idle handler distributes
+ * the tile flushing overhead over time.
  */
 gboolean
 gegl_tile_handler_cache_wash (GeglTileHandlerCache *cache)
 {
-  GeglTile  *last_dirty = NULL;
-  guint      count      = 0;
-  gint       length     = g_queue_get_length (cache_queue);
-  gint       wash_tiles = cache_wash_percentage * length / 100;
-  GList     *link;
+  gint i;
 
-  for (link = g_queue_peek_head_link (cache_queue); link; link = link->next)
+  for (i = 0; i < GEGL_TILE_CACHE_SHARDS; i++)
     {
-      CacheItem *item = LINK_GET_ITEM (link);
-      GeglTile  *tile = item->tile;
+      guint       s          = (guint) g_atomic_int_add (&cache_wash_shard, 1) %
+                               GEGL_TILE_CACHE_SHARDS;
+      CacheShard *shard      = &shards[s];
+      GeglTile   *last_dirty = NULL;
+      gint        q;
+
+      g_mutex_lock (&shard->mutex);
+      for (q = 0; q < CACHE_N_QUEUES && !last_dirty; q++)
+        {
+          GQueue *queue      = &shard->queues[q];
+          gint    wash_tiles = cache_wash_percentage * g_queue_get_length (queue) / 100;
+          GList  *link;
 
-      count++;
-      if (!gegl_tile_is_stored (tile))
-        if (count > length - wash_tiles)
-          last_dirty = tile;
-    }
+          for (link = g_queue_peek_tail_link (queue);
+               link && wash_tiles > 0;
+               link = link->prev, wash_tiles--)
+            {
+              CacheItem *item = LINK_GET_ITEM (link);
 
-  if (last_dirty != NULL)
-    {
-      gegl_tile_store (last_dirty);
-      return TRUE;
+              if (!gegl_tile_is_stored (item->tile))
+                {
+                  last_dirty = gegl_tile_ref (item->tile);
+                  break;
+                }
+            }
+        }
+      g_mutex_unlock (&shard->mutex);
+
+      if (last_dirty != NULL)
+        {
+          gegl_tile_store (last_dirty);
+          gegl_tile_unref (last_dirty);
+          return TRUE;
+        }
     }
   return FALSE;
 }
 
 static inline CacheItem *
-cache_lookup (GeglTileHandlerCache *cache,
+cache_lookup (CacheShard           *shard,
+              GeglTileHandlerCache *cache,
               gint                  x,
               gint                  y,
               gint                  z)
@@ -320,39 +643,58 @@ cache_lookup (GeglTileHandlerCache *cache,
   key.z       = z;
   key.handler = cache;
 
-  return g_hash_table_lookup (cache_ht, &key);
+  return g_hash_table_lookup (shard->ht, &key);
 }
 
-/* returns the requested Tile if it is in the cache, NULL otherwize.
+/* returns the requested Tile if it is in the cache, NULL otherwize,
+ * recording the lookup in the statistics of the policy if @count_stats
+ * is set.
  */
 static GeglTile *
 gegl_tile_handler_cache_get_tile (GeglTileHandlerCache *cache,
                                   gint                  x,
                                   gint                  y,
-                                  gint                  z)
+                                  gint                  z,
+                                  gboolean              count_stats)
 {
-  CacheItem *result;
+  const CachePolicy *policy;
+  CacheShard        *shard;
+  CacheStats        *stats;
+  CacheItem         *result;
+  GeglTile          *tile = NULL;
 
-  if (cache->count == 0)
+  if (g_atomic_int_get (&cache->count) == 0 && !count_stats)
     return NULL;
 
-  g_mutex_lock (&mutex);
-  result = cache_lookup (cache, x, y, z);
+  policy = cache_policy_get ();
+  shard  = &shards[cache_shard_index (cache, x, y, z)];
+  stats  = &shard->stats[policy - cache_policies];
+
+  g_mutex_lock (&shard->mutex);
+  result = cache_lookup (shard, cache, x, y, z);
+  if (count_stats)
+    {
+      if (result)
+        stats->hits++;
+      else
+        stats->misses++;
+    }
   if (result)
     {
-      g_queue_unlink (cache_queue, &result->link);
-      g_queue_push_head_link (cache_queue, &result->link);
-      g_mutex_unlock (&mutex);
-      while (result->tile == NULL)
-      {
+      policy->hit (shard, result);
+
+      if (result->tile == NULL)
         g_printerr ("NULL tile in %s %p %i %i %i %p\n", __FUNCTION__, result, result->x, result->y, result->z,
                 result->tile);
-        return NULL;
-      }
-      return gegl_tile_ref (result->tile);
+      else
+        tile = gegl_tile_ref (result->tile);
     }
-  g_mutex_unlock (&mutex);
-  return NULL;
+  g_mutex_unlock (&shard->mutex);
+
+  if (count_stats && result == NULL)
+    GEGL_TRACE_INSTANT ("cache", "miss");
+
+  return tile;
 }
 
 static gboolean
@@ -361,7 +703,7 @@ gegl_tile_handler_cache_has_tile (GeglTileHandlerCache *cache,
                                   gint                  y,
                                   gint                  z)
 {
-  GeglTile *tile = gegl_tile_handler_cache_get_tile (cache, x, y, z);
+  GeglTile *tile = gegl_tile_handler_cache_get_tile (cache, x, y, z, FALSE);
 
   if (tile)
     {
@@ -372,35 +714,95 @@ gegl_tile_handler_cache_has_tile (GeglTileHandlerCache *cache,
   return FALSE;
 }
 
+/* drop the tile of @shard chosen by the eviction policy, if the shard
+ * holds more than @min_total bytes.
+ */
 static gboolean
-gegl_tile_handler_cache_trim (GeglTileHandlerCache *cache)
+gegl_tile_handler_cache_trim_shard (CacheShard *shard,
+                                    guint64     min_total,
+                                    guint64     fair_share)
 {
-  GList *link;
+  const CachePolicy *policy        = cache_policy_get ();
+  CacheItem         *last_writable = NULL;
+  GeglTile          *tile;
+  GeglTileStorage   *storage;
 
-  link = g_queue_pop_tail_link (cache_queue);
-
-  if (link != NULL)
+  g_mutex_lock (&shard->mutex);
+  if (shard->total > min_total)
     {
-      CacheItem *last_writable = LINK_GET_ITEM (link);
-      GeglTile *tile = last_writable->tile;
-      GeglTileStorage *storage = tile->tile_storage;
-
-      last_writable->handler->items = g_slist_remove (last_writable->handler->items, last_writable);
-      g_hash_table_remove (cache_ht, last_writable);
-      cache_total -= tile->size;
+      CacheItem *item = policy->victim (shard, fair_share);
 
-      if (storage && storage->hot_tile == tile)
+      if (item != NULL)
         {
-          storage->hot_tile = NULL;
-          gegl_tile_unref (tile);
+          guint s = cache_shard_index (item->handler, item->x, item->y, item->z);
+
+          cache_shard_unlink (shard, item);
+          g_queue_unlink (&item->handler->items[s], &item->handler_link);
+          g_hash_table_remove (shard->ht, item);
+          shard->total -= item->tile->size;
+          g_atomic_int_add (&item->handler->count, -1);
+          shard->stats[policy - cache_policies].evictions++;
+          last_writable = item;
         }
+    }
+  g_mutex_unlock (&shard->mutex);
 
+  if (last_writable == NULL)
+    return FALSE;
+
+  GEGL_TRACE_INSTANT ("cache", "evict");
+
+  tile    = last_writable->tile;
+  storage = tile->tile_storage;
+
+  cache_total_add (-tile->size);
+
+  if (storage && storage->hot_tile == tile)
+    {
+      storage->hot_tile = NULL;
       gegl_tile_unref (tile);
-      g_slice_free (CacheItem, last_writable);
-      return TRUE;
     }
 
-  return FALSE;
+  gegl_tile_unref (tile);
+  g_slice_free (CacheItem, last_writable);
+  return TRUE;
+}
+
+/* evict tiles until the total size of the cache is within the configured
+ * tile cache size, starting with the shard that was last inserted into,
+ * and continuing with the shards that hold more than their fair share.
+ */
+static void
+gegl_tile_handler_cache_trim (guint shard_index)
+{
+  guint64 cache_size = gegl_config ()->tile_cache_size;
+  guint64 fair_share = cache_size / GEGL_TILE_CACHE_SHARDS;
+  gint    misses     = 0;
+
+  if (cache_total_get () <= cache_size)
+    return;
+
+  while (gegl_tile_handler_cache_trim_shard (&shards[shard_index],
+                                             fair_share, fair_share))
+    if (cache_total_get () <= cache_size)
+      return;
+
+  /* after two full rounds without finding a shard above its share, the
+   * shards are trimmed regardless of their size
+   */
+  while (cache_total_get () > cache_size &&
+         misses < 3 * GEGL_TILE_CACHE_SHARDS)
+    {
+      guint s = (guint) g_atomic_int_add (&cache_victim, 1) %
+                GEGL_TILE_CACHE_SHARDS;
+
+      if (gegl_tile_handler_cache_trim_shard (&shards[s],
+                 misses < 2 * GEGL_TILE_CACHE_SHARDS ? fair_share : 0,
+                 fair_share))
+        misses = 0;
+      else
+        misses++;
+    }
 }
 
 static void
@@ -409,24 +811,28 @@ gegl_tile_handler_cache_invalidate (GeglTileHandlerCache *cache,
                                     gint                  y,
                                     gint                  z)
 {
-  CacheItem *item;
+  guint       s     = cache_shard_index (cache, x, y, z);
+  CacheShard *shard = &shards[s];
+  CacheItem  *item;
 
-  g_mutex_lock (&mutex);
-  item = cache_lookup (cache, x, y, z);
+  g_mutex_lock (&shard->mutex);
+  item = cache_lookup (shard, cache, x, y, z);
   if (item)
     {
-      cache_total -= item->tile->size;
+      shard->total -= item->tile->size;
+      cache_total_add (-item->tile->size);
       item->tile->tile_storage = NULL;
       gegl_tile_mark_as_stored (item->tile); /* to cheat it out of being stored */
+      cache_shard_unlink (shard, item);
       gegl_tile_unref (item->tile);
 
-      g_queue_unlink (cache_queue, &item->link);
-      cache->items = g_slist_remove (cache->items, item);
+      g_queue_unlink (&cache->items[s], &item->handler_link);
+      g_atomic_int_add (&cache->count, -1);
 
-      g_hash_table_remove (cache_ht, item);
+      g_hash_table_remove (shard->ht, item);
       g_slice_free (CacheItem, item);
     }
-  g_mutex_unlock (&mutex);
+  g_mutex_unlock (&shard->mutex);
 }
 
 
@@ -436,19 +842,22 @@ gegl_tile_handler_cache_void (GeglTileHandlerCache *cache,
                               gint                  y,
                               gint                  z)
 {
-  CacheItem *item;
+  guint       s     = cache_shard_index (cache, x, y, z);
+  CacheShard *shard = &shards[s];
+  CacheItem  *item;
 
-  g_mutex_lock (&mutex);
-  item = cache_lookup (cache, x, y, z);
+  g_mutex_lock (&shard->mutex);
+  item = cache_lookup (shard, cache, x, y, z);
   if (item)
     {
-      cache_total -= item->tile->size;
-      g_queue_unlink (cache_queue, &item->link);
-      cache->items = g_slist_remove (cache->items, item);
-      g_hash_table_remove (cache_ht, item);
-      cache->count--;
+      shard->total -= item->tile->size;
+      cache_total_add (-item->tile->size);
+      cache_shard_unlink (shard, item);
+      g_queue_unlink (&cache->items[s], &item->handler_link);
+      g_hash_table_remove (shard->ht, item);
+      g_atomic_int_add (&cache->count, -1);
     }
-  g_mutex_unlock (&mutex);
+  g_mutex_unlock (&shard->mutex);
 
   if (item)
     {
@@ -466,16 +875,21 @@ gegl_tile_handler_cache_insert (GeglTileHandlerCache *cache,
                                 gint                  y,
                                 gint                  z)
 {
-  CacheItem *item = g_slice_new (CacheItem);
-
-  item->handler   = cache;
-  item->tile      = gegl_tile_ref (tile);
-  item->link.data = item;
-  item->link.next = NULL;
-  item->link.prev = NULL;
-  item->x         = x;
-  item->y         = y;
-  item->z         = z;
+  guint       s     = cache_shard_index (cache, x, y, z);
+  CacheShard *shard = &shards[s];
+  CacheItem  *item  = g_slice_new (CacheItem);
+
+  item->handler           = cache;
+  item->tile              = gegl_tile_ref (tile);
+  item->link.data         = item;
+  item->link.next         = NULL;
+  item->link.prev         = NULL;
+  item->handler_link.data = item;
+  item->handler_link.next = NULL;
+  item->handler_link.prev = NULL;
+  item->x                 = x;
+  item->y                 = y;
+  item->z                 = z;
 
   tile->x = x;
   tile->y = y;
@@ -487,24 +901,17 @@ gegl_tile_handler_cache_insert (GeglTileHandlerCache *cache,
 
   /* XXX: this is a window when the tile is a zero tile during update */
 
-  g_mutex_lock (&mutex);
-  cache_total  += item->tile->size;
-  g_queue_push_head_link (cache_queue, &item->link);
-
-  cache->count ++;
+  g_mutex_lock (&shard->mutex);
+  shard->total += item->tile->size;
+  cache_policy_get ()->insert (shard, item);
+  g_queue_push_head_link (&cache->items[s], &item->handler_link);
+  g_hash_table_insert (shard->ht, item, item);
+  g_mutex_unlock (&shard->mutex);
 
-  cache->items = g_slist_prepend (cache->items, item);
-  g_hash_table_insert (cache_ht, item, item);
+  g_atomic_int_inc (&cache->count);
+  cache_total_add (item->tile->size);
 
-  while (cache_total > gegl_config()->tile_cache_size)
-    {
-#ifdef GEGL_DEBUG_CACHE_HITS
-      GEGL_NOTE(GEGL_DEBUG_CACHE, "cache_total:"G_GUINT64_FORMAT" > cache_size:"G_GUINT64_FORMAT, cache_total, gegl_config()->tile_cache_size);
-      GEGL_NOTE(GEGL_DEBUG_CACHE, "%f%% hit:%i miss:%i  %i]", cache_hits*100.0/(cache_hits+cache_misses), cache_hits, cache_misses, g_queue_get_length (cache_queue));
-#endif
-      gegl_tile_handler_cache_trim (cache);
-    }
-  g_mutex_unlock (&mutex);
+  gegl_tile_handler_cache_trim (s);
 }
 
 GeglTileHandler *
@@ -558,22 +965,98 @@ gegl_tile_handler_cache_equalfunc (gconstpointer a,
 void
 gegl_tile_cache_init (void)
 {
-  if (cache_queue == NULL)
-    cache_queue = g_queue_new ();
-  if (cache_ht == NULL)
-    cache_ht = g_hash_table_new (gegl_tile_handler_cache_hashfunc, gegl_tile_handler_cache_equalfunc);
+  gint s;
+
+  if (shards[0].ht != NULL)
+    return;
+
+  for (s = 0; s < GEGL_TILE_CACHE_SHARDS; s++)
+    {
+      gint q;
+
+      for (q = 0; q < CACHE_N_QUEUES; q++)
+        {
+          g_queue_init (&shards[s].queues[q]);
+          shards[s].queue_totals[q] = 0;
+        }
+      g_queue_init (&shards[s].ghosts);
+      shards[s].ht = g_hash_table_new (gegl_tile_handler_cache_hashfunc,
+                                       gegl_tile_handler_cache_equalfunc);
+      shards[s].ghost_ht = g_hash_table_new (gegl_tile_handler_cache_hashfunc,
+                                             gegl_tile_handler_cache_equalfunc);
+      shards[s].total = 0;
+    }
 }
 
 void
 gegl_tile_cache_destroy (void)
 {
-  if (cache_queue)
+  gint s;
+  gint p;
+
+  for (p = 0; p < CACHE_N_POLICIES; p++)
+    {
+      guint64 hits, misses, evictions;
+
+      if (gegl_tile_cache_get_stats (cache_policies[p].name,
+                                     &hits, &misses, &evictions) &&
+          hits + misses > 0)
+        GEGL_NOTE (GEGL_DEBUG_CACHE,
+                   "%s: %.1f%% hit:%"G_GUINT64_FORMAT" miss:%"G_GUINT64_FORMAT" evicted:%"G_GUINT64_FORMAT,
+                   cache_policies[p].name, hits * 100.0 / (hits + misses),
+                   hits, misses, evictions);
+    }
+
+  for (s = 0; s < GEGL_TILE_CACHE_SHARDS; s++)
+    {
+      GList *link;
+      gint   q;
+
+      for (q = 0; q < CACHE_N_QUEUES; q++)
+        {
+          while (g_queue_pop_head_link (&shards[s].queues[q]));
+          shards[s].queue_totals[q] = 0;
+        }
+      while ((link = g_queue_pop_head_link (&shards[s].ghosts)))
+        g_slice_free (CacheItem, LINK_GET_ITEM (link));
+      if (shards[s].ht)
+        g_hash_table_destroy (shards[s].ht);
+      if (shards[s].ghost_ht)
+        g_hash_table_destroy (shards[s].ghost_ht);
+      shards[s].ht       = NULL;
+      shards[s].ghost_ht = NULL;
+      shards[s].total    = 0;
+      memset (shards[s].stats, 0, sizeof (shards[s].stats));
+    }
+  cache_total = 0;
+}
+
+gboolean
+gegl_tile_cache_get_stats (const gchar *policy,
+                           guint64     *hits,
+                           guint64     *misses,
+                           guint64     *evictions)
+{
+  gint p;
+  gint s;
+
+  for (p = 0; p < CACHE_N_POLICIES; p++)
+    if (!strcmp (policy, cache_policies[p].name))
+      break;
+
+  if (p == CACHE_N_POLICIES)
+    return FALSE;
+
+  *hits = *misses = *evictions = 0;
+
+  for (s = 0; s < GEGL_TILE_CACHE_SHARDS; s++)
     {
-      while (g_queue_pop_head_link (cache_queue));
-      g_queue_free (cache_queue);
+      g_mutex_lock (&shards[s].mutex);
+      *hits      += shards[s].stats[p].hits;
+      *misses    += shards[s].stats[p].misses;
+      *evictions += shards[s].stats[p].evictions;
+      g_mutex_unlock (&shards[s].mutex);
     }
-  if (cache_ht)
-    g_hash_table_destroy (cache_ht);
-  cache_queue = NULL;
-  cache_ht = NULL;
+
+  return TRUE;
 }
@@ -33,6 +33,11 @@
 #define GEGL_TILE_HANDLER_CACHE_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS ((obj),  GEGL_TYPE_TILE_HANDLER_CACHE, GeglTileHandlerCacheClass))
 
 
+/* The tiles of all caches are spread over this many independently locked
+ * shards, picked by the hash of the tile coordinates.
+ */
+#define GEGL_TILE_CACHE_SHARDS 16
+
 typedef struct _GeglTileHandlerCache      GeglTileHandlerCache;
 typedef struct _GeglTileHandlerCacheClass GeglTileHandlerCacheClass;
 
@@ -40,8 +45,11 @@ struct _GeglTileHandlerCache
 {
   GeglTileHandler  parent_instance;
   GeglTileStorage *tile_storage;
-  GSList          *items;
+  GQueue           items[GEGL_TILE_CACHE_SHARDS]; /* items per shard, protected
+                                                     by the shard lock */
   int              count; /* number of items held by cache */
+  guint            stamp; /* unique for every cache, even when a new cache
+                             is allocated at the address of a freed one */
 };
 
 struct _GeglTileHandlerCacheClass
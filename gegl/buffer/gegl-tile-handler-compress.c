@@ -0,0 +1,576 @@
+/* This file is part of GEGL.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include <glib-object.h>
+
+#include "gegl.h"
+#include "gegl-types-internal.h"
+#include "gegl-config.h"
+#include "gegl-buffer-types.h"
+#include "gegl-buffer-private.h"
+#include "gegl-tile.h"
+#include "gegl-tile-backend.h"
+#include "gegl-tile-storage.h"
+#include "gegl-tile-handler-compress.h"
+#include "gegl-tile-handler-private.h"
+#include "gegl-debug.h"
+
+
+/* a tile is only kept compressed if that saves at least a quarter */
+#define COMPRESS_MAX_RATIO(size) ((size) * 3 / 4)
+
+typedef enum
+{
+  COMPRESS_UNIFORM, /* a single pixel repeated over the whole tile */
+  COMPRESS_RLE      /* pixel run length encoding */
+} CompressKind;
+
+typedef struct CompressedTile
+{
+  GeglTileHandlerCompress *handler;
+  GList                    link;   /* link in the global LRU queue */
+  gint                     x;
+  gint                     y;
+  gint                     z;
+  CompressKind             kind;
+  gint                     length; /* length of the compressed data */
+  guchar                  *data;
+} CompressedTile;
+
+
+/* The compressed tiles of all handlers share one budget and LRU queue,
+ * protected by the mutex, as are the dropping and n_spilling fields of the
+ * handlers.  The tile table of each handler is protected by the mutex of
+ * its tile storage, like the rest of the handler chain.
+ */
+static GMutex                mutex;
+static GCond                 spilled_cond; /* signalled when a tile of a
+                                              dropping handler is spilled */
+static GQueue                queue = G_QUEUE_INIT; /* most recently used at the head */
+static GeglTileCompressStats stats;
+
+
+G_DEFINE_TYPE (GeglTileHandlerCompress, gegl_tile_handler_compress,
+               GEGL_TYPE_TILE_HANDLER)
+
+
+/* Pixel run length encoding: a header byte n < 128 is followed by n + 1
+ * literal pixels, a header byte n >= 128 by one pixel to be repeated
+ * n - 126 times.  Returns the encoded length, or -1 if it would exceed
+ * max_length.
+ */
+static gint
+compress_rle (const guchar *src,
+              gint          n_pixels,
+              gint          px_size,
+              guchar       *dest,
+              gint          max_length)
+{
+  gint i   = 0;
+  gint out = 0;
+
+  while (i < n_pixels)
+    {
+      const guchar *pixel = src + i * px_size;
+      gint          run   = 1;
+
+      while (i + run < n_pixels && run < 129 &&
+             !memcmp (pixel + run * px_size, pixel, px_size))
+        run++;
+
+      if (run >= 2)
+        {
+          if (out + 1 + px_size > max_length)
+            return -1;
+
+          dest[out++] = run + 126;
+          memcpy (dest + out, pixel, px_size);
+          out += px_size;
+          i   += run;
+        }
+      else
+        {
+          gint literal = 1;
+
+          /* take pixels up to the start of the next run */
+          while (i + literal < n_pixels && literal < 128 &&
+                 (i + literal + 1 >= n_pixels ||
+                  memcmp (pixel + literal * px_size,
+                          pixel + (literal + 1) * px_size, px_size)))
+            literal++;
+
+          if (out + 1 + literal * px_size > max_length)
+            return -1;
+
+          dest[out++] = literal - 1;
+          memcpy (dest + out, pixel, literal * px_size);
+          out += literal * px_size;
+          i   += literal;
+        }
+    }
+
+  return out;
+}
+
+static void
+decompress_rle (const guchar *src,
+                gint          length,
+                gint          px_size,
+                guchar       *dest)
+{
+  const guchar *end = src + length;
+
+  while (src < end)
+    {
+      gint n = *src++;
+
+      if (n < 128)
+        {
+          memcpy (dest, src, (n + 1) * px_size);
+          dest += (n + 1) * px_size;
+          src  += (n + 1) * px_size;
+        }
+      else
+        {
+          gint i;
+
+          for (i = 0; i < n - 126; i++)
+            {
+              memcpy (dest, src, px_size);
+              dest += px_size;
+            }
+          src += px_size;
+        }
+    }
+}
+
+static void
+decompress_uniform (const guchar *pixel,
+                    gint          px_size,
+                    guchar       *dest,
+                    gint          tile_size)
+{
+  gint filled = px_size;
+
+  memcpy (dest, pixel, px_size);
+
+  /* double the filled part until the tile is full */
+  while (filled < tile_size)
+    {
+      gint n = MIN (filled, tile_size - filled);
+
+      memcpy (dest + filled, dest, n);
+      filled += n;
+    }
+}
+
+static GeglTile *
+compressed_tile_decompress (GeglTileHandlerCompress *self,
+                            CompressedTile          *ctile)
+{
+  GeglTile *tile = gegl_tile_new (self->tile_size);
+
+  if (ctile->kind == COMPRESS_UNIFORM)
+    decompress_uniform (ctile->data, self->px_size,
+                        gegl_tile_get_data (tile), self->tile_size);
+  else
+    decompress_rle (ctile->data, ctile->length, self->px_size,
+                    gegl_tile_get_data (tile));
+
+  return tile;
+}
+
+static CompressedTile *
+lookup (GeglTileHandlerCompress *self,
+        gint                     x,
+        gint                     y,
+        gint                     z)
+{
+  CompressedTile key;
+
+  key.x = x;
+  key.y = y;
+  key.z = z;
+
+  return g_hash_table_lookup (self->tiles, &key);
+}
+
+/* frees a compressed tile that has already been unlinked from the queue */
+static void
+compressed_tile_free (CompressedTile *ctile)
+{
+  g_hash_table_remove (ctile->handler->tiles, ctile);
+  g_free (ctile->data);
+  g_slice_free (CompressedTile, ctile);
+}
+
+static void
+compressed_tile_unlink (CompressedTile *ctile)
+{
+  g_queue_unlink (&queue, &ctile->link);
+  stats.size     -= ctile->length;
+  stats.raw_size -= ctile->handler->tile_size;
+}
+
+static void
+drop_tile (GeglTileHandlerCompress *self,
+           gint                     x,
+           gint                     y,
+           gint                     z)
+{
+  CompressedTile *ctile = lookup (self, x, y, z);
+
+  if (ctile)
+    {
+      g_mutex_lock (&mutex);
+      compressed_tile_unlink (ctile);
+      g_mutex_unlock (&mutex);
+
+      compressed_tile_free (ctile);
+    }
+}
+
+/* write a compressed tile on to the backend of its handler, the caller
+ * holds the storage mutex of the handler and has unlinked the tile.
+ */
+static void
+spill_tile (CompressedTile *ctile)
+{
+  GeglTileHandlerCompress *self   = ctile->handler;
+  GeglTileSource          *source = gegl_tile_handler_get_source (self);
+  GeglTile                *tile   = compressed_tile_decompress (self, ctile);
+
+  if (source)
+    gegl_tile_source_set_tile (source, ctile->x, ctile->y, ctile->z, tile);
+
+  gegl_tile_mark_as_stored (tile);
+  gegl_tile_unref (tile);
+
+  compressed_tile_free (ctile);
+}
+
+/* Spill least recently used tiles until the tier is within budget, the
+ * caller holds the storage mutex of @self.  Tiles of other buffers are only
+ * spilled if their storage can be locked without waiting, since their
+ * owners might be waiting for our mutex.
+ */
+static void
+trim (GeglTileHandlerCompress *self)
+{
+  guint64  budget = gegl_config ()->compressed_cache_size;
+  GList   *link;
+
+  g_mutex_lock (&mutex);
+
+  link = g_queue_peek_tail_link (&queue);
+
+  while (stats.size > budget && link)
+    {
+      CompressedTile          *ctile   = link->data;
+      GeglTileHandlerCompress *handler = ctile->handler;
+      GeglTileStorage         *storage = _gegl_tile_handler_get_tile_storage (
+                                           GEGL_TILE_HANDLER (handler));
+
+      if (handler != self &&
+          (handler->dropping ||
+           storage == NULL || !g_rec_mutex_trylock (&storage->mutex)))
+        {
+          link = link->prev;
+          continue;
+        }
+
+      compressed_tile_unlink (ctile);
+      stats.spilled++;
+      handler->n_spilling++;
+      g_mutex_unlock (&mutex);
+
+      spill_tile (ctile);
+
+      if (handler != self)
+        g_rec_mutex_unlock (&storage->mutex);
+
+      g_mutex_lock (&mutex);
+      if (--handler->n_spilling == 0 && handler->dropping)
+        g_cond_broadcast (&spilled_cond);
+      link = g_queue_peek_tail_link (&queue);
+    }
+
+  g_mutex_unlock (&mutex);
+}
+
+static GeglTile *
+get_tile (GeglTileHandlerCompress *self,
+          gint                     x,
+          gint                     y,
+          gint                     z)
+{
+  CompressedTile *ctile = lookup (self, x, y, z);
+  GeglTile       *tile;
+
+  g_mutex_lock (&mutex);
+  if (ctile)
+    {
+      g_queue_unlink (&queue, &ctile->link);
+      g_queue_push_head_link (&queue, &ctile->link);
+      stats.hits++;
+    }
+  else
+    {
+      stats.misses++;
+    }
+  g_mutex_unlock (&mutex);
+
+  if (!ctile)
+    return gegl_tile_handler_source_command (self, GEGL_TILE_GET,
+                                             x, y, z, NULL);
+
+  /* the tile stays in the tier, so it is stored as it is */
+  tile = compressed_tile_decompress (self, ctile);
+  gegl_tile_mark_as_stored (tile);
+
+  return tile;
+}
+
+static gpointer
+set_tile (GeglTileHandlerCompress *self,
+          GeglTile                *tile,
+          gint                     x,
+          gint                     y,
+          gint                     z)
+{
+  const guchar   *data     = gegl_tile_get_data (tile);
+  gint            n_pixels = self->tile_size / self->px_size;
+  CompressedTile *ctile;
+  CompressKind    kind;
+  gint            length;
+
+  drop_tile (self, x, y, z);
+
+  if (tile->is_zero_tile ||
+      !memcmp (data, data + self->px_size, self->tile_size - self->px_size))
+    {
+      kind   = COMPRESS_UNIFORM;
+      length = self->px_size;
+      memcpy (self->scratch, data, length);
+    }
+  else
+    {
+      kind   = COMPRESS_RLE;
+      length = compress_rle (data, n_pixels, self->px_size, self->scratch,
+                             COMPRESS_MAX_RATIO (self->tile_size));
+    }
+
+  if (length < 0)
+    {
+      g_mutex_lock (&mutex);
+      stats.rejected++;
+      g_mutex_unlock (&mutex);
+
+      return gegl_tile_handler_source_command (self, GEGL_TILE_SET,
+                                               x, y, z, tile);
+    }
+
+  ctile            = g_slice_new (CompressedTile);
+  ctile->handler   = self;
+  ctile->link.data = ctile;
+  ctile->link.next = NULL;
+  ctile->link.prev = NULL;
+  ctile->x         = x;
+  ctile->y         = y;
+  ctile->z         = z;
+  ctile->kind      = kind;
+  ctile->length    = length;
+  ctile->data      = g_memdup (self->scratch, length);
+
+  g_hash_table_insert (self->tiles, ctile, ctile);
+
+  /* an older version of the tile might still be in the backend */
+  gegl_tile_handler_source_command (self, GEGL_TILE_VOID, x, y, z, NULL);
+
+  g_mutex_lock (&mutex);
+  g_queue_push_head_link (&queue, &ctile->link);
+  stats.size     += length;
+  stats.raw_size += self->tile_size;
+  stats.stored++;
+  if (kind == COMPRESS_UNIFORM)
+    stats.uniform++;
+  g_mutex_unlock (&mutex);
+
+  gegl_tile_mark_as_stored (tile);
+
+  trim (self);
+
+  return GINT_TO_POINTER (TRUE);
+}
+
+/* Drops all tiles of @self, which might be spilled by trim() on another
+ * thread meanwhile; spills in progress are waited for, and no new ones are
+ * started, before the tiles are collected.
+ */
+static void
+drop_all (GeglTileHandlerCompress *self)
+{
+  GList *tiles;
+  GList *iter;
+
+  g_mutex_lock (&mutex);
+  self->dropping = TRUE;
+  while (self->n_spilling > 0)
+    g_cond_wait (&spilled_cond, &mutex);
+
+  tiles = g_hash_table_get_values (self->tiles);
+  for (iter = tiles; iter; iter = iter->next)
+    compressed_tile_unlink (iter->data);
+  self->dropping = FALSE;
+  g_mutex_unlock (&mutex);
+
+  for (iter = tiles; iter; iter = iter->next)
+    compressed_tile_free (iter->data);
+
+  g_list_free (tiles);
+}
+
+static gpointer
+gegl_tile_handler_compress_command (GeglTileSource  *source,
+                                    GeglTileCommand  command,
+                                    gint             x,
+                                    gint             y,
+                                    gint             z,
+                                    gpointer         data)
+{
+  GeglTileHandlerCompress *self = (GeglTileHandlerCompress *) source;
+
+  switch (command)
+    {
+      case GEGL_TILE_GET:
+        return get_tile (self, x, y, z);
+      case GEGL_TILE_SET:
+        return set_tile (self, data, x, y, z);
+      case GEGL_TILE_EXIST:
+        if (lookup (self, x, y, z))
+          return GINT_TO_POINTER (TRUE);
+        break;
+      case GEGL_TILE_VOID:
+        drop_tile (self, x, y, z);
+        break;
+      case GEGL_TILE_REINIT:
+        drop_all (self);
+        break;
+      default:
+        break;
+    }
+
+  return gegl_tile_handler_source_command (source, command, x, y, z, data);
+}
+
+static guint
+gegl_tile_handler_compress_hashfunc (gconstpointer key)
+{
+  const CompressedTile *e = key;
+  guint                 hash;
+  gint                  i;
+
+  /* interleave the 10 least significant bits of all coordinates */
+  hash = 0;
+  for (i = 9; i >= 0; i--)
+    {
+#define ADD_BIT(bit)    do { hash |= (((bit) != 0) ? 1 : 0); hash <<= 1; } while (0)
+      ADD_BIT (e->x & (1 << i));
+      ADD_BIT (e->y & (1 << i));
+      ADD_BIT (e->z & (1 << i));
+#undef ADD_BIT
+    }
+  return hash;
+}
+
+static gboolean
+gegl_tile_handler_compress_equalfunc (gconstpointer a,
+                                      gconstpointer b)
+{
+  const CompressedTile *ea = a;
+  const CompressedTile *eb = b;
+
+  return ea->x == eb->x &&
+         ea->y == eb->y &&
+         ea->z == eb->z;
+}
+
+static void
+gegl_tile_handler_compress_dispose (GObject *object)
+{
+  GeglTileHandlerCompress *self = GEGL_TILE_HANDLER_COMPRESS (object);
+
+  if (self->tiles)
+    {
+      drop_all (self);
+      g_hash_table_unref (self->tiles);
+      self->tiles = NULL;
+    }
+
+  G_OBJECT_CLASS (gegl_tile_handler_compress_parent_class)->dispose (object);
+}
+
+static void
+gegl_tile_handler_compress_finalize (GObject *object)
+{
+  GeglTileHandlerCompress *self = GEGL_TILE_HANDLER_COMPRESS (object);
+
+  g_free (self->scratch);
+
+  G_OBJECT_CLASS (gegl_tile_handler_compress_parent_class)->finalize (object);
+}
+
+static void
+gegl_tile_handler_compress_class_init (GeglTileHandlerCompressClass *klass)
+{
+  GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+
+  gobject_class->dispose  = gegl_tile_handler_compress_dispose;
+  gobject_class->finalize = gegl_tile_handler_compress_finalize;
+}
+
+static void
+gegl_tile_handler_compress_init (GeglTileHandlerCompress *self)
+{
+  ((GeglTileSource *) self)->command = gegl_tile_handler_compress_command;
+
+  self->tiles = g_hash_table_new (gegl_tile_handler_compress_hashfunc,
+                                  gegl_tile_handler_compress_equalfunc);
+}
+
+GeglTileHandler *
+gegl_tile_handler_compress_new (GeglTileBackend *backend)
+{
+  GeglTileHandlerCompress *self = g_object_new (GEGL_TYPE_TILE_HANDLER_COMPRESS, NULL);
+
+  self->tile_size = gegl_tile_backend_get_tile_size (backend);
+  self->px_size   = babl_format_get_bytes_per_pixel (gegl_tile_backend_get_format (backend));
+  self->scratch   = g_malloc (COMPRESS_MAX_RATIO (self->tile_size));
+
+  return (GeglTileHandler *) self;
+}
+
+void
+gegl_tile_handler_compress_get_stats (GeglTileCompressStats *stats_out)
+{
+  g_mutex_lock (&mutex);
+  *stats_out = stats;
+  g_mutex_unlock (&mutex);
+}
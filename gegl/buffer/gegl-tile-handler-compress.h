@@ -0,0 +1,84 @@
+/* This file is part of GEGL.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GEGL_TILE_HANDLER_COMPRESS_H__
+#define __GEGL_TILE_HANDLER_COMPRESS_H__
+
+#include "gegl-tile-handler.h"
+
+/***
+ * GeglTileHandlerCompress sits between the tile cache and the backend, and
+ * keeps the tiles stored by the cache in memory in compressed form. Uniform
+ * tiles are kept as a single pixel, other tiles are run length encoded, and
+ * tiles that don't compress well are passed on to the backend. When the
+ * compressed tiles of all buffers exceed the compressed-cache-size, the
+ * least recently used ones are written on to their backends.
+ */
+
+G_BEGIN_DECLS
+
+#define GEGL_TYPE_TILE_HANDLER_COMPRESS            (gegl_tile_handler_compress_get_type ())
+#define GEGL_TILE_HANDLER_COMPRESS(obj)            (G_TYPE_CHECK_INSTANCE_CAST ((obj), GEGL_TYPE_TILE_HANDLER_COMPRESS, GeglTileHandlerCompress))
+#define GEGL_TILE_HANDLER_COMPRESS_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST ((klass),  GEGL_TYPE_TILE_HANDLER_COMPRESS, GeglTileHandlerCompressClass))
+#define GEGL_IS_TILE_HANDLER_COMPRESS(obj)         (G_TYPE_CHECK_INSTANCE_TYPE ((obj), GEGL_TYPE_TILE_HANDLER_COMPRESS))
+#define GEGL_IS_TILE_HANDLER_COMPRESS_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE ((klass),  GEGL_TYPE_TILE_HANDLER_COMPRESS))
+#define GEGL_TILE_HANDLER_COMPRESS_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS ((obj),  GEGL_TYPE_TILE_HANDLER_COMPRESS, GeglTileHandlerCompressClass))
+
+
+typedef struct _GeglTileHandlerCompress      GeglTileHandlerCompress;
+typedef struct _GeglTileHandlerCompressClass GeglTileHandlerCompressClass;
+
+struct _GeglTileHandlerCompress
+{
+  GeglTileHandler  parent_instance;
+
+  GHashTable      *tiles;     /* the compressed tiles, by coordinates */
+  gint             tile_size;
+  gint             px_size;
+  guchar          *scratch;   /* room for one compressed tile */
+  gboolean         dropping;  /* all tiles are being dropped, they aren't
+                                 to be spilled anymore */
+  gint             n_spilling; /* tiles being spilled by other threads */
+};
+
+struct _GeglTileHandlerCompressClass
+{
+  GeglTileHandlerClass parent_class;
+};
+
+typedef struct
+{
+  guint64 hits;      /* tiles read back from the compressed tier */
+  guint64 misses;    /* tile reads passed on to the backend */
+  guint64 stored;    /* tiles stored in the compressed tier */
+  guint64 uniform;   /* stored tiles that were a single color */
+  guint64 rejected;  /* tiles passed on to the backend as they didn't
+                        compress well enough */
+  guint64 spilled;   /* tiles written on to the backend to stay within
+                        the compressed-cache-size */
+  guint64 size;      /* bytes held by compressed tiles */
+  guint64 raw_size;  /* uncompressed size of the tiles held */
+} GeglTileCompressStats;
+
+GType             gegl_tile_handler_compress_get_type  (void) G_GNUC_CONST;
+
+GeglTileHandler * gegl_tile_handler_compress_new       (GeglTileBackend       *backend);
+
+void              gegl_tile_handler_compress_get_stats (GeglTileCompressStats *stats);
+
+G_END_DECLS
+
+#endif
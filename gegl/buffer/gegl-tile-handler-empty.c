@@ -42,8 +42,8 @@ finalize (GObject *object)
   G_OBJECT_CLASS (gegl_tile_handler_empty_parent_class)->finalize (object);
 }
 
-static GeglTile *
-_new_empty_tile (const gint tile_size)
+GeglTile *
+gegl_tile_handler_empty_new_tile (gint tile_size)
 {
   static GeglTile   *common_tile = NULL;
   static const gint  common_empty_size = sizeof (gdouble) * 4 * 128 * 128;
@@ -100,7 +100,7 @@ get_tile (GeglTileSource *gegl_tile_source,
   if (!empty->tile)
     {
       gint tile_size = gegl_tile_backend_get_tile_size (empty->backend);
-      empty->tile    = _new_empty_tile (tile_size);
+      empty->tile    = gegl_tile_handler_empty_new_tile (tile_size);
     }
 
   return gegl_tile_handler_dup_tile (GEGL_TILE_HANDLER (empty),
@@ -28,6 +28,9 @@
 #include "gegl-tile-handler-empty.h"
 #include "gegl-tile-handler-zoom.h"
 #include "gegl-tile-handler-cache.h"
+#include "gegl-tile-handler-compress.h"
+#include "gegl-tile-backend-ram.h"
+#include "gegl-tile-backend-swap.h"
 #include "gegl-tile-handler-log.h"
 #include "gegl-tile-handler-private.h"
 #include "gegl-types-internal.h"
@@ -76,6 +79,17 @@ gegl_tile_storage_new (GeglTileBackend *backend)
   _gegl_tile_handler_set_tile_storage (handler, tile_storage);
   _gegl_tile_handler_set_cache (handler, (GeglTileHandlerCache *) cache);
 
+  /* keep tiles evicted from the cache compressed in memory before they go
+   * to swap, file backends are left alone as their tiles should persist */
+  if (gegl_config ()->compressed_cache_size > 0 &&
+      (GEGL_IS_TILE_BACKEND_SWAP (backend) || GEGL_IS_TILE_BACKEND_RAM (backend)))
+    {
+      GeglTileHandler *compress = gegl_tile_handler_compress_new (backend);
+
+      gegl_tile_handler_chain_add (tile_handler_chain, compress);
+      g_object_unref (compress);
+    }
+
   gegl_tile_handler_chain_add (tile_handler_chain, cache);
   gegl_tile_handler_chain_add (tile_handler_chain, zoom);
   gegl_tile_handler_chain_add (tile_handler_chain, empty);
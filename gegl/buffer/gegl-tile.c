@@ -31,6 +31,7 @@
 #include "gegl.h"
 #include "gegl-buffer.h"
 #include "gegl-tile.h"
+#include "gegl-tile-alloc.h"
 #include "gegl-buffer-private.h"
 #include "gegl-tile-source.h"
 #include "gegl-tile-storage.h"
@@ -67,7 +68,7 @@ void gegl_tile_unref (GeglTile *tile)
           if (tile->destroy_notify)
             {
               if (tile->destroy_notify == (void*)&free_data_directly)
-                gegl_free (tile->data);
+                gegl_tile_free (tile->data, tile->size);
               else
                 tile->destroy_notify (tile->destroy_notify_data);
             }
@@ -137,7 +138,7 @@ gegl_tile_new (gint size)
 {
   GeglTile *tile = gegl_tile_new_bare ();
 
-  tile->data = gegl_malloc (size);
+  tile->data = gegl_tile_alloc (size);
   tile->size = size;
 
   return tile;
@@ -147,7 +148,7 @@ static gpointer
 gegl_memdup (gpointer src, gsize size)
 {
   gpointer ret;
-  ret = gegl_malloc (size);
+  ret = gegl_tile_alloc (size);
   memcpy (ret, src, size);
   return ret;
 }
@@ -169,7 +170,7 @@ gegl_tile_unclone (GeglTile *tile)
        */
       if (tile->is_zero_tile)
         {
-          tile->data = gegl_calloc (tile->size, 1);
+          tile->data = gegl_tile_alloc0 (tile->size);
           tile->is_zero_tile = 0;
         }
       else
@@ -0,0 +1,542 @@
+/* This file is part of GEGL.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* AVX2 versions of the 2x2 downscale and the boxfilter for pixels with four
+ * components. This file is built with AVX2 enabled, and its functions are
+ * only called after gegl_cpu_accel_get_support () reported AVX2.
+ *
+ * The results have to be the same as those of the scalar code in
+ * gegl-algorithms.c, so the sums are done in the same order, and FMA is not
+ * used: fusing the multiplies and adds of the boxfilter rounds differently.
+ */
+
+#include "config.h"
+
+#include <string.h>
+#include <immintrin.h>
+
+#include <glib-object.h>
+
+#include <babl/babl.h>
+
+#include "gegl-types.h"
+#include "gegl-algorithms.h"
+
+#define ALWAYS_INLINE inline __attribute__ ((always_inline))
+
+typedef enum
+{
+  COMPONENT_FLOAT,
+  COMPONENT_U16,
+  COMPONENT_U8
+} ComponentType;
+
+void
+gegl_downscale_2x2_float_avx2 (gint    bpp,
+                               gint    src_width,
+                               gint    src_height,
+                               guchar *src_data,
+                               gint    src_rowstride,
+                               guchar *dst_data,
+                               gint    dst_rowstride)
+{
+  const gint   dst_width = src_width / 2;
+  const __m256 quarter   = _mm256_set1_ps (0.25f);
+  gint         y;
+
+  if (bpp != 4 * sizeof (gfloat))
+    {
+      gegl_downscale_2x2_float (bpp, src_width, src_height,
+                                src_data, src_rowstride,
+                                dst_data, dst_rowstride);
+      return;
+    }
+
+  if (!src_data || !dst_data)
+    return;
+
+  for (y = 0; y < src_height / 2; y++)
+    {
+      const gfloat *a   = (gfloat *) (src_data + src_rowstride * y * 2);
+      const gfloat *b   = (gfloat *) (src_data + src_rowstride * y * 2 +
+                                      src_rowstride);
+      gfloat       *dst = (gfloat *) (dst_data + dst_rowstride * y);
+      gint          x;
+
+      /* two destination pixels from four source pixels of each row */
+      for (x = 0; x + 2 <= dst_width; x += 2)
+        {
+          const __m256 a01 = _mm256_loadu_ps (a);
+          const __m256 a23 = _mm256_loadu_ps (a + 8);
+          const __m256 b01 = _mm256_loadu_ps (b);
+          const __m256 b23 = _mm256_loadu_ps (b + 8);
+          __m256       sum;
+
+          /* source pixels 0 and 2 with 1 and 3 */
+          sum = _mm256_add_ps (_mm256_permute2f128_ps (a01, a23, 0x20),
+                               _mm256_permute2f128_ps (a01, a23, 0x31));
+          sum = _mm256_add_ps (sum, _mm256_permute2f128_ps (b01, b23, 0x20));
+          sum = _mm256_add_ps (sum, _mm256_permute2f128_ps (b01, b23, 0x31));
+
+          /* multiplying by a quarter rounds the same as dividing by four */
+          _mm256_storeu_ps (dst, _mm256_mul_ps (sum, quarter));
+
+          a   += 16;
+          b   += 16;
+          dst += 8;
+        }
+
+      for (; x < dst_width; x++)
+        {
+          __m128 sum;
+
+          sum = _mm_add_ps (_mm_loadu_ps (a), _mm_loadu_ps (a + 4));
+          sum = _mm_add_ps (sum, _mm_loadu_ps (b));
+          sum = _mm_add_ps (sum, _mm_loadu_ps (b + 4));
+
+          _mm_storeu_ps (dst, _mm_mul_ps (sum, _mm256_castps256_ps128 (quarter)));
+
+          a   += 8;
+          b   += 8;
+          dst += 4;
+        }
+    }
+}
+
+/* averages the two pixels in each 128 bit lane of @a and @b, which hold
+ * source pixels 0, 2 and 1, 3 of the two rows, into two destination pixels
+ * of 32 bit components
+ */
+static ALWAYS_INLINE __m256i
+downscale_u16_lanes (__m256i a,
+                     __m256i b)
+{
+  __m256i sum;
+
+  sum = _mm256_add_epi32 (_mm256_cvtepu16_epi32 (_mm256_castsi256_si128 (a)),
+                          _mm256_cvtepu16_epi32 (_mm256_extracti128_si256 (a, 1)));
+  sum = _mm256_add_epi32 (sum,
+                          _mm256_cvtepu16_epi32 (_mm256_castsi256_si128 (b)));
+  sum = _mm256_add_epi32 (sum,
+                          _mm256_cvtepu16_epi32 (_mm256_extracti128_si256 (b, 1)));
+
+  return _mm256_srli_epi32 (sum, 2);
+}
+
+void
+gegl_downscale_2x2_u16_avx2 (gint    bpp,
+                             gint    src_width,
+                             gint    src_height,
+                             guchar *src_data,
+                             gint    src_rowstride,
+                             guchar *dst_data,
+                             gint    dst_rowstride)
+{
+  const gint dst_width = src_width / 2;
+  gint       y;
+
+  if (bpp != 4 * sizeof (guint16))
+    {
+      gegl_downscale_2x2_u16 (bpp, src_width, src_height,
+                              src_data, src_rowstride,
+                              dst_data, dst_rowstride);
+      return;
+    }
+
+  if (!src_data || !dst_data)
+    return;
+
+  for (y = 0; y < src_height / 2; y++)
+    {
+      const guint16 *a   = (guint16 *) (src_data + src_rowstride * y * 2);
+      const guint16 *b   = (guint16 *) (src_data + src_rowstride * y * 2 +
+                                        src_rowstride);
+      guint16       *dst = (guint16 *) (dst_data + dst_rowstride * y);
+      gint           x;
+
+      /* four destination pixels from eight source pixels of each row */
+      for (x = 0; x + 4 <= dst_width; x += 4)
+        {
+          const gint order = _MM_SHUFFLE (3, 1, 2, 0);
+          __m256i    a0 = _mm256_loadu_si256 ((const __m256i *) a);
+          __m256i    a1 = _mm256_loadu_si256 ((const __m256i *) (a + 16));
+          __m256i    b0 = _mm256_loadu_si256 ((const __m256i *) b);
+          __m256i    b1 = _mm256_loadu_si256 ((const __m256i *) (b + 16));
+          __m256i    sum0, sum1;
+
+          a0 = _mm256_permute4x64_epi64 (a0, order);
+          a1 = _mm256_permute4x64_epi64 (a1, order);
+          b0 = _mm256_permute4x64_epi64 (b0, order);
+          b1 = _mm256_permute4x64_epi64 (b1, order);
+
+          sum0 = downscale_u16_lanes (a0, b0);
+          sum1 = downscale_u16_lanes (a1, b1);
+
+          /* packing interleaves the lanes, put the pixels back in order */
+          _mm256_storeu_si256 ((__m256i *) dst,
+                               _mm256_permute4x64_epi64 (
+                                 _mm256_packus_epi32 (sum0, sum1), order));
+
+          a   += 32;
+          b   += 32;
+          dst += 16;
+        }
+
+      for (; x < dst_width; x++)
+        {
+          gint i;
+
+          for (i = 0; i < 4; i++)
+            dst[i] = ((guint) a[i] + a[i + 4] + b[i] + b[i + 4]) / 4;
+
+          a   += 8;
+          b   += 8;
+          dst += 4;
+        }
+    }
+}
+
+/* averages the even and odd source pixels of the rows @a and @b, which hold
+ * the even pixels in their lower and the odd ones in their upper lane, into
+ * four destination pixels of 16 bit components
+ */
+static ALWAYS_INLINE __m256i
+downscale_u8_lanes (__m256i a,
+                    __m256i b)
+{
+  __m256i sum;
+
+  sum = _mm256_add_epi16 (_mm256_cvtepu8_epi16 (_mm256_castsi256_si128 (a)),
+                          _mm256_cvtepu8_epi16 (_mm256_extracti128_si256 (a, 1)));
+  sum = _mm256_add_epi16 (sum,
+                          _mm256_cvtepu8_epi16 (_mm256_castsi256_si128 (b)));
+  sum = _mm256_add_epi16 (sum,
+                          _mm256_cvtepu8_epi16 (_mm256_extracti128_si256 (b, 1)));
+
+  return _mm256_srli_epi16 (sum, 2);
+}
+
+void
+gegl_downscale_2x2_u8_avx2 (gint    bpp,
+                            gint    src_width,
+                            gint    src_height,
+                            guchar *src_data,
+                            gint    src_rowstride,
+                            guchar *dst_data,
+                            gint    dst_rowstride)
+{
+  const gint dst_width = src_width / 2;
+  gint       y;
+
+  if (bpp != 4)
+    {
+      gegl_downscale_2x2_u8 (bpp, src_width, src_height,
+                             src_data, src_rowstride,
+                             dst_data, dst_rowstride);
+      return;
+    }
+
+  if (!src_data || !dst_data)
+    return;
+
+  for (y = 0; y < src_height / 2; y++)
+    {
+      const guint8 *a   = src_data + src_rowstride * y * 2;
+      const guint8 *b   = src_data + src_rowstride * y * 2 + src_rowstride;
+      guint8       *dst = dst_data + dst_rowstride * y;
+      gint          x;
+
+      /* eight destination pixels from sixteen source pixels of each row */
+      for (x = 0; x + 8 <= dst_width; x += 8)
+        {
+          const __m256i even_odd = _mm256_setr_epi32 (0, 2, 4, 6, 1, 3, 5, 7);
+          __m256i       a0 = _mm256_loadu_si256 ((const __m256i *) a);
+          __m256i       a1 = _mm256_loadu_si256 ((const __m256i *) (a + 32));
+          __m256i       b0 = _mm256_loadu_si256 ((const __m256i *) b);
+          __m256i       b1 = _mm256_loadu_si256 ((const __m256i *) (b + 32));
+          __m256i       sum0, sum1;
+
+          a0 = _mm256_permutevar8x32_epi32 (a0, even_odd);
+          a1 = _mm256_permutevar8x32_epi32 (a1, even_odd);
+          b0 = _mm256_permutevar8x32_epi32 (b0, even_odd);
+          b1 = _mm256_permutevar8x32_epi32 (b1, even_odd);
+
+          sum0 = downscale_u8_lanes (a0, b0);
+          sum1 = downscale_u8_lanes (a1, b1);
+
+          /* packing interleaves the lanes, put the pixels back in order */
+          _mm256_storeu_si256 ((__m256i *) dst,
+                               _mm256_permute4x64_epi64 (
+                                 _mm256_packus_epi16 (sum0, sum1),
+                                 _MM_SHUFFLE (3, 1, 2, 0)));
+
+          a   += 64;
+          b   += 64;
+          dst += 32;
+        }
+
+      for (; x < dst_width; x++)
+        {
+          gint i;
+
+          for (i = 0; i < 4; i++)
+            dst[i] = ((guint) a[i] + a[i + 4] + b[i] + b[i + 4]) / 4;
+
+          a   += 8;
+          b   += 8;
+          dst += 4;
+        }
+    }
+}
+
+static inline int int_floorf (float x)
+{
+  int i = (int)x; /* truncate */
+  return i - ( i > x ); /* convert trunc to floor */
+}
+
+static ALWAYS_INLINE __m128
+boxfilter_load (const guchar  *src,
+                ComponentType  type)
+{
+  switch (type)
+    {
+    case COMPONENT_FLOAT:
+      return _mm_loadu_ps ((const gfloat *) src);
+
+    case COMPONENT_U16:
+      return _mm_cvtepi32_ps (
+               _mm_cvtepu16_epi32 (_mm_loadl_epi64 ((const __m128i *) src)));
+
+    case COMPONENT_U8:
+    default:
+      {
+        gint32 pixel;
+
+        memcpy (&pixel, src, sizeof (pixel));
+
+        return _mm_cvtepi32_ps (_mm_cvtepu8_epi32 (_mm_cvtsi32_si128 (pixel)));
+      }
+    }
+}
+
+static ALWAYS_INLINE gboolean
+boxfilter_transparent (const guchar  *src,
+                       ComponentType  type)
+{
+  switch (type)
+    {
+    case COMPONENT_FLOAT:
+      return ((const gfloat *) src)[3] == 0;
+
+    case COMPONENT_U16:
+      return ((const guint16 *) src)[3] == 0;
+
+    case COMPONENT_U8:
+    default:
+      return src[3] == 0;
+    }
+}
+
+/* stores @sum, rounding it like BOXFILTER_ROUND () does for integer types,
+ * by adding one half in double precision and truncating
+ */
+static ALWAYS_INLINE void
+boxfilter_store (guchar        *dst,
+                 __m128         sum,
+                 ComponentType  type)
+{
+  __m128i rounded;
+
+  if (type == COMPONENT_FLOAT)
+    {
+      _mm_storeu_ps ((gfloat *) dst, sum);
+      return;
+    }
+
+  rounded = _mm256_cvttpd_epi32 (_mm256_add_pd (_mm256_cvtps_pd (sum),
+                                                _mm256_set1_pd (0.5)));
+  rounded = _mm_packus_epi32 (rounded, rounded);
+
+  if (type == COMPONENT_U16)
+    {
+      _mm_storel_epi64 ((__m128i *) dst, rounded);
+    }
+  else
+    {
+      gint32 pixel = _mm_cvtsi128_si32 (_mm_packus_epi16 (rounded, rounded));
+
+      memcpy (dst, &pixel, sizeof (pixel));
+    }
+}
+
+/* the four component case of gegl-algorithms-boxfilter.inc, with the
+ * components of a pixel computed at once
+ */
+static ALWAYS_INLINE void
+boxfilter_rgba (guchar              *dest_buf,
+                const guchar        *source_buf,
+                const GeglRectangle *dst_rect,
+                const GeglRectangle *src_rect,
+                const gint           s_rowstride,
+                const gdouble        scale,
+                const gint           bpp,
+                const gint           d_rowstride,
+                ComponentType        type)
+{
+  const guchar *src[9];
+
+  gfloat left_weight[dst_rect->width];
+  gfloat center_weight[dst_rect->width];
+  gfloat right_weight[dst_rect->width];
+
+  gint   jj[dst_rect->width];
+
+  for (gint x = 0; x < dst_rect->width; x++)
+  {
+    gfloat sx  = (dst_rect->x + x + .5) / scale - src_rect->x;
+    jj[x]  = int_floorf (sx);
+
+    left_weight[x]   = .5 - scale * (sx - jj[x]);
+    left_weight[x]   = MAX (0.0, left_weight[x]);
+    right_weight[x]  = .5 - scale * ((jj[x] + 1) - sx);
+    right_weight[x]  = MAX (0.0, right_weight[x]);
+    center_weight[x] = 1. - left_weight[x] - right_weight[x];
+
+    jj[x] *= bpp;
+  }
+
+  for (gint y = 0; y < dst_rect->height; y++)
+    {
+      gfloat top_weight, middle_weight, bottom_weight;
+      const gfloat sy = (dst_rect->y + y + .5) / scale - src_rect->y;
+      const gint     ii = int_floorf (sy);
+      guchar        *dst = dest_buf + y * d_rowstride;
+      const guchar  *src_base = source_buf + ii * s_rowstride;
+
+      top_weight    = .5 - scale * (sy - ii);
+      top_weight    = MAX (0., top_weight);
+      bottom_weight = .5 - scale * ((ii + 1 ) - sy);
+      bottom_weight = MAX (0., bottom_weight);
+      middle_weight = 1. - top_weight - bottom_weight;
+
+      for (gint x = 0; x < dst_rect->width; x++)
+        {
+          src[4] = src_base + jj[x];
+          src[1] = src[4] - s_rowstride;
+          src[7] = src[4] + s_rowstride;
+          src[2] = src[1] + bpp;
+          src[5] = src[4] + bpp;
+          src[8] = src[7] + bpp;
+          src[0] = src[1] - bpp;
+          src[3] = src[4] - bpp;
+          src[6] = src[7] - bpp;
+
+          if (boxfilter_transparent (src[0], type) &&
+              boxfilter_transparent (src[1], type) &&
+              boxfilter_transparent (src[2], type) &&
+              boxfilter_transparent (src[3], type) &&
+              boxfilter_transparent (src[4], type) &&
+              boxfilter_transparent (src[5], type) &&
+              boxfilter_transparent (src[6], type) &&
+              boxfilter_transparent (src[7], type))
+            {
+              memset (dst, 0, bpp);
+            }
+          else
+            {
+              const gfloat lt = left_weight[x] * top_weight;
+              const gfloat lm = left_weight[x] * middle_weight;
+              const gfloat lb = left_weight[x] * bottom_weight;
+              const gfloat ct = center_weight[x] * top_weight;
+              const gfloat cm = center_weight[x] * middle_weight;
+              const gfloat cb = center_weight[x] * bottom_weight;
+              const gfloat rt = right_weight[x] * top_weight;
+              const gfloat rm = right_weight[x] * middle_weight;
+              const gfloat rb = right_weight[x] * bottom_weight;
+              __m128       sum;
+
+              sum = _mm_mul_ps (boxfilter_load (src[0], type), _mm_set1_ps (lt));
+              sum = _mm_add_ps (sum, _mm_mul_ps (boxfilter_load (src[3], type), _mm_set1_ps (lm)));
+              sum = _mm_add_ps (sum, _mm_mul_ps (boxfilter_load (src[6], type), _mm_set1_ps (lb)));
+              sum = _mm_add_ps (sum, _mm_mul_ps (boxfilter_load (src[1], type), _mm_set1_ps (ct)));
+              sum = _mm_add_ps (sum, _mm_mul_ps (boxfilter_load (src[4], type), _mm_set1_ps (cm)));
+              sum = _mm_add_ps (sum, _mm_mul_ps (boxfilter_load (src[7], type), _mm_set1_ps (cb)));
+              sum = _mm_add_ps (sum, _mm_mul_ps (boxfilter_load (src[2], type), _mm_set1_ps (rt)));
+              sum = _mm_add_ps (sum, _mm_mul_ps (boxfilter_load (src[5], type), _mm_set1_ps (rm)));
+              sum = _mm_add_ps (sum, _mm_mul_ps (boxfilter_load (src[8], type), _mm_set1_ps (rb)));
+
+              boxfilter_store (dst, sum, type);
+            }
+
+          dst += bpp;
+        }
+    }
+}
+
+void
+gegl_resample_boxfilter_float_avx2 (guchar              *dest_buf,
+                                    const guchar        *source_buf,
+                                    const GeglRectangle *dst_rect,
+                                    const GeglRectangle *src_rect,
+                                    gint                 s_rowstride,
+                                    gdouble              scale,
+                                    gint                 bpp,
+                                    gint                 d_rowstride)
+{
+  if (bpp == 4 * sizeof (gfloat))
+    boxfilter_rgba (dest_buf, source_buf, dst_rect, src_rect,
+                    s_rowstride, scale, bpp, d_rowstride, COMPONENT_FLOAT);
+  else
+    gegl_resample_boxfilter_float (dest_buf, source_buf, dst_rect, src_rect,
+                                   s_rowstride, scale, bpp, d_rowstride);
+}
+
+void
+gegl_resample_boxfilter_u16_avx2 (guchar              *dest_buf,
+                                  const guchar        *source_buf,
+                                  const GeglRectangle *dst_rect,
+                                  const GeglRectangle *src_rect,
+                                  gint                 s_rowstride,
+                                  gdouble              scale,
+                                  gint                 bpp,
+                                  gint                 d_rowstride)
+{
+  if (bpp == 4 * sizeof (guint16))
+    boxfilter_rgba (dest_buf, source_buf, dst_rect, src_rect,
+                    s_rowstride, scale, bpp, d_rowstride, COMPONENT_U16);
+  else
+    gegl_resample_boxfilter_u16 (dest_buf, source_buf, dst_rect, src_rect,
+                                 s_rowstride, scale, bpp, d_rowstride);
+}
+
+void
+gegl_resample_boxfilter_u8_avx2 (guchar              *dest_buf,
+                                 const guchar        *source_buf,
+                                 const GeglRectangle *dst_rect,
+                                 const GeglRectangle *src_rect,
+                                 gint                 s_rowstride,
+                                 gdouble              scale,
+                                 gint                 bpp,
+                                 gint                 d_rowstride)
+{
+  if (bpp == 4)
+    boxfilter_rgba (dest_buf, source_buf, dst_rect, src_rect,
+                    s_rowstride, scale, bpp, d_rowstride, COMPONENT_U8);
+  else
+    gegl_resample_boxfilter_u8 (dest_buf, source_buf, dst_rect, src_rect,
+                                s_rowstride, scale, bpp, d_rowstride);
+}
@@ -27,9 +27,69 @@
 
 #include "gegl-types.h"
 #include "gegl-algorithms.h"
+#include "gegl-cpuaccel.h"
 
 #include <math.h>
 
+typedef void (* GeglDownscale2x2Func) (gint    bpp,
+                                       gint    src_width,
+                                       gint    src_height,
+                                       guchar *src_data,
+                                       gint    src_rowstride,
+                                       guchar *dst_data,
+                                       gint    dst_rowstride);
+
+typedef void (* GeglBoxfilterFunc) (guchar              *dest_buf,
+                                    const guchar        *source_buf,
+                                    const GeglRectangle *dst_rect,
+                                    const GeglRectangle *src_rect,
+                                    gint                 s_rowstride,
+                                    gdouble              scale,
+                                    gint                 bpp,
+                                    gint                 d_rowstride);
+
+/* the implementations used by the dispatchers below, replaced by vector
+ * versions in gegl_algorithms_init () when the CPU supports them
+ */
+static GeglDownscale2x2Func downscale_2x2_float = gegl_downscale_2x2_float;
+static GeglDownscale2x2Func downscale_2x2_u16   = gegl_downscale_2x2_u16;
+static GeglDownscale2x2Func downscale_2x2_u8    = gegl_downscale_2x2_u8;
+static GeglBoxfilterFunc    boxfilter_float     = gegl_resample_boxfilter_float;
+static GeglBoxfilterFunc    boxfilter_u16       = gegl_resample_boxfilter_u16;
+static GeglBoxfilterFunc    boxfilter_u8        = gegl_resample_boxfilter_u8;
+
+static void
+gegl_algorithms_init (void)
+{
+  static gsize initialized = 0;
+
+  if (g_once_init_enter (&initialized))
+    {
+#ifdef USE_AVX2
+      if (gegl_cpu_accel_get_support () & GEGL_CPU_ACCEL_X86_AVX2)
+        {
+          downscale_2x2_float = gegl_downscale_2x2_float_avx2;
+          downscale_2x2_u16   = gegl_downscale_2x2_u16_avx2;
+          downscale_2x2_u8    = gegl_downscale_2x2_u8_avx2;
+          boxfilter_float     = gegl_resample_boxfilter_float_avx2;
+          boxfilter_u16       = gegl_resample_boxfilter_u16_avx2;
+          boxfilter_u8        = gegl_resample_boxfilter_u8_avx2;
+        }
+#endif
+
+#ifdef USE_NEON
+      if (gegl_cpu_accel_get_support () & GEGL_CPU_ACCEL_ARM_NEON)
+        {
+          downscale_2x2_float = gegl_downscale_2x2_float_neon;
+          downscale_2x2_u16   = gegl_downscale_2x2_u16_neon;
+          downscale_2x2_u8    = gegl_downscale_2x2_u8_neon;
+        }
+#endif
+
+      g_once_init_leave (&initialized, 1);
+    }
+}
+
 void gegl_downscale_2x2 (const Babl *format,
                          gint    src_width,
                          gint    src_height,
@@ -41,12 +101,14 @@ void gegl_downscale_2x2 (const Babl *format,
   const gint  bpp = babl_format_get_bytes_per_pixel (format);
   const Babl *comp_type = babl_format_get_type (format, 0);
 
+  gegl_algorithms_init ();
+
   if (comp_type == babl_type ("float"))
-    gegl_downscale_2x2_float (bpp, src_width, src_height, src_data, src_rowstride, dst_data, dst_rowstride);
+    downscale_2x2_float (bpp, src_width, src_height, src_data, src_rowstride, dst_data, dst_rowstride);
   else if (comp_type == babl_type ("u8"))
-    gegl_downscale_2x2_u8 (bpp, src_width, src_height, src_data, src_rowstride, dst_data, dst_rowstride);
+    downscale_2x2_u8 (bpp, src_width, src_height, src_data, src_rowstride, dst_data, dst_rowstride);
   else if (comp_type == babl_type ("u16"))
-    gegl_downscale_2x2_u16 (bpp, src_width, src_height, src_data, src_rowstride, dst_data, dst_rowstride);
+    downscale_2x2_u16 (bpp, src_width, src_height, src_data, src_rowstride, dst_data, dst_rowstride);
   else if (comp_type == babl_type ("u32"))
     gegl_downscale_2x2_u32 (bpp, src_width, src_height, src_data, src_rowstride, dst_data, dst_rowstride);
   else if (comp_type == babl_type ("double"))
@@ -96,18 +158,20 @@ void gegl_resample_boxfilter (guchar              *dest_buf,
   const Babl *comp_type  = babl_format_get_type (format, 0);
   const gint bpp = babl_format_get_bytes_per_pixel (format);
 
+  gegl_algorithms_init ();
+
   if (comp_type == babl_type ("u8"))
-    gegl_resample_boxfilter_u8 (dest_buf, source_buf, dst_rect, src_rect,
-                                s_rowstride, scale, bpp, d_rowstride);
+    boxfilter_u8 (dest_buf, source_buf, dst_rect, src_rect,
+                  s_rowstride, scale, bpp, d_rowstride);
   else if (comp_type == babl_type ("u16"))
-    gegl_resample_boxfilter_u16 (dest_buf, source_buf, dst_rect, src_rect,
-                                 s_rowstride, scale, bpp, d_rowstride);
+    boxfilter_u16 (dest_buf, source_buf, dst_rect, src_rect,
+                   s_rowstride, scale, bpp, d_rowstride);
   else if (comp_type == babl_type ("u32"))
     gegl_resample_boxfilter_u32 (dest_buf, source_buf, dst_rect, src_rect,
                                  s_rowstride, scale, bpp, d_rowstride);
   else if (comp_type == babl_type ("float"))
-    gegl_resample_boxfilter_float (dest_buf, source_buf, dst_rect, src_rect,
-                                   s_rowstride, scale, bpp, d_rowstride);
+    boxfilter_float (dest_buf, source_buf, dst_rect, src_rect,
+                     s_rowstride, scale, bpp, d_rowstride);
   else if (comp_type == babl_type ("double"))
     gegl_resample_boxfilter_double (dest_buf, source_buf, dst_rect, src_rect,
                                     s_rowstride, scale, bpp, d_rowstride);
@@ -204,6 +204,86 @@ void gegl_resample_nearest (guchar              *dst,
                             gint                 dst_stride);
 
 
+/* Vector versions of the above, picked by gegl_downscale_2x2 () and
+ * gegl_resample_boxfilter () when the CPU supports them. They give the same
+ * results as the scalar versions, and fall back on them for pixels that
+ * don't have four components.
+ */
+void gegl_downscale_2x2_float_avx2 (gint    bpp,
+                                    gint    src_width,
+                                    gint    src_height,
+                                    guchar *src_data,
+                                    gint    src_rowstride,
+                                    guchar *dst_data,
+                                    gint    dst_rowstride);
+
+void gegl_downscale_2x2_u16_avx2 (gint    bpp,
+                                  gint    src_width,
+                                  gint    src_height,
+                                  guchar *src_data,
+                                  gint    src_rowstride,
+                                  guchar *dst_data,
+                                  gint    dst_rowstride);
+
+void gegl_downscale_2x2_u8_avx2 (gint    bpp,
+                                 gint    src_width,
+                                 gint    src_height,
+                                 guchar *src_data,
+                                 gint    src_rowstride,
+                                 guchar *dst_data,
+                                 gint    dst_rowstride);
+
+void gegl_resample_boxfilter_float_avx2 (guchar              *dest_buf,
+                                         const guchar        *source_buf,
+                                         const GeglRectangle *dst_rect,
+                                         const GeglRectangle *src_rect,
+                                         gint                 s_rowstride,
+                                         gdouble              scale,
+                                         gint                 bpp,
+                                         gint                 d_rowstride);
+
+void gegl_resample_boxfilter_u16_avx2 (guchar              *dest_buf,
+                                       const guchar        *source_buf,
+                                       const GeglRectangle *dst_rect,
+                                       const GeglRectangle *src_rect,
+                                       gint                 s_rowstride,
+                                       gdouble              scale,
+                                       gint                 bpp,
+                                       gint                 d_rowstride);
+
+void gegl_resample_boxfilter_u8_avx2 (guchar              *dest_buf,
+                                      const guchar        *source_buf,
+                                      const GeglRectangle *dst_rect,
+                                      const GeglRectangle *src_rect,
+                                      gint                 s_rowstride,
+                                      gdouble              scale,
+                                      gint                 bpp,
+                                      gint                 d_rowstride);
+
+void gegl_downscale_2x2_float_neon (gint    bpp,
+                                    gint    src_width,
+                                    gint    src_height,
+                                    guchar *src_data,
+                                    gint    src_rowstride,
+                                    guchar *dst_data,
+                                    gint    dst_rowstride);
+
+void gegl_downscale_2x2_u16_neon (gint    bpp,
+                                  gint    src_width,
+                                  gint    src_height,
+                                  guchar *src_data,
+                                  gint    src_rowstride,
+                                  guchar *dst_data,
+                                  gint    dst_rowstride);
+
+void gegl_downscale_2x2_u8_neon (gint    bpp,
+                                 gint    src_width,
+                                 gint    src_height,
+                                 guchar *src_data,
+                                 gint    src_rowstride,
+                                 guchar *dst_data,
+                                 gint    dst_rowstride);
+
 G_END_DECLS
 
 #endif /* __GEGL_ALGORITHMS_H__ */
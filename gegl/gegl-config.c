@@ -27,6 +27,7 @@
 #include "gegl-types-internal.h"
 #include "gegl-config.h"
 
+#include "buffer/gegl-buffer-private.h"
 #include "opencl/gegl-cl.h"
 
 G_DEFINE_TYPE (GeglConfig, gegl_config, G_TYPE_OBJECT)
@@ -45,7 +46,11 @@ enum
   PROP_THREADS,
   PROP_USE_OPENCL,
   PROP_QUEUE_SIZE,
-  PROP_APPLICATION_LICENSE
+  PROP_APPLICATION_LICENSE,
+  PROP_PARALLEL_GRAPH,
+  PROP_TILE_CACHE_POLICY,
+  PROP_COMPRESSED_CACHE_SIZE,
+  PROP_POINT_FUSION
 };
 
 gint _gegl_threads = 1; 
@@ -100,6 +105,22 @@ gegl_config_get_property (GObject    *gobject,
         g_value_set_string (value, config->application_license);
         break;
 
+      case PROP_PARALLEL_GRAPH:
+        g_value_set_boolean (value, config->parallel_graph);
+        break;
+
+      case PROP_TILE_CACHE_POLICY:
+        g_value_set_string (value, config->tile_cache_policy);
+        break;
+
+      case PROP_COMPRESSED_CACHE_SIZE:
+        g_value_set_uint64 (value, config->compressed_cache_size);
+        break;
+
+      case PROP_POINT_FUSION:
+        g_value_set_boolean (value, config->point_fusion);
+        break;
+
       default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID (gobject, property_id, pspec);
         break;
@@ -150,6 +171,21 @@ gegl_config_set_property (GObject      *gobject,
           g_free (config->application_license);
         config->application_license = g_value_dup_string (value);
         break;
+      case PROP_PARALLEL_GRAPH:
+        config->parallel_graph = g_value_get_boolean (value);
+        break;
+      case PROP_TILE_CACHE_POLICY:
+        if (config->tile_cache_policy)
+          g_free (config->tile_cache_policy);
+        config->tile_cache_policy = g_value_dup_string (value);
+        gegl_tile_cache_set_policy (config->tile_cache_policy);
+        break;
+      case PROP_COMPRESSED_CACHE_SIZE:
+        config->compressed_cache_size = g_value_get_uint64 (value);
+        break;
+      case PROP_POINT_FUSION:
+        config->point_fusion = g_value_get_boolean (value);
+        break;
       default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID (gobject, property_id, pspec);
         break;
@@ -167,6 +203,9 @@ gegl_config_finalize (GObject *gobject)
   if (config->application_license)
     g_free (config->application_license);
 
+  if (config->tile_cache_policy)
+    g_free (config->tile_cache_policy);
+
   G_OBJECT_CLASS (gegl_config_parent_class)->finalize (gobject);
 }
 
@@ -261,6 +300,38 @@ gegl_config_class_init (GeglConfigClass *klass)
                                                         "",
                                                         G_PARAM_READWRITE |
                                                         G_PARAM_CONSTRUCT));
+
+  g_object_class_install_property (gobject_class, PROP_PARALLEL_GRAPH,
+                                   g_param_spec_boolean ("parallel-graph",
+                                                         "Parallel graph",
+                                                         "Evaluate whole graphs in parallel over tile aligned parts of the requested region",
+                                                         FALSE,
+                                                         G_PARAM_READWRITE |
+                                                         G_PARAM_CONSTRUCT));
+
+  g_object_class_install_property (gobject_class, PROP_TILE_CACHE_POLICY,
+                                   g_param_spec_string ("tile-cache-policy",
+                                                        "Tile cache policy",
+                                                        "eviction policy of the tile cache, \"2q\" (scan resistant) or \"lru\"",
+                                                        "2q",
+                                                        G_PARAM_READWRITE |
+                                                        G_PARAM_CONSTRUCT));
+
+  g_object_class_install_property (gobject_class, PROP_COMPRESSED_CACHE_SIZE,
+                                   g_param_spec_uint64 ("compressed-cache-size",
+                                                        "Compressed cache size",
+                                                        "size of the compressed tile tier between the tile cache and swap in bytes, 0 disables it; GEGL_COMPRESSED_CACHE_SIZE sets it in megabytes",
+                                                        0, G_MAXUINT64, 0,
+                                                        G_PARAM_READWRITE |
+                                                        G_PARAM_CONSTRUCT));
+
+  g_object_class_install_property (gobject_class, PROP_POINT_FUSION,
+                                   g_param_spec_boolean ("point-fusion",
+                                                         "Point fusion",
+                                                         "Process chains of point operations together, block by block, without intermediate buffers",
+                                                         TRUE,
+                                                         G_PARAM_READWRITE |
+                                                         G_PARAM_CONSTRUCT));
 }
 
 static void
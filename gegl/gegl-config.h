@@ -37,6 +37,8 @@ struct _GeglConfig
 
   gchar   *swap;
   guint64  tile_cache_size;
+  gchar   *tile_cache_policy;
+  guint64  compressed_cache_size;
   gint     chunk_size; /* The size of elements being processed at once */
   gdouble  quality;
   gint     tile_width;
@@ -44,6 +46,8 @@ struct _GeglConfig
   gboolean use_opencl;
   gint     queue_size;
   gchar   *application_license;
+  gboolean parallel_graph;
+  gboolean point_fusion;
 };
 
 struct _GeglConfigClass
@@ -115,7 +115,23 @@ enum
 
 enum
 {
-  ARCH_X86_INTEL_FEATURE_PNI      = 1 << 0
+  ARCH_X86_INTEL_FEATURE_PNI      = 1 << 0,
+  ARCH_X86_INTEL_FEATURE_FMA      = 1 << 12,
+  ARCH_X86_INTEL_FEATURE_OSXSAVE  = 1 << 27,
+  ARCH_X86_INTEL_FEATURE_AVX      = 1 << 28
+};
+
+/* extended features, cpuid leaf 7 */
+enum
+{
+  ARCH_X86_INTEL_FEATURE_AVX2     = 1 << 5
+};
+
+/* state enabled by the OS in XCR0 */
+enum
+{
+  ARCH_X86_XCR0_SSE               = 1 << 1,
+  ARCH_X86_XCR0_AVX               = 1 << 2
 };
 
 #if !defined(ARCH_X86_64) && (defined(PIC) || defined(__PIC__))
@@ -128,6 +144,16 @@ enum
              "=c" (ecx),           \
              "=d" (edx)            \
            : "0" (op))
+#define cpuid_count(op,count,eax,ebx,ecx,edx) \
+  __asm__ ("movl %%ebx, %%esi\n\t"            \
+           "cpuid\n\t"                        \
+           "xchgl %%ebx,%%esi"                \
+           : "=a" (eax),                      \
+             "=S" (ebx),                      \
+             "=c" (ecx),                      \
+             "=d" (edx)                       \
+           : "0" (op),                        \
+             "2" (count))
 #else
 #define cpuid(op,eax,ebx,ecx,edx)  \
   __asm__ ("cpuid"                 \
@@ -136,6 +162,14 @@ enum
              "=c" (ecx),           \
              "=d" (edx)            \
            : "0" (op))
+#define cpuid_count(op,count,eax,ebx,ecx,edx) \
+  __asm__ ("cpuid"                            \
+           : "=a" (eax),                      \
+             "=b" (ebx),                      \
+             "=c" (ecx),                      \
+             "=d" (edx)                       \
+           : "0" (op),                        \
+             "2" (count))
 #endif
 
 
@@ -210,6 +244,23 @@ arch_get_vendor (void)
   return ARCH_X86_VENDOR_UNKNOWN;
 }
 
+#ifdef USE_SSE
+static gboolean
+arch_accel_avx_os_support (void)
+{
+  guint32 eax, edx;
+
+  /* xgetbv, spelled out for assemblers that don't know it */
+  __asm__ (".byte 0x0f, 0x01, 0xd0"
+           : "=a" (eax),
+             "=d" (edx)
+           : "c" (0));
+
+  return ((eax & (ARCH_X86_XCR0_SSE | ARCH_X86_XCR0_AVX)) ==
+          (ARCH_X86_XCR0_SSE | ARCH_X86_XCR0_AVX));
+}
+#endif /* USE_SSE */
+
 static guint32
 arch_accel_intel (void)
 {
@@ -235,6 +286,27 @@ arch_accel_intel (void)
 
     if (ecx & ARCH_X86_INTEL_FEATURE_PNI)
       caps |= GEGL_CPU_ACCEL_X86_SSE3;
+
+    /* the 256 bit registers are only usable when the OS saves them on
+     * context switches, which it announces in XCR0
+     */
+    if ((ecx & ARCH_X86_INTEL_FEATURE_OSXSAVE) &&
+        (ecx & ARCH_X86_INTEL_FEATURE_AVX)     &&
+        arch_accel_avx_os_support ())
+      {
+        if (ecx & ARCH_X86_INTEL_FEATURE_FMA)
+          caps |= GEGL_CPU_ACCEL_X86_FMA;
+
+        cpuid (0, eax, ebx, ecx, edx);
+
+        if (eax >= 7)
+          {
+            cpuid_count (7, 0, eax, ebx, ecx, edx);
+
+            if (ebx & ARCH_X86_INTEL_FEATURE_AVX2)
+              caps |= GEGL_CPU_ACCEL_X86_AVX2;
+          }
+      }
 #endif /* USE_SSE */
   }
 #endif /* USE_MMX */
@@ -400,7 +472,8 @@ arch_accel (void)
 
 #ifdef USE_SSE
   if ((caps & GEGL_CPU_ACCEL_X86_SSE) && !arch_accel_sse_os_support ())
-    caps &= ~(GEGL_CPU_ACCEL_X86_SSE | GEGL_CPU_ACCEL_X86_SSE2);
+    caps &= ~(GEGL_CPU_ACCEL_X86_SSE  | GEGL_CPU_ACCEL_X86_SSE2 |
+              GEGL_CPU_ACCEL_X86_AVX2 | GEGL_CPU_ACCEL_X86_FMA);
 #endif
 
   return caps;
@@ -480,6 +553,38 @@ arch_accel (void)
 #endif /* ARCH_PPC && USE_ALTIVEC */
 
 
+#if defined(ARCH_ARM) && defined(USE_NEON)
+
+#ifdef HAVE_SYS_AUXV_H
+#include <sys/auxv.h>
+#endif
+
+#define HAVE_ACCEL 1
+
+enum
+{
+  ARCH_ARM_HWCAP_NEON = 1 << 12
+};
+
+static guint32
+arch_accel (void)
+{
+#if defined(ARCH_ARM64)
+  /* Advanced SIMD is a mandatory part of ARMv8-A */
+  return GEGL_CPU_ACCEL_ARM_NEON;
+#elif defined(HAVE_SYS_AUXV_H) && defined(AT_HWCAP)
+  if (getauxval (AT_HWCAP) & ARCH_ARM_HWCAP_NEON)
+    return GEGL_CPU_ACCEL_ARM_NEON;
+
+  return 0;
+#else
+  return 0;
+#endif
+}
+
+#endif /* ARCH_ARM && USE_NEON */
+
+
 static GeglCpuAccelFlags
 cpu_accel (void)
 {
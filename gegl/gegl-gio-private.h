@@ -30,6 +30,9 @@ gegl_gio_open_input_stream(const gchar *uri, const gchar *path, GFile **out_file
 GOutputStream *
 gegl_gio_open_output_stream(const gchar *uri, const gchar *path, GFile **out_file, GError **err);
 
+gint
+gegl_gio_open_temp_file(const gchar *path, gchar **out_target, gchar **out_tmp_path);
+
 gboolean
 gegl_gio_uri_is_datauri(const gchar *uri);
 
@@ -19,6 +19,14 @@
 #include <gegl-gio-private.h>
 #include <string.h>
 #include <stdio.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <glib/gstdio.h>
+
+#ifndef O_BINARY
+#define O_BINARY 0
+#endif
 
 #ifdef G_OS_WIN32
 #include <windows.h>
@@ -216,3 +224,81 @@ gegl_gio_open_output_stream(const gchar *uri, const gchar *path, GFile **out_fil
 
   return stream;
 }
+
+/**
+ * gegl_gio_open_temp_file:
+ * @path: path of the file to be replaced
+ * @out_target: (out) (transfer full): return location for the path of the
+ * file to replace, the file @path links to if it is a symbolic link.
+ * @out_tmp_path: (out) (transfer full): return location for the path of
+ * the temporary file.
+ *
+ * Creates a temporary file next to the file @path refers to, to be renamed
+ * over it once written. The temporary file gets the permissions of the
+ * file it replaces, if that exists.
+ *
+ * Return value: a file descriptor open for writing, or -1 with errno set.
+ *
+ * Note: currently private API.
+ */
+gint
+gegl_gio_open_temp_file(const gchar *path, gchar **out_target, gchar **out_tmp_path)
+{
+  gchar *target = g_strdup(path);
+  gchar *tmp_path;
+  gint depth;
+  gint fd;
+
+  g_return_val_if_fail(path, -1);
+  g_return_val_if_fail(out_target, -1);
+  g_return_val_if_fail(out_tmp_path, -1);
+
+  /* replacing a symbolic link would turn it into a regular file */
+  for (depth = 0;
+       depth < 32 && g_file_test(target, G_FILE_TEST_IS_SYMLINK);
+       depth++)
+    {
+      gchar *link = g_file_read_link(target, NULL);
+
+      if (link == NULL)
+        break;
+
+      if (!g_path_is_absolute(link))
+        {
+          gchar *dir = g_path_get_dirname(target);
+          gchar *resolved = g_build_filename(dir, link, NULL);
+
+          g_free(dir);
+          g_free(link);
+          link = resolved;
+        }
+
+      g_free(target);
+      target = link;
+    }
+
+  tmp_path = g_strdup_printf("%s.XXXXXX", target);
+
+  fd = g_mkstemp_full(tmp_path, O_WRONLY | O_BINARY, 0666);
+  if (fd == -1)
+    {
+      g_free(target);
+      g_free(tmp_path);
+      *out_target = *out_tmp_path = NULL;
+      return -1;
+    }
+
+#ifndef G_OS_WIN32
+  {
+    GStatBuf st;
+
+    if (g_stat(target, &st) == 0)
+      fchmod(fd, st.st_mode & 07777);
+  }
+#endif
+
+  *out_target = target;
+  *out_tmp_path = tmp_path;
+
+  return fd;
+}
@@ -89,6 +89,7 @@ guint gegl_debug_flags = 0;
 #include "gegl-types.h"
 #include "gegl-types-internal.h"
 #include "gegl-instrument.h"
+#include "gegl-trace.h"
 #include "gegl-init.h"
 #include "gegl-init-private.h"
 #include "module/geglmodule.h"
@@ -101,9 +102,11 @@ guint gegl_debug_flags = 0;
 #include "buffer/gegl-buffer-iterator-private.h"
 #include "buffer/gegl-tile-backend-ram.h"
 #include "buffer/gegl-tile-backend-file.h"
+#include "buffer/gegl-tile-alloc.h"
 #include "gegl-config.h"
 #include "graph/gegl-node-private.h"
 #include "gegl-random-private.h"
+#include "gegl-scheduler-private.h"
 
 static gboolean  gegl_post_parse_hook (GOptionContext *context,
                                        GOptionGroup   *group,
@@ -345,6 +348,10 @@ static void gegl_config_parse_env (GeglConfig *config)
   if (g_getenv ("GEGL_CACHE_SIZE"))
     config->tile_cache_size = atoll(g_getenv("GEGL_CACHE_SIZE"))* 1024*1024;
 
+  if (g_getenv ("GEGL_COMPRESSED_CACHE_SIZE"))
+    config->compressed_cache_size =
+      atoll (g_getenv ("GEGL_COMPRESSED_CACHE_SIZE")) * 1024 * 1024;
+
   if (g_getenv ("GEGL_CHUNK_SIZE"))
     config->chunk_size = atoi(g_getenv("GEGL_CHUNK_SIZE"));
 
@@ -369,6 +376,16 @@ static void gegl_config_parse_env (GeglConfig *config)
         }
     }
 
+  if (g_getenv ("GEGL_PARALLEL_GRAPH"))
+    config->parallel_graph = atoi (g_getenv ("GEGL_PARALLEL_GRAPH")) != 0;
+
+  if (g_getenv ("GEGL_POINT_FUSION"))
+    config->point_fusion = atoi (g_getenv ("GEGL_POINT_FUSION")) != 0;
+
+  if (g_getenv ("GEGL_TILE_CACHE_POLICY"))
+    g_object_set (config, "tile-cache-policy",
+                  g_getenv ("GEGL_TILE_CACHE_POLICY"), NULL);
+
   if (g_getenv ("GEGL_USE_OPENCL"))
     {
       const char *opencl_env = g_getenv ("GEGL_USE_OPENCL");
@@ -451,8 +468,10 @@ gegl_exit (void)
 
   GEGL_INSTRUMENT_START()
 
+  gegl_scheduler_cleanup ();
   gegl_tile_backend_swap_cleanup ();
   gegl_tile_cache_destroy ();
+  gegl_trace_cleanup ();
   gegl_operation_gtype_cleanup ();
   gegl_extension_handler_cleanup ();
   gegl_random_cleanup ();
@@ -495,6 +514,7 @@ gegl_exit (void)
 #endif
     }
   gegl_tile_cache_destroy ();
+  gegl_tile_alloc_cleanup ();
 
   if (gegl_swap_dir ())
     {
@@ -598,6 +618,24 @@ gegl_get_default_module_paths(void)
   return list;
 }
 
+/* The module registry lets modules be loaded when their operations are
+ * first used instead of at startup. GEGL_MODULE_REGISTRY can name a
+ * different file for it, or disable it when empty.
+ */
+static gchar *
+gegl_get_module_registry_path (void)
+{
+  const gchar *path = g_getenv ("GEGL_MODULE_REGISTRY");
+
+  if (path)
+    return *path ? g_strdup (path) : NULL;
+
+  return g_build_filename (g_get_user_cache_dir (),
+                           GEGL_LIBRARY,
+                           "module-registry",
+                           NULL);
+}
+
 static void
 load_module_path(gchar *path, GeglModuleDB *db)
 {
@@ -618,6 +656,9 @@ gegl_post_parse_hook (GOptionContext *context,
   if (g_getenv ("GEGL_DEBUG_TIME") != NULL)
     gegl_instrument_enable ();
 
+  if (g_getenv ("GEGL_TRACE") != NULL)
+    gegl_trace_enable (g_getenv ("GEGL_TRACE"));
+
   gegl_instrument ("gegl", "gegl_init", 0);
 
   config = gegl_config ();
@@ -678,10 +719,14 @@ gegl_post_parse_hook (GOptionContext *context,
 
   if (!module_db)
     {
-      GSList *paths = gegl_get_default_module_paths ();
+      GSList *paths    = gegl_get_default_module_paths ();
+      gchar  *registry = gegl_get_module_registry_path ();
       module_db = gegl_module_db_new (FALSE);
+      if (registry)
+        gegl_module_db_set_registry (module_db, registry);
       g_slist_foreach(paths, (GFunc)load_module_path, module_db);
       g_slist_free_full (paths, g_free);
+      g_free (registry);
     }
 
   GEGL_INSTRUMENT_END ("gegl_init", "load modules");
@@ -18,10 +18,20 @@
 
 #include "config.h"
 
+#include <string.h>
 #include <glib-object.h>
 
 #include "gegl.h"
 #include "gegl-lookup.h"
+#include "gegl-config.h"
+#include "gegl-scheduler.h"
+
+typedef struct
+{
+  GeglLookup *lookup;
+  gint        first;
+  gint        last;
+} FillData;
 
 GeglLookup *
 gegl_lookup_new_full (GeglLookupFunction function,
@@ -132,9 +142,12 @@ gegl_lookup_new_full (GeglLookupFunction function,
         positive_max-=diff;
     }
 
+  /* one more entry than the ranges use, which precomputed lookups need to
+   * interpolate in the last slot
+   */
   lookup = g_malloc0 (sizeof (GeglLookup) + sizeof (gfloat) *
                                                   ((positive_max-positive_min)+
-                                                   (negative_max-negative_min)));
+                                                   (negative_max-negative_min) + 1));
 
   lookup->positive_min = positive_min;
   lookup->positive_max = positive_max;
@@ -154,6 +167,144 @@ gegl_lookup_new (GeglLookupFunction function,
   return gegl_lookup_new_full (function, data, 0, 1.0, 0.000010);
 }
 
+/* Precomputed tables hold the function value at the start of each slot.
+ * Slot 0 of the negative range is never looked up, it holds the end of
+ * the positive range instead, and the extra entry at the end holds the end
+ * of the negative range, so that every slot has a right neighbour to
+ * interpolate towards.
+ */
+static void
+fill_entries (gpointer data)
+{
+  FillData   *fill          = data;
+  GeglLookup *lookup        = fill->lookup;
+  gint        positive_size = lookup->positive_max - lookup->positive_min;
+  gint        j;
+
+  for (j = fill->first; j < fill->last; j++)
+    {
+      union
+      {
+        float   f;
+        guint32 i;
+      } u;
+
+      if (j <= positive_size)
+        u.i = (j + lookup->positive_min) << lookup->shift;
+      else
+        u.i = (j - positive_size + lookup->negative_min) << lookup->shift;
+
+      lookup->table[j] = lookup->function (u.f, lookup->data);
+    }
+}
+
+GeglLookup *
+gegl_lookup_new_precomputed (GeglLookupFunction function,
+                             gpointer           data,
+                             gfloat             start,
+                             gfloat             end,
+                             gfloat             precision,
+                             gboolean           threaded)
+{
+  GeglLookup *lookup;
+  FillData    fill[GEGL_MAX_THREADS];
+  gint        n_entries;
+  gint        threads = 1;
+  gint        i;
+
+  lookup = gegl_lookup_new_full (function, data, start, end, precision);
+
+  n_entries = (lookup->positive_max - lookup->positive_min) +
+              (lookup->negative_max - lookup->negative_min) + 1;
+
+  if (threaded && n_entries >= 4096)
+    threads = gegl_config_threads ();
+
+  for (i = 0; i < threads; i++)
+    {
+      fill[i].lookup = lookup;
+      fill[i].first  = (gint64) n_entries * i / threads;
+      fill[i].last   = (gint64) n_entries * (i + 1) / threads;
+    }
+
+  if (threads > 1)
+    {
+      GeglTaskGroup *group = gegl_task_group_new ();
+
+      for (i = 1; i < threads; i++)
+        gegl_task_group_add (group, fill_entries, &fill[i]);
+      fill_entries (&fill[0]);
+
+      gegl_task_group_join (group);
+    }
+  else
+    {
+      fill_entries (&fill[0]);
+    }
+
+  /* mark every entry as computed, gegl_lookup () never writes to the
+   * table after this
+   */
+  memset (lookup->bitmask, 0xff, sizeof (lookup->bitmask));
+  lookup->precomputed = TRUE;
+
+  return lookup;
+}
+
+void
+gegl_lookup_process (GeglLookup   *lookup,
+                     const gfloat *src,
+                     gint          src_stride,
+                     gfloat       *dst,
+                     gint          dst_stride,
+                     glong         n_values)
+{
+  const guint32  positive_min  = lookup->positive_min;
+  const guint32  positive_max  = lookup->positive_max;
+  const guint32  negative_min  = lookup->negative_min;
+  const guint32  negative_max  = lookup->negative_max;
+  const guint32  positive_size = positive_max - positive_min;
+  const gint     shift         = lookup->shift;
+  const guint32  mask          = (1u << shift) - 1;
+  const gfloat   scale         = 1.0f / (1u << shift);
+  const gfloat  *table         = lookup->table;
+  glong          n;
+
+  if (!lookup->precomputed)
+    {
+      for (n = 0; n < n_values; n++)
+        dst[n * dst_stride] = gegl_lookup (lookup, src[n * src_stride]);
+      return;
+    }
+
+  for (n = 0; n < n_values; n++)
+    {
+      union
+      {
+        float   f;
+        guint32 i;
+      } u;
+      guint32 i;
+      gfloat  t;
+
+      u.f = src[n * src_stride];
+      i = u.i >> shift;
+
+      if (i > positive_min && i < positive_max)
+        i = i - positive_min;
+      else if (i > negative_min && i < negative_max)
+        i = i - negative_min + positive_size;
+      else
+        {
+          dst[n * dst_stride] = lookup->function (u.f, lookup->data);
+          continue;
+        }
+
+      t = (u.i & mask) * scale;
+      dst[n * dst_stride] = table[i] + (table[i + 1] - table[i]) * t;
+    }
+}
+
 void
 gegl_lookup_free (GeglLookup *lookup)
 {
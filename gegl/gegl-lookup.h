@@ -33,6 +33,7 @@ typedef struct GeglLookup
   GeglLookupFunction function;
   gpointer           data;
   gint               shift;
+  gboolean           precomputed;
   guint32            positive_min, positive_max, negative_min, negative_max;
   guint32            bitmask[GEGL_LOOKUP_MAX_ENTRIES/32];
   gfloat             table[];
@@ -64,6 +65,49 @@ GeglLookup *gegl_lookup_new_full  (GeglLookupFunction  function,
 GeglLookup *gegl_lookup_new       (GeglLookupFunction  function,
                                    gpointer            data);
 
+/**
+ * gegl_lookup_new_precomputed: (skip)
+ * @function: The function to build a lookup for
+ * @data: A user data pointer passed to lookup calls
+ * @start: Lower bound of the lookup
+ * @end: Upper bound of the lookup
+ * @precision: The precision of the lookup table
+ * @threaded: Whether @function may be called from several threads at once
+ *
+ * Create a lookup with the table filled in up front, from several threads
+ * if @threaded is set. The table is never written to afterwards, so the
+ * lookup can be used by several threads at once as long as @function can
+ * for values outside the table.
+ *
+ * Return value: a #GeglLookup
+ */
+GeglLookup *gegl_lookup_new_precomputed (GeglLookupFunction  function,
+                                         gpointer            data,
+                                         gfloat              start,
+                                         gfloat              end,
+                                         gfloat              precision,
+                                         gboolean            threaded);
+
+/**
+ * gegl_lookup_process: (skip)
+ * @lookup: #GeglLookup to use
+ * @src: the values to look up
+ * @src_stride: distance in floats between consecutive values in @src
+ * @dst: where to store the results
+ * @dst_stride: distance in floats between consecutive results in @dst
+ * @n_values: number of values to look up
+ *
+ * Map @n_values values through @lookup. With a precomputed lookup the
+ * results are linearly interpolated between the table entries, otherwise
+ * this is the same as calling gegl_lookup() for each value.
+ */
+void        gegl_lookup_process   (GeglLookup         *lookup,
+                                   const gfloat       *src,
+                                   gint                src_stride,
+                                   gfloat             *dst,
+                                   gint                dst_stride,
+                                   glong               n_values);
+
 /**
  * gegl_lookup_free: (skip)
  * @lookup: #GeglLookup to free
@@ -0,0 +1,24 @@
+/* This file is part of GEGL
+ *
+ * GEGL is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * GEGL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GEGL_SCHEDULER_PRIV_H__
+#define __GEGL_SCHEDULER_PRIV_H__
+
+/* Stops and joins the worker threads, called from gegl_exit() */
+void
+gegl_scheduler_cleanup (void);
+
+#endif /* __GEGL_SCHEDULER_PRIV_H__ */
@@ -0,0 +1,269 @@
+/* This file is part of GEGL
+ *
+ * GEGL is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * GEGL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Every worker thread owns a deque of tasks. Tasks added from a worker go
+ * to the head of its own deque and are taken back from the head (most
+ * recently added first, while the data is still in cache), idle threads
+ * steal from the tail of other deques. Tasks added by threads outside the
+ * pool go to a shared deque. Threads waiting in gegl_task_group_join()
+ * take part in the same stealing, and only sleep when there is nothing
+ * queued anywhere.
+ */
+
+#include "config.h"
+
+#include <glib-object.h>
+
+#include "gegl-config.h"
+#include "gegl-scheduler.h"
+#include "gegl-scheduler-private.h"
+#include "gegl-trace.h"
+
+#define SHARED_DEQUE GEGL_MAX_THREADS
+
+typedef struct
+{
+  GeglTaskFunc   func;
+  gpointer       data;
+  GeglTaskGroup *group;
+} GeglTask;
+
+struct _GeglTaskGroup
+{
+  gint pending;
+};
+
+typedef struct
+{
+  GMutex mutex;
+  GQueue tasks;
+} TaskDeque;
+
+static TaskDeque deques[GEGL_MAX_THREADS + 1];
+static GThread  *workers[GEGL_MAX_THREADS];
+static gint      n_workers = 0;
+static gint      n_queued  = 0;
+static gboolean  quit      = FALSE;
+
+/* protects starting and stopping workers, and sleeping */
+static GMutex    mutex;
+static GCond     cond;
+
+/* index + 1 of the deque owned by the current thread, unset outside the pool */
+static GPrivate  worker_index;
+
+static gint
+current_deque (void)
+{
+  gint index = GPOINTER_TO_INT (g_private_get (&worker_index));
+
+  return index ? index - 1 : SHARED_DEQUE;
+}
+
+static GeglTask *
+deque_pop (TaskDeque *deque)
+{
+  GeglTask *task;
+
+  g_mutex_lock (&deque->mutex);
+  task = g_queue_pop_head (&deque->tasks);
+  g_mutex_unlock (&deque->mutex);
+
+  return task;
+}
+
+static GeglTask *
+deque_steal (TaskDeque *deque)
+{
+  GeglTask *task;
+
+  g_mutex_lock (&deque->mutex);
+  task = g_queue_pop_tail (&deque->tasks);
+  g_mutex_unlock (&deque->mutex);
+
+  return task;
+}
+
+static GeglTask *
+take_task (void)
+{
+  GeglTask *task;
+  gint      self = current_deque ();
+  gint      workers_count;
+  gint      i;
+
+  if (!g_atomic_int_get (&n_queued))
+    return NULL;
+
+  task = deque_pop (&deques[self]);
+
+  if (!task && self != SHARED_DEQUE)
+    task = deque_steal (&deques[SHARED_DEQUE]);
+
+  workers_count = g_atomic_int_get (&n_workers);
+
+  for (i = 1; !task && i <= workers_count; i++)
+    {
+      gint victim = (self + i) % workers_count;
+
+      if (victim != self)
+        task = deque_steal (&deques[victim]);
+    }
+
+  if (task)
+    g_atomic_int_add (&n_queued, -1);
+
+  return task;
+}
+
+static void
+run_task (GeglTask *task)
+{
+  GeglTaskGroup *group = task->group;
+
+  GEGL_TRACE_START();
+  task->func (task->data);
+  GEGL_TRACE_END ("scheduler", "task");
+  g_slice_free (GeglTask, task);
+
+  /* the group may be freed by its joiner as soon as pending drops to 0 */
+  if (g_atomic_int_dec_and_test (&group->pending))
+    {
+      g_mutex_lock (&mutex);
+      g_cond_broadcast (&cond);
+      g_mutex_unlock (&mutex);
+    }
+}
+
+static gpointer
+worker_thread (gpointer data)
+{
+  g_private_set (&worker_index, data);
+
+  g_mutex_lock (&mutex);
+  while (!quit)
+    {
+      GeglTask *task;
+
+      g_mutex_unlock (&mutex);
+
+      while ((task = take_task ()))
+        run_task (task);
+
+      g_mutex_lock (&mutex);
+
+      if (!quit && !g_atomic_int_get (&n_queued))
+        g_cond_wait (&cond, &mutex);
+    }
+  g_mutex_unlock (&mutex);
+
+  return NULL;
+}
+
+static void
+ensure_workers (void)
+{
+  gint wanted = MIN (gegl_config_threads (), GEGL_MAX_THREADS) - 1;
+
+  if (g_atomic_int_get (&n_workers) >= wanted)
+    return;
+
+  g_mutex_lock (&mutex);
+  while (n_workers < wanted)
+    {
+      workers[n_workers] = g_thread_new ("gegl-worker", worker_thread,
+                                         GINT_TO_POINTER (n_workers + 1));
+      g_atomic_int_inc (&n_workers);
+    }
+  g_mutex_unlock (&mutex);
+}
+
+GeglTaskGroup *
+gegl_task_group_new (void)
+{
+  ensure_workers ();
+
+  return g_slice_new0 (GeglTaskGroup);
+}
+
+void
+gegl_task_group_add (GeglTaskGroup *group,
+                     GeglTaskFunc   func,
+                     gpointer       data)
+{
+  GeglTask  *task  = g_slice_new (GeglTask);
+  TaskDeque *deque = &deques[current_deque ()];
+
+  task->func  = func;
+  task->data  = data;
+  task->group = group;
+
+  g_atomic_int_inc (&group->pending);
+
+  g_mutex_lock (&deque->mutex);
+  g_queue_push_head (&deque->tasks, task);
+  g_mutex_unlock (&deque->mutex);
+
+  g_atomic_int_inc (&n_queued);
+
+  g_mutex_lock (&mutex);
+  g_cond_signal (&cond);
+  g_mutex_unlock (&mutex);
+}
+
+void
+gegl_task_group_join (GeglTaskGroup *group)
+{
+  while (g_atomic_int_get (&group->pending))
+    {
+      GeglTask *task = take_task ();
+
+      if (task)
+        {
+          run_task (task);
+          continue;
+        }
+
+      /* nothing left to help with, sleep until a task is queued or one of
+       * ours completes */
+      g_mutex_lock (&mutex);
+      if (g_atomic_int_get (&group->pending) &&
+          !g_atomic_int_get (&n_queued))
+        g_cond_wait (&cond, &mutex);
+      g_mutex_unlock (&mutex);
+    }
+
+  g_slice_free (GeglTaskGroup, group);
+}
+
+void
+gegl_scheduler_cleanup (void)
+{
+  gint i;
+
+  g_mutex_lock (&mutex);
+  quit = TRUE;
+  g_cond_broadcast (&cond);
+  g_mutex_unlock (&mutex);
+
+  for (i = 0; i < n_workers; i++)
+    g_thread_join (workers[i]);
+
+  g_mutex_lock (&mutex);
+  n_workers = 0;
+  quit      = FALSE;
+  g_mutex_unlock (&mutex);
+}
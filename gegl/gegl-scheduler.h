@@ -0,0 +1,68 @@
+/* This file is part of GEGL
+ *
+ * GEGL is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * GEGL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GEGL_SCHEDULER_H__
+#define __GEGL_SCHEDULER_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/***
+ * Task scheduler:
+ *
+ * GEGL keeps one pool of worker threads that all threaded processing is
+ * submitted to. Work is added to a #GeglTaskGroup, and the thread that
+ * created the group waits for it with gegl_task_group_join(). While
+ * waiting, the joining thread executes queued tasks itself, so nested
+ * parallel work cannot starve the pool.
+ */
+
+typedef struct _GeglTaskGroup GeglTaskGroup;
+
+typedef void (*GeglTaskFunc) (gpointer data);
+
+/**
+ * gegl_task_group_new: (skip)
+ *
+ * Create a new, empty group of tasks.
+ */
+GeglTaskGroup *gegl_task_group_new  (void);
+
+/**
+ * gegl_task_group_add: (skip)
+ * @group: a #GeglTaskGroup
+ * @func: the function to run
+ * @data: data passed to @func
+ *
+ * Queue @func to be run with @data by the worker threads.
+ */
+void           gegl_task_group_add  (GeglTaskGroup *group,
+                                     GeglTaskFunc   func,
+                                     gpointer       data);
+
+/**
+ * gegl_task_group_join: (skip)
+ * @group: a #GeglTaskGroup
+ *
+ * Wait for all tasks added to @group to finish, helping with queued
+ * work in the meantime, and free @group.
+ */
+void           gegl_task_group_join (GeglTaskGroup *group);
+
+G_END_DECLS
+
+#endif /* __GEGL_SCHEDULER_H__ */
@@ -0,0 +1,254 @@
+/* This file is part of GEGL
+ *
+ * GEGL is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * GEGL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <errno.h>
+#include <string.h>
+
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+
+#include "gegl-trace.h"
+
+/* number of events kept per thread, a power of two */
+#define TRACE_RING_SIZE (1 << 16)
+
+typedef struct
+{
+  gint64       start;     /* usecs since tracing was enabled */
+  gint64       duration;  /* usecs, or -1 for instant events */
+  const gchar *category;
+  const gchar *name;
+} TraceEvent;
+
+typedef struct
+{
+  gint        tid;
+  guint64     n_events;   /* events recorded, including overwritten ones */
+  TraceEvent  events[TRACE_RING_SIZE];
+} TraceRing;
+
+/* what a thread records into; rings are freed by gegl_trace_cleanup(),
+ * which threads notice by the generation changing
+ */
+typedef struct
+{
+  TraceRing  *ring;
+  guint       generation;
+} TraceThread;
+
+gboolean gegl_trace_enabled = FALSE;
+
+static gchar   *trace_path  = NULL;
+static gint64   trace_epoch = 0;
+static GSList  *trace_rings = NULL;
+static gint     trace_tids  = 0;
+static guint    trace_generation = 0;
+static GMutex   trace_mutex;
+static GPrivate trace_thread = G_PRIVATE_INIT (g_free);
+
+void
+gegl_trace_enable (const gchar *path)
+{
+  g_return_if_fail (path != NULL);
+
+  g_free (trace_path);
+  trace_path  = g_strdup (path);
+  trace_epoch = g_get_monotonic_time ();
+
+  gegl_trace_enabled = TRUE;
+}
+
+/* rings outlive their threads, so events of finished threads are written
+ * too
+ */
+static TraceRing *
+get_ring (void)
+{
+  TraceThread *thread = g_private_get (&trace_thread);
+
+  if (G_UNLIKELY (thread == NULL))
+    {
+      thread = g_new0 (TraceThread, 1);
+      g_private_set (&trace_thread, thread);
+    }
+
+  if (G_UNLIKELY (thread->ring == NULL ||
+                  thread->generation != trace_generation))
+    {
+      TraceRing *ring = g_new (TraceRing, 1);
+
+      ring->n_events = 0;
+
+      g_mutex_lock (&trace_mutex);
+      ring->tid          = ++trace_tids;
+      trace_rings        = g_slist_prepend (trace_rings, ring);
+      thread->generation = trace_generation;
+      g_mutex_unlock (&trace_mutex);
+
+      thread->ring = ring;
+    }
+
+  return thread->ring;
+}
+
+static inline void
+record (const gchar *category,
+        const gchar *name,
+        gint64       start,
+        gint64       duration)
+{
+  TraceRing  *ring  = get_ring ();
+  TraceEvent *event = &ring->events[ring->n_events & (TRACE_RING_SIZE - 1)];
+
+  event->start    = start - trace_epoch;
+  event->duration = duration;
+  event->category = category;
+  event->name     = name;
+
+  ring->n_events++;
+}
+
+void
+real_gegl_trace_complete (const gchar *category,
+                          const gchar *name,
+                          gint64       start)
+{
+  record (category, name, start, g_get_monotonic_time () - start);
+}
+
+void
+real_gegl_trace_instant (const gchar *category,
+                         const gchar *name)
+{
+  record (category, name, g_get_monotonic_time (), -1);
+}
+
+static void
+write_string (FILE        *file,
+              const gchar *str)
+{
+  fputc ('"', file);
+
+  for (; str && *str; str++)
+    {
+      if (*str == '"' || *str == '\\')
+        fprintf (file, "\\%c", *str);
+      else if ((guchar) *str < 0x20)
+        fprintf (file, "\\u%04x", (guint) (guchar) *str);
+      else
+        fputc (*str, file);
+    }
+
+  fputc ('"', file);
+}
+
+static void
+write_ring (FILE      *file,
+            TraceRing *ring,
+            gint       pid,
+            gboolean  *first)
+{
+  guint64 i = 0;
+
+  if (ring->n_events > TRACE_RING_SIZE)
+    i = ring->n_events - TRACE_RING_SIZE;
+
+  if (ring->n_events == 0)
+    return;
+
+  fprintf (file, "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%i,"
+                 "\"tid\":%i,\"args\":{\"name\":\"thread %i\"}}",
+           *first ? "" : ",", pid, ring->tid, ring->tid);
+  *first = FALSE;
+
+  for (; i < ring->n_events; i++)
+    {
+      TraceEvent *event = &ring->events[i & (TRACE_RING_SIZE - 1)];
+
+      fputs (",\n{\"name\":", file);
+      write_string (file, event->name);
+      fputs (",\"cat\":", file);
+      write_string (file, event->category);
+
+      if (event->duration >= 0)
+        fprintf (file, ",\"ph\":\"X\",\"ts\":%" G_GINT64_FORMAT
+                       ",\"dur\":%" G_GINT64_FORMAT,
+                 event->start, event->duration);
+      else
+        fprintf (file, ",\"ph\":\"i\",\"s\":\"t\",\"ts\":%" G_GINT64_FORMAT,
+                 event->start);
+
+      fprintf (file, ",\"pid\":%i,\"tid\":%i}", pid, ring->tid);
+    }
+}
+
+void
+gegl_trace_cleanup (void)
+{
+  FILE     *file;
+  GSList   *iter;
+  gboolean  first = TRUE;
+  gint      pid   = 1;
+
+  if (!trace_path)
+    return;
+
+  gegl_trace_enabled = FALSE;
+
+#ifdef HAVE_UNISTD_H
+  pid = getpid ();
+#endif
+
+  g_mutex_lock (&trace_mutex);
+
+  file = g_fopen (trace_path, "w");
+
+  if (file)
+    {
+      GSList *rings = g_slist_reverse (g_slist_copy (trace_rings));
+
+      fputs ("{\"traceEvents\":[", file);
+      for (iter = rings; iter; iter = iter->next)
+        write_ring (file, iter->data, pid, &first);
+      g_slist_free (rings);
+      fputs ("\n],\"displayTimeUnit\":\"ms\"}\n", file);
+
+      if (fclose (file) != 0)
+        g_warning ("failed to write trace to '%s': %s",
+                   trace_path, g_strerror (errno));
+    }
+  else
+    {
+      g_warning ("failed to open '%s' for the trace: %s",
+                 trace_path, g_strerror (errno));
+    }
+
+  g_slist_free_full (trace_rings, g_free);
+  trace_rings = NULL;
+  trace_tids  = 0;
+  trace_generation++;
+
+  g_mutex_unlock (&trace_mutex);
+
+  g_clear_pointer (&trace_path, g_free);
+}
@@ -0,0 +1,71 @@
+/* This file is part of GEGL
+ *
+ * GEGL is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * GEGL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GEGL_TRACE_H__
+#define __GEGL_TRACE_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/***
+ * Tracing:
+ *
+ * When the GEGL_TRACE environment variable names a file, timestamped events
+ * are recorded per thread, and written to that file by gegl_exit() in the
+ * Trace Event format understood by chrome://tracing and perfetto. Each
+ * thread records into its own ring buffer, so only the most recent events
+ * of a long run are kept. When tracing is disabled the macros below cost a
+ * single test of gegl_trace_enabled.
+ *
+ * Event categories and names are not copied; they have to be static or
+ * interned strings.
+ */
+
+extern gboolean gegl_trace_enabled;
+
+/* start recording events, to be written to @path */
+void gegl_trace_enable  (const gchar *path);
+
+/* write the recorded events and free them */
+void gegl_trace_cleanup (void);
+
+void real_gegl_trace_complete (const gchar *category,
+                               const gchar *name,
+                               gint64       start);
+
+void real_gegl_trace_instant  (const gchar *category,
+                               const gchar *name);
+
+#define GEGL_TRACE_START() \
+  { gint64 _gegl_trace_start = 0; \
+    if (G_UNLIKELY (gegl_trace_enabled)) { _gegl_trace_start = g_get_monotonic_time (); }
+
+#define GEGL_TRACE_END(category, name) \
+    if (G_UNLIKELY (gegl_trace_enabled && _gegl_trace_start)) { \
+      real_gegl_trace_complete (category, name, _gegl_trace_start); \
+                                                                  } \
+  }
+
+#define GEGL_TRACE_INSTANT(category, name) \
+  G_STMT_START { \
+    if (G_UNLIKELY (gegl_trace_enabled)) \
+      real_gegl_trace_instant (category, name); \
+  } G_STMT_END
+
+G_END_DECLS
+
+#endif /* __GEGL_TRACE_H__ */
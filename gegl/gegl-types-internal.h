@@ -25,6 +25,7 @@ G_BEGIN_DECLS
 typedef struct _GeglPad              GeglPad;
 typedef struct _GeglConnection       GeglConnection;
 
+typedef struct _GeglBufferPool       GeglBufferPool;
 typedef struct _GeglEvalManager      GeglEvalManager;
 typedef struct _GeglDotVisitor       GeglDotVisitor;
 typedef struct _GeglVisitable        GeglVisitable;
@@ -133,6 +133,9 @@ void
 gegl_node_emit_computed (GeglNode *node,
                          const GeglRectangle *rect);
 
+/* changes whenever a graph changes in other ways than its pixel contents */
+guint         gegl_node_get_graph_serial    (void);
+
 
 G_END_DECLS
 
@@ -76,6 +76,10 @@ struct _GeglNodePrivate
 
 static guint gegl_node_signals[LAST_SIGNAL] = {0};
 
+/* Incremented on every change that can alter the connections, formats or
+ * bounding boxes in a graph, unlike changes of the pixel contents only */
+static gint  graph_serial = 0;
+
 
 static void            gegl_node_class_init               (GeglNodeClass *klass);
 static void            gegl_node_init                     (GeglNode      *self);
@@ -798,6 +802,8 @@ gegl_node_disconnect (GeglNode    *sink,
       source_pad = gegl_connection_get_source_pad (connection);
       source     = gegl_connection_get_source_node (connection);
 
+      g_atomic_int_inc (&graph_serial);
+
       gegl_node_source_invalidated (source, &source->have_rect, sink_pad);
 
       {
@@ -989,7 +995,9 @@ gegl_node_blit_buffer (GeglNode            *self,
 
   if (result)
     {
-      if (buffer)
+      /* nothing to copy when the graph rendered into @buffer itself, like
+       * when @buffer is the cache of the node */
+      if (buffer && result != buffer)
         gegl_buffer_copy (result, &request, GEGL_ABYSS_NONE, buffer, NULL);
       g_object_unref (result);
     }
@@ -1186,6 +1194,8 @@ gegl_node_property_changed (GObject    *gobject,
 {
   GeglNode *self = GEGL_NODE (user_data);
 
+  g_atomic_int_inc (&graph_serial);
+
   if (arg1 != user_data &&
       ((arg1 &&
         arg1->value_type != GEGL_TYPE_BUFFER) ||
@@ -2159,6 +2169,14 @@ gegl_node_set_passthrough (GeglNode *node,
 {
   g_return_if_fail (GEGL_IS_NODE (node));
 
+  g_atomic_int_inc (&graph_serial);
+
   gegl_node_invalidated (node, NULL, TRUE);
   node->passthrough = passthrough;
 }
+
+guint
+gegl_node_get_graph_serial (void)
+{
+  return g_atomic_int_get (&graph_serial);
+}
@@ -230,6 +230,36 @@ gegl_module_new (const gchar *filename,
   return module;
 }
 
+/**
+ * gegl_module_new_unloaded:
+ * @filename: The filename of a loadable module.
+ * @verbose:  Pass %TRUE to enable debugging output.
+ *
+ * Creates a new #GeglModule instance without loading the module, for
+ * modules whose operations are known from the module registry. The module
+ * is loaded with g_type_module_use() the first time one of its operations
+ * is needed.
+ *
+ * Return value: The new #GeglModule object.
+ **/
+GeglModule *
+gegl_module_new_unloaded (const gchar *filename,
+                          gboolean     verbose)
+{
+  GeglModule *module;
+
+  g_return_val_if_fail (filename != NULL, NULL);
+
+  module = g_object_new (GEGL_TYPE_MODULE, NULL);
+
+  module->filename = g_strdup (filename);
+  module->verbose  = verbose ? TRUE : FALSE;
+  module->on_disk  = TRUE;
+  module->state    = GEGL_MODULE_STATE_NOT_LOADED;
+
+  return module;
+}
+
 /**
  * gegl_module_query_module:
  * @module: A #GeglModule.
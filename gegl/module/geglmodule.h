@@ -98,6 +98,9 @@ GeglModule  * gegl_module_new              (const gchar     *filename,
                                             gboolean         load_inhibit,
                                             gboolean         verbose);
 
+GeglModule  * gegl_module_new_unloaded     (const gchar     *filename,
+                                            gboolean         verbose);
+
 gboolean      gegl_module_query_module     (GeglModule      *module);
 
 void          gegl_module_modified         (GeglModule      *module);
@@ -18,11 +18,25 @@
 #include <string.h>
 
 #include <glib-object.h>
+#include <glib/gstdio.h>
 #include "gegl-plugin.h"
+#include "gegl-operations.h"
+#include "gegl-extension-handler-private.h"
 #include "geglmodule.h"
 #include "geglmoduledb.h"
 #include "gegldatafiles.h"
 
+/* the registry is discarded when written by a different version of GEGL,
+ * or in a different format
+ */
+#define REGISTRY_GROUP   "registry"
+#define REGISTRY_FORMAT  2
+#define REGISTRY_VERSION G_STRINGIFY (GEGL_MAJOR_VERSION) "." \
+                         G_STRINGIFY (GEGL_MINOR_VERSION) "." \
+                         G_STRINGIFY (GEGL_MICRO_VERSION) "-"  \
+                         G_STRINGIFY (GEGL_MODULE_ABI_VERSION) "-" \
+                         G_STRINGIFY (REGISTRY_FORMAT)
+
 enum
 {
   ADD,
@@ -107,9 +121,13 @@ gegl_module_db_class_init (GeglModuleDBClass *klass)
 static void
 gegl_module_db_init (GeglModuleDB *db)
 {
-  db->modules      = NULL;
-  db->load_inhibit = NULL;
-  db->verbose      = FALSE;
+  db->modules        = NULL;
+  db->load_inhibit   = NULL;
+  db->verbose        = FALSE;
+
+  db->registry       = NULL;
+  db->registry_path  = NULL;
+  db->registry_dirty = FALSE;
 }
 
 static void
@@ -129,6 +147,15 @@ gegl_module_db_finalize (GObject *object)
       db->load_inhibit = NULL;
     }
 
+  if (db->registry)
+    {
+      g_key_file_free (db->registry);
+      db->registry = NULL;
+    }
+
+  g_free (db->registry_path);
+  db->registry_path = NULL;
+
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
@@ -238,6 +265,275 @@ gegl_module_db_get_load_inhibit (GeglModuleDB *db)
   return db->load_inhibit;
 }
 
+/**
+ * gegl_module_db_set_registry:
+ * @db:   A #GeglModuleDB.
+ * @path: The file the module registry is kept in.
+ *
+ * Makes @db keep a registry of the operations provided by the modules it
+ * loads in @path. Modules whose entry in the registry is up to date with
+ * their modification time are not loaded by gegl_module_db_load(), their
+ * operations are made known with gegl_operations_add_deferred() instead,
+ * and the module is loaded when one of them is first looked up.
+ **/
+void
+gegl_module_db_set_registry (GeglModuleDB *db,
+                             const gchar  *path)
+{
+  gchar *version;
+
+  g_return_if_fail (GEGL_IS_MODULE_DB (db));
+  g_return_if_fail (path != NULL);
+
+  if (db->registry)
+    g_key_file_free (db->registry);
+  g_free (db->registry_path);
+
+  db->registry       = g_key_file_new ();
+  db->registry_path  = g_strdup (path);
+  db->registry_dirty = FALSE;
+
+  if (! g_key_file_load_from_file (db->registry, path, G_KEY_FILE_NONE, NULL))
+    return;
+
+  version = g_key_file_get_string (db->registry, REGISTRY_GROUP, "version", NULL);
+
+  if (g_strcmp0 (version, REGISTRY_VERSION))
+    {
+      g_key_file_free (db->registry);
+      db->registry = g_key_file_new ();
+    }
+
+  g_free (version);
+}
+
+/* registry entries are by absolute path, as GEGL_PATH may be relative */
+static gchar *
+gegl_module_db_registry_key (const gchar *filename)
+{
+  gchar *cwd;
+  gchar *key;
+
+  if (g_path_is_absolute (filename))
+    return g_strdup (filename);
+
+  cwd = g_get_current_dir ();
+  key = g_build_filename (cwd, filename, NULL);
+  g_free (cwd);
+
+  return key;
+}
+
+/* returns the operations of the module in @file_data when they are known
+ * from the registry, NULL when the module has to be loaded to find them
+ */
+static gchar **
+gegl_module_db_registry_lookup (GeglModuleDB           *db,
+                                const GeglDatafileData *file_data)
+{
+  gchar  *key;
+  gchar **operations = NULL;
+  GError *error      = NULL;
+  gint64  mtime;
+
+  if (! db->registry)
+    return NULL;
+
+  key   = gegl_module_db_registry_key (file_data->filename);
+  mtime = g_key_file_get_int64 (db->registry, key, "mtime", &error);
+
+  if (! error && mtime == (gint64) file_data->mtime)
+    operations = g_key_file_get_string_list (db->registry, key, "operations",
+                                             NULL, NULL);
+
+  g_clear_error (&error);
+  g_free (key);
+
+  return operations;
+}
+
+static void
+gegl_module_db_collect_operations (GType        type,
+                                   GTypePlugin *plugin,
+                                   GPtrArray   *names)
+{
+  GType *children;
+  guint  n_children;
+  guint  i;
+
+  children = g_type_children (type, &n_children);
+
+  for (i = 0; i < n_children; i++)
+    {
+      if (g_type_get_plugin (children[i]) == plugin)
+        {
+          GeglOperationClass *klass = g_type_class_ref (children[i]);
+
+          if (klass->name)
+            g_ptr_array_add (names, g_strdup (klass->name));
+          if (klass->compat_name)
+            g_ptr_array_add (names, g_strdup (klass->compat_name));
+
+          g_type_class_unref (klass);
+        }
+
+      gegl_module_db_collect_operations (children[i], plugin, names);
+    }
+
+  g_free (children);
+}
+
+/* adds "extension=operation" to @handlers for each extension @operation is
+ * registered for
+ */
+static void
+gegl_module_db_collect_handlers (const gchar *operation,
+                                 gchar      **extensions,
+                                 GPtrArray   *handlers)
+{
+  gint i;
+
+  for (i = 0; extensions[i]; i++)
+    g_ptr_array_add (handlers, g_strconcat (extensions[i], "=", operation,
+                                            NULL));
+
+  g_strfreev (extensions);
+}
+
+/* registers the file extensions recorded for a module under @key, as its
+ * operations would from their class_init once loaded
+ */
+static void
+gegl_module_db_registry_register_handlers (GeglModuleDB *db,
+                                           const gchar  *key,
+                                           gboolean      savers)
+{
+  gchar **handlers;
+  gint    i;
+
+  handlers = g_key_file_get_string_list (db->registry, key,
+                                         savers ? "savers" : "loaders",
+                                         NULL, NULL);
+  if (! handlers)
+    return;
+
+  for (i = 0; handlers[i]; i++)
+    {
+      gchar *operation = strchr (handlers[i], '=');
+
+      if (operation)
+        {
+          *operation++ = '\0';
+
+          if (savers)
+            gegl_extension_handler_register_saver (handlers[i], operation);
+          else
+            gegl_extension_handler_register_loader (handlers[i], operation);
+        }
+    }
+
+  g_strfreev (handlers);
+}
+
+/* record the operations of the freshly loaded @module in the registry,
+ * along with the file extensions they handle
+ */
+static void
+gegl_module_db_registry_update (GeglModuleDB           *db,
+                                GeglModule             *module,
+                                const GeglDatafileData *file_data)
+{
+  gchar *key;
+
+  if (! db->registry)
+    return;
+
+  key = gegl_module_db_registry_key (file_data->filename);
+
+  if (module->state == GEGL_MODULE_STATE_NOT_LOADED)
+    {
+      GPtrArray *names   = g_ptr_array_new_with_free_func (g_free);
+      GPtrArray *loaders = g_ptr_array_new_with_free_func (g_free);
+      GPtrArray *savers  = g_ptr_array_new_with_free_func (g_free);
+      guint      i;
+
+      /* the classes register their extensions when initialized */
+      gegl_module_db_collect_operations (GEGL_TYPE_OPERATION,
+                                         G_TYPE_PLUGIN (module), names);
+
+      for (i = 0; i < names->len; i++)
+        {
+          const gchar *name = g_ptr_array_index (names, i);
+
+          gegl_module_db_collect_handlers (
+            name, gegl_extension_handler_get_loader_extensions (name), loaders);
+          gegl_module_db_collect_handlers (
+            name, gegl_extension_handler_get_saver_extensions (name), savers);
+        }
+
+      g_key_file_set_int64 (db->registry, key, "mtime", file_data->mtime);
+      g_key_file_set_string_list (db->registry, key, "operations",
+                                  (const gchar * const *) names->pdata,
+                                  names->len);
+      g_key_file_set_string_list (db->registry, key, "loaders",
+                                  (const gchar * const *) loaders->pdata,
+                                  loaders->len);
+      g_key_file_set_string_list (db->registry, key, "savers",
+                                  (const gchar * const *) savers->pdata,
+                                  savers->len);
+
+      g_ptr_array_free (names, TRUE);
+      g_ptr_array_free (loaders, TRUE);
+      g_ptr_array_free (savers, TRUE);
+    }
+  else
+    {
+      /* modules that failed to load are tried again next time */
+      g_key_file_remove_group (db->registry, key, NULL);
+    }
+
+  db->registry_dirty = TRUE;
+
+  g_free (key);
+}
+
+static void
+gegl_module_db_registry_save (GeglModuleDB *db)
+{
+  GError  *error = NULL;
+  gchar  **groups;
+  gchar   *dirname;
+  gchar   *data;
+  gsize    length;
+  gint     i;
+
+  /* forget modules that were removed */
+  groups = g_key_file_get_groups (db->registry, NULL);
+  for (i = 0; groups[i]; i++)
+    if (strcmp (groups[i], REGISTRY_GROUP) &&
+        ! g_file_test (groups[i], G_FILE_TEST_IS_REGULAR))
+      g_key_file_remove_group (db->registry, groups[i], NULL);
+  g_strfreev (groups);
+
+  g_key_file_set_string (db->registry, REGISTRY_GROUP, "version",
+                         REGISTRY_VERSION);
+
+  dirname = g_path_get_dirname (db->registry_path);
+  g_mkdir_with_parents (dirname, S_IRUSR | S_IWUSR | S_IXUSR);
+  g_free (dirname);
+
+  /* replaced atomically, other processes may be reading it */
+  data = g_key_file_to_data (db->registry, &length, NULL);
+  if (! g_file_set_contents (db->registry_path, data, length, &error))
+    {
+      g_warning ("unable to write the module registry: %s", error->message);
+      g_error_free (error);
+    }
+  g_free (data);
+
+  db->registry_dirty = FALSE;
+}
+
 /**
  * gegl_module_db_load:
  * @db:          A #GeglModuleDB.
@@ -261,6 +557,9 @@ gegl_module_db_load (GeglModuleDB *db,
                                      gegl_module_db_module_initialize,
                                      db);
 
+  if (db->registry_dirty)
+    gegl_module_db_registry_save (db);
+
 #ifdef DUMP_DB
   g_list_foreach (db->modules, gegl_module_db_dump_module, NULL);
 #endif
@@ -302,6 +601,9 @@ gegl_module_db_refresh (GeglModuleDB *db,
                                    G_FILE_TEST_EXISTS,
                                    gegl_module_db_module_initialize,
                                    db);
+
+  if (db->registry_dirty)
+    gegl_module_db_registry_save (db);
 }
 
 /* name must be of the form lib*.so (Unix) or *.dll (Win32) */
@@ -326,9 +628,10 @@ static void
 gegl_module_db_module_initialize (const GeglDatafileData *file_data,
                                   gpointer                user_data)
 {
-  GeglModuleDB *db = GEGL_MODULE_DB (user_data);
-  GeglModule   *module;
-  gboolean      load_inhibit;
+  GeglModuleDB  *db = GEGL_MODULE_DB (user_data);
+  GeglModule    *module;
+  gboolean       load_inhibit;
+  gchar        **operations;
 
   if (! valid_module_name (file_data->filename))
     return;
@@ -340,9 +643,37 @@ gegl_module_db_module_initialize (const GeglDatafileData *file_data,
   load_inhibit = is_in_inhibit_list (file_data->filename,
                                      db->load_inhibit);
 
-  module = gegl_module_new (file_data->filename,
-                            load_inhibit,
-                            db->verbose);
+  operations = load_inhibit ? NULL :
+               gegl_module_db_registry_lookup (db, file_data);
+
+  if (operations)
+    {
+      gchar *key = gegl_module_db_registry_key (file_data->filename);
+      gint   i;
+
+      module = gegl_module_new_unloaded (file_data->filename, db->verbose);
+
+      for (i = 0; operations[i]; i++)
+        gegl_operations_add_deferred (operations[i], G_TYPE_MODULE (module));
+
+      /* gegl:load and gegl:save look up the operations of files by their
+       * extension, which the operations register from their class_init
+       */
+      gegl_module_db_registry_register_handlers (db, key, FALSE);
+      gegl_module_db_registry_register_handlers (db, key, TRUE);
+
+      g_strfreev (operations);
+      g_free (key);
+    }
+  else
+    {
+      module = gegl_module_new (file_data->filename,
+                                load_inhibit,
+                                db->verbose);
+
+      if (! load_inhibit)
+        gegl_module_db_registry_update (db, module, file_data);
+    }
 
   g_signal_connect (module, "modified",
                     G_CALLBACK (gegl_module_db_module_modified),
@@ -40,6 +40,10 @@ struct _GeglModuleDB
 
   gchar    *load_inhibit;
   gboolean  verbose;
+
+  GKeyFile *registry;       /* the operations of modules, by module path */
+  gchar    *registry_path;
+  gboolean  registry_dirty;
 };
 
 struct _GeglModuleDBClass
@@ -68,6 +72,9 @@ void           gegl_module_db_set_load_inhibit (GeglModuleDB *db,
                                                 const gchar  *load_inhibit);
 const gchar  * gegl_module_db_get_load_inhibit (GeglModuleDB *db);
 
+void           gegl_module_db_set_registry     (GeglModuleDB *db,
+                                                const gchar  *path);
+
 void           gegl_module_db_load             (GeglModuleDB *db,
                                                 const gchar  *module_path);
 void           gegl_module_db_refresh          (GeglModuleDB *db,
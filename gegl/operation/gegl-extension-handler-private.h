@@ -21,4 +21,11 @@
 
 void          gegl_extension_handler_cleanup        (void);
 
+/* the extensions @handler is registered for as a loader or as a saver, for
+ * the module registry to register them again without loading the module
+ * of @handler
+ */
+gchar      ** gegl_extension_handler_get_loader_extensions (const gchar *handler);
+gchar      ** gegl_extension_handler_get_saver_extensions  (const gchar *handler);
+
 #endif /* __GEGL_EXTENSION_HANDLER_PRIVATE_H__ */
\ No newline at end of file
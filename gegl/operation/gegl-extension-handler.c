@@ -17,6 +17,7 @@
  */
 
 #include "config.h"
+#include <string.h>
 #include <glib.h>
 #include "gegl-extension-handler.h"
 #include "gegl-extension-handler-private.h"
@@ -109,6 +110,40 @@ gegl_extension_handler_get_saver (const gchar *extension)
                                           "gegl:png-save");
 }
 
+static gchar **
+gegl_extension_handler_get_extensions_util (GHashTable  *handlers,
+                                            const gchar *handler)
+{
+  GPtrArray      *extensions = g_ptr_array_new ();
+  GHashTableIter  iter;
+  gpointer        extension;
+  gpointer        value;
+
+  if (handlers)
+    {
+      g_hash_table_iter_init (&iter, handlers);
+      while (g_hash_table_iter_next (&iter, &extension, &value))
+        if (!strcmp (value, handler))
+          g_ptr_array_add (extensions, g_strdup (extension));
+    }
+
+  g_ptr_array_add (extensions, NULL);
+
+  return (gchar **) g_ptr_array_free (extensions, FALSE);
+}
+
+gchar **
+gegl_extension_handler_get_loader_extensions (const gchar *handler)
+{
+  return gegl_extension_handler_get_extensions_util (load_handlers, handler);
+}
+
+gchar **
+gegl_extension_handler_get_saver_extensions (const gchar *handler)
+{
+  return gegl_extension_handler_get_extensions_util (save_handlers, handler);
+}
+
 void
 gegl_extension_handler_cleanup (void)
 {
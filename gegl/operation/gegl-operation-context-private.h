@@ -47,6 +47,11 @@ struct _GeglOperationContext
   gboolean       cached;       /* true if the cache can be used directly, and
                                   recomputation of inputs is unneccesary) */
 
+  gboolean       cached_partially; /* true if only the invalid part of the
+                                      cache is recomputed, the result is
+                                      written to the cache and the cache is
+                                      passed on */
+
   gint           refs;         /* set to number of nodes that depends on it
                                   before evaluation begins, each time data is
                                   fetched from the op the reference count is
@@ -60,6 +65,9 @@ struct _GeglOperationContext
                                                                    2 = 1:4,
                                                                    4 = 1:8,
                                                                    6 = 1:16 .. */
+  GeglBufferPool *pool;         /* where the output buffer is taken from, set
+                                   by the graph traversal for operations that
+                                   write their whole result, or NULL */
 };
 
 GeglOperationContext *gegl_operation_context_new       (GeglOperation        *operation);
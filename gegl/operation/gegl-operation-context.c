@@ -32,6 +32,7 @@
 #include "gegl-config.h"
 
 #include "operation/gegl-operation.h"
+#include "process/gegl-buffer-pool.h"
 
 static GValue *
 gegl_operation_context_add_value (GeglOperationContext *self,
@@ -352,6 +353,8 @@ gegl_operation_context_get_target (GeglOperationContext *context,
     {
       if (linear_buffers)
         output = gegl_buffer_linear_new (result, format);
+      else if (context->pool)
+        output = gegl_buffer_pool_take (context->pool, result, format);
       else
         output = gegl_buffer_new (result, format);
     }
@@ -25,6 +25,7 @@
 #include "gegl-operation-point-composer3.h"
 #include "gegl-operation-context.h"
 #include "gegl-config.h"
+#include "gegl-scheduler.h"
 #include <sys/types.h>
 #include <unistd.h>
 #include <string.h>
@@ -37,7 +38,6 @@ typedef struct ThreadData
   guchar                           *aux;
   guchar                           *aux2;
   guchar                           *output;
-  gint                             *pending;
   gint                             *started;
   gint                              level;
   gboolean                          success;
@@ -53,7 +53,7 @@ typedef struct ThreadData
   const Babl *output_fish;
 } ThreadData;
 
-static void thread_process (gpointer thread_data, gpointer unused)
+static void thread_process (gpointer thread_data)
 {
   ThreadData *data = thread_data;
 
@@ -89,19 +89,6 @@ static void thread_process (gpointer thread_data, gpointer unused)
   
   if (data->output_fish)
     babl_process (data->output_fish, data->output_tmp, data->output, samples);
-
-  g_atomic_int_add (data->pending, -1);
-}
-
-static GThreadPool *thread_pool (void)
-{
-  static GThreadPool *pool = NULL;
-  if (!pool)
-    {
-      pool =  g_thread_pool_new (thread_process, NULL, gegl_config_threads (),
-                                 FALSE, NULL);
-    }
-  return pool;
 }
 
 static gboolean
@@ -238,7 +225,7 @@ gegl_operation_point_composer3_process (GeglOperation       *operation,
       if (gegl_operation_use_threading (operation, result) && result->height > 1)
       {
         gint threads = gegl_config_threads ();
-        GThreadPool *pool = thread_pool ();
+        GeglTaskGroup *group;
         ThreadData thread_data[GEGL_MAX_THREADS];
         GeglBufferIterator *i = gegl_buffer_iterator_new (output, result, level, output_buf_format, GEGL_ACCESS_WRITE, GEGL_ABYSS_NONE);
         gint foo = 0, bar = 0, read = 0;
@@ -335,7 +322,6 @@ gegl_operation_point_composer3_process (GeglOperation       *operation,
         while (gegl_buffer_iterator_next (i))
           {
             gint threads = gegl_config_threads ();
-            gint pending;
             gint bit;
 
             if (i->roi[0].height < threads)
@@ -344,7 +330,6 @@ gegl_operation_point_composer3_process (GeglOperation       *operation,
             }
 
             bit = i->roi[0].height / threads;
-            pending = threads;
 
             for (gint j = 0; j < threads; j++)
             {
@@ -363,17 +348,16 @@ gegl_operation_point_composer3_process (GeglOperation       *operation,
               thread_data[j].aux = aux?((guchar*)i->data[foo]) + (bit * j * i->roi[0].width * aux_buf_bpp):NULL;
               thread_data[j].aux2 = aux2?((guchar*)i->data[bar]) + (bit * j * i->roi[0].width * aux2_buf_bpp):NULL;
               thread_data[j].output = ((guchar*)i->data[0]) + (bit * j * i->roi[0].width * out_buf_bpp);
-              thread_data[j].pending = &pending;
               thread_data[j].level = level;
               thread_data[j].success = TRUE;
             }
-            pending = threads;
 
+            group = gegl_task_group_new ();
             for (gint j = 1; j < threads; j++)
-              g_thread_pool_push (pool, &thread_data[j], NULL);
-            thread_process (&thread_data[0], NULL);
+              gegl_task_group_add (group, thread_process, &thread_data[j]);
+            thread_process (&thread_data[0]);
 
-            while (g_atomic_int_get (&pending)) {};
+            gegl_task_group_join (group);
           }
 
         return TRUE;
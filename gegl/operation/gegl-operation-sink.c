@@ -131,3 +131,11 @@ gboolean gegl_operation_sink_needs_full (GeglOperation *operation)
   klass  = GEGL_OPERATION_SINK_CLASS (G_OBJECT_GET_CLASS (operation));
   return klass->needs_full;
 }
+
+gboolean gegl_operation_sink_can_stream (GeglOperation *operation)
+{
+  GeglOperationSinkClass *klass;
+
+  klass  = GEGL_OPERATION_SINK_CLASS (G_OBJECT_GET_CLASS (operation));
+  return klass->stream_band != NULL;
+}
@@ -55,13 +55,31 @@ struct _GeglOperationSinkClass
                         GeglBuffer          *input,
                         const GeglRectangle *roi,
                         gint                 level);
-  gpointer              pad[4];
+
+  /* Sinks able to encode the image in bands of whole rows, from the top
+   * to the bottom, implement stream_band. When such a sink is processed,
+   * each band is handed over as soon as it is rendered and released
+   * afterwards, instead of rendering all of @roi first. Once the first
+   * band was handed over, stream_finish is called exactly once, with
+   * @completed TRUE when the last band of @roi was handed over and every
+   * band succeeded.
+   */
+  gboolean (* stream_band)   (GeglOperation       *self,
+                              GeglBuffer          *input,
+                              const GeglRectangle *roi,
+                              const GeglRectangle *band,
+                              gint                 level);
+  void     (* stream_finish) (GeglOperation       *self,
+                              gboolean             completed);
+  gpointer              pad[2];
 };
 
 GType    gegl_operation_sink_get_type   (void) G_GNUC_CONST;
 
 gboolean gegl_operation_sink_needs_full (GeglOperation *operation);
 
+gboolean gegl_operation_sink_can_stream (GeglOperation *operation);
+
 G_END_DECLS
 
 #endif
@@ -31,6 +31,7 @@
 #include "graph/gegl-node-private.h"
 #include "graph/gegl-connection.h"
 #include "graph/gegl-pad.h"
+#include "process/gegl-graph-traversal.h"
 #include "gegl-operations.h"
 
 static void         attach                    (GeglOperation       *self);
@@ -787,6 +788,10 @@ gegl_operation_use_threading (GeglOperation *operation,
   if (threads == 1)
     return FALSE;
 
+  /* the graph is already being evaluated in parallel parts */
+  if (gegl_graph_in_parallel_worker ())
+    return FALSE;
+
   {
     GeglOperationClass       *op_class;
     op_class = GEGL_OPERATION_GET_CLASS (operation);
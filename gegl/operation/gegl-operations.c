@@ -36,7 +36,13 @@ static GHashTable *visible_operation_names = NULL;
 static GSList     *operations_list         = NULL;
 static guint       gtype_hash_serial       = 0;
 
+/* operations of modules that are not loaded yet, mapping their names to
+ * the GTypeModule providing them
+ */
+static GHashTable *deferred_operations     = NULL;
+
 static GMutex operations_cache_mutex = { 0, };
+static GMutex deferred_mutex         = { 0, };
 
 void
 gegl_operation_class_register_name (GeglOperationClass *klass,
@@ -207,11 +213,83 @@ gegl_operations_set_licenses_from_string (const gchar *license_str)
   gegl_operations_update_visible ();
 }
 
+void
+gegl_operations_add_deferred (const gchar *name,
+                              GTypeModule *module)
+{
+  g_mutex_lock (&deferred_mutex);
+
+  if (!deferred_operations)
+    deferred_operations = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                                 g_free, NULL);
+
+  g_hash_table_insert (deferred_operations, g_strdup (name), module);
+
+  g_mutex_unlock (&deferred_mutex);
+}
+
+static gboolean
+is_provided_by (gpointer key,
+                gpointer value,
+                gpointer module)
+{
+  return value == module;
+}
+
+/* load the module providing @name, if it was deferred; with @name NULL,
+ * all deferred modules are loaded
+ */
+static void
+gegl_operations_load_deferred (const gchar *name)
+{
+  GTypeModule *module;
+
+  g_mutex_lock (&deferred_mutex);
+
+  while (deferred_operations)
+    {
+      if (name)
+        {
+          module = g_hash_table_lookup (deferred_operations, name);
+        }
+      else
+        {
+          GHashTableIter iter;
+
+          module = NULL;
+          g_hash_table_iter_init (&iter, deferred_operations);
+          g_hash_table_iter_next (&iter, NULL, (gpointer) &module);
+        }
+
+      if (!module)
+        break;
+
+      g_hash_table_foreach_remove (deferred_operations, is_provided_by, module);
+
+      GEGL_NOTE (GEGL_DEBUG_MISC, "loading the module providing %s",
+                 name ? name : "deferred operations");
+
+      /* registers the types of the module, which then stays loaded as
+       * long as classes of its types are in use
+       */
+      if (g_type_module_use (module))
+        g_type_module_unuse (module);
+
+      if (name)
+        break;
+    }
+
+  g_mutex_unlock (&deferred_mutex);
+}
+
 GType
 gegl_operation_gtype_from_name (const gchar *name)
 {
   /* If any new modules have been loaded, scan for GeglOperations */
   guint latest_serial;
+
+  gegl_operations_load_deferred (name);
+
   latest_serial = g_type_get_type_registration_serial ();
   if (gtype_hash_serial != latest_serial)
     {
@@ -240,17 +318,16 @@ gchar **gegl_list_operations (guint *n_operations_p)
   gint    pasp_size = 0;
   gint    pasp_pos;
 
+  /* listing needs the classes of all operations */
+  gegl_operations_load_deferred (NULL);
+  gegl_operation_gtype_from_name ("");
+
+  /* should only happen if no operations are found */
   if (!operations_list)
     {
-      gegl_operation_gtype_from_name ("");
-
-      /* should only happen if no operations are found */
-      if (!operations_list)
-        {
-          if (n_operations_p)
-            *n_operations_p = 0;
-          return NULL;
-        }
+      if (n_operations_p)
+        *n_operations_p = 0;
+      return NULL;
     }
 
   g_mutex_lock (&operations_cache_mutex);
@@ -310,6 +387,14 @@ gegl_operation_gtype_cleanup (void)
       operations_list = NULL;
     }
   g_mutex_unlock (&operations_cache_mutex);
+
+  g_mutex_lock (&deferred_mutex);
+  if (deferred_operations)
+    {
+      g_hash_table_destroy (deferred_operations);
+      deferred_operations = NULL;
+    }
+  g_mutex_unlock (&deferred_mutex);
 }
 
 gboolean gegl_can_do_inplace_processing (GeglOperation       *operation,
@@ -36,4 +36,10 @@ void       gegl_operation_class_register_name (GeglOperationClass *klass,
 
 void       gegl_operations_set_licenses_from_string (const gchar *license_str);
 
+/* Make @name known as an operation of @module, which is loaded when the
+ * operation is first looked up.
+ */
+void       gegl_operations_add_deferred     (const gchar *name,
+                                             GTypeModule *module);
+
 #endif
@@ -0,0 +1,169 @@
+/* This file is part of GEGL
+ *
+ * GEGL is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * GEGL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* A pool of output buffers for the operations of a graph traversal.
+ *
+ * Every buffer handed out stays referenced by the pool. Once the contexts
+ * of the operation that produced a buffer and of all its consumers have
+ * been purged, the pool holds the only reference left, and the buffer is
+ * dead; gegl_buffer_pool_reclaim() makes it available again. A later
+ * operation asking for a buffer with the same format and extent then gets
+ * it back with its tiles, instead of a new buffer with a new storage and
+ * handler chain whose tiles all have to be allocated when written.
+ *
+ * The pixels of a reused buffer are those of its previous use, the pool is
+ * only meant for operations writing their whole result.
+ */
+
+#include "config.h"
+
+#include <glib-object.h>
+
+#include "gegl.h"
+#include "gegl-types-internal.h"
+#include "gegl-debug.h"
+
+#include "operation/gegl-operation.h"
+
+#include "process/gegl-buffer-pool.h"
+
+struct _GeglBufferPool
+{
+  GSList *busy; /* buffers handed out, which may still be in use */
+  GSList *idle; /* buffers only referenced by the pool */
+};
+
+static gint n_reused = 0;
+
+GeglBufferPool *
+gegl_buffer_pool_new (void)
+{
+  return g_slice_new0 (GeglBufferPool);
+}
+
+void
+gegl_buffer_pool_free (GeglBufferPool *pool)
+{
+  g_slist_free_full (pool->busy, g_object_unref);
+  g_slist_free_full (pool->idle, g_object_unref);
+
+  g_slice_free (GeglBufferPool, pool);
+}
+
+/**
+ * gegl_buffer_pool_take:
+ * @pool: a #GeglBufferPool
+ * @extent: the extent of the buffer
+ * @format: the format of the buffer
+ *
+ * Get a buffer from @pool, an idle one with the same extent and format if
+ * there is one, a new one otherwise. Its contents are undefined.
+ *
+ * Return value: (transfer full): the buffer
+ */
+GeglBuffer *
+gegl_buffer_pool_take (GeglBufferPool      *pool,
+                       const GeglRectangle *extent,
+                       const Babl          *format)
+{
+  GeglBuffer *buffer = NULL;
+  GSList     *iter;
+
+  for (iter = pool->idle; iter; iter = iter->next)
+    {
+      GeglBuffer *candidate = iter->data;
+
+      if (gegl_buffer_get_format (candidate) == format &&
+          gegl_rectangle_equal (gegl_buffer_get_extent (candidate), extent))
+        {
+          buffer     = candidate;
+          pool->idle = g_slist_delete_link (pool->idle, iter);
+          g_atomic_int_inc (&n_reused);
+
+          GEGL_NOTE (GEGL_DEBUG_PROCESS,
+                     "Reusing pooled %d×%d buffer",
+                     extent->width, extent->height);
+          break;
+        }
+    }
+
+  if (!buffer)
+    buffer = gegl_buffer_new (extent, format);
+
+  pool->busy = g_slist_prepend (pool->busy, buffer);
+
+  return g_object_ref (buffer);
+}
+
+/**
+ * gegl_buffer_pool_reclaim:
+ * @pool: a #GeglBufferPool
+ *
+ * Make the buffers of @pool that nothing but the pool references anymore
+ * available again.
+ */
+void
+gegl_buffer_pool_reclaim (GeglBufferPool *pool)
+{
+  GSList *iter;
+  GSList *next;
+
+  for (iter = pool->busy; iter; iter = next)
+    {
+      GeglBuffer *buffer = iter->data;
+
+      next = iter->next;
+
+      if (g_atomic_int_get ((gint *) &G_OBJECT (buffer)->ref_count) != 1)
+        continue;
+
+      pool->busy = g_slist_delete_link (pool->busy, iter);
+
+      /* a buffer that has been passed to more than one consumer is never
+       * processed in place again, don't keep it around
+       */
+      if (gegl_object_get_has_forked (G_OBJECT (buffer)))
+        g_object_unref (buffer);
+      else
+        pool->idle = g_slist_prepend (pool->idle, buffer);
+    }
+}
+
+/**
+ * gegl_buffer_pool_get_n_reused:
+ *
+ * For debugging and tests.
+ *
+ * Return value: the number of buffers any pool has handed out again
+ */
+guint
+gegl_buffer_pool_get_n_reused (void)
+{
+  return g_atomic_int_get (&n_reused);
+}
+
+/**
+ * gegl_buffer_pool_trim:
+ * @pool: a #GeglBufferPool
+ *
+ * Free the idle buffers of @pool.
+ */
+void
+gegl_buffer_pool_trim (GeglBufferPool *pool)
+{
+  g_slist_free_full (pool->idle, g_object_unref);
+  pool->idle = NULL;
+}
@@ -0,0 +1,35 @@
+/* This file is part of GEGL
+ *
+ * GEGL is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * GEGL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GEGL_BUFFER_POOL_H__
+#define __GEGL_BUFFER_POOL_H__
+
+G_BEGIN_DECLS
+
+GeglBufferPool *gegl_buffer_pool_new     (void);
+void            gegl_buffer_pool_free    (GeglBufferPool      *pool);
+
+GeglBuffer     *gegl_buffer_pool_take    (GeglBufferPool      *pool,
+                                          const GeglRectangle *extent,
+                                          const Babl          *format);
+void            gegl_buffer_pool_reclaim (GeglBufferPool      *pool);
+void            gegl_buffer_pool_trim    (GeglBufferPool      *pool);
+
+guint           gegl_buffer_pool_get_n_reused (void);
+
+G_END_DECLS
+
+#endif /* __GEGL_BUFFER_POOL_H__ */
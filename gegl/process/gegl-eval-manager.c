@@ -26,6 +26,7 @@
 #include "gegl-types-internal.h"
 #include "gegl-eval-manager.h"
 #include "gegl-instrument.h"
+#include "gegl-trace.h"
 
 #include "graph/gegl-node-private.h"
 
@@ -81,7 +82,11 @@ gegl_eval_manager_change_notification (GObject             *gobject,
                                        gpointer             user_data)
 {
   GeglEvalManager *manager = GEGL_EVAL_MANAGER (user_data);
-  manager->state = INVALID;
+
+  /* The caches along the way have already been invalidated for @rect, if
+   * only pixel contents changed the prepared graph can still be used */
+  if (manager->state == READY)
+    manager->state = CONTENTS_CHANGED;
 
   return FALSE;
 }
@@ -92,8 +97,23 @@ gegl_eval_manager_prepare (GeglEvalManager *self)
   g_return_if_fail (GEGL_IS_EVAL_MANAGER (self));
   g_return_if_fail (GEGL_IS_NODE (self->node));
 
+  if (self->state == CONTENTS_CHANGED)
+    {
+      if (self->graph_serial == gegl_node_get_graph_serial () &&
+          gegl_graph_revalidate (self->traversal))
+        {
+          self->state = READY;
+        }
+      else
+        {
+          self->state = INVALID;
+        }
+    }
+
   if (self->state != READY)
     {
+      self->graph_serial = gegl_node_get_graph_serial ();
+
       if (!self->traversal)
         self->traversal = gegl_graph_build (self->node);
       else
@@ -126,15 +146,32 @@ gegl_eval_manager_apply (GeglEvalManager     *self,
     level = GEGL_CACHE_VALID_MIPMAPS-1;
 
   GEGL_INSTRUMENT_START();
+  GEGL_TRACE_START();
   gegl_eval_manager_prepare (self);
+  GEGL_TRACE_END ("graph", "prepare-graph");
   GEGL_INSTRUMENT_END ("gegl", "prepare-graph");
 
+  if (gegl_graph_can_process_parallel (self->traversal, roi, level))
+    {
+      GEGL_INSTRUMENT_START();
+      GEGL_TRACE_START();
+      object = gegl_graph_process_parallel (self->traversal, roi, level);
+      GEGL_TRACE_END ("graph", "process-parallel");
+      GEGL_INSTRUMENT_END ("gegl", "process-parallel");
+
+      return object;
+    }
+
   GEGL_INSTRUMENT_START();
+  GEGL_TRACE_START();
   gegl_graph_prepare_request (self->traversal, roi, level);
+  GEGL_TRACE_END ("graph", "prepare-request");
   GEGL_INSTRUMENT_END ("gegl", "prepare-request");
 
   GEGL_INSTRUMENT_START();
+  GEGL_TRACE_START();
   object = gegl_graph_process (self->traversal, level);
+  GEGL_TRACE_END ("graph", "process");
   GEGL_INSTRUMENT_END ("gegl", "process");
 
   return object;
@@ -30,6 +30,7 @@ G_BEGIN_DECLS
 typedef enum
 {
   INVALID,
+  CONTENTS_CHANGED, /* only pixel contents changed since the last prepare */
   READY
 } GeglEvalManagerStates;
 
@@ -52,6 +53,7 @@ struct _GeglEvalManager
 
   GeglGraphTraversal    *traversal;
   GeglEvalManagerStates  state;
+  guint                  graph_serial; /* of the last prepare */
 
 };
 
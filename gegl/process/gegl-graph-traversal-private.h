@@ -26,6 +26,7 @@ struct _GeglGraphTraversal
   GList *bfs_path;
   gboolean rects_dirty;
   GeglBuffer *shared_empty;
+  GeglBufferPool *pool;
 };
 
 #endif /* __GEGL_GRAPH_TRAVERSAL_PRIVATE_H__ */
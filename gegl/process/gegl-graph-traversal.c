@@ -19,12 +19,18 @@
 
 #include "config.h"
 
+#include <math.h>
+#include <string.h>
+
 #include <glib-object.h>
 
 #include "gegl-types-internal.h"
 #include "gegl.h"
 #include "gegl-debug.h"
+#include "gegl-config.h"
 #include "gegl-instrument.h"
+#include "gegl-scheduler.h"
+#include "gegl-trace.h"
 
 #include "buffer/gegl-region.h"
 
@@ -33,6 +39,7 @@
 #include "graph/gegl-visitable.h"
 #include "graph/gegl-connection.h"
 
+#include "process/gegl-buffer-pool.h"
 #include "process/gegl-graph-traversal.h"
 #include "process/gegl-graph-traversal-private.h"
 #include "process/gegl-list-visitor.h"
@@ -40,6 +47,11 @@
 #include "operation/gegl-operation.h"
 #include "operation/gegl-operation-context.h"
 #include "operation/gegl-operation-context-private.h"
+#include "operation/gegl-operation-point-filter.h"
+#include "operation/gegl-operation-point-composer.h"
+#include "operation/gegl-operation-point-render.h"
+
+#include "opencl/gegl-cl.h"
 
 typedef struct
 {
@@ -128,6 +140,8 @@ gegl_graph_free (GeglGraphTraversal *path)
   g_hash_table_unref (path->contexts);
   if (path->shared_empty)
     g_object_unref (path->shared_empty);
+  if (path->pool)
+    gegl_buffer_pool_free (path->pool);
 
   g_free (path);
 }
@@ -202,6 +216,45 @@ gegl_graph_prepare (GeglGraphTraversal *path)
   }
 }
 
+/**
+ * gegl_graph_revalidate:
+ * @path: The traversal path
+ *
+ * Mark the bounding boxes found by the last gegl_graph_prepare() as valid
+ * again, after a change that only affected the pixel contents of the
+ * graph. The bounding boxes are computed anew, as they can depend on
+ * state outside of the graph, like the extent of the buffer of a
+ * gegl:buffer-source.
+ *
+ * Return value: FALSE if a bounding box changed, and the graph has to be
+ * prepared with gegl_graph_prepare()
+ */
+gboolean
+gegl_graph_revalidate (GeglGraphTraversal *path)
+{
+  GList *list_iter = NULL;
+
+  for (list_iter = path->dfs_path; list_iter; list_iter = list_iter->next)
+    {
+      GeglNode      *node = GEGL_NODE (list_iter->data);
+      GeglRectangle  have_rect;
+      gboolean       unchanged;
+
+      g_mutex_lock (&node->mutex);
+
+      have_rect = gegl_operation_get_bounding_box (node->operation);
+      unchanged = gegl_rectangle_equal (&have_rect, &node->have_rect);
+      node->valid_have_rect = unchanged;
+
+      g_mutex_unlock (&node->mutex);
+
+      if (!unchanged)
+        return FALSE;
+    }
+
+  return TRUE;
+}
+
 /**
  * gegl_graph_prepare_request:
  * @path: The traversal path
@@ -235,6 +288,7 @@ gegl_graph_prepare_request (GeglGraphTraversal  *path,
 
           /* Reset cached status, because the rect we need may have changed */
           context->cached = FALSE;
+          context->cached_partially = FALSE;
         }
     }
 
@@ -276,10 +330,17 @@ gegl_graph_prepare_request (GeglGraphTraversal  *path,
       
       if (node->cache)
         {
-          gint i;
+          GeglCache *cache = node->cache;
+          gint       i;
+
+          /* parts of a parallel evaluation mark regions of the same caches
+           * as computed while others check them
+           */
+          g_mutex_lock (&cache->mutex);
+
           for (i = level; i >=0 && !context->cached; i--)
           {
-            if (gegl_region_rect_in (node->cache->valid_region[level], request) == GEGL_OVERLAP_RECTANGLE_IN)
+            if (gegl_region_rect_in (cache->valid_region[level], request) == GEGL_OVERLAP_RECTANGLE_IN)
             {
               /* This node is cached and the cache fulfills our need rect */
               context->cached = TRUE;
@@ -287,7 +348,39 @@ gegl_graph_prepare_request (GeglGraphTraversal  *path,
             }
           }
           if (context->cached)
-            continue;
+            {
+              g_mutex_unlock (&cache->mutex);
+              continue;
+            }
+
+          if (level == 0)
+            {
+              /* Only recompute the part of the need rect that isn't valid
+               * in the cache, the rest of the cache is reused */
+              GeglRegion    *invalid = gegl_region_rectangle (request);
+              GeglRectangle  invalid_box;
+
+              gegl_region_subtract (invalid, cache->valid_region[level]);
+              gegl_region_get_clipbox (invalid, &invalid_box);
+              gegl_region_destroy (invalid);
+
+              if (!gegl_rectangle_equal (&invalid_box, request))
+                {
+                  GEGL_NOTE (GEGL_DEBUG_PROCESS,
+                             "Recomputing %d, %d %d×%d of %d, %d %d×%d for %s",
+                             invalid_box.x, invalid_box.y,
+                             invalid_box.width, invalid_box.height,
+                             request->x, request->y,
+                             request->width, request->height,
+                             gegl_node_get_debug_name (node));
+
+                  context->cached_partially = TRUE;
+                  gegl_operation_context_set_need_rect (context, &invalid_box);
+                  request = gegl_operation_context_get_need_rect (context);
+                }
+            }
+
+          g_mutex_unlock (&cache->mutex);
         }
 
       {
@@ -296,7 +389,6 @@ gegl_graph_prepare_request (GeglGraphTraversal  *path,
 
         gegl_operation_context_set_need_rect (context, &full_request);
 
-        /* FIXME: We could trim this down based on the cache, instead of being all or nothing */
         gegl_operation_context_set_result_rect (context, request);
 
         for (input_pads = node->input_pads; input_pads; input_pads = input_pads->next)
@@ -373,6 +465,493 @@ gegl_graph_get_shared_empty (GeglGraphTraversal *path)
 }
 
 
+/* Runs of point operations, where each operation only feeds the next one,
+ * are processed together: every block of pixels is passed through all of
+ * the operations while it is in cache, and the intermediate buffers are
+ * never created. The number of pixels in a block, two blocks of RGBA float
+ * pixels fit in the L1 cache.
+ */
+#define POINT_RUN_BLOCK_PIXELS 512
+
+typedef struct
+{
+  GeglOperation                   *operation;
+  GeglOperationPointFilterClass   *filter_class;   /* NULL for composers */
+  GeglOperationPointComposerClass *composer_class; /* NULL for filters */
+  const Babl                      *fish;           /* converts the output of
+                                                      the previous operation
+                                                      to our input format, or
+                                                      NULL */
+  gint                             aux;            /* iterator index of the
+                                                      aux buffer, or 0 */
+} PointRunOp;
+
+typedef struct
+{
+  PointRunOp         *ops;
+  gint                n_ops;
+  gint                level;
+  gint                bpp[GEGL_BUFFER_MAX_ITERATORS];
+  GeglBufferIterator *iter;
+} PointRun;
+
+typedef struct
+{
+  PointRun *run;
+  gint      first_row;
+  gint      n_rows;
+  guchar   *scratch[2];
+} PointRunPart;
+
+static gint point_run_n_ops;
+
+/* Whether @operation is processed by the regular operation class functions
+ * of a point filter or a point composer. Operations overriding the
+ * processing of the base class, for instance to pass their input through
+ * for some property values, are left alone.
+ */
+static gboolean
+gegl_graph_is_point_op (GeglOperation *operation)
+{
+  GeglOperationClass *klass = GEGL_OPERATION_GET_CLASS (operation);
+
+  if (GEGL_IS_OPERATION_POINT_FILTER (operation))
+    {
+      GeglOperationClass *base = g_type_class_peek (GEGL_TYPE_OPERATION_POINT_FILTER);
+
+      return klass->process == base->process &&
+             GEGL_OPERATION_FILTER_CLASS (klass)->process ==
+             GEGL_OPERATION_FILTER_CLASS (base)->process;
+    }
+  else if (GEGL_IS_OPERATION_POINT_COMPOSER (operation))
+    {
+      GeglOperationClass *base = g_type_class_peek (GEGL_TYPE_OPERATION_POINT_COMPOSER);
+
+      return klass->process == base->process &&
+             GEGL_OPERATION_COMPOSER_CLASS (klass)->process ==
+             GEGL_OPERATION_COMPOSER_CLASS (base)->process;
+    }
+
+  return FALSE;
+}
+
+/* Whether the output of @operation can be written into a pooled buffer,
+ * which holds the pixels of its previous use; only operations known to
+ * write every pixel of their result qualify.
+ */
+static gboolean
+gegl_graph_can_pool_output (GeglOperation *operation)
+{
+  if (GEGL_IS_OPERATION_POINT_RENDER (operation))
+    {
+      GeglOperationClass *klass = GEGL_OPERATION_GET_CLASS (operation);
+      GeglOperationClass *base  = g_type_class_peek (GEGL_TYPE_OPERATION_POINT_RENDER);
+
+      return klass->process == base->process &&
+             GEGL_OPERATION_SOURCE_CLASS (klass)->process ==
+             GEGL_OPERATION_SOURCE_CLASS (base)->process;
+    }
+
+  return gegl_graph_is_point_op (operation);
+}
+
+/* Set the level @context is processed at, and the pool its output buffer
+ * is taken from. Pooled buffers are only used at level 0, the tiles of
+ * other levels of a reused buffer could be stale.
+ */
+static void
+gegl_graph_context_set_level (GeglGraphTraversal   *path,
+                              GeglOperationContext *context,
+                              gint                  level)
+{
+  context->level = level;
+  context->pool  = NULL;
+
+  if (level == 0 && gegl_graph_can_pool_output (context->operation))
+    {
+      if (!path->pool)
+        path->pool = gegl_buffer_pool_new ();
+      context->pool = path->pool;
+    }
+}
+
+/* Whether @node can be fused with the neighbouring operations in a run */
+static gboolean
+gegl_graph_point_op_can_fuse (GeglGraphTraversal *path,
+                              GeglNode           *node)
+{
+  GeglOperationContext *context = g_hash_table_lookup (path->contexts, node);
+
+  if (!context ||
+      node->passthrough ||
+      context->cached ||
+      context->cached_partially ||
+      context->need_rect.width <= 0 ||
+      context->need_rect.height <= 0)
+    return FALSE;
+
+  return gegl_graph_is_point_op (node->operation);
+}
+
+/* Whether @node is a point operation whose output only goes to the input
+ * pad of another point operation processing the same rectangle, in which
+ * case @node is processed as part of the run ending in that operation.
+ */
+static gboolean
+gegl_graph_point_op_is_fused (GeglGraphTraversal *path,
+                              GeglNode           *node)
+{
+  GeglOperationContext *context;
+  GList                *targets;
+  gboolean              fused = FALSE;
+
+  if (!gegl_graph_point_op_can_fuse (path, node))
+    return FALSE;
+
+  context = g_hash_table_lookup (path->contexts, node);
+  targets = gegl_graph_get_connected_output_contexts (path,
+              gegl_node_get_pad (node, "output"));
+
+  if (g_list_length (targets) == 1)
+    {
+      ContextConnection *target = targets->data;
+
+      fused = !strcmp (target->name, "input") &&
+              gegl_rectangle_equal (&context->need_rect,
+                                    &target->context->need_rect) &&
+              gegl_graph_point_op_can_fuse (path,
+                                            target->context->operation->node);
+    }
+
+  g_list_free_full (targets, free_context_connection);
+
+  return fused;
+}
+
+/* Collect the contexts of the run of fused operations ending in @node,
+ * from first to last, or return NULL if @node isn't the end of a run.
+ */
+static GPtrArray *
+gegl_graph_get_point_run (GeglGraphTraversal *path,
+                          GeglNode           *node)
+{
+  GPtrArray *run;
+  GeglNode  *source;
+  guint      i;
+
+  source = gegl_node_get_producer (node, "input", NULL);
+  if (!source ||
+      !gegl_graph_point_op_is_fused (path, source))
+    return NULL;
+
+  run = g_ptr_array_new ();
+  g_ptr_array_add (run, g_hash_table_lookup (path->contexts, node));
+
+  while (source && gegl_graph_point_op_is_fused (path, source))
+    {
+      g_ptr_array_add (run, g_hash_table_lookup (path->contexts, source));
+      source = gegl_node_get_producer (source, "input", NULL);
+    }
+
+  /* collected from last to first */
+  for (i = 0; i < run->len / 2; i++)
+    {
+      gpointer tmp = run->pdata[i];
+
+      run->pdata[i] = run->pdata[run->len - 1 - i];
+      run->pdata[run->len - 1 - i] = tmp;
+    }
+
+  return run;
+}
+
+static void
+gegl_graph_process_point_run_part (gpointer data)
+{
+  PointRunPart        *part = data;
+  PointRun            *run  = part->run;
+  GeglBufferIterator  *iter = run->iter;
+  const GeglRectangle *roi  = &iter->roi[0];
+  gint                 cols = MIN (roi->width, POINT_RUN_BLOCK_PIXELS);
+  gint                 rows = MAX (1, POINT_RUN_BLOCK_PIXELS / roi->width);
+  gint                 x, y;
+
+  for (y = part->first_row; y < part->first_row + part->n_rows; y += rows)
+    for (x = 0; x < roi->width; x += cols)
+      {
+        GeglRectangle block;
+        glong         offset = (glong) y * roi->width + x;
+        glong         samples;
+        guchar       *in;
+        gint          current = 0;
+        gint          i;
+
+        block.x      = roi->x + x;
+        block.y      = roi->y + y;
+        block.width  = MIN (cols, roi->width - x);
+        block.height = MIN (rows, part->first_row + part->n_rows - y);
+        samples      = block.width * block.height;
+
+        in = (guchar *) iter->data[1] + offset * run->bpp[1];
+
+        for (i = 0; i < run->n_ops; i++)
+          {
+            PointRunOp *op = &run->ops[i];
+            guchar     *out;
+
+            if (op->fish)
+              {
+                babl_process (op->fish, in, part->scratch[current], samples);
+                in = part->scratch[current];
+                current = !current;
+              }
+
+            if (i == run->n_ops - 1)
+              out = (guchar *) iter->data[0] + offset * run->bpp[0];
+            else
+              out = part->scratch[current];
+
+            if (op->filter_class)
+              {
+                op->filter_class->process (op->operation, in, out, samples,
+                                           &block, run->level);
+              }
+            else
+              {
+                guchar *aux = NULL;
+
+                if (op->aux)
+                  aux = (guchar *) iter->data[op->aux] +
+                        offset * run->bpp[op->aux];
+
+                op->composer_class->process (op->operation, in, aux, out,
+                                             samples, &block, run->level);
+              }
+
+            in = out;
+            current = !current;
+          }
+      }
+}
+
+/* Process the operations of @contexts from @first to @last, reading the
+ * input of the first one and writing the output of the last one, which is
+ * returned.
+ */
+static GeglBuffer *
+gegl_graph_process_point_ops (GPtrArray *contexts,
+                              gint       first,
+                              gint       last,
+                              gint       level)
+{
+  GeglOperationContext *first_context = g_ptr_array_index (contexts, first);
+  GeglOperationContext *last_context  = g_ptr_array_index (contexts, last);
+  const GeglRectangle  *roi           = &last_context->need_rect;
+  GeglBuffer           *input;
+  GeglBuffer           *output;
+  PointRun              run;
+  PointRunPart          parts[GEGL_MAX_THREADS];
+  gboolean              threaded;
+  const Babl           *format;
+  gint                  max_bpp = 0;
+  gint                  threads;
+  gint                  i, j;
+
+  input  = gegl_operation_context_get_source (first_context, "input");
+  output = gegl_operation_context_get_output_maybe_in_place (
+             last_context->operation, last_context, input, roi);
+
+  threaded  = gegl_operation_use_threading (first_context->operation, roi) &&
+              roi->height > 1;
+  run.n_ops = last - first + 1;
+  run.ops   = g_new0 (PointRunOp, run.n_ops);
+  run.level = level;
+
+  format     = gegl_operation_get_format (last_context->operation, "output");
+  run.iter   = gegl_buffer_iterator_new (output, roi, level, format,
+                                         GEGL_ACCESS_WRITE, GEGL_ABYSS_NONE);
+  run.bpp[0] = babl_format_get_bytes_per_pixel (format);
+
+  format     = gegl_operation_get_format (first_context->operation, "input");
+  gegl_buffer_iterator_add (run.iter, input, roi, level, format,
+                            GEGL_ACCESS_READ, GEGL_ABYSS_NONE);
+  run.bpp[1] = babl_format_get_bytes_per_pixel (format);
+
+  for (i = 0; i < run.n_ops; i++)
+    {
+      GeglOperationContext *context   = g_ptr_array_index (contexts, first + i);
+      GeglOperation        *operation = context->operation;
+      PointRunOp           *op        = &run.ops[i];
+      const Babl           *in_format;
+      const Babl           *out_format;
+
+      op->operation = operation;
+      in_format  = gegl_operation_get_format (operation, "input");
+      out_format = gegl_operation_get_format (operation, "output");
+
+      if (in_format != format)
+        op->fish = babl_fish (format, in_format);
+
+      if (GEGL_IS_OPERATION_POINT_FILTER (operation))
+        {
+          op->filter_class = GEGL_OPERATION_POINT_FILTER_GET_CLASS (operation);
+        }
+      else
+        {
+          GeglBuffer *aux = gegl_operation_context_get_source (context, "aux");
+
+          op->composer_class = GEGL_OPERATION_POINT_COMPOSER_GET_CLASS (operation);
+
+          if (aux)
+            {
+              const Babl *aux_format = gegl_operation_get_format (operation, "aux");
+
+              op->aux = gegl_buffer_iterator_add (run.iter, aux, roi, level,
+                                                  aux_format, GEGL_ACCESS_READ,
+                                                  GEGL_ABYSS_NONE);
+              run.bpp[op->aux] = babl_format_get_bytes_per_pixel (aux_format);
+              g_object_unref (aux);
+            }
+        }
+
+      if (!GEGL_OPERATION_GET_CLASS (operation)->threaded)
+        threaded = FALSE;
+
+      max_bpp = MAX (max_bpp, babl_format_get_bytes_per_pixel (in_format));
+      max_bpp = MAX (max_bpp, babl_format_get_bytes_per_pixel (out_format));
+      format  = out_format;
+    }
+
+  threads = threaded ? gegl_config_threads () : 1;
+
+  for (j = 0; j < threads; j++)
+    {
+      parts[j].run        = &run;
+      parts[j].scratch[0] = gegl_malloc (max_bpp * POINT_RUN_BLOCK_PIXELS);
+      parts[j].scratch[1] = gegl_malloc (max_bpp * POINT_RUN_BLOCK_PIXELS);
+    }
+
+  /* split the rows of every iterator chunk over the threads, like the
+   * point operations themselves do
+   */
+  while (gegl_buffer_iterator_next (run.iter))
+    {
+      gint height  = run.iter->roi[0].height;
+      gint n_parts = MIN (threads, height);
+      gint bit     = height / n_parts;
+
+      for (j = 0; j < n_parts; j++)
+        {
+          parts[j].first_row = bit * j;
+          parts[j].n_rows    = bit;
+        }
+      parts[n_parts - 1].n_rows = height - bit * (n_parts - 1);
+
+      if (n_parts > 1)
+        {
+          GeglTaskGroup *group = gegl_task_group_new ();
+
+          for (j = 1; j < n_parts; j++)
+            gegl_task_group_add (group, gegl_graph_process_point_run_part,
+                                 &parts[j]);
+          gegl_graph_process_point_run_part (&parts[0]);
+
+          gegl_task_group_join (group);
+        }
+      else
+        {
+          gegl_graph_process_point_run_part (&parts[0]);
+        }
+    }
+
+  for (j = 0; j < threads; j++)
+    {
+      gegl_free (parts[j].scratch[0]);
+      gegl_free (parts[j].scratch[1]);
+    }
+
+  g_free (run.ops);
+
+  if (input)
+    g_object_unref (input);
+
+  return output;
+}
+
+/**
+ * gegl_graph_get_n_fused_ops:
+ *
+ * Return value: The number of point operations processed as part of a
+ * fused run so far, for checking that runs are fused at all.
+ */
+gint
+gegl_graph_get_n_fused_ops (void)
+{
+  return g_atomic_int_get (&point_run_n_ops);
+}
+
+/* Process a run of fused point operations. The iterator used for a group
+ * of operations holds the output, the input and the aux buffers of the
+ * composers in it, runs needing more aux buffers than that are split into
+ * several groups, with a buffer between them.
+ */
+static void
+gegl_graph_process_point_run (GeglGraphTraversal *path,
+                              GPtrArray          *contexts,
+                              gint                level)
+{
+  gint n_contexts = contexts->len;
+  gint first      = 0;
+
+  while (first < n_contexts)
+    {
+      GeglOperationContext *context;
+      GeglBuffer           *output;
+      gint                  n_aux = 0;
+      gint                  last;
+
+      for (last = first; last < n_contexts; last++)
+        {
+          context = g_ptr_array_index (contexts, last);
+          gegl_graph_context_set_level (path, context, level);
+
+          if (gegl_operation_context_get_object (context, "aux"))
+            {
+              if (n_aux == GEGL_BUFFER_MAX_ITERATORS - 2)
+                break;
+              n_aux++;
+            }
+        }
+      last--;
+
+      context = g_ptr_array_index (contexts, first);
+      if (!gegl_operation_context_get_object (context, "input"))
+        gegl_operation_context_set_object (context, "input",
+                                           G_OBJECT (gegl_graph_get_shared_empty (path)));
+
+      output = gegl_graph_process_point_ops (contexts, first, last, level);
+
+      if (last + 1 < n_contexts)
+        gegl_operation_context_set_object (g_ptr_array_index (contexts, last + 1),
+                                           "input", G_OBJECT (output));
+
+      g_atomic_int_add (&point_run_n_ops, last - first + 1);
+
+      context = g_ptr_array_index (contexts, last);
+      GEGL_NOTE (GEGL_DEBUG_PROCESS,
+                 "Processed %d fused point operations ending in %s",
+                 last - first + 1,
+                 gegl_node_get_debug_name (context->operation->node));
+
+      first = last + 1;
+    }
+
+  /* the results are only kept in the context of the last operation */
+  for (first = 0; first < n_contexts - 1; first++)
+    gegl_operation_context_purge (g_ptr_array_index (contexts, first));
+}
+
+
 /**
  * gegl_graph_process:
  * @path: The traversal path
@@ -396,6 +975,8 @@ gegl_graph_process (GeglGraphTraversal *path,
   GeglOperationContext *context = NULL;
   GeglOperationContext *last_context = NULL;
   GeglBuffer *operation_result = NULL;
+  gboolean fuse_point_ops = gegl_config ()->point_fusion &&
+                            !gegl_cl_is_accelerated ();
 
   for (list_iter = path->dfs_path; list_iter; list_iter = list_iter->next)
     {
@@ -403,13 +984,24 @@ gegl_graph_process (GeglGraphTraversal *path,
       GeglOperation *operation = node->operation;
       g_return_val_if_fail (node, NULL);
       g_return_val_if_fail (operation, NULL);
+
+      /* processed together with the point operation consuming its output */
+      if (fuse_point_ops && gegl_graph_point_op_is_fused (path, node))
+        continue;
       
       GEGL_INSTRUMENT_START();
+      GEGL_TRACE_START();
 
       operation_result = NULL;
 
       if (last_context)
         gegl_operation_context_purge (last_context);
+
+      /* the buffers of the operations whose consumers are all done are
+       * free for reuse by this one
+       */
+      if (path->pool)
+        gegl_buffer_pool_reclaim (path->pool);
       
       context = g_hash_table_lookup (path->contexts, node);
       g_return_val_if_fail (context, NULL);
@@ -430,19 +1022,45 @@ gegl_graph_process (GeglGraphTraversal *path,
             }
           else
             {
-              /* Guarantee input pad */
-              if (gegl_node_has_pad (node, "input") &&
-                  !gegl_operation_context_get_object (context, "input"))
+              GPtrArray *run = NULL;
+
+              gegl_graph_context_set_level (path, context, level);
+
+              if (fuse_point_ops)
+                run = gegl_graph_get_point_run (path, node);
+
+              if (run)
                 {
-                  gegl_operation_context_set_object (context, "input", G_OBJECT (gegl_graph_get_shared_empty(path)));
+                  gegl_graph_process_point_run (path, run, level);
+                  g_ptr_array_free (run, TRUE);
+                }
+              else
+                {
+                  /* Guarantee input pad */
+                  if (gegl_node_has_pad (node, "input") &&
+                      !gegl_operation_context_get_object (context, "input"))
+                    {
+                      gegl_operation_context_set_object (context, "input", G_OBJECT (gegl_graph_get_shared_empty(path)));
+                    }
+
+                  gegl_operation_process (operation, context, "output", &context->need_rect, context->level);
                 }
-
-              context->level = level;
-              gegl_operation_process (operation, context, "output", &context->need_rect, context->level);
               operation_result = GEGL_BUFFER (gegl_operation_context_get_object (context, "output"));
 
               if (operation_result && operation_result == (GeglBuffer *)operation->node->cache)
-                gegl_cache_computed (operation->node->cache, &context->need_rect, level);
+                {
+                  gegl_cache_computed (operation->node->cache, &context->need_rect, level);
+                }
+              else if (operation_result && context->cached_partially)
+                {
+                  /* The consumers need the valid parts of the cache as well,
+                   * merge the recomputed part into it and pass it on */
+                  gegl_buffer_copy (operation_result, &context->need_rect,
+                                    GEGL_ABYSS_NONE,
+                                    GEGL_BUFFER (node->cache), &context->need_rect);
+                  gegl_cache_computed (node->cache, &context->need_rect, level);
+                  operation_result = GEGL_BUFFER (node->cache);
+                }
             }
         }
       else
@@ -476,6 +1094,7 @@ gegl_graph_process (GeglGraphTraversal *path,
       
       last_context = context;
 
+      GEGL_TRACE_END ("process", gegl_node_get_operation (node));
       GEGL_INSTRUMENT_END ("process", gegl_node_get_operation (node));
     }
   
@@ -488,5 +1107,253 @@ gegl_graph_process (GeglGraphTraversal *path,
       gegl_operation_context_purge (last_context);
     }
 
+  /* don't keep buffers alive between evaluations, requests for other
+   * rectangles can't reuse them
+   */
+  if (path->pool)
+    {
+      gegl_buffer_pool_reclaim (path->pool);
+      gegl_buffer_pool_trim (path->pool);
+    }
+
   return result;
 }
+
+/* Evaluation state shared by all the parts of a parallel graph evaluation */
+typedef struct
+{
+  GeglGraphTraversal *path;
+  GeglBuffer         *output;
+  gint                level;
+} ParallelJob;
+
+typedef struct
+{
+  ParallelJob   *job;
+  GeglRectangle  roi;
+} ParallelPart;
+
+static GPrivate parallel_worker;
+
+/**
+ * gegl_graph_in_parallel_worker:
+ *
+ * Return value: TRUE if the calling thread is evaluating a part of a
+ * parallel graph evaluation, in which case operations should not
+ * spread their own work over more threads.
+ */
+gboolean
+gegl_graph_in_parallel_worker (void)
+{
+  return g_private_get (&parallel_worker) != NULL;
+}
+
+/* Create a traversal for the same prepared graph as @path, with its own
+ * set of operation contexts so that it can process a different request
+ * concurrently.
+ */
+static GeglGraphTraversal *
+gegl_graph_fork (GeglGraphTraversal *path)
+{
+  GeglGraphTraversal *fork = g_new0 (GeglGraphTraversal, 1);
+  GList              *list_iter;
+
+  fork->dfs_path = g_list_copy (path->dfs_path);
+  fork->bfs_path = g_list_copy (path->bfs_path);
+  fork->contexts = g_hash_table_new_full (NULL,
+                                          NULL,
+                                          NULL,
+                                          (GDestroyNotify)gegl_operation_context_destroy);
+  fork->rects_dirty  = FALSE;
+  fork->shared_empty = g_object_ref (gegl_graph_get_shared_empty (path));
+
+  for (list_iter = fork->dfs_path; list_iter; list_iter = list_iter->next)
+    {
+      GeglNode *node = GEGL_NODE (list_iter->data);
+
+      g_hash_table_insert (fork->contexts,
+                           node,
+                           gegl_operation_context_new (node->operation));
+    }
+
+  return fork;
+}
+
+static void
+gegl_graph_process_part (gpointer data)
+{
+  ParallelPart       *part = data;
+  ParallelJob        *job  = part->job;
+  GeglGraphTraversal *fork = gegl_graph_fork (job->path);
+  GeglBuffer         *result;
+  gpointer            was_worker;
+
+  /* a thread waiting for its own parts can run another part inside one, the
+   * outer part is still a parallel worker once the inner one is done
+   */
+  was_worker = g_private_get (&parallel_worker);
+  g_private_set (&parallel_worker, GINT_TO_POINTER (TRUE));
+
+  gegl_graph_prepare_request (fork, &part->roi, job->level);
+  result = gegl_graph_process (fork, job->level);
+
+  if (result)
+    {
+      gegl_buffer_copy (result, &part->roi, GEGL_ABYSS_NONE,
+                        job->output, &part->roi);
+      g_object_unref (result);
+    }
+
+  gegl_graph_free (fork);
+
+  g_private_set (&parallel_worker, was_worker);
+
+  g_slice_free (ParallelPart, part);
+}
+
+/* Pick the size of the parts a request is split into; parts are a whole
+ * number of tiles, and there should be enough of them to keep all threads
+ * busy.
+ */
+static void
+gegl_graph_get_part_size (const GeglRectangle *roi,
+                          gint                *part_width,
+                          gint                *part_height)
+{
+  gint tile_width  = gegl_config ()->tile_width;
+  gint tile_height = gegl_config ()->tile_height;
+  gint threads     = gegl_config_threads ();
+  gint tiles       = MAX (1, gegl_config ()->chunk_size / (tile_width * tile_height));
+  gint factor      = MAX (1, (gint) sqrt (tiles));
+
+  while (factor > 1)
+    {
+      gint parts_x = (roi->width  + tile_width  * factor - 1) / (tile_width  * factor);
+      gint parts_y = (roi->height + tile_height * factor - 1) / (tile_height * factor);
+
+      if (parts_x * parts_y >= threads * 2)
+        break;
+      factor--;
+    }
+
+  *part_width  = tile_width  * factor;
+  *part_height = tile_height * factor;
+}
+
+/**
+ * gegl_graph_can_process_parallel:
+ * @path: The traversal path
+ * @roi: The request rect
+ * @level: The mipmap level of the request
+ *
+ * Check whether the prepared graph can be evaluated with
+ * gegl_graph_process_parallel(), this requires the "parallel-graph"
+ * option to be enabled, and every operation in the graph to be safe
+ * for threaded processing.
+ *
+ * Return value: TRUE if @roi should be processed in parallel
+ */
+gboolean
+gegl_graph_can_process_parallel (GeglGraphTraversal  *path,
+                                 const GeglRectangle *roi,
+                                 gint                 level)
+{
+  GList    *list_iter;
+  GeglNode *last;
+
+  if (!gegl_config ()->parallel_graph ||
+      gegl_config_threads () < 2 ||
+      level != 0 ||
+      gegl_graph_in_parallel_worker () ||
+      gegl_cl_is_accelerated ())
+    return FALSE;
+
+  if ((gint64) roi->width * roi->height < 2 * gegl_config ()->tile_width *
+                                              gegl_config ()->tile_height)
+    return FALSE;
+
+  last = GEGL_NODE (g_list_last (path->dfs_path)->data);
+  if (!gegl_node_has_pad (last, "output"))
+    return FALSE;
+
+  for (list_iter = path->dfs_path; list_iter; list_iter = list_iter->next)
+    {
+      GeglNode *node = GEGL_NODE (list_iter->data);
+
+      if (!GEGL_OPERATION_GET_CLASS (node->operation)->threaded)
+        return FALSE;
+    }
+
+  return TRUE;
+}
+
+/**
+ * gegl_graph_process_parallel:
+ * @path: The traversal path, prepared with gegl_graph_prepare
+ * @roi: The request rect
+ * @level: The mipmap level of the request
+ *
+ * Process @roi by splitting it into tile aligned parts, each of which is
+ * rendered through the whole graph by a worker thread. Area operations
+ * get the surroundings they need for each part from the regular need
+ * rect negotiation.
+ *
+ * Return value: (transfer full): The result of the graph.
+ */
+GeglBuffer *
+gegl_graph_process_parallel (GeglGraphTraversal  *path,
+                             const GeglRectangle *roi,
+                             gint                 level)
+{
+  GeglNode     *last = GEGL_NODE (g_list_last (path->dfs_path)->data);
+  GeglRectangle  request;
+  GeglTaskGroup *group;
+  ParallelJob    job;
+  gint          part_width;
+  gint          part_height;
+  gint          x0, y0;
+  gint          x, y;
+
+  gegl_rectangle_intersect (&request, &last->have_rect, roi);
+
+  /* the forks all share the empty buffer of @path, create it up front */
+  gegl_graph_get_shared_empty (path);
+
+  if (request.width <= 0 || request.height <= 0)
+    return g_object_ref (path->shared_empty);
+
+  job.path   = path;
+  job.level  = level;
+  job.output = gegl_buffer_new (&request,
+                                gegl_operation_get_format (last->operation,
+                                                           "output"));
+
+  gegl_graph_get_part_size (&request, &part_width, &part_height);
+
+  /* make the part grid line up with the tile grid of the output */
+  x0 = request.x - ((request.x % part_width)  + part_width)  % part_width;
+  y0 = request.y - ((request.y % part_height) + part_height) % part_height;
+
+  group = gegl_task_group_new ();
+
+  for (y = y0; y < request.y + request.height; y += part_height)
+    for (x = x0; x < request.x + request.width; x += part_width)
+      {
+        ParallelPart *part = g_slice_new (ParallelPart);
+
+        part->job = &job;
+        gegl_rectangle_intersect (&part->roi, &request,
+                                  GEGL_RECTANGLE (x, y, part_width, part_height));
+
+        gegl_task_group_add (group, gegl_graph_process_part, part);
+      }
+
+  gegl_task_group_join (group);
+
+  GEGL_NOTE (GEGL_DEBUG_PROCESS,
+             "Processed %d, %d %d×%d of %s in parallel parts of %d×%d",
+             request.x, request.y, request.width, request.height,
+             gegl_node_get_debug_name (last), part_width, part_height);
+
+  return job.output;
+}
@@ -26,6 +26,7 @@ void                gegl_graph_rebuild          (GeglGraphTraversal  *path,
 void                gegl_graph_free             (GeglGraphTraversal  *path);
 
 void                gegl_graph_prepare          (GeglGraphTraversal  *path);
+gboolean            gegl_graph_revalidate       (GeglGraphTraversal  *path);
 void                gegl_graph_prepare_request  (GeglGraphTraversal  *path,
                                                  const GeglRectangle *roi,
                                                  gint                 level);
@@ -34,4 +35,14 @@ GeglBuffer         *gegl_graph_process          (GeglGraphTraversal  *path,
 
 GeglRectangle       gegl_graph_get_bounding_box (GeglGraphTraversal  *path);
 
+gboolean            gegl_graph_can_process_parallel (GeglGraphTraversal  *path,
+                                                     const GeglRectangle *roi,
+                                                     gint                 level);
+GeglBuffer         *gegl_graph_process_parallel     (GeglGraphTraversal  *path,
+                                                     const GeglRectangle *roi,
+                                                     gint                 level);
+gboolean            gegl_graph_in_parallel_worker   (void);
+
+gint                gegl_graph_get_n_fused_ops      (void);
+
 #endif /* __GEGL_GRAPH_TRAVERSAL_H__ */
@@ -43,6 +43,22 @@ void           gegl_processor_set_rectangle (GeglProcessor       *processor,
                                              const GeglRectangle *rectangle);
 gboolean       gegl_processor_work          (GeglProcessor       *processor,
                                              gdouble             *progress);
+
+/* Statistics of the chunks planned by a processor, the overlap is what the
+ * area filters upstream compute around the chunks in addition to them,
+ * overlap_area / area is the fraction of work done twice.
+ */
+typedef struct
+{
+  gint    n_chunks;
+  gint    chunk_width;   /* of the last plan */
+  gint    chunk_height;
+  gint64  area;
+  gint64  overlap_area;
+} GeglProcessorPlanStats;
+
+void           gegl_processor_get_plan_stats (GeglProcessor          *processor,
+                                              GeglProcessorPlanStats *stats);
 G_END_DECLS
 
 #endif /* __GEGL_PROCESSOR_PRIVATE_H__ */
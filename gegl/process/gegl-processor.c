@@ -18,6 +18,12 @@
 
 #include "config.h"
 
+#include <stdlib.h>
+#include <string.h>
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+
 #include <glib-object.h>
 
 #include "gegl.h"
@@ -31,11 +37,13 @@
 #include "operation/gegl-operation-sink.h"
 
 #include "gegl-config.h"
+#include "gegl-trace.h"
 #include "gegl-processor.h"
 #include "gegl-processor-private.h"
 
 #include "graph/gegl-visitor.h"
 #include "graph/gegl-visitable.h"
+#include "process/gegl-eval-manager.h"
 #include "process/gegl-list-visitor.h"
 
 #include "opencl/gegl-cl.h"
@@ -65,7 +73,8 @@ static void      gegl_processor_set_node     (GeglProcessor         *processor,
                                               GeglNode              *node);
 static void      gegl_processor_constructed  (GObject               *object);
 static gdouble   gegl_processor_progress     (GeglProcessor         *processor);
-static gint      gegl_processor_get_band_size(gint                   size) G_GNUC_CONST;
+static void      gegl_processor_stream_finish (GeglProcessor        *processor,
+                                               gboolean              completed);
 
 
 struct _GeglProcessor
@@ -83,11 +92,39 @@ struct _GeglProcessor
   gint             chunk_size;
 
   gdouble          progress;
+
+  GeglProcessorPlanStats  plan_stats;
+
+  /* asynchronous work, see gegl_processor_work_async() */
+  GThread                *async_thread;
+  GMutex                  async_mutex;  /* protects the chunks, priority and
+                                           the valid_region while working */
+  GQueue                  async_chunks;
+  GeglRectangle           priority;
+  gint                    cancelled;
+  gint                    finished;     /* the thread only runs the done
+                                           callbacks anymore */
+  GeglProcessorChunkFunc  chunk_func;
+  GeglProcessorDoneFunc   done_func;
+  gpointer                user_data;
+  GDestroyNotify          destroy_notify;
+  gboolean               *async_released; /* set when the processor is
+                                             finalized by one of the
+                                             callbacks, on the thread */
+
+  /* streaming to a sink, see gegl_processor_stream_band() */
+  gboolean                streaming;
+  gboolean                stream_open;
+  gboolean                stream_failed;
+  GeglEvalManager        *stream_manager;
 };
 
 
 G_DEFINE_TYPE (GeglProcessor, gegl_processor, G_TYPE_OBJECT)
 
+/* the processor the calling thread does asynchronous work for */
+static GPrivate async_processor;
+
 
 static void
 gegl_processor_class_init (GeglProcessorClass *klass)
@@ -139,6 +176,10 @@ gegl_processor_init (GeglProcessor *processor)
   processor->queued_region    = NULL;
   processor->dirty_rectangles = NULL;
   processor->chunk_size       = 128 * 128;
+  processor->async_thread     = NULL;
+
+  g_mutex_init (&processor->async_mutex);
+  g_queue_init (&processor->async_chunks);
 }
 
 static void
@@ -156,6 +197,29 @@ gegl_processor_finalize (GObject *self_object)
 {
   GeglProcessor *processor = GEGL_PROCESSOR (self_object);
 
+  if (processor->async_thread &&
+      g_private_get (&async_processor) == processor)
+    {
+      /* the last reference was dropped from a callback, the thread can't
+       * join itself; it stops without touching the processor anymore once
+       * the callback returns */
+      *processor->async_released = TRUE;
+      g_thread_unref (processor->async_thread);
+      processor->async_thread = NULL;
+    }
+  else if (processor->async_thread)
+    {
+      gegl_processor_cancel (processor);
+      gegl_processor_wait (processor);
+    }
+
+  gegl_processor_stream_finish (processor, FALSE);
+
+  if (processor->stream_manager)
+    {
+      g_object_unref (processor->stream_manager);
+    }
+
   if (processor->context)
     {
       gegl_operation_context_destroy (processor->context);
@@ -181,6 +245,8 @@ gegl_processor_finalize (GObject *self_object)
       gegl_region_destroy (processor->valid_region);
     }
 
+  g_mutex_clear (&processor->async_mutex);
+
   G_OBJECT_CLASS (gegl_processor_parent_class)->finalize (self_object);
 }
 
@@ -269,7 +335,13 @@ gegl_processor_set_node (GeglProcessor *processor,
           return;
         }
 
-      if (!gegl_operation_sink_needs_full (processor->node->operation))
+      /* streaming sinks take the image band by band as it is rendered,
+       * without keeping it in the cache */
+      processor->streaming =
+        gegl_operation_sink_can_stream (processor->node->operation);
+
+      if (processor->streaming ||
+          !gegl_operation_sink_needs_full (processor->node->operation))
         {
           processor->valid_region = gegl_region_new ();
         }
@@ -346,12 +418,17 @@ gegl_processor_set_rectangle (GeglProcessor       *processor,
       processor->dirty_rectangles = NULL;
     }
 
+  /* a stream started for another rectangle is not going to be completed */
+  gegl_processor_stream_finish (processor, FALSE);
+  processor->stream_failed = FALSE;
+
   /* if the node's operation is a sink and it needs the full content then
    * a context will be set up together with a cache and
    * needed and result rectangles */
   if (processor->node &&
       GEGL_IS_OPERATION_SINK (processor->node->operation) &&
-      gegl_operation_sink_needs_full (processor->node->operation))
+      gegl_operation_sink_needs_full (processor->node->operation) &&
+      !processor->streaming)
     {
       GeglCache *cache;
 
@@ -376,160 +453,527 @@ gegl_processor_set_rectangle (GeglProcessor       *processor,
       processor->valid_region = gegl_region_new ();
     }
 
+  /* the stats describe the plan of the current rectangle */
+  memset (&processor->plan_stats, 0, sizeof (processor->plan_stats));
+
   g_object_notify (G_OBJECT (processor), "rectangle");
 }
 
-/* Will generate band_sizes that are adapted to the size of the tiles */
+/* Returns the size of the largest CPU cache, that the working set of a chunk
+ * should fit in */
+static gsize
+gegl_processor_get_cpu_cache_size (void)
+{
+  static gsize cache_size = 0;
+
+  if (!cache_size)
+    {
+      glong size = 0;
+
+#ifdef _SC_LEVEL3_CACHE_SIZE
+      size = sysconf (_SC_LEVEL3_CACHE_SIZE);
+#endif
+#ifdef _SC_LEVEL2_CACHE_SIZE
+      if (size <= 0)
+        size = sysconf (_SC_LEVEL2_CACHE_SIZE);
+#endif
+      if (size <= 0)
+        size = 2 * 1024 * 1024;
+
+      cache_size = size;
+    }
+
+  return cache_size;
+}
+
+static void
+rectangle_free (gpointer rectangle)
+{
+  g_slice_free (GeglRectangle, rectangle);
+}
+
+/* Grows @bounds to cover what the operations upstream of @node need to
+ * compute @rect, following the input and aux pads. @visited maps the nodes
+ * already followed to the rectangle they were followed for, so that nodes
+ * shared by several consumers are only followed again for a larger one.
+ */
+static void
+gegl_processor_get_growth (GeglNode            *node,
+                           const GeglRectangle *rect,
+                           GeglRectangle       *bounds,
+                           GHashTable          *visited,
+                           gint                 depth)
+{
+  static const gchar *pads[] = {"input", "aux", "aux2"};
+  GeglRectangle      *followed;
+  gint                i;
+
+  if (!node->operation || depth > 32)
+    return;
+
+  followed = g_hash_table_lookup (visited, node);
+
+  if (followed)
+    {
+      if (gegl_rectangle_contains (followed, rect))
+        return;
+
+      gegl_rectangle_bounding_box (followed, followed, rect);
+    }
+  else
+    {
+      followed = g_slice_dup (GeglRectangle, rect);
+      g_hash_table_insert (visited, node, followed);
+    }
+
+  rect = followed;
+
+  for (i = 0; i < G_N_ELEMENTS (pads); i++)
+    {
+      GeglNode      *producer;
+      GeglRectangle  need;
+
+      if (!gegl_node_has_pad (node, pads[i]))
+        continue;
+
+      producer = gegl_node_get_producer (node, pads[i], NULL);
+      if (!producer)
+        continue;
+
+      need = gegl_operation_get_required_for_output (node->operation,
+                                                     pads[i], rect);
+      gegl_rectangle_bounding_box (bounds, bounds, &need);
+
+      gegl_processor_get_growth (producer, &need, bounds, visited, depth + 1);
+    }
+}
+
+/* Index of @x, @y along a Hilbert curve covering @n × @n cells, @n being a
+ * power of two */
+static guint
+hilbert_index (guint n,
+               guint x,
+               guint y)
+{
+  guint d = 0;
+  guint s;
+
+  for (s = n / 2; s > 0; s /= 2)
+    {
+      guint rx = (x & s) > 0;
+      guint ry = (y & s) > 0;
+
+      d += s * s * ((3 * rx) ^ ry);
+
+      if (ry == 0)
+        {
+          guint t;
+
+          if (rx == 1)
+            {
+              x = n - 1 - x;
+              y = n - 1 - y;
+            }
+
+          t = x;
+          x = y;
+          y = t;
+        }
+    }
+
+  return d;
+}
+
+typedef struct
+{
+  GeglRectangle rect;
+  guint         index;
+} PlannedChunk;
+
 static gint
-gegl_processor_get_band_size (gint size)
+planned_chunk_compare (gconstpointer a,
+                       gconstpointer b)
 {
-  gint band_size;
+  const PlannedChunk *ca = a;
+  const PlannedChunk *cb = b;
 
-  band_size = size / 2;
+  return (ca->index > cb->index) - (ca->index < cb->index);
+}
 
-  /* try to make the rects generated match better with potential 2^n sized
-   * tiles, XXX: should be improved to make the next slice fit as well. */
-  if (band_size <= 128)
+/* Cut @rectangle into bands of whole rows for a streaming sink and append
+ * them to @chunks from the top to the bottom. Bands are made of whole rows
+ * of tiles, and hold at least the chunk size of the processor.
+ */
+static void
+gegl_processor_plan_bands (GeglProcessor       *processor,
+                           const GeglRectangle *rectangle,
+                           GQueue              *chunks)
+{
+  const gint tile_height = gegl_config ()->tile_height;
+  gint       band_height;
+  gint       n_bands = 0;
+  gint       y;
+
+  band_height = tile_height *
+                MAX (1, processor->chunk_size /
+                        ((gint64) rectangle->width * tile_height));
+
+  y = rectangle->y - ((rectangle->y % tile_height) + tile_height) % tile_height;
+
+  for (; y < rectangle->y + rectangle->height; y += band_height)
     {
-      band_size = MIN(band_size, 64); /* prefer a band_size of 128,
-                                          hoping to hit tiles */
+      GeglRectangle band;
+
+      gegl_rectangle_intersect (&band, rectangle,
+                                GEGL_RECTANGLE (rectangle->x, y,
+                                                rectangle->width, band_height));
+      if (band.height <= 0)
+        continue;
+
+      processor->plan_stats.n_chunks++;
+      processor->plan_stats.area += (gint64) band.width * band.height;
+
+      g_queue_push_tail (chunks, g_slice_dup (GeglRectangle, &band));
+      n_bands++;
     }
-  else if (band_size <= 256)
+
+  processor->plan_stats.chunk_width  = rectangle->width;
+  processor->plan_stats.chunk_height = band_height;
+
+  GEGL_NOTE (GEGL_DEBUG_PROCESS,
+             "planned %d, %d %d×%d of %s as %d bands of %d rows",
+             rectangle->x, rectangle->y, rectangle->width, rectangle->height,
+             gegl_node_get_debug_name (processor->node),
+             n_bands, band_height);
+}
+
+/* Cut @rectangle into chunks aligned to the tile grid and append them to
+ * @chunks, in the order of a Hilbert curve over the chunk grid so that
+ * consecutive chunks are neighbours and share the pixels the area filters
+ * upstream read around them.
+ *
+ * A chunk is made of whole tiles and kept close to square. It is grown tile
+ * by tile up to the chunk size of the processor, and beyond that for as
+ * long as the pixels computed around it by area filters are more than a
+ * quarter of its own and its working set still fits in the CPU cache.
+ */
+static void
+gegl_processor_plan_chunks (GeglProcessor       *processor,
+                            const GeglRectangle *rectangle,
+                            GQueue              *chunks)
+{
+  const gint     scale       = 1 << processor->level;
+  const gint     tile_width  = gegl_config ()->tile_width;
+  const gint     tile_height = gegl_config ()->tile_height;
+  const gint64   max_area    = (gint64) processor->chunk_size * scale * scale;
+  gint64         cache_area;
+  GeglRectangle  probe       = {0, 0, tile_width, tile_height};
+  GeglRectangle  growth      = probe;
+  gint           margin_x, margin_y;
+  gint           tiles_x, tiles_y;
+  gint           chunk_width, chunk_height;
+  gint           x0, y0, columns, rows;
+  guint          n;
+  GHashTable    *visited;
+  PlannedChunk  *planned;
+  gint           n_planned = 0;
+  gint           i, x, y;
+
+  if (rectangle->width <= 0 || rectangle->height <= 0)
+    return;
+
+  if (processor->streaming)
     {
-      band_size = MIN(band_size, 128); /* prefer a band_size of 128,
-                                          hoping to hit tiles */
+      gegl_processor_plan_bands (processor, rectangle, chunks);
+      return;
     }
-  else if (band_size <= 512)
+
+  /* the rectangles needed by area filters are only known once prepared */
+  gegl_node_get_bounding_box (processor->input);
+  visited = g_hash_table_new_full (NULL, NULL, NULL, rectangle_free);
+  gegl_processor_get_growth (processor->input, &probe, &growth, visited, 0);
+  g_hash_table_destroy (visited);
+
+  margin_x = (growth.width  - probe.width)  / scale;
+  margin_y = (growth.height - probe.height) / scale;
+
+  /* an input and an output pixel of 16 bytes for every pixel of a chunk */
+  cache_area = gegl_processor_get_cpu_cache_size () / 32;
+
+  tiles_x = tiles_y = 1;
+  while ((gint64) tiles_x * tile_width  < rectangle->width ||
+         (gint64) tiles_y * tile_height < rectangle->height)
+    {
+      gint   next_x = tiles_x;
+      gint   next_y = tiles_y;
+      gint64 area   = (gint64) tiles_x * tile_width * tiles_y * tile_height;
+      gint64 grown  = (gint64) (tiles_x * tile_width  + margin_x) *
+                               (tiles_y * tile_height + margin_y);
+
+      /* grow along the shorter side to stay close to square, but not
+       * beyond the rectangle, so that thin bands get chunks of full size
+       */
+      if ((gint64) tiles_x * tile_width >= rectangle->width)
+        next_y++;
+      else if ((gint64) tiles_y * tile_height >= rectangle->height)
+        next_x++;
+      else if (tiles_x * tile_width <= tiles_y * tile_height)
+        next_x++;
+      else
+        next_y++;
+
+      if ((gint64) next_x * tile_width * next_y * tile_height > max_area &&
+          (grown - area <= area / 4 ||
+           (gint64) (next_x * tile_width  + margin_x) *
+                    (next_y * tile_height + margin_y) > cache_area))
+        break;
+
+      tiles_x = next_x;
+      tiles_y = next_y;
+    }
+
+  chunk_width  = tiles_x * tile_width;
+  chunk_height = tiles_y * tile_height;
+
+  x0 = rectangle->x - ((rectangle->x % chunk_width)  + chunk_width)  % chunk_width;
+  y0 = rectangle->y - ((rectangle->y % chunk_height) + chunk_height) % chunk_height;
+
+  columns = (rectangle->x + rectangle->width  - x0 + chunk_width  - 1) / chunk_width;
+  rows    = (rectangle->y + rectangle->height - y0 + chunk_height - 1) / chunk_height;
+
+  for (n = 1; n < columns || n < rows; n *= 2);
+
+  planned = g_new (PlannedChunk, columns * rows);
+
+  for (y = 0; y < rows; y++)
+    for (x = 0; x < columns; x++)
+      {
+        PlannedChunk *chunk = &planned[n_planned];
+
+        gegl_rectangle_intersect (&chunk->rect, rectangle,
+                                  GEGL_RECTANGLE (x0 + x * chunk_width,
+                                                  y0 + y * chunk_height,
+                                                  chunk_width, chunk_height));
+        if (chunk->rect.width <= 0 || chunk->rect.height <= 0)
+          continue;
+
+        chunk->index = hilbert_index (n, x, y);
+        n_planned++;
+      }
+
+  qsort (planned, n_planned, sizeof (PlannedChunk), planned_chunk_compare);
+
+  for (i = 0; i < n_planned; i++)
     {
-      band_size = MIN(band_size, 256); /* prefer a band_size of 128,
-                                          hoping to hit tiles */
+      GeglRectangle *chunk = &planned[i].rect;
+      gint64         area  = (gint64) chunk->width * chunk->height;
+
+      processor->plan_stats.n_chunks++;
+      processor->plan_stats.area         += area;
+      processor->plan_stats.overlap_area +=
+        (gint64) (chunk->width + margin_x) * (chunk->height + margin_y) - area;
+
+      g_queue_push_tail (chunks, g_slice_dup (GeglRectangle, chunk));
     }
 
-  if (band_size < 1)
-    band_size = 1;
+  processor->plan_stats.chunk_width  = chunk_width;
+  processor->plan_stats.chunk_height = chunk_height;
 
-  return band_size;
+  GEGL_NOTE (GEGL_DEBUG_PROCESS,
+             "planned %d, %d %d×%d of %s as %d chunks of %d×%d, "
+             "area filters add %d×%d pixels around each",
+             rectangle->x, rectangle->y, rectangle->width, rectangle->height,
+             gegl_node_get_debug_name (processor->node),
+             n_planned, chunk_width, chunk_height, margin_x, margin_y);
+
+  g_free (planned);
 }
 
-/* If the processor's dirty rectangle is too big then it will be cut, added
- * to the processor's list of dirty rectangles and TRUE will be returned.
- * If the rectangle is small enough it will be processed, using a buffer or
- * not as appropriate, and will return TRUE if there is more work */
-static gboolean
-render_rectangle (GeglProcessor *processor)
+/* Queue the chunks of @rectangle in front of the dirty rectangles */
+static void
+gegl_processor_queue_rectangle (GeglProcessor       *processor,
+                                const GeglRectangle *rectangle)
+{
+  GQueue         chunks = G_QUEUE_INIT;
+  GeglRectangle *chunk;
+
+  gegl_processor_plan_chunks (processor, rectangle, &chunks);
+
+  while ((chunk = g_queue_pop_tail (&chunks)))
+    processor->dirty_rectangles = g_slist_prepend (processor->dirty_rectangles,
+                                                   chunk);
+}
+
+/* Ends the stream to the sink, if one was started */
+static void
+gegl_processor_stream_finish (GeglProcessor *processor,
+                              gboolean       completed)
+{
+  GeglOperationSinkClass *klass;
+
+  if (!processor->stream_open)
+    return;
+
+  processor->stream_open = FALSE;
+
+  klass = GEGL_OPERATION_SINK_GET_CLASS (processor->node->operation);
+  if (klass->stream_finish)
+    klass->stream_finish (processor->node->operation, completed);
+}
+
+/* Renders the band @dr of the processor's rectangle and hands it over to
+ * the streaming sink, the rendered pixels are released right after. Bands
+ * come in from the top to the bottom, the stream is finished with the last
+ * one, or with the first band the sink fails on.
+ */
+static void
+gegl_processor_stream_band (GeglProcessor       *processor,
+                            const GeglRectangle *dr)
+{
+  GeglOperation          *operation = processor->node->operation;
+  GeglOperationSinkClass *klass     = GEGL_OPERATION_SINK_GET_CLASS (operation);
+  GeglBuffer             *band;
+
+  if (processor->stream_failed)
+    return;
+
+  if (!processor->stream_manager)
+    processor->stream_manager = gegl_eval_manager_new (processor->input,
+                                                       "output");
+
+  band = gegl_eval_manager_apply (processor->stream_manager, dr,
+                                  processor->level);
+
+  processor->stream_open = TRUE;
+
+  if (!band ||
+      !klass->stream_band (operation, band, &processor->rectangle, dr,
+                           processor->level))
+    {
+      processor->stream_failed = TRUE;
+      gegl_processor_stream_finish (processor, FALSE);
+    }
+  else if (dr->y + dr->height >= processor->rectangle.y +
+                                 processor->rectangle.height)
+    {
+      gegl_processor_stream_finish (processor, TRUE);
+    }
+
+  if (band)
+    g_object_unref (band);
+}
+
+/* Renders @dr into the cache of the processor's input, or through the sink
+ * node when the processor is not buffered */
+static void
+render_chunk (GeglProcessor       *processor,
+              const GeglRectangle *dr)
 {
   gboolean    buffered;
-  const gint  max_area = processor->chunk_size * (1<<processor->level) * (1<<processor->level);
   GeglCache  *cache    = NULL;
-  const Babl *format   = NULL;
-  gint        pxsize;
+
+  GEGL_TRACE_START();
 
   /* Retreive the cache if the processor's node is not buffered if it's
    * operation is a sink and it doesn't use the full area  */
   buffered = !(GEGL_IS_OPERATION_SINK(processor->node->operation) &&
                !gegl_operation_sink_needs_full (processor->node->operation));
-  if (buffered)
+
+  if (processor->streaming)
     {
-      cache = gegl_node_get_cache (processor->input);
-      format = gegl_buffer_get_format ((GeglBuffer *)cache);
-      pxsize = babl_format_get_bytes_per_pixel (format);
-    }
+      gegl_processor_stream_band (processor, dr);
 
-  if (processor->dirty_rectangles)
+      g_mutex_lock (&processor->async_mutex);
+      gegl_region_union_with_rect (processor->valid_region, dr);
+      g_mutex_unlock (&processor->async_mutex);
+    }
+  else if (buffered)
     {
-      GeglRectangle *dr = processor->dirty_rectangles->data;
+      gboolean found_full = FALSE;
 
-      /* If a dirty rectangle is bigger than the max area, then cut it
-       * to smaller pieces */
-      if (dr->height * dr->width > max_area && 1)
-        {
-          gint band_size;
+      cache = gegl_node_get_cache (processor->input);
 
-          {
-            GeglRectangle *fragment;
+      g_mutex_lock (&cache->mutex);
+      for (gint level = processor->level; level >= 0; level--)
+      {
+        if (gegl_region_rect_in (cache->valid_region[level], dr) == GEGL_OVERLAP_RECTANGLE_IN)
+        {
+          found_full = TRUE;
+          break;
+        }
+        /* XXX: dr should be adjusted to be the bounding box of not-found
+         * in cache if there is partial hits
+         */
+      }
+      g_mutex_unlock (&cache->mutex);
 
-            fragment = g_slice_dup (GeglRectangle, dr);
+      if (!found_full && processor->level == 0)
+        {
+          /* The operation of the input node renders straight into the
+           * tiles of its cache when the cache is its output, other results
+           * are copied over, sharing whole tiles where they line up */
+          gegl_node_blit_buffer (processor->input, GEGL_BUFFER (cache),
+                                 dr, 0, GEGL_ABYSS_NONE);
+
+          /* tells the cache that the rectangle (dr) has been computed */
+          gegl_cache_computed (cache, dr, processor->level);
+        }
+      else if (!found_full)
+        {
+          /* create a buffer and initialise it */
+          const Babl *format = gegl_buffer_get_format ((GeglBuffer *)cache);
+          guchar     *buf;
 
-            /* When splitting a rectangle, we'll do it on the biggest side */
-            if (dr->width > dr->height)
-              {
-                band_size = gegl_processor_get_band_size ( dr->width );
+          buf = g_malloc (dr->width * dr->height *
+                          babl_format_get_bytes_per_pixel (format));
+          g_assert (buf);
 
-                fragment->width = band_size;
-                dr->width      -= band_size;
-                dr->x          += band_size;
-              }
-            else
-              {
-                band_size = gegl_processor_get_band_size (dr->height);
+          /* do the image calculations using the buffer, scaled down from
+           * level 0 unless mipmap rendering is enabled */
+          gegl_node_blit (processor->input, 1.0/(1<<processor->level),
+                          dr, format, buf,
+                          GEGL_AUTO_ROWSTRIDE, GEGL_BLIT_DEFAULT);
 
-                fragment->height = band_size;
-                dr->height      -= band_size;
-                dr->y           += band_size;
-              }
-            processor->dirty_rectangles = g_slist_prepend (processor->dirty_rectangles, fragment);
-          }
-          return TRUE;
-        }
-      /* remove the rectangle that will be processed from the list of dirty ones */
-      processor->dirty_rectangles = g_slist_remove (processor->dirty_rectangles, dr);
+          /* copy the buffer data into the cache */
+          gegl_buffer_set (GEGL_BUFFER (cache), dr, processor->level, format, buf, GEGL_AUTO_ROWSTRIDE);
 
-      if (!dr->width || !dr->height)
-        {
-          g_slice_free (GeglRectangle, dr);
+          /* tells the cache that the rectangle (dr) has been computed */
+          gegl_cache_computed (cache, dr, processor->level);
 
-          return TRUE;
+          /* release the buffer */
+          g_free (buf);
         }
+    }
+  else
+    {
+       gegl_node_blit (processor->node, 1.0/(1<<processor->level),
+                       dr, NULL, NULL,
+                       GEGL_AUTO_ROWSTRIDE, GEGL_BLIT_DEFAULT);
 
-      if (buffered)
-        {
-          gboolean found_full = FALSE;
-          for (gint level = processor->level; level >= 0; level--)
-          {
-            if (gegl_region_rect_in (cache->valid_region[level], dr) == GEGL_OVERLAP_RECTANGLE_IN)
-            {
-              found_full = TRUE;
-              break;
-            }
-            /* XXX: dr should be adjusted to be the bounding box of not-found
-             * in cache if there is partial hits
-             */
-          }
-
-          if (!found_full)
-            {
-              /* create a buffer and initialise it */
-              guchar *buf;
-
-              buf = g_malloc (dr->width * dr->height * pxsize);
-              g_assert (buf);
+       g_mutex_lock (&processor->async_mutex);
+       gegl_region_union_with_rect (processor->valid_region, dr);
+       g_mutex_unlock (&processor->async_mutex);
+    }
 
-              /* FIXME: Check if the node caches naturaly, if so the buffer_set call isn't needed */
+  GEGL_TRACE_END ("processor", "chunk");
+}
 
-              /* do the image calculations using the buffer */
-              gegl_node_blit (processor->input, 1.0/(1<<processor->level),
-                              dr, format, buf,
-                              GEGL_AUTO_ROWSTRIDE, GEGL_BLIT_DEFAULT);
+/* Processes the first of the processor's dirty rectangles, using a buffer or
+ * not as appropriate, and returns TRUE if there is more work */
+static gboolean
+render_rectangle (GeglProcessor *processor)
+{
+  if (processor->dirty_rectangles)
+    {
+      GeglRectangle *dr = processor->dirty_rectangles->data;
 
-              /* copy the buffer data into the cache */
-              gegl_buffer_set (GEGL_BUFFER (cache), dr, processor->level, format, buf, GEGL_AUTO_ROWSTRIDE);
+      /* remove the rectangle that will be processed from the list of dirty ones */
+      processor->dirty_rectangles = g_slist_remove (processor->dirty_rectangles, dr);
 
-              /* tells the cache that the rectangle (dr) has been computed */
-              gegl_cache_computed (cache, dr, processor->level);
+      if (dr->width && dr->height)
+        render_chunk (processor, dr);
 
-              /* release the buffer */
-              g_free (buf);
-            }
-          g_slice_free (GeglRectangle, dr);
-        }
-      else
-        {
-           gegl_node_blit (processor->node, 1.0/(1<<processor->level),
-                           dr, NULL, NULL,
-                           GEGL_AUTO_ROWSTRIDE, GEGL_BLIT_DEFAULT);
-           gegl_region_union_with_rect (processor->valid_region, dr);
-           g_slice_free (GeglRectangle, dr);
-        }
+      g_slice_free (GeglRectangle, dr);
     }
 
   return processor->dirty_rectangles != NULL;
@@ -562,6 +1006,36 @@ region_area (GeglRegion *region)
   return sum;
 }
 
+/* Locks and returns the valid region of @processor, which the async thread
+ * changes under the async_mutex for the processor's own region and under
+ * the mutex of the cache for the region of the cache. Unlock it with
+ * gegl_processor_unlock_valid_region().
+ */
+static GeglRegion *
+gegl_processor_lock_valid_region (GeglProcessor *processor)
+{
+  GeglCache *cache;
+
+  if (processor->valid_region)
+    {
+      g_mutex_lock (&processor->async_mutex);
+      return processor->valid_region;
+    }
+
+  cache = gegl_node_get_cache (processor->input);
+  g_mutex_lock (&cache->mutex);
+  return cache->valid_region[processor->level];
+}
+
+static void
+gegl_processor_unlock_valid_region (GeglProcessor *processor)
+{
+  if (processor->valid_region)
+    g_mutex_unlock (&processor->async_mutex);
+  else
+    g_mutex_unlock (&gegl_node_get_cache (processor->input)->mutex);
+}
+
 /* returns the area not covered by the rectangle */
 static gint
 area_left (GeglRegion    *area,
@@ -597,17 +1071,10 @@ gegl_processor_progress (GeglProcessor *processor)
 
   g_return_val_if_fail (processor->input != NULL, 1);
 
-  if (processor->valid_region)
-    {
-      valid_region = processor->valid_region;
-    }
-  else
-    {
-      valid_region = gegl_node_get_cache (processor->input)->valid_region[processor->level];
-    }
-
+  valid_region = gegl_processor_lock_valid_region (processor);
   wanted = rect_area (&(processor->rectangle));
   valid  = wanted - area_left (valid_region, &(processor->rectangle));
+  gegl_processor_unlock_valid_region (processor);
   if (wanted == 0)
     {
       if (gegl_processor_is_rendered (processor))
@@ -636,15 +1103,8 @@ gegl_processor_render (GeglProcessor *processor,
 {
   GeglRegion *valid_region;
 
-  if (processor->valid_region)
-    {
-      valid_region = processor->valid_region;
-    }
-  else
-    {
-      g_return_val_if_fail (processor->input != NULL, FALSE);
-      valid_region = gegl_node_get_cache (processor->input)->valid_region[processor->level];
-    }
+  g_return_val_if_fail (processor->valid_region || processor->input != NULL,
+                        FALSE);
 
   {
     gboolean more_work = render_rectangle (processor);
@@ -655,6 +1115,8 @@ gegl_processor_render (GeglProcessor *processor,
           {
             gint valid;
             gint wanted;
+
+            valid_region = gegl_processor_lock_valid_region (processor);
             if (rectangle)
               {
                 wanted = rect_area (rectangle);
@@ -665,6 +1127,7 @@ gegl_processor_render (GeglProcessor *processor,
                 valid  = region_area (valid_region);
                 wanted = region_area (processor->queued_region);
               }
+            gegl_processor_unlock_valid_region (processor);
             if (wanted == 0)
               {
                 *progress = 1.0;
@@ -687,7 +1150,9 @@ gegl_processor_render (GeglProcessor *processor,
       gint           n_rectangles;
       gint           i;
 
+      valid_region = gegl_processor_lock_valid_region (processor);
       gegl_region_subtract (region, valid_region);
+      gegl_processor_unlock_valid_region (processor);
       gegl_region_get_rectangles (region, &rectangles, &n_rectangles);
       gegl_region_destroy (region);
 
@@ -698,8 +1163,7 @@ gegl_processor_render (GeglProcessor *processor,
           gegl_region_subtract (processor->queued_region, tr);
           gegl_region_destroy (tr);
 
-          processor->dirty_rectangles = g_slist_prepend (processor->dirty_rectangles,
-                                                         g_slice_dup (GeglRectangle, &roi));
+          gegl_processor_queue_rectangle (processor, &roi);
         }
 
       g_free (rectangles);
@@ -707,8 +1171,12 @@ gegl_processor_render (GeglProcessor *processor,
       if (n_rectangles != 0)
         {
           if (progress)
-            *progress = 1.0 - ((double) area_left (valid_region, rectangle) /
-                               rect_area (rectangle));
+            {
+              valid_region = gegl_processor_lock_valid_region (processor);
+              *progress = 1.0 - ((double) area_left (valid_region, rectangle) /
+                                 rect_area (rectangle));
+              gegl_processor_unlock_valid_region (processor);
+            }
           return TRUE;
         }
 
@@ -733,8 +1201,7 @@ gegl_processor_render (GeglProcessor *processor,
           gegl_region_subtract (processor->queued_region, tr);
           gegl_region_destroy (tr);
 
-          processor->dirty_rectangles = g_slist_prepend (processor->dirty_rectangles,
-                                                         g_slice_dup (GeglRectangle, &roi));
+          gegl_processor_queue_rectangle (processor, &roi);
         }
 
       g_free (rectangles);
@@ -831,3 +1298,219 @@ void gegl_processor_set_scale (GeglProcessor *processor,
 {
   processor->level = gegl_level_from_scale (scale);
 }
+
+/* Takes the next chunk to render, the first one intersecting the priority
+ * rectangle if any does, returns NULL when done or cancelled */
+static GeglRectangle *
+gegl_processor_next_chunk (GeglProcessor *processor)
+{
+  GeglRectangle *chunk = NULL;
+  GList         *iter;
+
+  g_mutex_lock (&processor->async_mutex);
+
+  if (g_atomic_int_get (&processor->cancelled))
+    {
+      while ((chunk = g_queue_pop_head (&processor->async_chunks)))
+        g_slice_free (GeglRectangle, chunk);
+    }
+  else
+    {
+      /* the bands of a streaming sink have to stay in order */
+      if (processor->priority.width > 0 && processor->priority.height > 0 &&
+          !processor->streaming)
+        {
+          for (iter = processor->async_chunks.head; iter; iter = iter->next)
+            if (gegl_rectangle_intersect (NULL, iter->data, &processor->priority))
+              {
+                chunk = iter->data;
+                g_queue_delete_link (&processor->async_chunks, iter);
+                break;
+              }
+        }
+
+      if (!chunk)
+        chunk = g_queue_pop_head (&processor->async_chunks);
+    }
+
+  g_mutex_unlock (&processor->async_mutex);
+
+  return chunk;
+}
+
+static gpointer
+gegl_processor_async_thread (gpointer data)
+{
+  GeglProcessor  *processor      = data;
+  GDestroyNotify  destroy_notify = processor->destroy_notify;
+  gpointer        user_data      = processor->user_data;
+  GeglRectangle  *chunk;
+  gboolean        completed;
+  gboolean        released       = FALSE;
+
+  processor->async_released = &released;
+  g_private_set (&async_processor, processor);
+
+  while ((chunk = gegl_processor_next_chunk (processor)))
+    {
+      render_chunk (processor, chunk);
+
+      if (processor->chunk_func)
+        processor->chunk_func (processor, chunk, processor->user_data);
+
+      g_slice_free (GeglRectangle, chunk);
+
+      if (released)
+        {
+          g_private_set (&async_processor, NULL);
+          if (destroy_notify)
+            destroy_notify (user_data);
+
+          return GINT_TO_POINTER (FALSE);
+        }
+    }
+
+  completed = !g_atomic_int_get (&processor->cancelled);
+
+  if (!completed)
+    gegl_processor_stream_finish (processor, FALSE);
+
+  if (completed && processor->context)
+    {
+      /* the actual writing to the destination */
+      gegl_operation_process (processor->node->operation,
+                              processor->context,
+                              "output"  /* ignored output_pad */,
+                              &processor->context->result_rect, processor->context->level);
+      gegl_operation_context_destroy (processor->context);
+      processor->context = NULL;
+    }
+
+  GEGL_NOTE (GEGL_DEBUG_PROCESS, "asynchronous work on %s %s",
+             gegl_node_get_debug_name (processor->node),
+             completed ? "completed" : "cancelled");
+
+  /* new work can be started from here on, it joins this thread first */
+  g_atomic_int_set (&processor->finished, TRUE);
+
+  if (processor->done_func)
+    processor->done_func (processor, completed, processor->user_data);
+
+  g_private_set (&async_processor, NULL);
+
+  if (destroy_notify)
+    destroy_notify (user_data);
+
+  return GINT_TO_POINTER (completed);
+}
+
+void
+gegl_processor_work_async (GeglProcessor          *processor,
+                           GeglProcessorChunkFunc  chunk_func,
+                           GeglProcessorDoneFunc   done_func,
+                           gpointer                user_data,
+                           GDestroyNotify          destroy_notify)
+{
+  GeglRegion    *region;
+  GeglRectangle *rectangles;
+  GSList        *iter;
+  gint           n_rectangles;
+  gint           i;
+
+  g_return_if_fail (GEGL_IS_PROCESSOR (processor));
+  g_return_if_fail (processor->input != NULL);
+
+  if (processor->async_thread)
+    {
+      /* work that finished by itself, without gegl_processor_wait() */
+      g_return_if_fail (g_atomic_int_get (&processor->finished));
+
+      g_thread_join (processor->async_thread);
+      processor->async_thread = NULL;
+    }
+
+  /* queue everything of the rectangle that isn't valid yet, this replaces
+   * the work queued by gegl_processor_work() */
+  region = gegl_region_rectangle (&processor->rectangle);
+
+  gegl_region_subtract (region, gegl_processor_lock_valid_region (processor));
+  gegl_processor_unlock_valid_region (processor);
+
+  gegl_region_get_rectangles (region, &rectangles, &n_rectangles);
+  gegl_region_destroy (region);
+
+  for (iter = processor->dirty_rectangles; iter; iter = g_slist_next (iter))
+    g_slice_free (GeglRectangle, iter->data);
+  g_slist_free (processor->dirty_rectangles);
+  processor->dirty_rectangles = NULL;
+  gegl_region_destroy (processor->queued_region);
+  processor->queued_region = gegl_region_new ();
+
+  memset (&processor->plan_stats, 0, sizeof (processor->plan_stats));
+
+  for (i = 0; i < n_rectangles; i++)
+    gegl_processor_plan_chunks (processor, &rectangles[i],
+                                &processor->async_chunks);
+
+  g_free (rectangles);
+
+  processor->cancelled      = FALSE;
+  processor->finished       = FALSE;
+  processor->chunk_func     = chunk_func;
+  processor->done_func      = done_func;
+  processor->user_data      = user_data;
+  processor->destroy_notify = destroy_notify;
+
+  processor->async_thread = g_thread_new ("gegl-processor",
+                                          gegl_processor_async_thread,
+                                          processor);
+}
+
+void
+gegl_processor_set_priority_rectangle (GeglProcessor       *processor,
+                                       const GeglRectangle *rectangle)
+{
+  g_return_if_fail (GEGL_IS_PROCESSOR (processor));
+
+  g_mutex_lock (&processor->async_mutex);
+  if (rectangle)
+    processor->priority = *rectangle;
+  else
+    gegl_rectangle_set (&processor->priority, 0, 0, 0, 0);
+  g_mutex_unlock (&processor->async_mutex);
+}
+
+void
+gegl_processor_cancel (GeglProcessor *processor)
+{
+  g_return_if_fail (GEGL_IS_PROCESSOR (processor));
+
+  g_atomic_int_set (&processor->cancelled, TRUE);
+}
+
+gboolean
+gegl_processor_wait (GeglProcessor *processor)
+{
+  gboolean completed;
+
+  g_return_val_if_fail (GEGL_IS_PROCESSOR (processor), FALSE);
+  g_return_val_if_fail (g_private_get (&async_processor) != processor, FALSE);
+
+  if (!processor->async_thread)
+    return !g_atomic_int_get (&processor->cancelled);
+
+  completed = GPOINTER_TO_INT (g_thread_join (processor->async_thread));
+  processor->async_thread = NULL;
+
+  return completed;
+}
+
+void
+gegl_processor_get_plan_stats (GeglProcessor          *processor,
+                               GeglProcessorPlanStats *stats)
+{
+  g_return_if_fail (GEGL_IS_PROCESSOR (processor));
+  g_return_if_fail (stats != NULL);
+
+  *stats = processor->plan_stats;
+}
@@ -79,6 +79,101 @@ void           gegl_processor_set_rectangle (GeglProcessor       *processor,
 gboolean       gegl_processor_work          (GeglProcessor *processor,
                                              gdouble       *progress);
 
+/**
+ * GeglProcessorChunkFunc:
+ * @processor: the #GeglProcessor doing the work
+ * @rectangle: the #GeglRectangle that was just rendered
+ * @user_data: data passed to gegl_processor_work_async()
+ *
+ * Called from the thread rendering for the processor each time a chunk
+ * has been rendered. Use for instance g_idle_add() to move the update to
+ * the main loop of a user interface.
+ */
+typedef void (*GeglProcessorChunkFunc) (GeglProcessor       *processor,
+                                        const GeglRectangle *rectangle,
+                                        gpointer             user_data);
+
+/**
+ * GeglProcessorDoneFunc:
+ * @processor: the #GeglProcessor doing the work
+ * @completed: TRUE if everything was rendered, FALSE if cancelled
+ * @user_data: data passed to gegl_processor_work_async()
+ *
+ * Called from the thread rendering for the processor once it is done.
+ */
+typedef void (*GeglProcessorDoneFunc)  (GeglProcessor       *processor,
+                                        gboolean             completed,
+                                        gpointer             user_data);
+
+/**
+ * gegl_processor_work_async:
+ * @processor: a #GeglProcessor
+ * @chunk_func: (scope notified) (closure user_data) (destroy destroy_notify) (allow-none):
+ *   called for every rendered chunk
+ * @done_func: (scope notified) (closure user_data) (allow-none): called when
+ *   done
+ * @user_data: data to pass to @chunk_func and @done_func
+ * @destroy_notify: (allow-none): called with @user_data after @done_func
+ *
+ * Render all of the processor's rectangle that isn't valid yet in a
+ * separate thread, without blocking the caller. The chunks are rendered in
+ * order, with chunks intersecting the rectangle set with
+ * gegl_processor_set_priority_rectangle() first, and the operations use
+ * the worker threads of GEGL for each chunk.
+ *
+ * Neither the graph nor the processor should be changed while the work is
+ * in progress, except through gegl_processor_set_priority_rectangle() and
+ * gegl_processor_cancel(). Unreferencing the processor cancels the work
+ * and waits for it to stop. When the last reference is dropped from within
+ * @chunk_func, the work stops as soon as it returns, without calling
+ * @done_func.
+ *
+ * Once @done_func has been called, new work can be started without calling
+ * gegl_processor_wait() first, but not from within @done_func itself.
+ *
+ * ---
+ * gegl_processor_set_priority_rectangle (processor, &viewport);
+ * gegl_processor_work_async (processor, chunk_done, NULL, view, NULL);
+ */
+void           gegl_processor_work_async    (GeglProcessor          *processor,
+                                             GeglProcessorChunkFunc  chunk_func,
+                                             GeglProcessorDoneFunc   done_func,
+                                             gpointer                user_data,
+                                             GDestroyNotify          destroy_notify);
+
+/**
+ * gegl_processor_set_priority_rectangle:
+ * @processor: a #GeglProcessor
+ * @rectangle: (allow-none): the #GeglRectangle to render first, or NULL
+ *
+ * Make asynchronous work render the chunks intersecting @rectangle before
+ * any others, for instance the visible part of a view. Can be changed
+ * while the processor is working.
+ */
+void           gegl_processor_set_priority_rectangle
+                                            (GeglProcessor       *processor,
+                                             const GeglRectangle *rectangle);
+
+/**
+ * gegl_processor_cancel:
+ * @processor: a #GeglProcessor
+ *
+ * Stop asynchronous work after the chunk that is being rendered, without
+ * waiting for it.
+ */
+void           gegl_processor_cancel        (GeglProcessor *processor);
+
+/**
+ * gegl_processor_wait:
+ * @processor: a #GeglProcessor
+ *
+ * Wait for asynchronous work started with gegl_processor_work_async() to
+ * finish. Not to be called from the callbacks of the work.
+ *
+ * Returns TRUE if everything was rendered, FALSE if the work was cancelled.
+ */
+gboolean       gegl_processor_wait          (GeglProcessor *processor);
+
 G_END_DECLS
 
 #endif /* __GEGL_PROCESSOR_H__ */
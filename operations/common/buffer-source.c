@@ -192,6 +192,7 @@ gegl_op_class_init (GeglOpClass *klass)
       NULL);
 
   operation_class->no_cache = TRUE;
+  operation_class->threaded = TRUE;
 }
 
 #endif
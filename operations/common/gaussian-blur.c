@@ -62,9 +62,13 @@ property_enum  (filter, _("Filter"),
 #include "gegl-op.h"
 #include <math.h>
 #include <stdio.h>
+#include <string.h>
 
 #define RADIUS_SCALE   4
 
+/* width in pixels of the blocks of columns the vertical pass works on */
+#define VER_BLOCK_WIDTH 32
+
 static void
 iir_young_find_constants (gfloat   radius,
                           gdouble *B,
@@ -105,6 +109,11 @@ iir_young_find_constants (gfloat   sigma,
   *B = 1 - ( (b[1]+b[2]+b[3])/b[0] );
 }
 
+/* Filters w_len pixels of @components interleaved floats each. Called with
+ * @components set to four times the width of a block of rows, it filters
+ * all the columns of the block at once, with the inner loops running over
+ * contiguous memory.
+ */
 static inline void
 iir_young_blur_pixels_1D (gfloat  *buf,
                           gint     components,
@@ -115,56 +124,73 @@ iir_young_blur_pixels_1D (gfloat  *buf,
 {
   gint wcount, i, c;
   gdouble tmp;
-  gdouble recip = 1.0 / b[0];
-  gint offset = 0;
+  const gdouble b1    = b[1];
+  const gdouble b2    = b[2];
+  const gdouble b3    = b[3];
+  const gdouble recip = 1.0 / b[0];
 
   /* forward filter */
-  wcount = 0;
-
-  while (wcount < w_len)
+  for (wcount = 0; wcount < w_len; wcount++)
     {
-      for (c = 0; c < components; ++c)
+      const gfloat *src = buf + wcount * components;
+      gfloat       *dst = w + wcount * components;
+
+      if (wcount >= 3)
         {
-          tmp = 0;
+          const gfloat *w1 = dst - components;
+          const gfloat *w2 = dst - 2 * components;
+          const gfloat *w3 = dst - 3 * components;
 
-          for (i = 1; i < 4; i++)
+          for (c = 0; c < components; ++c)
+            dst[c] = (b1 * w1[c] + b2 * w2[c] + b3 * w3[c]) * recip +
+                     B * src[c];
+        }
+      else
+        {
+          for (c = 0; c < components; ++c)
             {
-              if (wcount - i >= 0)
-                tmp += b[i] * w[(wcount - i) * components + c];
-            }
+              tmp = 0;
 
-          tmp *= recip;
-          tmp += B * buf[offset + c];
-          w[wcount * components + c] = tmp;
-        }
+              for (i = 1; i <= wcount; i++)
+                tmp += b[i] * dst[c - i * components];
 
-      wcount++;
-      offset += components;
+              tmp *= recip;
+              tmp += B * src[c];
+              dst[c] = tmp;
+            }
+        }
     }
 
   /* backward filter */
-  wcount = w_len - 1;
-  offset -= components;
-
-  while (wcount >= 0)
+  for (wcount = w_len - 1; wcount >= 0; wcount--)
     {
-      for (c = 0; c < components; ++c)
+      const gfloat *src = w + wcount * components;
+      gfloat       *dst = buf + wcount * components;
+
+      if (wcount + 3 < w_len)
         {
-          tmp = 0;
+          const gfloat *b1_row = dst + components;
+          const gfloat *b2_row = dst + 2 * components;
+          const gfloat *b3_row = dst + 3 * components;
 
-          for (i = 1; i < 4; i++)
+          for (c = 0; c < components; ++c)
+            dst[c] = (b1 * b1_row[c] + b2 * b2_row[c] + b3 * b3_row[c]) *
+                     recip + B * src[c];
+        }
+      else
+        {
+          for (c = 0; c < components; ++c)
             {
-              if (wcount + i < w_len)
-                tmp += b[i] * buf[offset + components * i + c];
-            }
+              tmp = 0;
 
-          tmp *= recip;
-          tmp += B * w[wcount * components + c];
-          buf[offset + c] = tmp;
-        }
+              for (i = 1; wcount + i < w_len; i++)
+                tmp += b[i] * dst[c + i * components];
 
-      offset -= components;
-      wcount--;
+              tmp *= recip;
+              tmp += B * src[c];
+              dst[c] = tmp;
+            }
+        }
     }
 }
 
@@ -198,7 +224,9 @@ iir_young_hor_blur (GeglBuffer          *src,
   gegl_free (scratch);
 }
 
-/* expects src and dst buf to have the same width and no x-offset */
+/* expects src and dst buf to have the same width and no x-offset, the
+ * columns are filtered in blocks of VER_BLOCK_WIDTH
+ */
 static void
 iir_young_ver_blur (GeglBuffer          *src,
                     const GeglRectangle *src_rect,
@@ -210,18 +238,26 @@ iir_young_ver_blur (GeglBuffer          *src,
   gint u;
   const Babl *format = babl_format ("RaGaBaA float");
   const int pixel_count = src_rect->height;
-  gfloat *buf     = gegl_malloc (pixel_count * sizeof(gfloat) * 4);
-  gfloat *scratch = gegl_malloc (pixel_count * sizeof(gfloat) * 4);
-  GeglRectangle read_rect = {dst_rect->x, src_rect->y, 1, src_rect->height};
+  const int block_width = MIN (dst_rect->width, VER_BLOCK_WIDTH);
+  gfloat *buf     = gegl_malloc (pixel_count * block_width * sizeof(gfloat) * 4);
+  gfloat *scratch = gegl_malloc (pixel_count * block_width * sizeof(gfloat) * 4);
+  GeglRectangle read_rect  = {dst_rect->x, src_rect->y, 1, src_rect->height};
+  GeglRectangle write_rect = {dst_rect->x, dst_rect->y, 1, dst_rect->height};
+  const gint    write_row  = dst_rect->y - src_rect->y;
 
-  for (u = 0; u < dst_rect->width; u++)
+  for (u = 0; u < dst_rect->width; u += VER_BLOCK_WIDTH)
     {
-      read_rect.x = dst_rect->x + u;
+      read_rect.x      = dst_rect->x + u;
+      read_rect.width  = MIN (VER_BLOCK_WIDTH, dst_rect->width - u);
+      write_rect.x     = read_rect.x;
+      write_rect.width = read_rect.width;
       gegl_buffer_get (src, &read_rect, 1.0, format, buf, GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
 
-      iir_young_blur_pixels_1D (buf, 4, B, b, scratch, pixel_count);
+      iir_young_blur_pixels_1D (buf, read_rect.width * 4, B, b, scratch, pixel_count);
 
-      gegl_buffer_set (dst, &read_rect, 0, format, buf, GEGL_AUTO_ROWSTRIDE);
+      gegl_buffer_set (dst, &write_rect, 0, format,
+                       buf + write_row * read_rect.width * 4,
+                       GEGL_AUTO_ROWSTRIDE);
     }
 
   gegl_free (buf);
@@ -290,18 +326,18 @@ fir_get_mean_pixel_1D (gfloat  *src,
                        gint     matrix_length)
 {
   gint    i, c;
-  gint    offset;
   gdouble acc[components];
 
   for (c = 0; c < components; ++c)
     acc[c] = 0;
 
-  offset = 0;
-
   for (i = 0; i < matrix_length; i++)
     {
+      const gfloat  *row    = src + i * components;
+      const gdouble  weight = cmatrix[i];
+
       for (c = 0; c < components; ++c)
-        acc[c] += src[offset++] * cmatrix[i];
+        acc[c] += row[c] * weight;
     }
 
   for (c = 0; c < components; ++c)
@@ -349,6 +385,9 @@ fir_hor_blur (GeglBuffer          *src,
   gegl_free (dst_buf);
 }
 
+/* filters the columns in blocks of VER_BLOCK_WIDTH, each output row of a
+ * block is the weighted sum of matrix_length rows of the source block
+ */
 static void
 fir_ver_blur (GeglBuffer          *src,
               GeglBuffer          *dst,
@@ -358,29 +397,33 @@ fir_ver_blur (GeglBuffer          *src,
 {
   gint        u,v;
   const gint  radius = matrix_length / 2;
+  const gint  block_width = MIN (dst_rect->width, VER_BLOCK_WIDTH);
   const Babl *format = babl_format ("RaGaBaA float");
 
   GeglRectangle write_rect = {dst_rect->x, dst_rect->y, 1, dst_rect->height};
-  gfloat *dst_buf    = gegl_malloc (write_rect.height * sizeof(gfloat) * 4);
+  gfloat *dst_buf    = gegl_malloc (write_rect.height * block_width * sizeof(gfloat) * 4);
 
   GeglRectangle read_rect  = {dst_rect->x, dst_rect->y - radius, 1, dst_rect->height + 2 * radius};
-  gfloat *src_buf    = gegl_malloc (read_rect.height * sizeof(gfloat) * 4);
+  gfloat *src_buf    = gegl_malloc (read_rect.height * block_width * sizeof(gfloat) * 4);
 
-  for (u = 0; u < dst_rect->width; u++)
+  for (u = 0; u < dst_rect->width; u += VER_BLOCK_WIDTH)
     {
-      gint offset     = 0;
-      read_rect.x     = dst_rect->x + u;
-      write_rect.x    = dst_rect->x + u;
+      gint row_size;
+
+      read_rect.x      = dst_rect->x + u;
+      read_rect.width  = MIN (VER_BLOCK_WIDTH, dst_rect->width - u);
+      write_rect.x     = read_rect.x;
+      write_rect.width = read_rect.width;
+      row_size         = read_rect.width * 4;
       gegl_buffer_get (src, &read_rect, 1.0, format, src_buf, GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
 
       for (v = 0; v < dst_rect->height; v++)
         {
-          fir_get_mean_pixel_1D (src_buf + offset,
-                                 dst_buf + offset,
-                                 4,
+          fir_get_mean_pixel_1D (src_buf + v * row_size,
+                                 dst_buf + v * row_size,
+                                 row_size,
                                  cmatrix,
                                  matrix_length);
-          offset += 4;
         }
 
       gegl_buffer_set (dst, &write_rect, 0, format, dst_buf, GEGL_AUTO_ROWSTRIDE);
@@ -390,6 +433,110 @@ fir_ver_blur (GeglBuffer          *src,
   gegl_free (dst_buf);
 }
 
+typedef struct
+{
+  GeglBuffer          *src;
+  const GeglRectangle *src_rect;
+  GeglBuffer          *dst;
+  GeglRectangle        dst_rect;
+  gdouble              B;
+  gdouble             *b;        /* IIR constants, NULL for the FIR filter */
+  gdouble             *cmatrix;
+  gint                 cmatrix_len;
+} BlurPass;
+
+static void
+hor_blur_thread (gpointer data)
+{
+  BlurPass *pass = data;
+
+  if (pass->b)
+    iir_young_hor_blur (pass->src, pass->src_rect, pass->dst, &pass->dst_rect,
+                        pass->B, pass->b);
+  else
+    fir_hor_blur (pass->src, pass->dst, &pass->dst_rect,
+                  pass->cmatrix, pass->cmatrix_len);
+}
+
+static void
+ver_blur_thread (gpointer data)
+{
+  BlurPass *pass = data;
+
+  if (pass->b)
+    iir_young_ver_blur (pass->src, pass->src_rect, pass->dst, &pass->dst_rect,
+                        pass->B, pass->b);
+  else
+    fir_ver_blur (pass->src, pass->dst, &pass->dst_rect,
+                  pass->cmatrix, pass->cmatrix_len);
+}
+
+/* Runs a pass over pass->dst_rect, split in bands of rows for the
+ * horizontal pass and in bands of whole column blocks for the vertical
+ * pass, when the operation is to use threading.
+ */
+static void
+run_pass (GeglOperation *operation,
+          BlurPass      *pass,
+          gboolean       vertical)
+{
+  GeglTaskFunc   func    = vertical ? ver_blur_thread : hor_blur_thread;
+  gint           threads = 1;
+  gint           size;
+  gint           bit;
+  gint           i;
+  BlurPass       thread_data[GEGL_MAX_THREADS];
+  GeglTaskGroup *group;
+
+  if (gegl_operation_use_threading (operation, &pass->dst_rect))
+    threads = gegl_config_threads ();
+
+  if (vertical)
+    size = (pass->dst_rect.width + VER_BLOCK_WIDTH - 1) / VER_BLOCK_WIDTH;
+  else
+    size = pass->dst_rect.height;
+
+  threads = CLAMP (threads, 1, size);
+
+  if (threads == 1)
+    {
+      func (pass);
+      return;
+    }
+
+  bit = size / threads;
+
+  for (i = 0; i < threads; i++)
+    {
+      gint start = bit * i;
+      gint end   = i == threads - 1 ? size : start + bit;
+
+      thread_data[i] = *pass;
+
+      if (vertical)
+        {
+          gint x0 = pass->dst_rect.x + start * VER_BLOCK_WIDTH;
+          gint x1 = MIN (pass->dst_rect.x + end * VER_BLOCK_WIDTH,
+                         pass->dst_rect.x + pass->dst_rect.width);
+
+          thread_data[i].dst_rect.x     = x0;
+          thread_data[i].dst_rect.width = x1 - x0;
+        }
+      else
+        {
+          thread_data[i].dst_rect.y      = pass->dst_rect.y + start;
+          thread_data[i].dst_rect.height = end - start;
+        }
+    }
+
+  group = gegl_task_group_new ();
+  for (i = 1; i < threads; i++)
+    gegl_task_group_add (group, func, &thread_data[i]);
+  func (&thread_data[0]);
+
+  gegl_task_group_join (group);
+}
+
 static void
 prepare (GeglOperation *operation)
 {
@@ -619,9 +766,8 @@ process (GeglOperation       *operation,
   GeglProperties          *o       = GEGL_PROPERTIES (operation);
 
   GeglRectangle temp_extend;
-  gdouble       B, b[4];
-  gdouble      *cmatrix;
-  gint          cmatrix_len;
+  BlurPass      pass;
+  gdouble       b[4];
   gboolean      horizontal_irr;
   gboolean      vertical_irr;
 
@@ -655,34 +801,85 @@ process (GeglOperation       *operation,
   temp_extend.width  = result->width;
   temp = gegl_buffer_new (&temp_extend, babl_format ("RaGaBaA float"));
 
+  pass.src      = input;
+  pass.src_rect = &rect;
+  pass.dst      = temp;
+  pass.dst_rect = temp_extend;
+  pass.b        = NULL;
+  pass.cmatrix  = NULL;
+
   if (horizontal_irr)
     {
-      iir_young_find_constants (o->std_dev_x, &B, b);
-      iir_young_hor_blur (input, &rect, temp, &temp_extend, B, b);
+      iir_young_find_constants (o->std_dev_x, &pass.B, b);
+      pass.b = b;
     }
   else
     {
-      cmatrix_len = fir_gen_convolve_matrix (o->std_dev_x, &cmatrix);
-      fir_hor_blur (input, temp, &temp_extend, cmatrix, cmatrix_len);
-      g_free (cmatrix);
+      pass.cmatrix_len = fir_gen_convolve_matrix (o->std_dev_x, &pass.cmatrix);
     }
 
+  run_pass (operation, &pass, FALSE);
+  g_free (pass.cmatrix);
+
+  pass.src      = temp;
+  pass.src_rect = &rect;
+  pass.dst      = output;
+  pass.dst_rect = *result;
+  pass.b        = NULL;
+  pass.cmatrix  = NULL;
+
   if (vertical_irr)
     {
-      iir_young_find_constants (o->std_dev_y, &B, b);
-      iir_young_ver_blur (temp, &rect, output, result, B, b);
+      iir_young_find_constants (o->std_dev_y, &pass.B, b);
+      pass.b = b;
     }
   else
     {
-      cmatrix_len = fir_gen_convolve_matrix (o->std_dev_y, &cmatrix);
-      fir_ver_blur (temp, output, result, cmatrix, cmatrix_len);
-      g_free (cmatrix);
+      pass.cmatrix_len = fir_gen_convolve_matrix (o->std_dev_y, &pass.cmatrix);
     }
 
+  run_pass (operation, &pass, TRUE);
+  g_free (pass.cmatrix);
+
   g_object_unref (temp);
   return  TRUE;
 }
 
+/* The passes are split over the worker threads by process () itself, the
+ * vertical one in blocks of columns, rather than in bands of rows by the
+ * filter base class, which would make every band run the vertical filter
+ * over the whole margin above and below it.
+ */
+static gboolean
+operation_process (GeglOperation        *operation,
+                   GeglOperationContext *context,
+                   const gchar          *output_prop,
+                   const GeglRectangle  *result,
+                   gint                  level)
+{
+  GeglOperationFilterClass *klass;
+  GeglBuffer               *input;
+  GeglBuffer               *output;
+  gboolean                  success;
+
+  klass = GEGL_OPERATION_FILTER_GET_CLASS (operation);
+
+  if (strcmp (output_prop, "output"))
+    {
+      g_warning ("requested processing of %s pad on a filter", output_prop);
+      return FALSE;
+    }
+
+  input  = gegl_operation_context_get_source (context, "input");
+  output = gegl_operation_context_get_target (context, "output");
+
+  success = klass->process (operation, input, output, result, level);
+
+  if (input != NULL)
+    g_object_unref (input);
+
+  return success;
+}
 
 static void
 gegl_op_class_init (GeglOpClass *klass)
@@ -694,6 +891,7 @@ gegl_op_class_init (GeglOpClass *klass)
   filter_class    = GEGL_OPERATION_FILTER_CLASS (klass);
 
   operation_class->prepare        = prepare;
+  operation_class->process        = operation_process;
   operation_class->opencl_support = TRUE;
 
   filter_class->process           = process;
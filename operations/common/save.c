@@ -39,6 +39,7 @@ struct _GeglOp
   GeglNode          *input;
   GeglNode          *save;
   gchar             *cached_path;
+  GeglBuffer        *collected;   /* for savers that can't stream */
 };
 
 typedef struct
@@ -168,6 +169,68 @@ gegl_save_process (GeglOperation        *operation,
                                  level);
 }
 
+/* Bands are passed on to savers that can stream, and collected into a
+ * buffer for the others, which get all of it once the last band is in.
+ */
+static gboolean
+gegl_save_stream_band (GeglOperation       *operation,
+                       GeglBuffer          *input,
+                       const GeglRectangle *roi,
+                       const GeglRectangle *band,
+                       gint                 level)
+{
+  GeglOp        *self  = GEGL_OP (operation);
+  GeglOperation *saver = gegl_node_get_gegl_operation (self->save);
+
+  if (!GEGL_IS_OPERATION_SINK (saver))
+    return FALSE;
+
+  if (gegl_operation_sink_can_stream (saver))
+    return GEGL_OPERATION_SINK_GET_CLASS (saver)->stream_band (saver, input,
+                                                               roi, band,
+                                                               level);
+
+  if (band->y == roi->y)
+    {
+      g_clear_object (&self->collected);
+      self->collected = gegl_buffer_new (roi, gegl_buffer_get_format (input));
+    }
+
+  if (!self->collected)
+    return FALSE;
+
+  gegl_buffer_copy (input, band, GEGL_ABYSS_NONE, self->collected, band);
+
+  return TRUE;
+}
+
+static void
+gegl_save_stream_finish (GeglOperation *operation,
+                         gboolean       completed)
+{
+  GeglOp                 *self  = GEGL_OP (operation);
+  GeglOperation          *saver = gegl_node_get_gegl_operation (self->save);
+  GeglOperationSinkClass *saver_class;
+
+  if (!GEGL_IS_OPERATION_SINK (saver))
+    return;
+
+  saver_class = GEGL_OPERATION_SINK_GET_CLASS (saver);
+
+  if (saver_class->stream_finish)
+    {
+      saver_class->stream_finish (saver, completed);
+    }
+  else if (self->collected)
+    {
+      if (completed)
+        saver_class->process (saver, self->collected,
+                              gegl_buffer_get_extent (self->collected), 0);
+
+      g_clear_object (&self->collected);
+    }
+}
+
 static void
 gegl_save_dispose (GObject *object)
 {
@@ -176,6 +239,8 @@ gegl_save_dispose (GObject *object)
   g_free (self->cached_path);
   self->cached_path = NULL;
 
+  g_clear_object (&self->collected);
+
   G_OBJECT_CLASS (gegl_op_parent_class)->dispose (object);
 }
 
@@ -193,7 +258,9 @@ gegl_op_class_init (GeglOpClass *klass)
   operation_class->attach  = gegl_save_attach;
   operation_class->process = gegl_save_process;
 
-  sink_class->needs_full = TRUE;
+  sink_class->needs_full    = TRUE;
+  sink_class->stream_band   = gegl_save_stream_band;
+  sink_class->stream_finish = gegl_save_stream_finish;
 
   gegl_operation_class_set_keys (operation_class,
     "name"       , "gegl:save",
@@ -82,32 +82,18 @@ typedef struct ThreadData
   GeglOperation            *operation;
   GeglBuffer               *input;
   GeglBuffer               *output;
-  gint                     *pending;
   gint                      level;
   gboolean                  success;
   GeglRectangle             roi;
 } ThreadData;
 
 static void
-thread_process (gpointer thread_data, gpointer unused)
+thread_process (gpointer thread_data)
 {
   ThreadData *data = thread_data;
   if (!data->klass->process (data->operation,
                        data->input, data->output, &data->roi, data->level))
     data->success = FALSE;
-  g_atomic_int_add (data->pending, -1);
-}
-
-static GThreadPool *
-thread_pool (void)
-{
-  static GThreadPool *pool = NULL;
-  if (!pool)
-    {
-      pool =  g_thread_pool_new (thread_process, NULL, gegl_config_threads (),
-                                 FALSE, NULL);
-    }
-  return pool;
 }
 
 static void
@@ -470,9 +456,8 @@ operation_process (GeglOperation        *operation,
   if (gegl_operation_use_threading (operation, result))
   {
     gint threads = gegl_config_threads ();
-    GThreadPool *pool = thread_pool ();
+    GeglTaskGroup *group;
     ThreadData thread_data[GEGL_MAX_THREADS];
-    gint pending = threads;
 
     if (o->direction == GEGL_WIND_DIRECTION_LEFT ||
         o->direction == GEGL_WIND_DIRECTION_RIGHT)
@@ -505,16 +490,16 @@ operation_process (GeglOperation        *operation,
       thread_data[i].operation = operation;
       thread_data[i].input = input;
       thread_data[i].output = output;
-      thread_data[i].pending = &pending;
       thread_data[i].level = level;
       thread_data[i].success = TRUE;
     }
 
+    group = gegl_task_group_new ();
     for (gint i = 1; i < threads; i++)
-      g_thread_pool_push (pool, &thread_data[i], NULL);
-    thread_process (&thread_data[0], NULL);
+      gegl_task_group_add (group, thread_process, &thread_data[i]);
+    thread_process (&thread_data[0]);
 
-    while (g_atomic_int_get (&pending)) {};
+    gegl_task_group_join (group);
 
     success = thread_data[0].success;
   }
@@ -637,7 +622,6 @@ process (GeglOperation       *operation,
   return TRUE;
 }
 
-
 static void
 gegl_op_class_init (GeglOpClass *klass)
 {
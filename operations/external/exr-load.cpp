@@ -30,9 +30,11 @@ property_file_path (path, "File", "")
 
 extern "C" {
 #include "gegl-op.h"
+#include "gegl-tile-backend-decode.h"
 }
 
 #include <ImfInputFile.h>
+#include <ImfTiledInputFile.h>
 #include <ImfChannelList.h>
 #include <ImfRgbaFile.h>
 #include <ImfRgbaYca.h>
@@ -68,12 +70,29 @@ static gfloat chroma_sampling[] =
   };
 
 
+/* the buffer handed out for tiled files, see new_lazy_buffer() */
+typedef struct
+{
+  gchar      *path;
+  GeglBuffer *buffer;
+} Priv;
+
+typedef struct
+{
+  TiledInputFile *file;
+  gint            format_flags;
+  gint            bpp;
+  gint            tile_width;
+  gint            tile_height;
+} TileDecoder;
+
 static gboolean
 query_exr              (const gchar *path,
                         gint        *width,
                         gint        *height,
                         gint        *ff_ptr,
-                        gpointer    *format);
+                        gpointer    *format,
+                        gboolean    *tiled);
 
 static gboolean
 import_exr             (GeglBuffer  *gegl_buffer,
@@ -124,7 +143,8 @@ insert_channels        (FrameBuffer  &fb,
                         char         *base,
                         gint          width,
                         gint          format_flags,
-                        gint          bpp);
+                        gint          bpp,
+                        gint          rowstride);
 
 
 
@@ -407,7 +427,8 @@ insert_channels (FrameBuffer  &fb,
                  char         *base,
                  gint          width,
                  gint          format_flags,
-                 gint          bpp)
+                 gint          bpp,
+                 gint          rowstride)
 {
   gint alpha_offset;
   PixelType tp;
@@ -428,9 +449,9 @@ insert_channels (FrameBuffer  &fb,
 
   if (format_flags & COLOR_RGB)
     {
-      fb.insert ("R", Slice (tp, base,          bpp, 0, 1,1, 0.0));
-      fb.insert ("G", Slice (tp, base+bpc,      bpp, 0, 1,1, 0.0));
-      fb.insert ("B", Slice (tp, base+bpc*2,    bpp, 0, 1,1, 0.0));
+      fb.insert ("R", Slice (tp, base,          bpp, rowstride, 1,1, 0.0));
+      fb.insert ("G", Slice (tp, base+bpc,      bpp, rowstride, 1,1, 0.0));
+      fb.insert ("B", Slice (tp, base+bpc*2,    bpp, rowstride, 1,1, 0.0));
     }
   else if (format_flags & COLOR_C)
     {
@@ -440,12 +461,12 @@ insert_channels (FrameBuffer  &fb,
     }
   else if (format_flags & COLOR_Y)
     {
-      fb.insert ("Y",  Slice (tp, base, bpp, 0, 1,1, 0.5));
+      fb.insert ("Y",  Slice (tp, base, bpp, rowstride, 1,1, 0.5));
       alpha_offset = bpc;
     }
 
   if (format_flags & COLOR_ALPHA)
-    fb.insert ("A", Slice (tp, base+alpha_offset, bpp, 0, 1,1, 1.0));
+    fb.insert ("A", Slice (tp, base+alpha_offset, bpp, rowstride, 1,1, 1.0));
 }
 
 
@@ -483,7 +504,8 @@ import_exr (GeglBuffer  *gegl_buffer,
                        base,
                        gegl_buffer_get_width (gegl_buffer),
                        format_flags,
-                       pxsize);
+                       pxsize,
+                       0);
 
       file.setFrameBuffer (frameBuffer);
 
@@ -533,7 +555,8 @@ query_exr (const gchar *path,
            gint        *width,
            gint        *height,
            gint        *ff_ptr,
-           gpointer    *format)
+           gpointer    *format,
+           gboolean    *tiled)
 {
   gchar format_string[16];
   gint format_flags = 0;
@@ -549,6 +572,9 @@ query_exr (const gchar *path,
       *width  = dw.max.x - dw.min.x + 1;
       *height = dw.max.y - dw.min.y + 1;
 
+      if (tiled)
+        *tiled = file.header().hasTileDescription ();
+
       if (ch.findChannel ("R") || ch.findChannel ("G") || ch.findChannel ("B"))
         {
           strcpy (format_string, "RGB");
@@ -623,7 +649,7 @@ get_bounding_box (GeglOperation *operation)
   gint          w, h, ff;
   gpointer      format;
 
-  if (query_exr (o->path, &w, &h, &ff, &format))
+  if (query_exr (o->path, &w, &h, &ff, &format, NULL))
     {
       result.width = w;
       result.height = h;
@@ -644,7 +670,7 @@ process (GeglOperation       *operation,
   gpointer    format;
   gboolean    ok;
 
-  ok = query_exr (o->path, &w, &h, &ff, &format);
+  ok = query_exr (o->path, &w, &h, &ff, &format, NULL);
 
   if (ok)
     {
@@ -658,13 +684,192 @@ process (GeglOperation       *operation,
   return TRUE;
 }
 
+static gboolean
+decode_tile (gint     x,
+             gint     y,
+             guchar  *data,
+             gpointer user_data)
+{
+  TileDecoder *decoder   = (TileDecoder *) user_data;
+  gint         rowstride = decoder->tile_width * decoder->bpp;
+
+  try
+    {
+      FrameBuffer frameBuffer;
+      Box2i       dw = decoder->file->dataWindowForTile (x, y);
+
+      /* tiles at the right and bottom edges are cut by the data window */
+      if (dw.max.x - dw.min.x + 1 < decoder->tile_width ||
+          dw.max.y - dw.min.y + 1 < decoder->tile_height)
+        memset (data, 0, rowstride * decoder->tile_height);
+
+      /* as in import_exr, the pointer passed is that of pixel (0 0) */
+      insert_channels (frameBuffer,
+                       decoder->file->header (),
+                       (char *) data - dw.min.x * decoder->bpp
+                                     - dw.min.y * rowstride,
+                       decoder->tile_width,
+                       decoder->format_flags,
+                       decoder->bpp,
+                       rowstride);
+
+      decoder->file->setFrameBuffer (frameBuffer);
+      decoder->file->readTile (x, y);
+    }
+  catch (...)
+    {
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
+static void
+free_decoder (gpointer user_data)
+{
+  TileDecoder *decoder = (TileDecoder *) user_data;
+
+  delete decoder->file;
+  g_free (decoder);
+}
+
+/* Creates a buffer whose tiles are the tiles of level 0 of a tiled file,
+ * decoded the first time they are read. Returns NULL for files that are
+ * not tiled, and for luminance/chroma files, as the chroma is
+ * reconstructed from the neighbouring rows.
+ */
+static GeglBuffer *
+new_lazy_buffer (const gchar *path)
+{
+  gint         w, h, ff;
+  gpointer     format;
+  gboolean     tiled = FALSE;
+  TileDecoder *decoder;
+
+  if (!query_exr (path, &w, &h, &ff, &format, &tiled) ||
+      !tiled || (ff & COLOR_C))
+    return NULL;
+
+  decoder = g_new0 (TileDecoder, 1);
+  decoder->format_flags = ff;
+  decoder->bpp          = babl_format_get_bytes_per_pixel ((const Babl *) format);
+
+  try
+    {
+      decoder->file = new TiledInputFile (path);
+    }
+  catch (...)
+    {
+      g_free (decoder);
+      return NULL;
+    }
+
+  decoder->tile_width  = decoder->file->tileXSize ();
+  decoder->tile_height = decoder->file->tileYSize ();
+
+  {
+    GeglTileBackend *backend;
+    GeglBuffer      *buffer;
+
+    backend = gegl_tile_backend_decode_new (w, h,
+                                            decoder->tile_width,
+                                            decoder->tile_height,
+                                            (const Babl *) format,
+                                            decode_tile, decoder,
+                                            free_decoder);
+    buffer = gegl_buffer_new_for_backend (NULL, backend);
+    g_object_unref (backend);
+
+    return buffer;
+  }
+}
+
+/* Returns the private data of @operation, with the buffer of the tiles of
+ * the file at the current path */
+static Priv *
+get_priv (GeglOperation *operation)
+{
+  GeglProperties *o = GEGL_PROPERTIES (operation);
+  Priv           *p = (Priv *) o->user_data;
+
+  if (!p)
+    {
+      p = g_new0 (Priv, 1);
+      o->user_data = p;
+    }
+
+  if (g_strcmp0 (p->path, o->path))
+    {
+      g_free (p->path);
+      p->path = g_strdup (o->path);
+
+      if (p->buffer)
+        g_object_unref (p->buffer);
+      p->buffer = new_lazy_buffer (o->path);
+    }
+
+  return p;
+}
+
+/* Hands out the buffer of the tiles of the file when it is tiled, and
+ * loads all of it otherwise.
+ */
+static gboolean
+operation_process (GeglOperation        *operation,
+                   GeglOperationContext *context,
+                   const gchar          *output_pad,
+                   const GeglRectangle  *result,
+                   gint                  level)
+{
+  Priv               *p = get_priv (operation);
+  GeglOperationClass *operation_class;
+
+  if (p->buffer)
+    {
+      gegl_operation_context_take_object (context, "output",
+                                          G_OBJECT (g_object_ref (p->buffer)));
+      /* the tiles are shared, don't process into the buffer in place */
+      gegl_object_set_has_forked (G_OBJECT (p->buffer));
+      return TRUE;
+    }
+
+  operation_class = GEGL_OPERATION_CLASS (gegl_op_parent_class);
+
+  return operation_class->process (operation, context, output_pad,
+                                   result, level);
+}
+
 static GeglRectangle
 get_cached_region (GeglOperation       *operation,
                    const GeglRectangle *roi)
 {
+  Priv *p = get_priv (operation);
+
+  /* only the tiles under @roi are decoded */
+  if (p->buffer)
+    return *roi;
+
   return get_bounding_box (operation);
 }
 
+static void
+finalize (GObject *object)
+{
+  GeglProperties *o = GEGL_PROPERTIES (object);
+  Priv           *p = (Priv *) o->user_data;
+
+  if (p)
+    {
+      if (p->buffer)
+        g_object_unref (p->buffer);
+      g_free (p->path);
+      g_free (p);
+      o->user_data = NULL;
+    }
+
+  G_OBJECT_CLASS (gegl_op_parent_class)->finalize (object);
+}
+
 static void
 gegl_op_class_init (GeglOpClass *klass)
 {
@@ -674,7 +879,10 @@ gegl_op_class_init (GeglOpClass *klass)
   operation_class = GEGL_OPERATION_CLASS (klass);
   source_class    = GEGL_OPERATION_SOURCE_CLASS (klass);
 
+  G_OBJECT_CLASS (klass)->finalize = finalize;
+
   source_class->process = process;
+  operation_class->process = operation_process;
   operation_class->get_bounding_box = get_bounding_box;
 
   operation_class->get_cached_region = get_cached_region;
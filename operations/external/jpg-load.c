@@ -205,20 +205,29 @@ gegl_jpg_load_query_jpg (GInputStream *stream,
   return status;
 }
 
+/* number of rows decoded before they are written to the buffer */
+#define BAND_HEIGHT 64
+
+/* libjpeg can scale the image down by up to 8 while decoding it */
+#define MAX_SCALE_LEVEL 3
+
 static gint
 gegl_jpg_load_buffer_import_jpg (GeglBuffer  *gegl_buffer,
                                  GInputStream *stream,
                                  gint         dest_x,
-                                 gint         dest_y)
+                                 gint         dest_y,
+                                 gint         level)
 {
   gint row_stride;
   struct jpeg_decompress_struct  cinfo;
   struct jpeg_error_mgr          jerr;
   struct jpeg_source_mgr         src;
-  JSAMPARRAY                     buffer;
+  JSAMPROW                       rows[BAND_HEIGHT];
+  guchar                        *band;
   const Babl                    *format;
   GeglRectangle                  write_rect;
   gboolean                       is_inverted_cmyk = FALSE;
+  gint                           i;
   GioSource gio_source = { stream, NULL, 1024 };
 
   cinfo.err = jpeg_std_error (&jerr);
@@ -234,6 +243,14 @@ gegl_jpg_load_buffer_import_jpg (GeglBuffer  *gegl_buffer,
    */
   cinfo.dct_method = JDCT_FLOAT;
 
+  /* For a mipmap level, let libjpeg decode the image scaled down, which
+   * only does part of the inverse DCT of each block. Levels beyond what
+   * libjpeg can scale to are made from the smallest one by the buffer.
+   */
+  level = MIN (level, MAX_SCALE_LEVEL);
+  cinfo.scale_num   = 1;
+  cinfo.scale_denom = 1 << level;
+
   (void) jpeg_start_decompress (&cinfo);
 
   format = babl_from_jpeg_colorspace(cinfo.out_color_space);
@@ -247,17 +264,16 @@ gegl_jpg_load_buffer_import_jpg (GeglBuffer  *gegl_buffer,
 
   row_stride = cinfo.output_width * cinfo.output_components;
 
-  if ((row_stride) % 2)
-    (row_stride)++;
-
-  /* allocated with the jpeg library, and freed with the decompress context */
-  buffer = (*cinfo.mem->alloc_sarray)
-    ((j_common_ptr) &cinfo, JPOOL_IMAGE, row_stride, 1);
+  band = g_malloc (row_stride * BAND_HEIGHT);
+  for (i = 0; i < BAND_HEIGHT; i++)
+    rows[i] = band + i * row_stride;
 
+  /* the rectangle is in coordinates of level 0, the buffer divides it by
+   * the scale of the level
+   */
   write_rect.x = dest_x;
   write_rect.y = dest_y;
-  write_rect.width  = cinfo.output_width;
-  write_rect.height = 1;
+  write_rect.width  = cinfo.output_width << level;
 
   // Most CMYK JPEG files are produced by Adobe Photoshop. Each component is stored where 0 means 100% ink
   // However this might not be case for all. Gory details: https://bugzilla.mozilla.org/show_bug.cgi?id=674619
@@ -265,21 +281,29 @@ gegl_jpg_load_buffer_import_jpg (GeglBuffer  *gegl_buffer,
 
   while (cinfo.output_scanline < cinfo.output_height)
     {
-      jpeg_read_scanlines (&cinfo, buffer, 1);
+      gint n_rows = 0;
+
+      /* libjpeg returns at most the rows of one iMCU row at a time */
+      while (n_rows < BAND_HEIGHT &&
+             cinfo.output_scanline < cinfo.output_height)
+        n_rows += jpeg_read_scanlines (&cinfo, rows + n_rows,
+                                       BAND_HEIGHT - n_rows);
 
       if (is_inverted_cmyk) {
-        for (int i=0; i<row_stride; i++) {
-            buffer[0][i] = 255-buffer[0][i];
+        for (i = 0; i < row_stride * n_rows; i++) {
+            band[i] = 255-band[i];
         }
       }
 
-      gegl_buffer_set (gegl_buffer, &write_rect, 0,
-                       format, buffer[0],
-                       GEGL_AUTO_ROWSTRIDE);
+      write_rect.height = n_rows << level;
+
+      gegl_buffer_set (gegl_buffer, &write_rect, level,
+                       format, band, row_stride);
 
-      write_rect.y += 1;
+      write_rect.y += write_rect.height;
     }
 
+  g_free (band);
   jpeg_destroy_decompress (&cinfo);
 
   return 0;
@@ -325,7 +349,7 @@ gegl_jpg_load_process (GeglOperation       *operation,
   GInputStream *stream = gegl_gio_open_input_stream(o->uri, o->path, &file, &err);
   if (!stream)
     return FALSE;
-  status = gegl_jpg_load_buffer_import_jpg(output, stream, 0, 0);
+  status = gegl_jpg_load_buffer_import_jpg(output, stream, 0, 0, level);
   g_input_stream_close(stream, NULL, NULL);
 
   if (err)
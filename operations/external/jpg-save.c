@@ -47,119 +47,209 @@ property_boolean (grayscale, _("Grayscale"), FALSE)
 
 #include "gegl-op.h"
 #include <stdio.h>
+#include <errno.h>
+#include <glib/gstdio.h>
+#include <gegl-gio-private.h>
 #include <jpeglib.h>
 
-static gint
-gegl_buffer_export_jpg (GeglBuffer  *gegl_buffer,
-                        const gchar *path,
-                        gint         quality,
-                        gint         smoothing,
-                        gboolean     optimize,
-                        gboolean     progressive,
-                        gboolean     grayscale,
-                        gint         src_x,
-                        gint         src_y,
-                        gint         width,
-                        gint         height)
+typedef struct
+{
+  FILE                        *fp;
+  gchar                       *path;
+  gchar                       *tmp_path; /* written instead of path until
+                                            the image is complete, NULL
+                                            for stdout */
+  struct jpeg_compress_struct  cinfo;
+  struct jpeg_error_mgr        jerr;
+  const Babl                  *format;
+} JpgStream;
+
+/* Opens a temporary file next to @path and starts the compression of a
+ * JPEG of @width × @height into it; returns NULL on failure.
+ */
+static JpgStream *
+jpg_stream_open (const gchar *path,
+                 gint         quality,
+                 gint         smoothing,
+                 gboolean     optimize,
+                 gboolean     progressive,
+                 gboolean     grayscale,
+                 gint         width,
+                 gint         height)
 {
-  FILE *fp;
-  struct jpeg_compress_struct cinfo;
-  struct jpeg_error_mgr jerr;
-  JSAMPROW row_pointer[1];
-  const Babl *format;
+  JpgStream *stream = g_new0 (JpgStream, 1);
+  struct jpeg_compress_struct *cinfo = &stream->cinfo;
 
   if (!strcmp (path, "-"))
     {
-      fp = stdout;
+      stream->fp = stdout;
     }
   else
     {
-      fp = fopen (path, "wb");
+      gint fd;
+
+      fd = gegl_gio_open_temp_file (path, &stream->path, &stream->tmp_path);
+      if (fd != -1)
+        {
+          stream->fp = fdopen (fd, "wb");
+          if (!stream->fp)
+            {
+              g_close (fd, NULL);
+              g_unlink (stream->tmp_path);
+            }
+        }
     }
-  if (!fp)
+  if (!stream->fp)
     {
-      return -1;
+      g_free (stream->path);
+      g_free (stream->tmp_path);
+      g_free (stream);
+      return NULL;
     }
 
-  cinfo.err = jpeg_std_error (&jerr);
-  jpeg_create_compress (&cinfo);
+  cinfo->err = jpeg_std_error (&stream->jerr);
+  jpeg_create_compress (cinfo);
 
-  jpeg_stdio_dest (&cinfo, fp);
+  jpeg_stdio_dest (cinfo, stream->fp);
 
-  cinfo.image_width = width;
-  cinfo.image_height = height;
+  cinfo->image_width = width;
+  cinfo->image_height = height;
 
   if (!grayscale)
     {
-      cinfo.input_components = 3;
-      cinfo.in_color_space = JCS_RGB;
+      cinfo->input_components = 3;
+      cinfo->in_color_space = JCS_RGB;
+      stream->format = babl_format ("R'G'B' u8");
     }
   else
     {
-      cinfo.input_components = 1;
-      cinfo.in_color_space = JCS_GRAYSCALE;
+      cinfo->input_components = 1;
+      cinfo->in_color_space = JCS_GRAYSCALE;
+      stream->format = babl_format ("Y' u8");
     }
 
-  jpeg_set_defaults (&cinfo);
-  jpeg_set_quality (&cinfo, quality, TRUE);
-  cinfo.smoothing_factor = smoothing;
-  cinfo.optimize_coding = optimize;
+  jpeg_set_defaults (cinfo);
+  jpeg_set_quality (cinfo, quality, TRUE);
+  cinfo->smoothing_factor = smoothing;
+  cinfo->optimize_coding = optimize;
   if (progressive)
-    jpeg_simple_progression (&cinfo);
+    jpeg_simple_progression (cinfo);
 
   /* Use 1x1,1x1,1x1 MCUs and no subsampling */
-  cinfo.comp_info[0].h_samp_factor = 1;
-  cinfo.comp_info[0].v_samp_factor = 1;
+  cinfo->comp_info[0].h_samp_factor = 1;
+  cinfo->comp_info[0].v_samp_factor = 1;
 
   if (!grayscale)
     {
-      cinfo.comp_info[1].h_samp_factor = 1;
-      cinfo.comp_info[1].v_samp_factor = 1;
-      cinfo.comp_info[2].h_samp_factor = 1;
-      cinfo.comp_info[2].v_samp_factor = 1;
+      cinfo->comp_info[1].h_samp_factor = 1;
+      cinfo->comp_info[1].v_samp_factor = 1;
+      cinfo->comp_info[2].h_samp_factor = 1;
+      cinfo->comp_info[2].v_samp_factor = 1;
     }
 
   /* No restart markers */
-  cinfo.restart_interval = 0;
-  cinfo.restart_in_rows = 0;
+  cinfo->restart_interval = 0;
+  cinfo->restart_in_rows = 0;
 
-  jpeg_start_compress (&cinfo, TRUE);
+  jpeg_start_compress (cinfo, TRUE);
 
-  if (!grayscale)
-    {
-      format = babl_format ("R'G'B' u8");
-      row_pointer[0] = g_malloc (width * 3);
-    }
+  return stream;
+}
+
+/* Compresses the rows of @rect in @buffer, which continue the image */
+static void
+jpg_stream_write (JpgStream           *stream,
+                  GeglBuffer          *buffer,
+                  const GeglRectangle *rect)
+{
+  const gint  rowstride = rect->width * stream->cinfo.input_components;
+  guchar     *pixels;
+  JSAMPROW   *rows;
+  gint        i;
+
+  pixels = g_malloc (rowstride * rect->height);
+  rows   = g_new (JSAMPROW, rect->height);
+
+  for (i = 0; i < rect->height; i++)
+    rows[i] = pixels + rowstride * i;
+
+  gegl_buffer_get (buffer, rect, 1.0, stream->format, pixels, rowstride,
+                   GEGL_ABYSS_NONE);
+
+  jpeg_write_scanlines (&stream->cinfo, rows, rect->height);
+
+  g_free (rows);
+  g_free (pixels);
+}
+
+/* Finishes the image and moves it to the target path when @completed,
+ * the temporary file is removed and the target left untouched otherwise.
+ */
+static gboolean
+jpg_stream_close (JpgStream *stream,
+                  gboolean   completed)
+{
+  gboolean success = completed;
+
+  if (completed)
+    jpeg_finish_compress (&stream->cinfo);
   else
-    {
-      format = babl_format ("Y' u8");
-      row_pointer[0] = g_malloc (width);
-    }
+    jpeg_abort_compress (&stream->cinfo);
 
-  while (cinfo.next_scanline < cinfo.image_height) {
-    GeglRectangle rect;
+  jpeg_destroy_compress (&stream->cinfo);
 
-    rect.x = src_x;
-    rect.y = src_y + cinfo.next_scanline;
-    rect.width = width;
-    rect.height = 1;
+  if (stdout != stream->fp && fclose (stream->fp))
+    success = FALSE;
 
-    gegl_buffer_get (gegl_buffer, &rect, 1.0, format,
-                     row_pointer[0], GEGL_AUTO_ROWSTRIDE,
-                     GEGL_ABYSS_NONE);
+  if (stream->tmp_path)
+    {
+      if (success && g_rename (stream->tmp_path, stream->path))
+        {
+          g_warning ("could not rename %s to %s: %s", stream->tmp_path,
+                     stream->path, g_strerror (errno));
+          success = FALSE;
+        }
+      if (!success)
+        g_unlink (stream->tmp_path);
+    }
 
-    jpeg_write_scanlines (&cinfo, row_pointer, 1);
-  }
+  g_free (stream->path);
+  g_free (stream->tmp_path);
+  g_free (stream);
 
-  jpeg_finish_compress (&cinfo);
-  jpeg_destroy_compress (&cinfo);
+  return success;
+}
 
-  g_free (row_pointer[0]);
+static gint
+gegl_buffer_export_jpg (GeglBuffer  *gegl_buffer,
+                        const gchar *path,
+                        gint         quality,
+                        gint         smoothing,
+                        gboolean     optimize,
+                        gboolean     progressive,
+                        gboolean     grayscale,
+                        gint         src_x,
+                        gint         src_y,
+                        gint         width,
+                        gint         height)
+{
+  JpgStream *stream;
+  gint       y;
 
-  if (stdout != fp)
-    fclose (fp);
+  stream = jpg_stream_open (path, quality, smoothing, optimize, progressive,
+                            grayscale, width, height);
+  if (!stream)
+    {
+      return -1;
+    }
 
-  return 0;
+  /* a few rows at a time, to not convert all of the buffer at once */
+  for (y = 0; y < height; y += 64)
+    jpg_stream_write (stream, gegl_buffer,
+                      GEGL_RECTANGLE (src_x, src_y + y,
+                                      width, MIN (64, height - y)));
+
+  return jpg_stream_close (stream, TRUE) ? 0 : -1;
 }
 
 static gboolean
@@ -177,6 +267,49 @@ gegl_jpg_save_process (GeglOperation       *operation,
   return  TRUE;
 }
 
+static gboolean
+gegl_jpg_save_stream_band (GeglOperation       *operation,
+                           GeglBuffer          *input,
+                           const GeglRectangle *result,
+                           const GeglRectangle *band,
+                           gint                 level)
+{
+  GeglProperties *o = GEGL_PROPERTIES (operation);
+
+  if (band->y == result->y)
+    {
+      if (o->user_data)
+        jpg_stream_close (o->user_data, FALSE);
+
+      o->user_data = jpg_stream_open (o->path, o->quality, o->smoothing,
+                                      o->optimize, o->progressive,
+                                      o->grayscale,
+                                      result->width, result->height);
+      if (!o->user_data)
+        {
+          g_warning ("could not open %s for writing", o->path);
+          return FALSE;
+        }
+    }
+
+  if (!o->user_data)
+    return FALSE;
+
+  jpg_stream_write (o->user_data, input, band);
+  return TRUE;
+}
+
+static void
+gegl_jpg_save_stream_finish (GeglOperation *operation,
+                             gboolean       completed)
+{
+  GeglProperties *o = GEGL_PROPERTIES (operation);
+
+  if (o->user_data)
+    jpg_stream_close (o->user_data, completed);
+  o->user_data = NULL;
+}
+
 
 static void
 gegl_op_class_init (GeglOpClass *klass)
@@ -187,8 +320,10 @@ gegl_op_class_init (GeglOpClass *klass)
   operation_class = GEGL_OPERATION_CLASS (klass);
   sink_class      = GEGL_OPERATION_SINK_CLASS (klass);
 
-  sink_class->process    = gegl_jpg_save_process;
-  sink_class->needs_full = TRUE;
+  sink_class->process       = gegl_jpg_save_process;
+  sink_class->stream_band   = gegl_jpg_save_stream_band;
+  sink_class->stream_finish = gegl_jpg_save_stream_finish;
+  sink_class->needs_full    = TRUE;
 
   gegl_operation_class_set_keys (operation_class,
     "name",         "gegl:jpg-save",
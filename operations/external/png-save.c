@@ -40,56 +40,101 @@ property_int    (bitdepth, _("Bitdepth"), 16)
 #include "gegl-op.h"
 #include <png.h>
 #include <stdio.h>
+#include <errno.h>
+#include <glib/gstdio.h>
+#include <gegl-gio-private.h>
 
-/* this call is available when the png-save plug-in is loaded,
- * it might have to be dlsymed to be used?
+typedef struct
+{
+  FILE       *fp;
+  gchar      *path;
+  gchar      *tmp_path; /* written instead of path until the image is
+                           complete, NULL for stdout */
+  png_struct *png;
+  png_info   *info;
+  const Babl *format;
+} PngStream;
+
+/* Closes the file of @stream and frees it, the temporary file replaces
+ * the target when @completed and is removed otherwise.
  */
-gint
-gegl_buffer_export_png (GeglBuffer  *gegl_buffer,
-                        const gchar *path,
-                        gint         compression,
-                        gint         bd,
-                        gint         src_x,
-                        gint         src_y,
-                        gint         width,
-                        gint         height);
+static gboolean
+png_stream_close_file (PngStream *stream,
+                       gboolean   completed)
+{
+  gboolean success = completed;
 
-gint
-gegl_buffer_export_png (GeglBuffer  *gegl_buffer,
-                        const gchar *path,
-                        gint         compression,
-                        gint         bd,
-                        gint         src_x,
-                        gint         src_y,
-                        gint         width,
-                        gint         height)
+  if (stdout != stream->fp && fclose (stream->fp))
+    success = FALSE;
+
+  if (stream->tmp_path)
+    {
+      if (success && g_rename (stream->tmp_path, stream->path))
+        {
+          g_warning ("could not rename %s to %s: %s", stream->tmp_path,
+                     stream->path, g_strerror (errno));
+          success = FALSE;
+        }
+      if (!success)
+        g_unlink (stream->tmp_path);
+    }
+
+  g_free (stream->path);
+  g_free (stream->tmp_path);
+  g_free (stream);
+
+  return success;
+}
+
+/* Opens a temporary file next to @path and writes the header of a PNG of
+ * @width × @height to it, with the color type following @input_format;
+ * returns NULL on failure.
+ */
+static PngStream *
+png_stream_open (const gchar *path,
+                 gint         compression,
+                 gint         bd,
+                 const Babl  *input_format,
+                 gint         width,
+                 gint         height)
 {
-  FILE          *fp;
-  gint           i;
-  png_struct    *png;
-  png_info      *info;
-  guchar        *pixels;
+  PngStream     *stream;
   png_color_16   white;
   int            png_color_type;
   gchar          format_string[16];
-  const Babl    *format;
   gint           bit_depth = 8;
 
+  stream = g_new0 (PngStream, 1);
+
   if (!strcmp (path, "-"))
     {
-      fp = stdout;
+      stream->fp = stdout;
     }
   else
     {
-      fp = fopen (path, "wb");
+      gint fd;
+
+      fd = gegl_gio_open_temp_file (path, &stream->path, &stream->tmp_path);
+      if (fd != -1)
+        {
+          stream->fp = fdopen (fd, "wb");
+          if (!stream->fp)
+            {
+              g_close (fd, NULL);
+              g_unlink (stream->tmp_path);
+            }
+        }
     }
-  if (!fp)
+  if (!stream->fp)
     {
-      return -1;
+      g_free (stream->path);
+      g_free (stream->tmp_path);
+      g_free (stream);
+      return NULL;
     }
 
   {
-    const Babl *babl = gegl_buffer_get_format (gegl_buffer);
+    const Babl *babl = input_format;
 
     if (bd == 16)
       bit_depth = 16;
@@ -125,29 +170,29 @@ gegl_buffer_export_png (GeglBuffer  *gegl_buffer,
   else
     strcat (format_string, "u8");
 
-  png = png_create_write_struct (PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
-  if (png == NULL)
-    {
-      if (stdout != fp)
-        fclose (fp);
+  stream->format = babl_format (format_string);
 
-      return -1;
+  stream->png = png_create_write_struct (PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
+  if (stream->png == NULL)
+    {
+      png_stream_close_file (stream, FALSE);
+      return NULL;
     }
 
-  info = png_create_info_struct (png);
+  stream->info = png_create_info_struct (stream->png);
 
-  if (setjmp (png_jmpbuf (png)))
+  if (setjmp (png_jmpbuf (stream->png)))
     {
-      if (stdout != fp)
-        fclose (fp);
+      png_destroy_write_struct (&stream->png, &stream->info);
 
-      return -1;
+      png_stream_close_file (stream, FALSE);
+      return NULL;
     }
 
-  png_set_compression_level (png, compression);
-  png_init_io (png, fp);
+  png_set_compression_level (stream->png, compression);
+  png_init_io (stream->png, stream->fp);
 
-  png_set_IHDR (png, info,
+  png_set_IHDR (stream->png, stream->info,
      width, height, bit_depth, png_color_type,
      PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_BASE, PNG_FILTER_TYPE_DEFAULT);
 
@@ -159,41 +204,120 @@ gegl_buffer_export_png (GeglBuffer  *gegl_buffer,
     }
   else
     white.gray = 0xff;
-  png_set_bKGD (png, info, &white);
+  png_set_bKGD (stream->png, stream->info, &white);
 
-  png_write_info (png, info);
+  png_write_info (stream->png, stream->info);
 
 #if BYTE_ORDER == LITTLE_ENDIAN
   if (bit_depth > 8)
-    png_set_swap (png);
+    png_set_swap (stream->png);
 #endif
 
-  format = babl_format (format_string);
-  pixels = g_malloc0 (width * babl_format_get_bytes_per_pixel (format));
+  return stream;
+}
 
-  for (i=0; i< height; i++)
-    {
-      GeglRectangle rect;
+/* Appends the rows of @rect in @buffer to the image */
+static gboolean
+png_stream_write (PngStream           *stream,
+                  GeglBuffer          *buffer,
+                  const GeglRectangle *rect)
+{
+  const gint   rowstride = rect->width *
+                           babl_format_get_bytes_per_pixel (stream->format);
+  guchar      *pixels;
+  png_bytep   *rows;
+  gint         i;
 
-      rect.x = src_x;
-      rect.y = src_y+i;
-      rect.width = width;
-      rect.height = 1;
+  pixels = g_malloc (rowstride * rect->height);
+  rows   = g_new (png_bytep, rect->height);
 
-      gegl_buffer_get (gegl_buffer, &rect, 1.0, babl_format (format_string), pixels, GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+  for (i = 0; i < rect->height; i++)
+    rows[i] = pixels + rowstride * i;
 
-      png_write_rows (png, &pixels, 1);
+  gegl_buffer_get (buffer, rect, 1.0, stream->format, pixels, rowstride,
+                   GEGL_ABYSS_NONE);
+
+  if (setjmp (png_jmpbuf (stream->png)))
+    {
+      g_free (rows);
+      g_free (pixels);
+      return FALSE;
     }
 
-  png_write_end (png, info);
+  png_write_rows (stream->png, rows, rect->height);
 
-  png_destroy_write_struct (&png, &info);
+  g_free (rows);
   g_free (pixels);
 
-  if (stdout != fp)
-    fclose (fp);
+  return TRUE;
+}
 
-  return 0;
+/* Ends the image and moves it to the target path when @completed, and
+ * leaves the target untouched otherwise.
+ */
+static gboolean
+png_stream_close (PngStream *stream,
+                  gboolean   completed)
+{
+  gboolean success = completed;
+
+  if (!setjmp (png_jmpbuf (stream->png)))
+    {
+      if (completed)
+        png_write_end (stream->png, stream->info);
+    }
+  else
+    {
+      success = FALSE;
+    }
+
+  png_destroy_write_struct (&stream->png, &stream->info);
+
+  return png_stream_close_file (stream, success);
+}
+
+/* this call is available when the png-save plug-in is loaded,
+ * it might have to be dlsymed to be used?
+ */
+gint
+gegl_buffer_export_png (GeglBuffer  *gegl_buffer,
+                        const gchar *path,
+                        gint         compression,
+                        gint         bd,
+                        gint         src_x,
+                        gint         src_y,
+                        gint         width,
+                        gint         height);
+
+gint
+gegl_buffer_export_png (GeglBuffer  *gegl_buffer,
+                        const gchar *path,
+                        gint         compression,
+                        gint         bd,
+                        gint         src_x,
+                        gint         src_y,
+                        gint         width,
+                        gint         height)
+{
+  PngStream *stream;
+  gint       y;
+  gboolean   success = TRUE;
+
+  stream = png_stream_open (path, compression, bd,
+                            gegl_buffer_get_format (gegl_buffer),
+                            width, height);
+  if (!stream)
+    {
+      return -1;
+    }
+
+  /* a few rows at a time, to not convert all of the buffer at once */
+  for (y = 0; y < height && success; y += 64)
+    success = png_stream_write (stream, gegl_buffer,
+                                GEGL_RECTANGLE (src_x, src_y + y,
+                                                width, MIN (64, height - y)));
+
+  return png_stream_close (stream, success) ? 0 : -1;
 }
 
 static gboolean
@@ -210,6 +334,47 @@ gegl_png_save_process (GeglOperation       *operation,
   return  TRUE;
 }
 
+static gboolean
+gegl_png_save_stream_band (GeglOperation       *operation,
+                           GeglBuffer          *input,
+                           const GeglRectangle *result,
+                           const GeglRectangle *band,
+                           gint                 level)
+{
+  GeglProperties *o = GEGL_PROPERTIES (operation);
+
+  if (band->y == result->y)
+    {
+      if (o->user_data)
+        png_stream_close (o->user_data, FALSE);
+
+      o->user_data = png_stream_open (o->path, o->compression, o->bitdepth,
+                                      gegl_buffer_get_format (input),
+                                      result->width, result->height);
+      if (!o->user_data)
+        {
+          g_warning ("could not open %s for writing", o->path);
+          return FALSE;
+        }
+    }
+
+  if (!o->user_data)
+    return FALSE;
+
+  return png_stream_write (o->user_data, input, band);
+}
+
+static void
+gegl_png_save_stream_finish (GeglOperation *operation,
+                             gboolean       completed)
+{
+  GeglProperties *o = GEGL_PROPERTIES (operation);
+
+  if (o->user_data)
+    png_stream_close (o->user_data, completed);
+  o->user_data = NULL;
+}
+
 
 static void
 gegl_op_class_init (GeglOpClass *klass)
@@ -220,8 +385,10 @@ gegl_op_class_init (GeglOpClass *klass)
   operation_class = GEGL_OPERATION_CLASS (klass);
   sink_class      = GEGL_OPERATION_SINK_CLASS (klass);
 
-  sink_class->process    = gegl_png_save_process;
-  sink_class->needs_full = TRUE;
+  sink_class->process       = gegl_png_save_process;
+  sink_class->stream_band   = gegl_png_save_stream_band;
+  sink_class->stream_finish = gegl_png_save_stream_finish;
+  sink_class->needs_full    = TRUE;
 
   gegl_operation_class_set_keys (operation_class,
   "name",        "gegl:png-save",
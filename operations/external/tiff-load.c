@@ -39,6 +39,7 @@ property_int(directory, _("Directory"), 1)
 
 #include <gegl-op.h>
 #include <gegl-gio-private.h>
+#include <gegl-tile-backend-decode.h>
 #include <glib/gprintf.h>
 #include <tiffio.h>
 
@@ -68,8 +69,29 @@ typedef struct
 
   gint width;
   gint height;
+
+  /* tiled images are decoded tile by tile as they are read */
+  gboolean lazy;
+  guint32 tile_width;
+  guint32 tile_height;
+  GeglBuffer *buffer;
 } Priv;
 
+static void
+close_tiff(Priv *p)
+{
+  if (p->tiff != NULL)
+    TIFFClose(p->tiff);
+  else if (p->stream != NULL)
+    g_input_stream_close(G_INPUT_STREAM(p->stream), NULL, NULL);
+  if (p->stream != NULL)
+    g_clear_object(&p->stream);
+  p->tiff = NULL;
+
+  if (p->file != NULL)
+    g_clear_object(&p->file);
+}
+
 static void
 cleanup(GeglOperation *operation)
 {
@@ -78,19 +100,14 @@ cleanup(GeglOperation *operation)
 
   if (p != NULL)
     {
-      if (p->tiff != NULL)
-        TIFFClose(p->tiff);
-      else if (p->stream != NULL)
-        g_input_stream_close(G_INPUT_STREAM(p->stream), NULL, NULL);
-      if (p->stream != NULL)
-        g_clear_object(&p->stream);
-      p->tiff = NULL;
+      close_tiff(p);
 
-      if (p->file != NULL)
-        g_clear_object(&p->file);
+      if (p->buffer != NULL)
+        g_clear_object(&p->buffer);
 
       p->width = p->height = 0;
       p->directory = 0;
+      p->lazy = FALSE;
     }
 }
 
@@ -502,6 +519,24 @@ query_tiff(GeglOperation *operation)
   p->height = (gint) height;
   p->width = (gint) width;
 
+  /* tiles decoded straight into the tiles of a buffer need to hold whole
+   * pixels of the output format, and seeking in the file must be cheap
+   */
+  p->lazy = FALSE;
+  if (p->mode == TIFF_LOADING_CONTIGUOUS && p->can_seek &&
+      TIFFIsTiled(p->tiff))
+    {
+      TIFFGetField(p->tiff, TIFFTAG_TILEWIDTH, &p->tile_width);
+      TIFFGetField(p->tiff, TIFFTAG_TILELENGTH, &p->tile_height);
+
+      p->lazy = p->tile_width > 0 && p->tile_height > 0 &&
+                TIFFTileSize(p->tiff) == p->tile_width * p->tile_height *
+                babl_format_get_bytes_per_pixel(p->format);
+    }
+
+  if (p->buffer != NULL)
+    g_clear_object(&p->buffer);
+
   return 0;
 }
 
@@ -694,12 +729,102 @@ load_separated(GeglOperation *operation,
   return 0;
 }
 
+/* Opens the TIFF of @uri, or of @path when there is no URI */
+static gboolean
+open_tiff(Priv *p,
+          const gchar *uri,
+          const gchar *path)
+{
+  GError *error = NULL;
+
+  p->stream = gegl_gio_open_input_stream(uri, path, &p->file, &error);
+  if (p->stream != NULL && p->file != NULL)
+    p->can_seek = g_seekable_can_seek(G_SEEKABLE(p->stream));
+  if (p->stream == NULL)
+    {
+      g_warning(error->message);
+      g_error_free(error);
+      return FALSE;
+    }
+
+  TIFFSetErrorHandler(error_handler);
+  TIFFSetWarningHandler(warning_handler);
+
+  p->tiff = TIFFClientOpen("GEGL-tiff-load", "r", (thandle_t) p,
+                           read_from_stream, write_to_stream,
+                           seek_in_stream, close_stream,
+                           get_file_size, NULL, NULL);
+  if (p->tiff == NULL)
+    {
+      if (uri != NULL && strlen(uri) > 0)
+        g_warning("failed to open TIFF from %s", uri);
+      else
+        g_warning("failed to open TIFF from %s", path);
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
+static gboolean
+decode_tile(gint x,
+            gint y,
+            guchar *data,
+            gpointer user_data)
+{
+  Priv *p = (Priv*) user_data;
+
+  return TIFFReadTile(p->tiff, data,
+                      x * p->tile_width, y * p->tile_height, 0, 0) >= 0;
+}
+
+static void
+free_decoder(gpointer user_data)
+{
+  Priv *p = (Priv*) user_data;
+
+  close_tiff(p);
+  g_free(p);
+}
+
+/* Creates a buffer whose tiles are the tiles of the file, decoded the first
+ * time they are read. The backend reads from a TIFF of its own, as the
+ * buffer can outlive the operation.
+ */
+static GeglBuffer *
+new_lazy_buffer(GeglOperation *operation)
+{
+  GeglProperties *o = GEGL_PROPERTIES(operation);
+  Priv *p = (Priv*) o->user_data;
+  Priv *decoder = g_new0(Priv, 1);
+  GeglTileBackend *backend;
+  GeglBuffer *buffer;
+
+  if (!open_tiff(decoder, o->uri, o->path) ||
+      !TIFFSetDirectory(decoder->tiff, p->directory - 1))
+    {
+      free_decoder(decoder);
+      return NULL;
+    }
+
+  decoder->tile_width = p->tile_width;
+  decoder->tile_height = p->tile_height;
+
+  backend = gegl_tile_backend_decode_new(p->width, p->height,
+                                         p->tile_width, p->tile_height,
+                                         p->format,
+                                         decode_tile, decoder, free_decoder);
+  buffer = gegl_buffer_new_for_backend(NULL, backend);
+  g_object_unref(backend);
+
+  return buffer;
+}
+
 static void
 prepare(GeglOperation *operation)
 {
   GeglProperties *o = GEGL_PROPERTIES(operation);
   Priv *p = (o->user_data) ? o->user_data : g_new0(Priv, 1);
-  GError *error = NULL;
   GFile *file = NULL;
   gint directories;
 
@@ -723,30 +848,8 @@ prepare(GeglOperation *operation)
 
   if (p->stream == NULL)
     {
-      p->stream = gegl_gio_open_input_stream(o->uri, o->path, &p->file, &error);
-      if (p->stream != NULL && p->file != NULL)
-        p->can_seek = g_seekable_can_seek(G_SEEKABLE(p->stream));
-      if (p->stream == NULL)
-        {
-          g_warning(error->message);
-          g_error_free(error);
-          cleanup(operation);
-          return;
-        }
-
-      TIFFSetErrorHandler(error_handler);
-      TIFFSetWarningHandler(warning_handler);
-
-      p->tiff = TIFFClientOpen("GEGL-tiff-load", "r", (thandle_t) p,
-                               read_from_stream, write_to_stream,
-                               seek_in_stream, close_stream,
-                               get_file_size, NULL, NULL);
-      if (p->tiff == NULL)
+      if (!open_tiff(p, o->uri, o->path))
         {
-          if (o->uri != NULL && strlen(o->uri) > 0)
-            g_warning("failed to open TIFF from %s", o->uri);
-          else
-            g_warning("failed to open TIFF from %s", o->path);
           cleanup(operation);
           return;
         }
@@ -823,10 +926,52 @@ process(GeglOperation *operation,
   return FALSE;
 }
 
+/* Hands out the buffer of the tiles of the file when the image is tiled,
+ * and loads all of it otherwise.
+ */
+static gboolean
+operation_process(GeglOperation *operation,
+                  GeglOperationContext *context,
+                  const gchar *output_pad,
+                  const GeglRectangle *result,
+                  gint level)
+{
+  GeglOperationClass *operation_class;
+  GeglProperties *o = GEGL_PROPERTIES(operation);
+  Priv *p = (Priv*) o->user_data;
+
+  if (p != NULL && p->tiff != NULL && p->lazy)
+    {
+      if (p->buffer == NULL)
+        p->buffer = new_lazy_buffer(operation);
+
+      if (p->buffer != NULL)
+        {
+          gegl_operation_context_take_object(context, "output",
+                                             G_OBJECT(g_object_ref(p->buffer)));
+          /* the tiles are shared, don't process into the buffer in place */
+          gegl_object_set_has_forked(G_OBJECT(p->buffer));
+          return TRUE;
+        }
+    }
+
+  operation_class = GEGL_OPERATION_CLASS(gegl_op_parent_class);
+
+  return operation_class->process(operation, context, output_pad,
+                                  result, level);
+}
+
 static GeglRectangle
 get_cached_region(GeglOperation       *operation,
                   const GeglRectangle *roi)
 {
+  GeglProperties *o = GEGL_PROPERTIES(operation);
+  Priv *p = (Priv*) o->user_data;
+
+  /* only the tiles under @roi are decoded */
+  if (p != NULL && p->lazy)
+    return *roi;
+
   return get_bounding_box(operation);
 }
 
@@ -858,6 +1003,7 @@ gegl_op_class_init(GeglOpClass *klass)
   source_class = GEGL_OPERATION_SOURCE_CLASS(klass);
 
   source_class->process = process;
+  operation_class->process = operation_process;
   operation_class->prepare = prepare;
   operation_class->get_bounding_box = get_bounding_box;
   operation_class->get_cached_region = get_cached_region;
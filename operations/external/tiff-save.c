@@ -37,6 +37,11 @@ property_file_path (path, _("File"), "")
 
 typedef struct
 {
+  gboolean failed;
+  gboolean abandoned; /* the image is incomplete, and mustn't replace the
+                         target */
+  gboolean existed;   /* the target existed before the save */
+
   GFile *file;
   GOutputStream *stream;
   gboolean can_seek;
@@ -46,8 +51,26 @@ typedef struct
   gsize position;
 
   TIFF *tiff;
+  const Babl *format;
 } Priv;
 
+/* Closes the stream with a cancelled close, which makes GIO drop what was
+ * written and leave an existing target untouched, a target that didn't
+ * exist is removed
+ */
+static void
+discard_stream(Priv *p)
+{
+  GCancellable *cancellable = g_cancellable_new();
+
+  g_cancellable_cancel(cancellable);
+  g_output_stream_close(G_OUTPUT_STREAM(p->stream), cancellable, NULL);
+  g_object_unref(cancellable);
+
+  if (p->file != NULL && !p->existed)
+    g_file_delete(p->file, NULL, NULL);
+}
+
 static void
 cleanup(GeglOperation *operation)
 {
@@ -59,7 +82,7 @@ cleanup(GeglOperation *operation)
       if (p->tiff != NULL)
         TIFFClose(p->tiff);
       else if (p->stream != NULL)
-        g_output_stream_close(G_OUTPUT_STREAM(p->stream), NULL, NULL);
+        discard_stream(p);
       if (p->stream != NULL)
         g_clear_object(&p->stream);
       p->tiff = NULL;
@@ -146,6 +169,7 @@ write_to_stream(thandle_t handle,
         {
           g_warning(error->message);
           g_error_free(error);
+          p->failed = TRUE;
         }
     }
   else
@@ -155,7 +179,10 @@ write_to_stream(thandle_t handle,
           new_size = p->position + size;
           new_buffer = g_try_realloc(p->buffer, new_size);
           if (!new_buffer)
-            return -1;
+            {
+              p->failed = TRUE;
+              return -1;
+            }
 
           p->allocated = new_size;
           p->buffer = new_buffer;
@@ -231,7 +258,8 @@ close_stream(thandle_t handle)
   g_assert(p->stream);
 
   /* !can_seek: file content is now fully cached, time to write it down. */
-  if (!p->can_seek && p->buffer != NULL && p->allocated > 0)
+  if (!p->abandoned && !p->failed &&
+      !p->can_seek && p->buffer != NULL && p->allocated > 0)
     {
       while (total < p->allocated)
         {
@@ -245,6 +273,7 @@ close_stream(thandle_t handle)
             {
                   g_warning(error->message);
                   g_error_free(error);
+                  p->failed = TRUE;
                   break;
             }
 
@@ -252,12 +281,21 @@ close_stream(thandle_t handle)
         }
     }
 
-  closed = g_output_stream_close(G_OUTPUT_STREAM(p->stream),
-                                 NULL, &error);
-  if (!closed)
+  if (p->abandoned || p->failed)
     {
-      g_warning(error->message);
-      g_error_free(error);
+      discard_stream(p);
+      closed = TRUE;
+    }
+  else
+    {
+      closed = g_output_stream_close(G_OUTPUT_STREAM(p->stream),
+                                     NULL, &error);
+      if (!closed)
+        {
+          g_warning(error->message);
+          g_error_free(error);
+          p->failed = TRUE;
+        }
     }
 
   g_clear_object(&p->stream);
@@ -311,60 +349,48 @@ static gint
 save_contiguous(GeglOperation *operation,
                 GeglBuffer    *input,
                 const GeglRectangle *result,
-                const Babl *format)
+                const GeglRectangle *rect)
 {
   GeglProperties *o = GEGL_PROPERTIES(operation);
   Priv *p = (Priv*) o->user_data;
   gint bytes_per_pixel, bytes_per_row;
-  gint tile_width = result->width;
-  gint tile_height = result->height;
   guchar *buffer;
-  gint x, y;
+  gint row;
 
   g_return_val_if_fail(p->tiff != NULL, -1);
 
-  bytes_per_pixel = babl_format_get_bytes_per_pixel(format);
-  bytes_per_row = bytes_per_pixel * tile_width;
+  bytes_per_pixel = babl_format_get_bytes_per_pixel(p->format);
+  bytes_per_row = bytes_per_pixel * rect->width;
 
-  buffer = g_try_new(guchar, bytes_per_row * tile_height);
+  buffer = g_try_new(guchar, bytes_per_row * rect->height);
 
   g_assert(buffer != NULL);
 
-  for (y = result->y; y < result->y + tile_height; y += tile_height)
-    {
-      for (x = result->x; x < result->x + tile_width; x += tile_width)
-        {
-          GeglRectangle tile = { x, y, tile_width, tile_height };
-          gint row;
-
-          gegl_buffer_get(input, &tile, 1.0, format, buffer,
-                          GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+  gegl_buffer_get(input, rect, 1.0, p->format, buffer,
+                  GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
 
-          for (row = y; row < y + tile_height; row++)
-            {
-              guchar *tile_row = buffer + (bytes_per_row * (row - y));
-              gint written;
+  for (row = 0; row < rect->height; row++)
+    {
+      guchar *tile_row = buffer + (bytes_per_row * row);
+      gint written;
 
-              written = TIFFWriteScanline(p->tiff, tile_row, row, 0);
+      written = TIFFWriteScanline(p->tiff, tile_row,
+                                  rect->y - result->y + row, 0);
 
-              if (!written)
-                {
-                  g_critical("failed a scanline write on row %d", row);
-                  continue;
-                }
-            }
+      if (!written)
+        {
+          g_critical("failed a scanline write on row %d", rect->y + row);
+          continue;
         }
     }
 
-  TIFFFlushData(p->tiff);
-
   g_free(buffer);
   return 0;
 }
 
 static int
 export_tiff (GeglOperation *operation,
-             GeglBuffer *input,
+             const Babl *input_format,
              const GeglRectangle *result)
 {
   GeglProperties *o = GEGL_PROPERTIES(operation);
@@ -388,7 +414,7 @@ export_tiff (GeglOperation *operation,
   TIFFSetField(p->tiff, TIFFTAG_IMAGEWIDTH, result->width);
   TIFFSetField(p->tiff, TIFFTAG_IMAGELENGTH, result->height);
 
-  format = gegl_buffer_get_format(input);
+  format = input_format;
 
   model = babl_format_get_model(format);
   type = babl_format_get_type(format, 0);
@@ -543,32 +569,39 @@ export_tiff (GeglOperation *operation,
 
   TIFFSetField(p->tiff, TIFFTAG_ROWSPERSTRIP, rows_per_stripe);
 
-  return save_contiguous(operation, input, result, format);
+  p->format = format;
+
+  return 0;
 }
 
+/* Opens the file and writes the tags of a TIFF holding @result, in a format
+ * following @input_format; the rows are written with save_contiguous()
+ */
 static gboolean
-process(GeglOperation *operation,
-        GeglBuffer *input,
-        const GeglRectangle *result,
-        int level)
+open_tiff(GeglOperation *operation,
+          const Babl *input_format,
+          const GeglRectangle *result)
 {
   GeglProperties *o = GEGL_PROPERTIES(operation);
   Priv *p = g_new0(Priv, 1);
-  gboolean status = TRUE;
   GError *error = NULL;
 
   g_assert(p != NULL);
 
   o->user_data = (void*) p;
 
+  /* the target is replaced once the stream is closed, until then GIO
+   * writes next to it
+   */
+  p->existed = g_file_test(o->path, G_FILE_TEST_EXISTS);
   p->stream = gegl_gio_open_output_stream(NULL, o->path, &p->file, &error);
   if (p->stream != NULL && p->file != NULL)
     p->can_seek = g_seekable_can_seek(G_SEEKABLE(p->stream));
   if (p->stream == NULL)
     {
-      status = FALSE;
       g_warning(error->message);
-      goto cleanup;
+      g_error_free(error);
+      return FALSE;
     }
 
   TIFFSetErrorHandler(error_handler);
@@ -580,30 +613,106 @@ process(GeglOperation *operation,
                            get_file_size, NULL, NULL);
   if (p->tiff == NULL)
     {
-      status = FALSE;
       g_warning("failed to open TIFF from %s", o->path);
-      goto cleanup;
+      return FALSE;
     }
 
-  if (export_tiff(operation, input, result))
+  if (export_tiff(operation, input_format, result))
     {
-      status = FALSE;
       g_warning("could not export TIFF file");
-      goto cleanup;
+      return FALSE;
     }
 
-cleanup:
-  cleanup(operation);
-  if (o->user_data != NULL)
-    g_free(o->user_data);
+  return TRUE;
+}
+
+/* Closes the file, the image replaces the target when @completed and the
+ * target is left untouched otherwise
+ */
+static gboolean
+close_tiff(GeglOperation *operation,
+           gboolean completed)
+{
+  GeglProperties *o = GEGL_PROPERTIES(operation);
+  Priv *p = (Priv*) o->user_data;
+  gboolean success = completed;
+
+  if (p != NULL)
+    {
+      p->abandoned = !completed;
+
+      cleanup(operation);
+
+      if (p->failed)
+        success = FALSE;
+
+      g_free(p);
+    }
   o->user_data = NULL;
 
-  if (error != NULL)
-    g_error_free(error);
+  return success;
+}
+
+static gboolean
+process(GeglOperation *operation,
+        GeglBuffer *input,
+        const GeglRectangle *result,
+        int level)
+{
+  GeglProperties *o = GEGL_PROPERTIES(operation);
+  gboolean status = FALSE;
+
+  if (open_tiff(operation, gegl_buffer_get_format(input), result))
+    {
+      status = save_contiguous(operation, input, result, result) == 0;
+      TIFFFlushData(((Priv*) o->user_data)->tiff);
+    }
+
+  status = close_tiff(operation, status);
 
   return status;
 }
 
+static gboolean
+stream_band(GeglOperation *operation,
+            GeglBuffer *input,
+            const GeglRectangle *result,
+            const GeglRectangle *band,
+            int level)
+{
+  GeglProperties *o = GEGL_PROPERTIES(operation);
+
+  if (band->y == result->y)
+    {
+      if (o->user_data != NULL)
+        close_tiff(operation, FALSE);
+
+      if (!open_tiff(operation, gegl_buffer_get_format(input), result))
+        {
+          close_tiff(operation, FALSE);
+          return FALSE;
+        }
+    }
+
+  if (o->user_data == NULL)
+    return FALSE;
+
+  return save_contiguous(operation, input, result, band) == 0;
+}
+
+static void
+stream_finish(GeglOperation *operation,
+              gboolean completed)
+{
+  GeglProperties *o = GEGL_PROPERTIES(operation);
+  Priv *p = (Priv*) o->user_data;
+
+  if (p != NULL && p->tiff != NULL && completed)
+    TIFFFlushData(p->tiff);
+
+  close_tiff(operation, completed);
+}
+
 static void
 gegl_op_class_init(GeglOpClass *klass)
 {
@@ -615,6 +724,8 @@ gegl_op_class_init(GeglOpClass *klass)
 
   sink_class->needs_full = TRUE;
   sink_class->process = process;
+  sink_class->stream_band = stream_band;
+  sink_class->stream_finish = stream_finish;
 
   gegl_operation_class_set_keys(operation_class,
     "name",          "gegl:tiff-save",
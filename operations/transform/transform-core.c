@@ -713,31 +713,18 @@ typedef struct ThreadData
   GeglOperation            *operation;
   GeglBuffer               *input;
   GeglBuffer               *output;
-  gint                     *pending;
   GeglMatrix3              *matrix;
   gint                      level;
   gboolean                  success;
   GeglRectangle             roi;
 } ThreadData;
 
-static void thread_process (gpointer thread_data, gpointer unused)
+static void thread_process (gpointer thread_data)
 {
   ThreadData *data = thread_data;
   data->func (data->operation,
                    data->output, data->input, data->matrix, data->level);
     data->success = FALSE;
-  g_atomic_int_add (data->pending, -1);
-}
-
-static GThreadPool *thread_pool (void)
-{
-  static GThreadPool *pool = NULL;
-  if (!pool)
-    {
-      pool =  g_thread_pool_new (thread_process, NULL, gegl_config_threads(),
-                                 FALSE, NULL);
-    }
-  return pool;
 }
 
 
@@ -937,21 +924,40 @@ transform_affine (GeglOperation *operation,
 
         gint y = roi->height;
         do {
-          gdouble u_float = u_start;
-          gdouble v_float = v_start;
-
-          gint x = roi->width;
-          do {
-            sampler_get_fun (sampler,
-                             u_float, v_float,
-                             &inverse_jacobian,
-                             dest_ptr,
-                             GEGL_ABYSS_NONE);
-            dest_ptr += (gint) 4 - (gint) 8 * flip_x;
-
-            u_float += inverse_jacobian.coeff [0][0];
-            v_float += inverse_jacobian.coeff [1][0];
-          } while (--x);
+          if (flip_x)
+            {
+              gdouble u_float = u_start;
+              gdouble v_float = v_start;
+
+              gint x = roi->width;
+              do {
+                sampler_get_fun (sampler,
+                                 u_float, v_float,
+                                 &inverse_jacobian,
+                                 dest_ptr,
+                                 GEGL_ABYSS_NONE);
+                dest_ptr += (gint) 4 - (gint) 8 * flip_x;
+
+                u_float += inverse_jacobian.coeff [0][0];
+                v_float += inverse_jacobian.coeff [1][0];
+              } while (--x);
+            }
+          else
+            {
+              /*
+               * The scanline pulled back to input space is a line with
+               * constant steps, sample it with a single span call.
+               */
+              gegl_sampler_get_span (sampler,
+                                     u_start, v_start,
+                                     inverse_jacobian.coeff [0][0],
+                                     inverse_jacobian.coeff [1][0],
+                                     &inverse_jacobian,
+                                     dest_ptr,
+                                     roi->width,
+                                     GEGL_ABYSS_NONE);
+              dest_ptr += (gint) 4 * roi->width;
+            }
 
           dest_ptr += (gint) 8 * (flip_x - flip_y) * roi->width;
 
@@ -1272,9 +1278,8 @@ gegl_transform_process (GeglOperation        *operation,
       if (gegl_operation_use_threading (operation, result))
       {
         gint threads = gegl_config_threads ();
-        GThreadPool *pool = thread_pool ();
+        GeglTaskGroup *group;
         ThreadData thread_data[GEGL_MAX_THREADS];
-        gint pending = threads;
 
         if (result->width > result->height)
         {
@@ -1308,16 +1313,16 @@ gegl_transform_process (GeglOperation        *operation,
           thread_data[i].operation = operation;
           thread_data[i].input = input;
           thread_data[i].output = output;
-          thread_data[i].pending = &pending;
           thread_data[i].level = level;
           thread_data[i].success = TRUE;
         }
 
+        group = gegl_task_group_new ();
         for (gint i = 1; i < threads; i++)
-          g_thread_pool_push (pool, &thread_data[i], NULL);
-        thread_process (&thread_data[0], NULL);
+          gegl_task_group_add (group, thread_process, &thread_data[i]);
+        thread_process (&thread_data[0]);
 
-        while (g_atomic_int_get (&pending)) {};
+        gegl_task_group_join (group);
       }
       else
       {
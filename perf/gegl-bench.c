@@ -0,0 +1,781 @@
+/* This file is part of GEGL
+ *
+ * GEGL is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * GEGL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* gegl-bench runs a suite of benchmarks of operations, buffer access
+ * patterns, samplers and graphs loaded from XML files given on the command
+ * line. Every benchmark is run a number of times after warming up, for each
+ * of a list of thread counts, and the median and 95th percentile times are
+ * reported. Results can be written to a JSON file, and compared against a
+ * JSON file written by an earlier run:
+ *
+ *   gegl-bench --json=before.json
+ *   ... change things ...
+ *   gegl-bench --baseline=before.json --threshold=5
+ *
+ * exits with status 1 when any benchmark got slower by more than 5%.
+ * The "@ id: megabytes/second" lines printed are in the format of the other
+ * programs in perf/, so create-report.rb can chart them.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include <glib.h>
+#include <json-glib/json-glib.h>
+
+#include "gegl.h"
+
+#define BPP      16
+#define SAMPLES  150000
+
+typedef struct _Bench Bench;
+
+typedef struct
+{
+  GeglBuffer *buffer;  /* RGBA float test data, size x size */
+  gint        size;
+  gpointer    pixels;  /* room for all pixels of buffer */
+  gint       *coords;  /* SAMPLES random coordinate pairs within buffer */
+} BenchContext;
+
+/* runs @bench once, returning the number of bytes processed */
+typedef gint64 (*BenchFunc) (BenchContext *ctx,
+                             const Bench  *bench);
+
+struct _Bench
+{
+  gchar     *id;
+  BenchFunc  func;
+  gchar     *arg;    /* XML of operations and graphs */
+  gint       param;  /* sampler type, or 1 for conversions to u8 */
+  gchar     *path;   /* directory of graphs loaded from files */
+};
+
+typedef struct
+{
+  const Bench *bench;
+  gint         threads;
+  gint64       bytes;
+  gdouble     *usecs;
+  gint         n_usecs;
+  gdouble      median;
+  gdouble      p95;
+  gdouble      min;
+} BenchResult;
+
+static gint      warmup    = 1;
+static gint      repeat    = 8;
+static gint      size      = 1024;
+static gchar    *threads   = NULL;
+static gchar    *filter    = NULL;
+static gchar    *json_path = NULL;
+static gchar    *baseline  = NULL;
+static gdouble   threshold = 5.0;
+static gboolean  list      = FALSE;
+
+static const GOptionEntry entries[] =
+{
+  { "warmup", 'w', 0, G_OPTION_ARG_INT, &warmup,
+    "Untimed runs before measuring (default: 1)", "N" },
+  { "repeat", 'r', 0, G_OPTION_ARG_INT, &repeat,
+    "Timed runs of every benchmark (default: 8)", "N" },
+  { "size", 's', 0, G_OPTION_ARG_INT, &size,
+    "Width and height of the test image (default: 1024)", "N" },
+  { "threads", 't', 0, G_OPTION_ARG_STRING, &threads,
+    "Comma separated thread counts to run with (default: the configured number)", "LIST" },
+  { "filter", 'f', 0, G_OPTION_ARG_STRING, &filter,
+    "Only run benchmarks with ids containing TEXT", "TEXT" },
+  { "json", 'j', 0, G_OPTION_ARG_FILENAME, &json_path,
+    "Write the results to FILE as JSON", "FILE" },
+  { "baseline", 'b', 0, G_OPTION_ARG_FILENAME, &baseline,
+    "Compare against the results in FILE, written with --json", "FILE" },
+  { "threshold", 0, 0, G_OPTION_ARG_DOUBLE, &threshold,
+    "Percentage a median may grow by before it is a regression (default: 5)", "PERCENT" },
+  { "list", 'l', 0, G_OPTION_ARG_NONE, &list,
+    "List the benchmarks and exit", NULL },
+  { NULL }
+};
+
+static gint64
+run_graph (BenchContext *ctx,
+           const Bench  *bench)
+{
+  GeglBuffer *output = NULL;
+  GeglNode   *gegl;
+  GeglNode   *graph;
+  GeglNode   *sink;
+  gint64      bytes;
+
+  graph = gegl_node_new_from_xml (bench->arg, bench->path ? bench->path : "/");
+  if (!graph)
+    {
+      g_printerr ("gegl-bench: unable to create the graph of %s\n", bench->id);
+      return 0;
+    }
+
+  gegl  = gegl_node_new ();
+  sink  = gegl_node_new_child (gegl,
+                               "operation", "gegl:buffer-sink",
+                               "buffer", &output,
+                               NULL);
+  gegl_node_add_child (gegl, graph);
+  g_object_unref (graph);
+
+  /* operations are applied to the test image, like in the other perf
+   * programs the input is what is counted for them
+   */
+  if (bench->path == NULL)
+    {
+      GeglNode *source = gegl_node_new_child (gegl,
+                                              "operation", "gegl:buffer-source",
+                                              "buffer", ctx->buffer,
+                                              NULL);
+      gegl_node_link (source, graph);
+    }
+
+  gegl_node_link (graph, sink);
+  gegl_node_process (sink);
+
+  if (bench->path == NULL)
+    bytes = (gint64) ctx->size * ctx->size * BPP;
+  else
+    bytes = (gint64) gegl_buffer_get_pixel_count (output) * BPP;
+
+  g_object_unref (gegl);
+  g_object_unref (output);
+
+  return bytes;
+}
+
+static const Babl *
+access_format (const Bench *bench)
+{
+  return babl_format (bench->param ? "R'G'B'A u8" : "RGBA float");
+}
+
+static gint64
+run_buffer_get (BenchContext *ctx,
+                const Bench  *bench)
+{
+  gegl_buffer_get (ctx->buffer, NULL, 1.0, access_format (bench), ctx->pixels,
+                   GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+  return (gint64) ctx->size * ctx->size * BPP;
+}
+
+static gint64
+run_buffer_set (BenchContext *ctx,
+                const Bench  *bench)
+{
+  gegl_buffer_set (ctx->buffer, NULL, 0, access_format (bench), ctx->pixels,
+                   GEGL_AUTO_ROWSTRIDE);
+
+  return (gint64) ctx->size * ctx->size * BPP;
+}
+
+static gint64
+run_buffer_get_rows (BenchContext *ctx,
+                     const Bench  *bench)
+{
+  GeglRectangle row = {0, 0, ctx->size, 1};
+
+  for (row.y = 0; row.y < ctx->size; row.y++)
+    gegl_buffer_get (ctx->buffer, &row, 1.0, access_format (bench),
+                     ctx->pixels, GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+  return (gint64) ctx->size * ctx->size * BPP;
+}
+
+static gint64
+run_buffer_get_pixel (BenchContext *ctx,
+                      const Bench  *bench)
+{
+  const Babl *format = access_format (bench);
+  gint        i;
+
+  for (i = 0; i < SAMPLES; i++)
+    {
+      GeglRectangle rect = {ctx->coords[i * 2], ctx->coords[i * 2 + 1], 1, 1};
+
+      gegl_buffer_get (ctx->buffer, &rect, 1.0, format, ctx->pixels,
+                       GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+    }
+
+  return (gint64) SAMPLES * BPP;
+}
+
+static gint64
+run_buffer_set_pixel (BenchContext *ctx,
+                      const Bench  *bench)
+{
+  const Babl *format = access_format (bench);
+  gfloat      pixel[4] = {0.2, 0.4, 0.1, 0.5};
+  gint        i;
+
+  for (i = 0; i < SAMPLES; i++)
+    {
+      GeglRectangle rect = {ctx->coords[i * 2], ctx->coords[i * 2 + 1], 1, 1};
+
+      gegl_buffer_set (ctx->buffer, &rect, 0, format, pixel,
+                       GEGL_AUTO_ROWSTRIDE);
+    }
+
+  return (gint64) SAMPLES * BPP;
+}
+
+static gint64
+run_buffer_iterator (BenchContext *ctx,
+                     const Bench  *bench)
+{
+  GeglBufferIterator *iter;
+
+  iter = gegl_buffer_iterator_new (ctx->buffer, NULL, 0, access_format (bench),
+                                   GEGL_ACCESS_READWRITE, GEGL_ABYSS_NONE);
+
+  while (gegl_buffer_iterator_next (iter))
+    {
+      gfloat *data = iter->data[0];
+      gint    i;
+
+      if (bench->param)
+        continue;
+
+      for (i = 0; i < iter->length * 4; i++)
+        data[i] = 1.0f - data[i];
+    }
+
+  return (gint64) ctx->size * ctx->size * BPP;
+}
+
+static gint64
+run_buffer_copy (BenchContext *ctx,
+                 const Bench  *bench)
+{
+  GeglBuffer *copy;
+
+  copy = gegl_buffer_new (gegl_buffer_get_extent (ctx->buffer),
+                          access_format (bench));
+  gegl_buffer_copy (ctx->buffer, NULL, GEGL_ABYSS_NONE, copy, NULL);
+  g_object_unref (copy);
+
+  return (gint64) ctx->size * ctx->size * BPP;
+}
+
+static gint64
+run_sampler (BenchContext *ctx,
+             const Bench  *bench)
+{
+  GeglSampler *sampler;
+  gfloat       pixel[4];
+  gint         i;
+
+  sampler = gegl_buffer_sampler_new (ctx->buffer, babl_format ("RGBA float"),
+                                     bench->param);
+
+  for (i = 0; i < SAMPLES; i++)
+    gegl_sampler_get (sampler,
+                      ctx->coords[i * 2] + 0.37, ctx->coords[i * 2 + 1] + 0.61,
+                      NULL, pixel, GEGL_ABYSS_NONE);
+
+  g_object_unref (sampler);
+
+  return (gint64) SAMPLES * BPP;
+}
+
+static Bench builtin[] =
+{
+  { "op/gaussian-blur", run_graph,
+    "<gegl><gegl:gaussian-blur std-dev-x='0.5' std-dev-y='0.5'/></gegl>" },
+  { "op/gaussian-blur-20", run_graph,
+    "<gegl><gegl:gaussian-blur std-dev-x='20.0' std-dev-y='20.0'/></gegl>" },
+  { "op/brightness-contrast", run_graph,
+    "<gegl><gegl:brightness-contrast contrast='0.2'/></gegl>" },
+  { "op/brightness-contrast-4x", run_graph,
+    "<gegl>"
+    "<gegl:brightness-contrast contrast='0.2'/>"
+    "<gegl:brightness-contrast contrast='0.2'/>"
+    "<gegl:brightness-contrast contrast='0.2'/>"
+    "<gegl:brightness-contrast contrast='0.2'/>"
+    "</gegl>" },
+  { "op/saturation", run_graph,
+    "<gegl><gegl:saturation scale='1.25'/></gegl>" },
+  { "op/unsharp-mask", run_graph,
+    "<gegl><gegl:unsharp-mask std-dev='3.0' scale='1.2'/></gegl>" },
+  { "op/rotate", run_graph,
+    "<gegl><gegl:rotate degrees='4.0'/></gegl>" },
+  { "op/rotate-nearest", run_graph,
+    "<gegl><gegl:rotate degrees='4.0' sampler='nearest'/></gegl>" },
+  { "op/scale-ratio", run_graph,
+    "<gegl><gegl:scale-ratio x='0.4' y='0.4'/></gegl>" },
+  { "op/translate", run_graph,
+    "<gegl><gegl:translate x='10.0' y='10.0'/></gegl>" },
+
+  { "buffer/get",                run_buffer_get },
+  { "buffer/get-u8",             run_buffer_get,       NULL, 1 },
+  { "buffer/set",                run_buffer_set },
+  { "buffer/set-u8",             run_buffer_set,       NULL, 1 },
+  { "buffer/get-rows",           run_buffer_get_rows },
+  { "buffer/get-1x1",            run_buffer_get_pixel },
+  { "buffer/get-1x1-u8",         run_buffer_get_pixel, NULL, 1 },
+  { "buffer/set-1x1",            run_buffer_set_pixel },
+  { "buffer/iterator-readwrite", run_buffer_iterator },
+  { "buffer/iterator-u8",        run_buffer_iterator,  NULL, 1 },
+  { "buffer/copy",               run_buffer_copy },
+  { "buffer/copy-u8",            run_buffer_copy,      NULL, 1 },
+
+  { "sampler/nearest", run_sampler, NULL, GEGL_SAMPLER_NEAREST },
+  { "sampler/linear",  run_sampler, NULL, GEGL_SAMPLER_LINEAR },
+  { "sampler/cubic",   run_sampler, NULL, GEGL_SAMPLER_CUBIC },
+  { "sampler/nohalo",  run_sampler, NULL, GEGL_SAMPLER_NOHALO },
+  { "sampler/lohalo",  run_sampler, NULL, GEGL_SAMPLER_LOHALO },
+};
+
+static gint
+compare_doubles (gconstpointer a,
+                 gconstpointer b)
+{
+  gdouble da = *(const gdouble *) a;
+  gdouble db = *(const gdouble *) b;
+
+  return da < db ? -1 : da > db;
+}
+
+static void
+bench_run (BenchContext *ctx,
+           BenchResult  *result)
+{
+  gint i;
+
+  for (i = 0; i < warmup; i++)
+    result->bench->func (ctx, result->bench);
+
+  result->usecs   = g_new (gdouble, repeat);
+  result->n_usecs = repeat;
+
+  for (i = 0; i < repeat; i++)
+    {
+      gint64 start = g_get_monotonic_time ();
+
+      result->bytes    = result->bench->func (ctx, result->bench);
+      result->usecs[i] = g_get_monotonic_time () - start;
+    }
+
+  /* keep the samples in run order for the JSON output */
+  {
+    gdouble *sorted = g_memdup (result->usecs, repeat * sizeof (gdouble));
+
+    qsort (sorted, repeat, sizeof (gdouble), compare_doubles);
+
+    if (repeat % 2)
+      result->median = sorted[repeat / 2];
+    else
+      result->median = (sorted[repeat / 2 - 1] + sorted[repeat / 2]) / 2.0;
+
+    result->p95 = sorted[(gint) ceil (0.95 * repeat) - 1];
+    result->min = sorted[0];
+
+    g_free (sorted);
+  }
+}
+
+static gchar *
+result_key (const gchar *id,
+            gint         threads)
+{
+  return g_strdup_printf ("%s x%i", id, threads);
+}
+
+static void
+print_result (const BenchResult *result)
+{
+  gchar *key = result_key (result->bench->id, result->threads);
+
+  g_print ("@ %s: %.2f megabytes/second, median %.3f ms, p95 %.3f ms\n",
+           key,
+           (result->bytes / 1024.0 / 1024.0) / (MAX (result->median, 1.0) / 1000000.0),
+           result->median / 1000.0, result->p95 / 1000.0);
+
+  g_free (key);
+}
+
+static gboolean
+write_json (GPtrArray   *results,
+            const gchar *path)
+{
+  JsonBuilder   *builder = json_builder_new ();
+  JsonGenerator *generator;
+  JsonNode      *root;
+  GError        *error = NULL;
+  gchar         *version;
+  gint           major, minor, micro;
+  guint          i;
+  gint           j;
+
+  gegl_get_version (&major, &minor, &micro);
+  version = g_strdup_printf ("%i.%i.%i", major, minor, micro);
+
+  json_builder_begin_object (builder);
+  json_builder_set_member_name (builder, "gegl-version");
+  json_builder_add_string_value (builder, version);
+  json_builder_set_member_name (builder, "size");
+  json_builder_add_int_value (builder, size);
+  json_builder_set_member_name (builder, "warmup");
+  json_builder_add_int_value (builder, warmup);
+  json_builder_set_member_name (builder, "repeat");
+  json_builder_add_int_value (builder, repeat);
+
+  json_builder_set_member_name (builder, "results");
+  json_builder_begin_array (builder);
+
+  for (i = 0; i < results->len; i++)
+    {
+      BenchResult *result = g_ptr_array_index (results, i);
+
+      json_builder_begin_object (builder);
+      json_builder_set_member_name (builder, "id");
+      json_builder_add_string_value (builder, result->bench->id);
+      json_builder_set_member_name (builder, "threads");
+      json_builder_add_int_value (builder, result->threads);
+      json_builder_set_member_name (builder, "bytes");
+      json_builder_add_int_value (builder, result->bytes);
+      json_builder_set_member_name (builder, "median-us");
+      json_builder_add_double_value (builder, result->median);
+      json_builder_set_member_name (builder, "p95-us");
+      json_builder_add_double_value (builder, result->p95);
+      json_builder_set_member_name (builder, "min-us");
+      json_builder_add_double_value (builder, result->min);
+
+      json_builder_set_member_name (builder, "samples-us");
+      json_builder_begin_array (builder);
+      for (j = 0; j < result->n_usecs; j++)
+        json_builder_add_double_value (builder, result->usecs[j]);
+      json_builder_end_array (builder);
+
+      json_builder_end_object (builder);
+    }
+
+  json_builder_end_array (builder);
+  json_builder_end_object (builder);
+
+  root      = json_builder_get_root (builder);
+  generator = json_generator_new ();
+  json_generator_set_root (generator, root);
+  json_generator_set_pretty (generator, TRUE);
+
+  if (!json_generator_to_file (generator, path, &error))
+    {
+      g_printerr ("gegl-bench: unable to write %s: %s\n", path, error->message);
+      g_error_free (error);
+    }
+
+  json_node_free (root);
+  g_object_unref (generator);
+  g_object_unref (builder);
+  g_free (version);
+
+  return error == NULL;
+}
+
+/* returns the medians of the results in @path, by result_key () */
+static GHashTable *
+read_baseline (const gchar *path)
+{
+  JsonParser *parser = json_parser_new ();
+  GHashTable *medians;
+  GError     *error  = NULL;
+  JsonObject *root;
+  JsonArray  *array;
+  guint       i;
+
+  if (!json_parser_load_from_file (parser, path, &error))
+    {
+      g_printerr ("gegl-bench: unable to read %s: %s\n", path, error->message);
+      g_error_free (error);
+      g_object_unref (parser);
+      return NULL;
+    }
+
+  medians = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+
+  root  = json_node_get_object (json_parser_get_root (parser));
+  array = json_object_get_array_member (root, "results");
+
+  for (i = 0; array && i < json_array_get_length (array); i++)
+    {
+      JsonObject *result = json_array_get_object_element (array, i);
+      gdouble    *median = g_new (gdouble, 1);
+
+      *median = json_object_get_double_member (result, "median-us");
+      g_hash_table_insert (medians,
+                           result_key (json_object_get_string_member (result, "id"),
+                                       json_object_get_int_member (result, "threads")),
+                           median);
+    }
+
+  g_object_unref (parser);
+
+  return medians;
+}
+
+/* prints how the results changed from @medians, returning the number of
+ * results that got slower by more than the threshold
+ */
+static gint
+compare_baseline (GPtrArray  *results,
+                  GHashTable *medians)
+{
+  gint  regressions = 0;
+  guint i;
+
+  g_print ("\ncompared to %s:\n", baseline);
+
+  for (i = 0; i < results->len; i++)
+    {
+      BenchResult *result = g_ptr_array_index (results, i);
+      gchar       *key    = result_key (result->bench->id, result->threads);
+      gdouble     *before = g_hash_table_lookup (medians, key);
+
+      if (before && *before > 0.0)
+        {
+          gdouble change = (result->median - *before) / *before * 100.0;
+
+          g_print ("  %-40s %10.3f ms -> %10.3f ms %+7.1f%%%s\n", key,
+                   *before / 1000.0, result->median / 1000.0, change,
+                   change > threshold ? "  REGRESSION" :
+                   change < -threshold ? "  improved" : "");
+
+          if (change > threshold)
+            regressions++;
+        }
+      else
+        {
+          g_print ("  %-40s %10s    %10.3f ms\n", key, "-",
+                   result->median / 1000.0);
+        }
+
+      g_free (key);
+    }
+
+  return regressions;
+}
+
+static GArray *
+parse_threads (void)
+{
+  GArray *counts = g_array_new (FALSE, FALSE, sizeof (gint));
+
+  if (threads)
+    {
+      gchar **strs = g_strsplit (threads, ",", -1);
+      gint    i;
+
+      for (i = 0; strs[i]; i++)
+        {
+          gint count = atoi (strs[i]);
+
+          if (count > 0)
+            g_array_append_val (counts, count);
+        }
+
+      g_strfreev (strs);
+    }
+
+  if (counts->len == 0)
+    {
+      gint count;
+
+      g_object_get (gegl_config (), "threads", &count, NULL);
+      g_array_append_val (counts, count);
+    }
+
+  return counts;
+}
+
+static GeglBuffer *
+test_buffer (gint width,
+             gint height)
+{
+  GeglBuffer *buffer;
+  gfloat     *buf = g_new (gfloat, width * height * 4);
+  gint        i;
+
+  buffer = gegl_buffer_new (GEGL_RECTANGLE (0, 0, width, height),
+                            babl_format ("RGBA float"));
+  for (i = 0; i < width * height * 4; i++)
+    buf[i] = g_random_double_range (-0.5, 2.0);
+  gegl_buffer_set (buffer, NULL, 0, babl_format ("RGBA float"), buf,
+                   GEGL_AUTO_ROWSTRIDE);
+
+  g_free (buf);
+  return buffer;
+}
+
+gint
+main (gint    argc,
+      gchar **argv)
+{
+  GOptionContext *context;
+  GError         *error   = NULL;
+  BenchContext    ctx;
+  GPtrArray      *benches = g_ptr_array_new ();
+  GPtrArray      *results = g_ptr_array_new ();
+  GArray         *counts;
+  gint            status  = 0;
+  guint           i, t;
+
+  context = g_option_context_new ("[GRAPH.xml...] - benchmark GEGL");
+  g_option_context_add_main_entries (context, entries, NULL);
+  g_option_context_add_group (context, gegl_get_option_group ());
+
+  if (!g_option_context_parse (context, &argc, &argv, &error))
+    {
+      g_printerr ("gegl-bench: %s\n", error->message);
+      g_error_free (error);
+      return 2;
+    }
+  g_option_context_free (context);
+
+  warmup = MAX (warmup, 0);
+  repeat = MAX (repeat, 1);
+  size   = MAX (size, 16);
+
+  for (i = 0; i < G_N_ELEMENTS (builtin); i++)
+    g_ptr_array_add (benches, &builtin[i]);
+
+  for (i = 1; i < argc; i++)
+    {
+      Bench *bench = g_new0 (Bench, 1);
+      gchar *base  = g_path_get_basename (argv[i]);
+      gchar *xml;
+
+      if (!g_file_get_contents (argv[i], &xml, NULL, &error))
+        {
+          g_printerr ("gegl-bench: %s\n", error->message);
+          g_clear_error (&error);
+          g_free (base);
+          g_free (bench);
+          status = 2;
+          continue;
+        }
+
+      if (g_str_has_suffix (base, ".xml"))
+        base[strlen (base) - 4] = '\0';
+
+      bench->id   = g_strconcat ("graph/", base, NULL);
+      bench->func = run_graph;
+      bench->arg  = xml;
+      bench->path = g_path_get_dirname (argv[i]);
+      g_ptr_array_add (benches, bench);
+
+      g_free (base);
+    }
+
+  if (list)
+    {
+      for (i = 0; i < benches->len; i++)
+        g_print ("%s\n", ((Bench *) g_ptr_array_index (benches, i))->id);
+
+      gegl_exit ();
+      return status;
+    }
+
+  ctx.size   = size;
+  ctx.buffer = test_buffer (size, size);
+  ctx.pixels = g_malloc0 ((gsize) size * size * BPP);
+  ctx.coords = g_new (gint, SAMPLES * 2);
+
+  for (i = 0; i < SAMPLES; i++)
+    {
+      ctx.coords[i * 2]     = g_random_int_range (0, size);
+      ctx.coords[i * 2 + 1] = g_random_int_range (0, size);
+    }
+
+  counts = parse_threads ();
+
+  for (t = 0; t < counts->len; t++)
+    {
+      g_object_set (gegl_config (),
+                    "threads", g_array_index (counts, gint, t),
+                    NULL);
+
+      for (i = 0; i < benches->len; i++)
+        {
+          const Bench *bench = g_ptr_array_index (benches, i);
+          BenchResult *result;
+
+          if (filter && !strstr (bench->id, filter))
+            continue;
+
+          result          = g_new0 (BenchResult, 1);
+          result->bench   = bench;
+          result->threads = g_array_index (counts, gint, t);
+
+          bench_run (&ctx, result);
+          print_result (result);
+
+          g_ptr_array_add (results, result);
+        }
+    }
+
+  if (json_path && !write_json (results, json_path))
+    status = 2;
+
+  if (baseline)
+    {
+      GHashTable *medians = read_baseline (baseline);
+
+      if (medians)
+        {
+          if (compare_baseline (results, medians) > 0)
+            status = MAX (status, 1);
+
+          g_hash_table_unref (medians);
+        }
+      else
+        {
+          status = 2;
+        }
+    }
+
+  for (i = 0; i < results->len; i++)
+    {
+      BenchResult *result = g_ptr_array_index (results, i);
+
+      g_free (result->usecs);
+      g_free (result);
+    }
+  for (i = G_N_ELEMENTS (builtin); i < benches->len; i++)
+    {
+      Bench *bench = g_ptr_array_index (benches, i);
+
+      g_free (bench->id);
+      g_free (bench->arg);
+      g_free (bench->path);
+      g_free (bench);
+    }
+
+  g_ptr_array_free (results, TRUE);
+  g_ptr_array_free (benches, TRUE);
+  g_array_free (counts, TRUE);
+  g_free (ctx.coords);
+  g_free (ctx.pixels);
+  g_object_unref (ctx.buffer);
+
+  gegl_exit ();
+
+  return status;
+}
@@ -0,0 +1,130 @@
+#include "test-common.h"
+#include "gegl-algorithms.h"
+
+#define SIZE       1024
+#define ITERATIONS 32
+
+/* Measures the 2x2 downscale used for mipmap levels, and the boxfilter used
+ * by gegl_buffer_get () at scales between 0.5 and 2, with the scalar
+ * versions and with the versions gegl picks for the CPU.
+ */
+
+typedef void (* Downscale2x2Func) (gint    bpp,
+                                   gint    src_width,
+                                   gint    src_height,
+                                   guchar *src_data,
+                                   gint    src_rowstride,
+                                   guchar *dst_data,
+                                   gint    dst_rowstride);
+
+typedef void (* BoxfilterFunc) (guchar              *dest_buf,
+                                const guchar        *source_buf,
+                                const GeglRectangle *dst_rect,
+                                const GeglRectangle *src_rect,
+                                gint                 s_rowstride,
+                                gdouble              scale,
+                                gint                 bpp,
+                                gint                 d_rowstride);
+
+static guchar *
+random_pixels (const Babl *format,
+               gint        n_pixels)
+{
+  const gint  bpp  = babl_format_get_bytes_per_pixel (format);
+  guchar     *data = g_malloc (n_pixels * bpp);
+  gint        i;
+
+  if (babl_format_get_type (format, 0) == babl_type ("float"))
+    {
+      for (i = 0; i < n_pixels * bpp / 4; i++)
+        ((gfloat *) data)[i] = g_random_double ();
+    }
+  else
+    {
+      for (i = 0; i < n_pixels * bpp; i++)
+        data[i] = g_random_int_range (0, 256);
+    }
+
+  return data;
+}
+
+static void
+bench_downscale (const gchar      *format_name,
+                 Downscale2x2Func  scalar)
+{
+  const Babl *format = babl_format (format_name);
+  const gint  bpp    = babl_format_get_bytes_per_pixel (format);
+  guchar     *src    = random_pixels (format, SIZE * SIZE);
+  guchar     *dst    = g_malloc (SIZE * SIZE * bpp / 4);
+  gchar      *id;
+  gint        i;
+
+  id = g_strdup_printf ("downscale-2x2 %s scalar", format_name);
+  test_start ();
+  for (i = 0; i < ITERATIONS; i++)
+    scalar (bpp, SIZE, SIZE, src, SIZE * bpp, dst, SIZE / 2 * bpp);
+  test_end (id, (glong) ITERATIONS * SIZE * SIZE * bpp);
+  g_free (id);
+
+  id = g_strdup_printf ("downscale-2x2 %s", format_name);
+  test_start ();
+  for (i = 0; i < ITERATIONS; i++)
+    gegl_downscale_2x2 (format, SIZE, SIZE, src, SIZE * bpp, dst, SIZE / 2 * bpp);
+  test_end (id, (glong) ITERATIONS * SIZE * SIZE * bpp);
+  g_free (id);
+
+  g_free (src);
+  g_free (dst);
+}
+
+static void
+bench_boxfilter (const gchar   *format_name,
+                 BoxfilterFunc  scalar)
+{
+  const Babl    *format   = babl_format (format_name);
+  const gint     bpp      = babl_format_get_bytes_per_pixel (format);
+  const gdouble  scale    = 0.75;
+  GeglRectangle  src_rect = {-1, -1, SIZE + 2, SIZE + 2};
+  GeglRectangle  dst_rect = {0, 0, SIZE * scale, SIZE * scale};
+  guchar        *src      = random_pixels (format, (SIZE + 2) * (SIZE + 2));
+  guchar        *dst      = g_malloc (dst_rect.width * dst_rect.height * bpp);
+  gchar         *id;
+  gint           i;
+
+  id = g_strdup_printf ("boxfilter %s scalar", format_name);
+  test_start ();
+  for (i = 0; i < ITERATIONS; i++)
+    scalar (dst, src, &dst_rect, &src_rect, (SIZE + 2) * bpp, scale,
+            bpp, dst_rect.width * bpp);
+  test_end (id, (glong) ITERATIONS * SIZE * SIZE * bpp);
+  g_free (id);
+
+  id = g_strdup_printf ("boxfilter %s", format_name);
+  test_start ();
+  for (i = 0; i < ITERATIONS; i++)
+    gegl_resample_boxfilter (dst, src, &dst_rect, &src_rect, (SIZE + 2) * bpp,
+                             scale, format, dst_rect.width * bpp);
+  test_end (id, (glong) ITERATIONS * SIZE * SIZE * bpp);
+  g_free (id);
+
+  g_free (src);
+  g_free (dst);
+}
+
+gint
+main (gint    argc,
+      gchar **argv)
+{
+  gegl_init (NULL, NULL);
+
+  bench_downscale ("RaGaBaA float", gegl_downscale_2x2_float);
+  bench_downscale ("RGBA u16",      gegl_downscale_2x2_u16);
+  bench_downscale ("R'G'B'A u8",    gegl_downscale_2x2_u8);
+
+  bench_boxfilter ("RaGaBaA float", gegl_resample_boxfilter_float);
+  bench_boxfilter ("RGBA u16",      gegl_resample_boxfilter_u16);
+  bench_boxfilter ("R'G'B'A u8",    gegl_resample_boxfilter_u8);
+
+  gegl_exit ();
+  return 0;
+}
@@ -0,0 +1,70 @@
+#include "test-common.h"
+
+#define SIZE       2048
+#define ITERATIONS 4
+
+/* Renders a chain of four point operations over a float buffer, processed
+ * operation by operation into intermediate buffers, and as one fused run.
+ */
+
+static void
+render_chain (GeglBuffer  *buffer,
+              gfloat      *pixels,
+              gboolean     fused,
+              const gchar *id)
+{
+  GeglRectangle roi = {0, 0, SIZE, SIZE};
+  gint          i;
+
+  g_object_set (gegl_config (), "point-fusion", fused, NULL);
+
+  test_start ();
+  for (i = 0; i < ITERATIONS; i++)
+    {
+      GeglNode *gegl, *source, *contrast, *saturation, *levels, *invert;
+
+      gegl       = gegl_node_new ();
+      source     = gegl_node_new_child (gegl, "operation", "gegl:buffer-source",
+                                        "buffer", buffer, NULL);
+      contrast   = gegl_node_new_child (gegl, "operation", "gegl:brightness-contrast",
+                                        "contrast", 1.2 + i * 0.1,
+                                        NULL);
+      saturation = gegl_node_new_child (gegl, "operation", "gegl:saturation",
+                                        "scale", 0.8,
+                                        NULL);
+      levels     = gegl_node_new_child (gegl, "operation", "gegl:levels",
+                                        "in-low", 0.1,
+                                        NULL);
+      invert     = gegl_node_new_child (gegl, "operation", "gegl:invert-linear",
+                                        NULL);
+      gegl_node_link_many (source, contrast, saturation, levels, invert, NULL);
+
+      gegl_node_blit (invert, 1.0, &roi, babl_format ("RGBA float"), pixels,
+                      GEGL_AUTO_ROWSTRIDE, GEGL_BLIT_DEFAULT);
+
+      g_object_unref (gegl);
+    }
+  test_end (id, (glong) ITERATIONS * SIZE * SIZE * 16);
+}
+
+gint
+main (gint    argc,
+      gchar **argv)
+{
+  GeglBuffer *buffer;
+  gfloat     *pixels;
+
+  gegl_init (&argc, &argv);
+
+  buffer = test_buffer (SIZE, SIZE, babl_format ("RGBA float"));
+  pixels = g_new (gfloat, SIZE * SIZE * 4);
+
+  render_chain (buffer, pixels, FALSE, "point-chain");
+  render_chain (buffer, pixels, TRUE,  "point-chain fused");
+
+  g_free (pixels);
+  g_object_unref (buffer);
+  gegl_exit ();
+
+  return 0;
+}
@@ -0,0 +1,48 @@
+#include "test-common.h"
+
+#define SIZE       2048
+#define ITERATIONS 4
+
+/* Renders a point operation over a float buffer into the cache of its node
+ * with a GeglProcessor, which is bound by memory bandwidth.
+ */
+
+gint
+main (gint    argc,
+      gchar **argv)
+{
+  GeglBuffer    *buffer;
+  GeglRectangle  roi = {0, 0, SIZE, SIZE};
+  gint           i;
+
+  gegl_init (&argc, &argv);
+
+  buffer = test_buffer (SIZE, SIZE, babl_format ("RGBA float"));
+
+  test_start ();
+  for (i = 0; i < ITERATIONS; i++)
+    {
+      GeglNode      *gegl, *source, *node;
+      GeglProcessor *processor;
+
+      gegl   = gegl_node_new ();
+      source = gegl_node_new_child (gegl, "operation", "gegl:buffer-source",
+                                    "buffer", buffer, NULL);
+      node   = gegl_node_new_child (gegl, "operation", "gegl:brightness-contrast",
+                                    "contrast", 1.2 + i * 0.1,
+                                    NULL);
+      gegl_node_link (source, node);
+
+      processor = gegl_node_new_processor (node, &roi);
+      while (gegl_processor_work (processor, NULL));
+
+      g_object_unref (processor);
+      g_object_unref (gegl);
+    }
+  test_end ("processor", (glong) ITERATIONS * SIZE * SIZE * 16);
+
+  g_object_unref (buffer);
+  gegl_exit ();
+
+  return 0;
+}
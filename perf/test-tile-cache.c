@@ -0,0 +1,96 @@
+#include "test-common.h"
+
+#define BPP        16
+#define SIZE       1024
+#define ITERATIONS 64
+#define MAX_JOBS   8
+
+/* Reads single rows spanning all tiles of a buffer from several threads at
+ * once, with the buffer contents held in the tile cache, to measure the
+ * throughput of tile cache lookups under contention.
+ */
+
+typedef struct
+{
+  GeglBuffer *buffer;
+  gint        offset;
+} Job;
+
+static gpointer
+read_rows (gpointer data)
+{
+  Job           *job = data;
+  GeglRectangle  row = {0, 0, SIZE, 1};
+  gfloat        *buf = g_malloc (SIZE * BPP);
+  gint           i;
+
+  for (i = 0; i < ITERATIONS * SIZE / 16; i++)
+    {
+      row.y = (job->offset + i * 17) % SIZE;
+      gegl_buffer_get (job->buffer, &row, 1.0, NULL, buf,
+                       GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+    }
+
+  g_free (buf);
+  return NULL;
+}
+
+static void
+run (const gchar *id,
+     GeglBuffer **buffers,
+     gint         n_jobs)
+{
+  GThread *threads[MAX_JOBS];
+  Job      jobs[MAX_JOBS];
+  gint     i;
+
+  for (i = 0; i < n_jobs; i++)
+    {
+      jobs[i].buffer = buffers[i];
+      jobs[i].offset = i * 64;
+    }
+
+  test_start ();
+  for (i = 0; i < n_jobs; i++)
+    threads[i] = g_thread_new (NULL, read_rows, &jobs[i]);
+  for (i = 0; i < n_jobs; i++)
+    g_thread_join (threads[i]);
+  test_end (id, (glong) n_jobs * ITERATIONS * SIZE / 16 * SIZE * BPP);
+}
+
+gint
+main (gint    argc,
+      gchar **argv)
+{
+  GeglBuffer *buffers[MAX_JOBS];
+  GeglBuffer *shared[MAX_JOBS];
+  gint        n_jobs;
+  gint        i;
+
+  gegl_init (NULL, NULL);
+
+  for (i = 0; i < MAX_JOBS; i++)
+    {
+      buffers[i] = test_buffer (SIZE, SIZE, babl_format ("RGBA float"));
+      shared[i]  = buffers[0];
+    }
+
+  for (n_jobs = 1; n_jobs <= MAX_JOBS; n_jobs *= 2)
+    {
+      gchar *id;
+
+      id = g_strdup_printf ("tile-cache %i private buffers", n_jobs);
+      run (id, buffers, n_jobs);
+      g_free (id);
+
+      id = g_strdup_printf ("tile-cache %i shared buffer", n_jobs);
+      run (id, shared, n_jobs);
+      g_free (id);
+    }
+
+  for (i = 0; i < MAX_JOBS; i++)
+    g_object_unref (buffers[i]);
+
+  gegl_exit ();
+  return 0;
+}
@@ -0,0 +1,139 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+#include <string.h>
+
+#include "gegl.h"
+
+#define SUCCESS  0
+#define FAILURE -1
+
+#define WIDTH  1000
+#define HEIGHT 700
+
+static guint16 *
+get_pixels (GeglBuffer *buffer)
+{
+  guint16 *pixels = g_new (guint16, WIDTH * HEIGHT * 4);
+
+  gegl_buffer_get (buffer, GEGL_RECTANGLE (0, 0, WIDTH, HEIGHT), 1.0,
+                   babl_format ("RGBA u16"), pixels,
+                   GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+  return pixels;
+}
+
+static gboolean
+inside (const GeglRectangle *rect,
+        gint                 x,
+        gint                 y)
+{
+  return x >= rect->x && x < rect->x + rect->width &&
+         y >= rect->y && y < rect->y + rect->height;
+}
+
+/* Copy with a format conversion, set a color and clear rectangles that
+ * don't line up with the tiles, with several threads, and check every
+ * pixel of the result.
+ */
+int
+main (int    argc,
+      char **argv)
+{
+  GeglBuffer    *src;
+  GeglBuffer    *dst;
+  GeglBuffer    *sub;
+  GeglColor     *color;
+  GeglRectangle  copy_rect  = {40, 30, 900, 650};
+  GeglRectangle  color_rect = {100, 100, 600, 400};
+  GeglRectangle  clear_rect = {150, 120, 400, 300};
+  GeglRectangle  sub_rect   = {0, 0, 100, 50};
+  guint16       *pattern;
+  guint16       *pixels;
+  gint           result = SUCCESS;
+  gint           x, y, c;
+
+  gegl_init (&argc, &argv);
+  g_object_set (gegl_config (), "threads", 4, NULL);
+
+  src     = gegl_buffer_new (GEGL_RECTANGLE (0, 0, WIDTH, HEIGHT),
+                             babl_format ("RGBA u16"));
+  pattern = g_new (guint16, WIDTH * HEIGHT * 4);
+  for (y = 0; y < HEIGHT; y++)
+    for (x = 0; x < WIDTH; x++)
+      for (c = 0; c < 4; c++)
+        pattern[(y * WIDTH + x) * 4 + c] = (x * 61 + y * 17 + c * 1000) & 0xffff;
+  gegl_buffer_set (src, NULL, 0, babl_format ("RGBA u16"), pattern,
+                   GEGL_AUTO_ROWSTRIDE);
+
+  dst = gegl_buffer_new (GEGL_RECTANGLE (0, 0, WIDTH, HEIGHT),
+                         babl_format ("RGBA float"));
+
+  gegl_buffer_copy (src, GEGL_RECTANGLE (13, 7, 900, 650), GEGL_ABYSS_NONE,
+                    dst, &copy_rect);
+
+  color = gegl_color_new ("rgba(1.0, 0.0, 0.0, 1.0)");
+  gegl_buffer_set_color (dst, &color_rect, color);
+  g_object_unref (color);
+
+  gegl_buffer_clear (dst, &clear_rect);
+
+  /* clearing a sub-buffer must stay within its extent, even when the
+   * rectangle covers whole tiles
+   */
+  sub = gegl_buffer_create_sub_buffer (dst, &sub_rect);
+  gegl_buffer_clear (sub, GEGL_RECTANGLE (0, 0, 300, 200));
+  g_object_unref (sub);
+
+  pixels = get_pixels (dst);
+
+  for (y = 0; y < HEIGHT && result == SUCCESS; y++)
+    for (x = 0; x < WIDTH && result == SUCCESS; x++)
+      {
+        const guint16 *pixel = pixels + (y * WIDTH + x) * 4;
+        guint16        expected[4] = { 0, 0, 0, 0 };
+
+        if (inside (&sub_rect, x, y) || inside (&clear_rect, x, y))
+          ;
+        else if (inside (&color_rect, x, y))
+          {
+            expected[0] = 0xffff;
+            expected[3] = 0xffff;
+          }
+        else if (inside (&copy_rect, x, y))
+          {
+            memcpy (expected,
+                    pattern + ((y - 23) * WIDTH + (x - 27)) * 4,
+                    sizeof (expected));
+          }
+
+        if (memcmp (pixel, expected, sizeof (expected)))
+          {
+            g_printerr ("pixel %i,%i is %i,%i,%i,%i expected %i,%i,%i,%i\n",
+                        x, y, pixel[0], pixel[1], pixel[2], pixel[3],
+                        expected[0], expected[1], expected[2], expected[3]);
+            result = FAILURE;
+          }
+      }
+
+  g_free (pixels);
+  g_free (pattern);
+  g_object_unref (dst);
+  g_object_unref (src);
+
+  gegl_exit ();
+
+  return result;
+}
@@ -0,0 +1,281 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <math.h>
+#include <glib/gstdio.h>
+
+#include "gegl.h"
+#include "gegl-buffer-index.h"
+#include "gegl-buffer-codec.h"
+
+#define SUCCESS  0
+#define FAILURE -1
+
+#define SIZE 512
+
+/* Compress a few kinds of data, and make sure corrupt data is rejected
+ * instead of overflowing the output.
+ */
+static gboolean
+test_codec (void)
+{
+  gint     size    = 64 * 64 * 16;
+  guchar  *data    = g_malloc (size);
+  guchar  *scratch = g_malloc (size * 2);
+  guchar  *out     = g_malloc (size);
+  gfloat  *floats  = (gfloat *) data;
+  gboolean success = TRUE;
+  gint     pattern;
+  gint     i;
+
+  for (pattern = 0; pattern < 3; pattern++)
+    {
+      GeglBufferTableEntry  entry = { 0, };
+      const guchar         *stored;
+
+      for (i = 0; i < size / 4; i++)
+        switch (pattern)
+          {
+            case 0: floats[i] = 0.5f; break;
+            case 1: floats[i] = sinf (i * 0.001f); break;
+            case 2: floats[i] = g_random_double (); break;
+          }
+
+      stored = gegl_buffer_codec_encode (&entry, data, size, 4, scratch);
+
+      if (!gegl_buffer_codec_decode (&entry, stored, out, size) ||
+          memcmp (data, out, size))
+        {
+          g_printerr ("pattern %i didn't survive compression\n", pattern);
+          success = FALSE;
+        }
+
+      if (pattern < 2 && entry.codec != GEGL_TILE_CODEC_LZ)
+        {
+          g_printerr ("pattern %i wasn't compressed\n", pattern);
+          success = FALSE;
+        }
+
+      if (entry.codec == GEGL_TILE_CODEC_LZ)
+        {
+          memcpy (out, stored, entry.size);
+          for (i = 0; i < entry.size; i += 7)
+            out[i] ^= 0x5a;
+          /* the result doesn't matter, as long as it stays in bounds */
+          gegl_buffer_codec_lz_decompress (out, entry.size, scratch, size);
+        }
+    }
+
+  g_free (data);
+  g_free (scratch);
+  g_free (out);
+
+  return success;
+}
+
+static gboolean
+buffers_equal (GeglBuffer *a,
+               GeglBuffer *b,
+               gdouble     scale)
+{
+  gint     size     = SIZE * scale;
+  gfloat  *pixels_a = g_new (gfloat, size * size * 4);
+  gfloat  *pixels_b = g_new (gfloat, size * size * 4);
+  gboolean equal;
+
+  gegl_buffer_get (a, GEGL_RECTANGLE (0, 0, size, size), scale,
+                   babl_format ("RGBA float"), pixels_a,
+                   GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+  gegl_buffer_get (b, GEGL_RECTANGLE (0, 0, size, size), scale,
+                   babl_format ("RGBA float"), pixels_b,
+                   GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+  equal = ! memcmp (pixels_a, pixels_b, size * size * 4 * sizeof (gfloat));
+
+  g_free (pixels_a);
+  g_free (pixels_b);
+
+  return equal;
+}
+
+/* Save a smooth float buffer along with a mipmap level, and check that
+ * it is stored compressed and loads back unchanged.
+ */
+static gboolean
+test_save_load (void)
+{
+  GeglBuffer       *buffer;
+  GeglBuffer       *loaded;
+  GeglBuffer       *opened;
+  GeglBufferItem   *header;
+  GStatBuf          st;
+  gfloat           *pixels;
+  gchar            *path;
+  gboolean          success = TRUE;
+  gint              fd;
+  gint              x, y;
+
+  path = g_build_filename (g_get_tmp_dir (), "test-buffer-file-format.gegl",
+                           NULL);
+
+  buffer = gegl_buffer_new (GEGL_RECTANGLE (0, 0, SIZE, SIZE),
+                            babl_format ("RGBA float"));
+  pixels = g_new (gfloat, SIZE * SIZE * 4);
+  for (y = 0; y < SIZE; y++)
+    for (x = 0; x < SIZE; x++)
+      {
+        gfloat *pixel = pixels + (y * SIZE + x) * 4;
+
+        pixel[0] = x / (gfloat) SIZE;
+        pixel[1] = y / (gfloat) SIZE;
+        pixel[2] = 0.25f;
+        pixel[3] = 1.0f;
+      }
+  gegl_buffer_set (buffer, NULL, 0, babl_format ("RGBA float"), pixels,
+                   GEGL_AUTO_ROWSTRIDE);
+  g_free (pixels);
+
+  /* compute the first mipmap level, so it gets stored */
+  buffers_equal (buffer, buffer, 0.5);
+
+  gegl_buffer_save (buffer, path, NULL);
+
+  fd = g_open (path, O_RDONLY, 0);
+  header = gegl_buffer_read_header (fd, NULL);
+  if (gegl_buffer_header_get_rev (header) != GEGL_FILE_SPEC_REV_TABLE)
+    {
+      g_printerr ("the saved file has revision %i\n",
+                  gegl_buffer_header_get_rev (header));
+      success = FALSE;
+    }
+  g_free (header);
+  close (fd);
+
+  if (g_stat (path, &st) != 0 ||
+      st.st_size > SIZE * SIZE * 4 * sizeof (gfloat) / 3)
+    {
+      g_printerr ("the saved file is %i bytes\n", (gint) st.st_size);
+      success = FALSE;
+    }
+
+  loaded = gegl_buffer_load (path);
+
+  if (!buffers_equal (buffer, loaded, 1.0))
+    {
+      g_printerr ("the loaded buffer differs\n");
+      success = FALSE;
+    }
+
+  if (!buffers_equal (buffer, loaded, 0.5))
+    {
+      g_printerr ("the loaded mipmap level differs\n");
+      success = FALSE;
+    }
+
+  g_object_unref (loaded);
+
+  /* gegl_buffer_open () reads the file too, and writes changes back to
+   * it, keeping its revision
+   */
+  opened = gegl_buffer_open (path);
+
+  if (!gegl_rectangle_equal (gegl_buffer_get_extent (opened),
+                             gegl_buffer_get_extent (buffer)) ||
+      !buffers_equal (buffer, opened, 1.0) ||
+      !buffers_equal (buffer, opened, 0.5))
+    {
+      g_printerr ("the opened buffer differs\n");
+      success = FALSE;
+    }
+
+  {
+    GeglRectangle patch = { 37, 53, 100, 120 };
+    gfloat        color[4] = { 1.0f, 0.0f, 0.5f, 1.0f };
+
+    pixels = g_new (gfloat, patch.width * patch.height * 4);
+    for (x = 0; x < patch.width * patch.height; x++)
+      memcpy (pixels + x * 4, color, sizeof (color));
+
+    gegl_buffer_set (buffer, &patch, 0, babl_format ("RGBA float"), pixels,
+                     GEGL_AUTO_ROWSTRIDE);
+    gegl_buffer_set (opened, &patch, 0, babl_format ("RGBA float"), pixels,
+                     GEGL_AUTO_ROWSTRIDE);
+    g_free (pixels);
+  }
+
+  g_object_unref (opened);
+
+  fd = g_open (path, O_RDONLY, 0);
+  header = gegl_buffer_read_header (fd, NULL);
+  if (gegl_buffer_header_get_rev (header) != GEGL_FILE_SPEC_REV_TABLE)
+    {
+      g_printerr ("the modified file has revision %i\n",
+                  gegl_buffer_header_get_rev (header));
+      success = FALSE;
+    }
+  g_free (header);
+  close (fd);
+
+  opened = gegl_buffer_open (path);
+
+  if (!buffers_equal (buffer, opened, 1.0) ||
+      !buffers_equal (buffer, opened, 0.5))
+    {
+      g_printerr ("changes to the opened buffer weren't written to the file\n");
+      success = FALSE;
+    }
+
+  g_object_unref (opened);
+
+  loaded = gegl_buffer_load (path);
+
+  if (!buffers_equal (buffer, loaded, 1.0) ||
+      !buffers_equal (buffer, loaded, 0.5))
+    {
+      g_printerr ("the modified file loads differently\n");
+      success = FALSE;
+    }
+
+  g_object_unref (loaded);
+  g_object_unref (buffer);
+
+  g_unlink (path);
+  g_free (path);
+
+  return success;
+}
+
+int
+main (int    argc,
+      char **argv)
+{
+  gint result = SUCCESS;
+
+  gegl_init (&argc, &argv);
+
+  if (!test_codec ())
+    result = FAILURE;
+
+  if (!test_save_load ())
+    result = FAILURE;
+
+  gegl_exit ();
+
+  return result;
+}
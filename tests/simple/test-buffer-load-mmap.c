@@ -0,0 +1,127 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+#include <string.h>
+#include <glib/gstdio.h>
+
+#include "gegl.h"
+
+#define SUCCESS  0
+#define FAILURE -1
+
+#define WIDTH  300
+#define HEIGHT 200
+
+static guchar *
+get_pixels (GeglBuffer *buffer)
+{
+  guchar *pixels = g_malloc (WIDTH * HEIGHT * 4);
+
+  gegl_buffer_get (buffer, GEGL_RECTANGLE (0, 0, WIDTH, HEIGHT), 1.0,
+                   babl_format ("R'G'B'A u8"), pixels,
+                   GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+  return pixels;
+}
+
+/* Load a saved buffer, check its pixels, and write to the loaded buffer,
+ * the writes must neither show up in the file nor in other buffers
+ * loaded from it.
+ */
+int
+main (int    argc,
+      char **argv)
+{
+  GeglBuffer *buffer;
+  GeglBuffer *loaded;
+  GeglBuffer *other;
+  GeglColor  *color;
+  guchar     *pixels;
+  guchar     *expected;
+  gchar      *path;
+  gint        result = SUCCESS;
+  gint        i;
+
+  gegl_init (&argc, &argv);
+
+  path = g_build_filename (g_get_tmp_dir (), "test-buffer-load-mmap.gegl",
+                           NULL);
+
+  buffer   = gegl_buffer_new (GEGL_RECTANGLE (0, 0, WIDTH, HEIGHT),
+                              babl_format ("R'G'B'A u8"));
+  expected = g_malloc (WIDTH * HEIGHT * 4);
+  for (i = 0; i < WIDTH * HEIGHT * 4; i++)
+    expected[i] = (i * 7) % 251;
+  gegl_buffer_set (buffer, NULL, 0, babl_format ("R'G'B'A u8"), expected,
+                   GEGL_AUTO_ROWSTRIDE);
+  gegl_buffer_save (buffer, path, NULL);
+  g_object_unref (buffer);
+
+  loaded = gegl_buffer_load (path);
+  pixels = get_pixels (loaded);
+  if (memcmp (pixels, expected, WIDTH * HEIGHT * 4))
+    {
+      g_printerr ("the loaded buffer differs from the saved one\n");
+      result = FAILURE;
+    }
+  g_free (pixels);
+
+  other = gegl_buffer_load (path);
+
+  color = gegl_color_new ("black");
+  gegl_buffer_set_color (loaded, GEGL_RECTANGLE (10, 10, 100, 100), color);
+  g_object_unref (color);
+
+  pixels = get_pixels (other);
+  if (memcmp (pixels, expected, WIDTH * HEIGHT * 4))
+    {
+      g_printerr ("writing to a loaded buffer changed another one\n");
+      result = FAILURE;
+    }
+  g_free (pixels);
+
+  /* saving over the file while it is in use replaces it */
+  gegl_buffer_save (loaded, path, NULL);
+
+  pixels = get_pixels (other);
+  if (memcmp (pixels, expected, WIDTH * HEIGHT * 4))
+    {
+      g_printerr ("saving over the file changed a buffer loaded from it\n");
+      result = FAILURE;
+    }
+  g_free (pixels);
+
+  buffer = gegl_buffer_load (path);
+  pixels = get_pixels (buffer);
+  if (pixels[(20 * WIDTH + 20) * 4] != 0 ||
+      memcmp (pixels, expected, 4))
+    {
+      g_printerr ("the saved buffer doesn't have the changes\n");
+      result = FAILURE;
+    }
+  g_free (pixels);
+
+  g_object_unref (buffer);
+  g_object_unref (other);
+  g_object_unref (loaded);
+  g_free (expected);
+
+  g_unlink (path);
+  g_free (path);
+
+  gegl_exit ();
+
+  return result;
+}
@@ -0,0 +1,140 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+#include <math.h>
+
+#include "gegl.h"
+#include "gegl-types-internal.h"
+#include "gegl-buffer-pool.h"
+
+#define SUCCESS  0
+#define FAILURE -1
+
+#define WIDTH  200
+#define HEIGHT 150
+
+/* A chain of operations that leave the pixels unchanged, but switch
+ * between two formats so that every operation needs a new output buffer,
+ * and the buffers of earlier operations are reused from the pool of the
+ * graph. Rendering different rectangles in turn must never show pixels of
+ * an earlier use of a buffer, and buffers have to be reused at all.
+ */
+static gboolean
+check_render (GeglNode            *node,
+              const GeglRectangle *rect,
+              const gfloat        *source)
+{
+  gfloat   *pixels = g_new (gfloat, rect->width * rect->height * 4);
+  gboolean  success = TRUE;
+  gint      x, y, c;
+
+  gegl_node_blit (node, 1.0, rect, babl_format ("RGBA float"), pixels,
+                  GEGL_AUTO_ROWSTRIDE, GEGL_BLIT_DEFAULT);
+
+  for (y = 0; y < rect->height && success; y++)
+    for (x = 0; x < rect->width && success; x++)
+      for (c = 0; c < 4; c++)
+        {
+          gfloat expected = source[((rect->y + y) * WIDTH + rect->x + x) * 4 + c];
+          gfloat result   = pixels[(y * rect->width + x) * 4 + c];
+
+          if (fabsf (expected - result) > 1e-3)
+            {
+              g_printerr ("test-buffer-pool: pixel %d,%d of %d,%d %d×%d is "
+                          "%f instead of %f\n", x, y, rect->x, rect->y,
+                          rect->width, rect->height, result, expected);
+              success = FALSE;
+              break;
+            }
+        }
+
+  g_free (pixels);
+
+  return success;
+}
+
+int main (int argc, char *argv[])
+{
+  const GeglRectangle rects[] = {{0, 0, WIDTH, HEIGHT},
+                                 {50, 20, 100, 100},
+                                 {0, 0, WIDTH, HEIGHT},
+                                 {50, 20, 100, 100}};
+  gint        result = SUCCESS;
+  GeglBuffer *buffer;
+  GeglNode   *gegl;
+  GeglNode   *source;
+  GeglNode   *node;
+  gfloat     *pixels;
+  GRand      *rand;
+  gint        i;
+
+  gegl_init (&argc, &argv);
+
+  /* process every operation into its own buffer */
+  g_object_set (gegl_config (),
+                "point-fusion", FALSE,
+                NULL);
+
+  rand   = g_rand_new_with_seed (1);
+  pixels = g_new (gfloat, WIDTH * HEIGHT * 4);
+  for (i = 0; i < WIDTH * HEIGHT * 4; i++)
+    pixels[i] = g_rand_double_range (rand, 0.1, 0.9);
+
+  buffer = gegl_buffer_new (GEGL_RECTANGLE (0, 0, WIDTH, HEIGHT),
+                            babl_format ("RGBA float"));
+  gegl_buffer_set (buffer, NULL, 0, babl_format ("RGBA float"), pixels,
+                   GEGL_AUTO_ROWSTRIDE);
+
+  gegl   = gegl_node_new ();
+  source = gegl_node_new_child (gegl,
+                                "operation", "gegl:buffer-source",
+                                "buffer", buffer,
+                                NULL);
+  node   = source;
+
+  for (i = 0; i < 3; i++)
+    {
+      GeglNode *saturation = gegl_node_new_child (gegl,
+                                                  "operation", "gegl:saturation",
+                                                  "scale", 1.0,
+                                                  NULL);
+      GeglNode *contrast   = gegl_node_new_child (gegl,
+                                                  "operation", "gegl:brightness-contrast",
+                                                  NULL);
+
+      gegl_node_link_many (node, saturation, contrast, NULL);
+      node = contrast;
+    }
+
+  for (i = 0; i < G_N_ELEMENTS (rects); i++)
+    if (!check_render (node, &rects[i], pixels))
+      result = FAILURE;
+
+  if (gegl_buffer_pool_get_n_reused () == 0)
+    {
+      g_printerr ("test-buffer-pool: no buffer was reused\n");
+      result = FAILURE;
+    }
+
+  g_object_unref (gegl);
+  g_object_unref (buffer);
+  g_free (pixels);
+  g_rand_free (rand);
+
+  gegl_exit ();
+
+  return result;
+}
@@ -0,0 +1,261 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <string.h>
+#include <math.h>
+
+#include "gegl.h"
+#include "gegl-algorithms.h"
+#include "gegl-cpuaccel.h"
+
+#define SUCCESS  0
+#define FAILURE -1
+
+/* Compares gegl_downscale_2x2 () and gegl_resample_boxfilter (), which use
+ * vector versions when the CPU supports them, with the scalar versions.
+ * The downscale has to give identical results. The boxfilter sums nine
+ * weighted pixels, and as GEGL is built with -ffast-math the compiler may
+ * reorder those sums differently in both versions; integer components may
+ * then round one unit apart.
+ */
+
+typedef void (* Downscale2x2Func) (gint    bpp,
+                                   gint    src_width,
+                                   gint    src_height,
+                                   guchar *src_data,
+                                   gint    src_rowstride,
+                                   guchar *dst_data,
+                                   gint    dst_rowstride);
+
+typedef void (* BoxfilterFunc) (guchar              *dest_buf,
+                                const guchar        *source_buf,
+                                const GeglRectangle *dst_rect,
+                                const GeglRectangle *src_rect,
+                                gint                 s_rowstride,
+                                gdouble              scale,
+                                gint                 bpp,
+                                gint                 d_rowstride);
+
+typedef struct
+{
+  const gchar      *format;
+  Downscale2x2Func  downscale;
+  BoxfilterFunc     boxfilter;
+} Variant;
+
+static const Variant variants[] =
+{
+  { "RaGaBaA float", gegl_downscale_2x2_float, gegl_resample_boxfilter_float },
+  { "RGB float",     gegl_downscale_2x2_float, gegl_resample_boxfilter_float },
+  { "YA float",      gegl_downscale_2x2_float, gegl_resample_boxfilter_float },
+  { "RGBA u16",      gegl_downscale_2x2_u16,   gegl_resample_boxfilter_u16 },
+  { "RGB u16",       gegl_downscale_2x2_u16,   gegl_resample_boxfilter_u16 },
+  { "R'G'B'A u8",    gegl_downscale_2x2_u8,    gegl_resample_boxfilter_u8 },
+  { "R'G'B' u8",     gegl_downscale_2x2_u8,    gegl_resample_boxfilter_u8 },
+  { "Y u8",          gegl_downscale_2x2_u8,    gegl_resample_boxfilter_u8 }
+};
+
+/* fills @data with random components, some of them 0 and some at the top
+ * of the range, and with some fully transparent pixels for the boxfilter
+ */
+static void
+random_fill (GRand      *rand,
+             const Babl *format,
+             guchar     *data,
+             gint        n_pixels)
+{
+  const Babl *type       = babl_format_get_type (format, 0);
+  const gint  components = babl_format_get_n_components (format);
+  gint        i;
+
+  for (i = 0; i < n_pixels * components; i++)
+    {
+      gdouble value = g_rand_double (rand);
+
+      if (g_rand_int_range (rand, 0, 8) == 0)
+        value = 0.0;
+      else if (g_rand_int_range (rand, 0, 8) == 0)
+        value = 1.0;
+
+      if (type == babl_type ("float"))
+        ((gfloat *) data)[i] = value * 2.5 - 0.5;
+      else if (type == babl_type ("u16"))
+        ((guint16 *) data)[i] = value * 65535;
+      else
+        data[i] = value * 255;
+    }
+}
+
+static gboolean
+test_downscale (GRand         *rand,
+                const Variant *variant,
+                gint           width,
+                gint           height)
+{
+  const Babl *format    = babl_format (variant->format);
+  const gint  bpp       = babl_format_get_bytes_per_pixel (format);
+  const gint  rowstride = width * bpp + 16;
+  const gint  dst_size  = rowstride * height / 2 + 64;
+  guchar     *src       = g_malloc (rowstride * height);
+  guchar     *expected  = g_malloc0 (dst_size);
+  guchar     *result    = g_malloc0 (dst_size);
+  gboolean    success;
+
+  random_fill (rand, format, src, rowstride * height / bpp);
+
+  variant->downscale (bpp, width, height, src, rowstride, expected, rowstride);
+  gegl_downscale_2x2 (format, width, height, src, rowstride, result, rowstride);
+
+  success = memcmp (expected, result, dst_size) == 0;
+
+  if (! success)
+    g_printerr ("2x2 downscale of %s at %ix%i differs from the scalar version\n",
+                variant->format, width, height);
+
+  g_free (src);
+  g_free (expected);
+  g_free (result);
+
+  return success;
+}
+
+static gboolean
+components_match (const Babl   *format,
+                  const guchar *expected,
+                  const guchar *result,
+                  gint          n)
+{
+  const Babl *type = babl_format_get_type (format, 0);
+  gint        i;
+
+  for (i = 0; i < n; i++)
+    {
+      if (type == babl_type ("float"))
+        {
+          gfloat a = ((const gfloat *) expected)[i];
+          gfloat b = ((const gfloat *) result)[i];
+
+          if (fabsf (a - b) > 1e-5 * MAX (1.0, fabsf (a)))
+            return FALSE;
+        }
+      else if (type == babl_type ("u16"))
+        {
+          if (ABS (((const guint16 *) expected)[i] -
+                   ((const guint16 *) result)[i]) > 1)
+            return FALSE;
+        }
+      else if (ABS (expected[i] - result[i]) > 1)
+        {
+          return FALSE;
+        }
+    }
+
+  return TRUE;
+}
+
+static gboolean
+test_boxfilter (GRand         *rand,
+                const Variant *variant,
+                gdouble        scale,
+                gint           width)
+{
+  const Babl    *format     = babl_format (variant->format);
+  const gint     bpp        = babl_format_get_bytes_per_pixel (format);
+  const gint     components = babl_format_get_n_components (format);
+  GeglRectangle  dst_rect   = {3, 5, width, 7};
+  GeglRectangle  src_rect;
+  gint           rowstride;
+  guchar        *src;
+  guchar        *expected;
+  guchar        *result;
+  gboolean       success;
+
+  /* the source has a border of one pixel around the area scaled, and
+   * another one that is only read
+   */
+  src_rect.x      = floor (dst_rect.x / scale) - 1;
+  src_rect.y      = floor (dst_rect.y / scale) - 1;
+  src_rect.width  = ceil ((dst_rect.x + dst_rect.width) / scale) + 2 - src_rect.x;
+  src_rect.height = ceil ((dst_rect.y + dst_rect.height) / scale) + 2 - src_rect.y;
+
+  rowstride = (src_rect.width + 2) * bpp;
+  src       = g_malloc (rowstride * (src_rect.height + 2));
+  expected  = g_malloc0 (dst_rect.width * dst_rect.height * bpp);
+  result    = g_malloc0 (dst_rect.width * dst_rect.height * bpp);
+
+  random_fill (rand, format, src, (src_rect.width + 2) * (src_rect.height + 2));
+
+  variant->boxfilter (expected, src + rowstride + bpp, &dst_rect, &src_rect,
+                      rowstride, scale, bpp, dst_rect.width * bpp);
+  gegl_resample_boxfilter (result, src + rowstride + bpp, &dst_rect, &src_rect,
+                           rowstride, scale, format, dst_rect.width * bpp);
+
+  success = components_match (format, expected, result,
+                              dst_rect.width * dst_rect.height * components);
+
+  if (! success)
+    g_printerr ("boxfilter of %s at scale %f differs from the scalar version\n",
+                variant->format, scale);
+
+  g_free (src);
+  g_free (expected);
+  g_free (result);
+
+  return success;
+}
+
+int
+main (int    argc,
+      char **argv)
+{
+  const gdouble scales[] = {0.5, 0.51, 0.6, 0.75, 0.9, 0.99, 1.0, 1.3, 1.99};
+  GRand        *rand;
+  gint          result = SUCCESS;
+  gint          v, i;
+
+  gegl_init (&argc, &argv);
+
+  rand = g_rand_new_with_seed (1);
+
+  if (gegl_cpu_accel_get_support () & (GEGL_CPU_ACCEL_X86_AVX2 |
+                                       GEGL_CPU_ACCEL_ARM_NEON))
+    g_print ("comparing vector versions with scalar versions\n");
+
+  for (v = 0; v < G_N_ELEMENTS (variants); v++)
+    {
+      gint width, height;
+
+      /* odd sizes, and widths that leave every remainder of the vector
+       * loops
+       */
+      for (width = 1; width < 70; width += width < 20 ? 1 : 7)
+        for (height = 2; height < 8; height += 3)
+          if (! test_downscale (rand, &variants[v], width, height))
+            result = FAILURE;
+
+      for (i = 0; i < G_N_ELEMENTS (scales); i++)
+        for (width = 1; width < 40; width += 5)
+          if (! test_boxfilter (rand, &variants[v], scales[i], width))
+            result = FAILURE;
+    }
+
+  g_rand_free (rand);
+
+  gegl_exit ();
+
+  return result;
+}
@@ -0,0 +1,113 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+#include <math.h>
+
+#include "gegl.h"
+
+#define SUCCESS  0
+#define FAILURE -1
+
+#define WIDTH  301
+#define HEIGHT 203
+
+/* values of the filter property of gaussian-blur-old */
+#define FILTER_FIR 1
+#define FILTER_IIR 2
+
+/* Blur a checkerboard with both filters of gaussian-blur-old, the vertical
+ * pass of which works on blocks of columns spread over the threads, the
+ * results have to be the same with one thread and with several.
+ */
+static gfloat *
+render_blur (gint filter,
+             gint threads)
+{
+  GeglNode *gegl;
+  GeglNode *checkerboard;
+  GeglNode *blur;
+  gfloat   *pixels = g_new0 (gfloat, WIDTH * HEIGHT * 4);
+
+  g_object_set (gegl_config (),
+                "threads", threads,
+                NULL);
+
+  gegl         = gegl_node_new ();
+  checkerboard = gegl_node_new_child (gegl,
+                                      "operation", "gegl:checkerboard",
+                                      "x", 13,
+                                      "y", 7,
+                                      NULL);
+  blur         = gegl_node_new_child (gegl,
+                                      "operation", "gegl:gaussian-blur-old",
+                                      "std-dev-x", 3.0,
+                                      "std-dev-y", 5.0,
+                                      "filter", filter,
+                                      NULL);
+
+  gegl_node_link (checkerboard, blur);
+
+  gegl_node_blit (blur, 1.0, GEGL_RECTANGLE (-17, -9, WIDTH, HEIGHT),
+                  babl_format ("RaGaBaA float"), pixels,
+                  GEGL_AUTO_ROWSTRIDE, GEGL_BLIT_DEFAULT);
+
+  g_object_unref (gegl);
+
+  return pixels;
+}
+
+static gboolean
+test_filter (const gchar *name,
+             gint         filter)
+{
+  gfloat   *serial   = render_blur (filter, 1);
+  gfloat   *threaded = render_blur (filter, 4);
+  gboolean  success  = TRUE;
+  gint      i;
+
+  for (i = 0; i < WIDTH * HEIGHT * 4; i++)
+    {
+      if (fabsf (serial[i] - threaded[i]) > 1e-5)
+        {
+          g_printerr ("test-gaussian-blur-threads: %s result differs at pixel %i\n",
+                      name, i / 4);
+          success = FALSE;
+          break;
+        }
+    }
+
+  g_free (serial);
+  g_free (threaded);
+
+  return success;
+}
+
+int main (int argc, char *argv[])
+{
+  gint result = SUCCESS;
+
+  gegl_init (&argc, &argv);
+
+  if (!test_filter ("fir", FILTER_FIR))
+    result = FAILURE;
+
+  if (!test_filter ("iir", FILTER_IIR))
+    result = FAILURE;
+
+  gegl_exit ();
+
+  return result;
+}
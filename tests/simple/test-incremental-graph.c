@@ -0,0 +1,197 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include "gegl.h"
+#include "gegl-plugin.h"
+
+#define SUCCESS  0
+#define FAILURE -1
+
+#define SIZE 256
+
+/* Render a graph, change a small part of its source buffer and a property,
+ * and check that the results are up to date after each change while the
+ * graph reuses what it still has cached, and is only prepared again when
+ * the extent of its source changes.
+ */
+
+static void (*buffer_source_prepare) (GeglOperation *operation);
+static gint n_prepares = 0;
+
+static void
+count_prepare (GeglOperation *operation)
+{
+  n_prepares++;
+  buffer_source_prepare (operation);
+}
+
+static gboolean
+check_pixels (GeglNode            *node,
+              const GeglRectangle *changed,
+              gfloat               inside,
+              gfloat               outside)
+{
+  gfloat   *pixels = g_new (gfloat, SIZE * SIZE);
+  gboolean  ok     = TRUE;
+  gint      x, y;
+
+  gegl_node_blit (node, 1.0, GEGL_RECTANGLE (0, 0, SIZE, SIZE),
+                  babl_format ("Y float"), pixels,
+                  GEGL_AUTO_ROWSTRIDE, GEGL_BLIT_DEFAULT);
+
+  for (y = 0; y < SIZE && ok; y++)
+    for (x = 0; x < SIZE && ok; x++)
+      {
+        gboolean in = changed &&
+                      x >= changed->x && x < changed->x + changed->width &&
+                      y >= changed->y && y < changed->y + changed->height;
+        gfloat   expected = in ? inside : outside;
+
+        if (ABS (pixels[y * SIZE + x] - expected) > 0.0001)
+          {
+            g_printerr ("pixel %i,%i is %f instead of %f\n",
+                        x, y, pixels[y * SIZE + x], expected);
+            ok = FALSE;
+          }
+      }
+
+  g_free (pixels);
+  return ok;
+}
+
+int
+main (int    argc,
+      char **argv)
+{
+  GeglRectangle       stroke = {100, 60, 16, 24};
+  GeglBuffer         *buffer;
+  GeglColor          *color;
+  GeglNode           *gegl;
+  GeglNode           *source;
+  GeglNode           *levels;
+  GeglRectangle       bbox;
+  GeglOperationClass *source_class;
+  gfloat             *white;
+  gint                result = SUCCESS;
+  gint                i;
+
+  gegl_init (&argc, &argv);
+
+  buffer = gegl_buffer_new (GEGL_RECTANGLE (0, 0, SIZE, SIZE),
+                            babl_format ("Y float"));
+  color  = gegl_color_new ("rgb(0.25, 0.25, 0.25)");
+  gegl_buffer_set_color (buffer, NULL, color);
+  g_object_unref (color);
+
+  gegl   = gegl_node_new ();
+  source = gegl_node_new_child (gegl,
+                                "operation", "gegl:buffer-source",
+                                "buffer",    buffer,
+                                NULL);
+  levels = gegl_node_new_child (gegl,
+                                "operation", "gegl:levels",
+                                "out-low",   0.0,
+                                "out-high",  0.5,
+                                NULL);
+  gegl_node_link (source, levels);
+
+  source_class = GEGL_OPERATION_GET_CLASS (gegl_node_get_gegl_operation (source));
+  buffer_source_prepare = source_class->prepare;
+  source_class->prepare = count_prepare;
+
+  if (!check_pixels (levels, NULL, 0.0, 0.125))
+    result = FAILURE;
+
+  n_prepares = 0;
+
+  /* a brush stroke on the source buffer */
+  white = g_new (gfloat, stroke.width * stroke.height);
+  for (i = 0; i < stroke.width * stroke.height; i++)
+    white[i] = 1.0;
+  gegl_buffer_set (buffer, &stroke, 0, babl_format ("Y float"), white,
+                   GEGL_AUTO_ROWSTRIDE);
+
+  if (!check_pixels (levels, &stroke, 0.5, 0.125))
+    result = FAILURE;
+
+  bbox = gegl_node_get_bounding_box (levels);
+  if (!gegl_rectangle_equal (&bbox, GEGL_RECTANGLE (0, 0, SIZE, SIZE)))
+    {
+      g_printerr ("bounding box is %i,%i %i×%i after a contents change\n",
+                  bbox.x, bbox.y, bbox.width, bbox.height);
+      result = FAILURE;
+    }
+
+  if (n_prepares != 0)
+    {
+      g_printerr ("the graph was prepared again after a contents change\n");
+      result = FAILURE;
+    }
+
+  /* shrinking the source buffer changes the bounding box, which has to be
+   * found anew
+   */
+  gegl_buffer_set_extent (buffer, GEGL_RECTANGLE (0, 0, SIZE, SIZE / 2));
+  gegl_buffer_set (buffer, &stroke, 0, babl_format ("Y float"), white,
+                   GEGL_AUTO_ROWSTRIDE);
+
+  {
+    gfloat pixel = -1.0;
+
+    gegl_node_blit (levels, 1.0, GEGL_RECTANGLE (0, SIZE * 3 / 4, 1, 1),
+                    babl_format ("Y float"), &pixel,
+                    GEGL_AUTO_ROWSTRIDE, GEGL_BLIT_DEFAULT);
+
+    if (n_prepares == 0)
+      {
+        g_printerr ("the graph wasn't prepared again after an extent change\n");
+        result = FAILURE;
+      }
+
+    if (pixel != 0.0)
+      {
+        g_printerr ("pixel outside of the extent is %f\n", pixel);
+        result = FAILURE;
+      }
+  }
+
+  bbox = gegl_node_get_bounding_box (levels);
+  if (!gegl_rectangle_equal (&bbox, GEGL_RECTANGLE (0, 0, SIZE, SIZE / 2)))
+    {
+      g_printerr ("bounding box is %i,%i %i×%i after an extent change\n",
+                  bbox.x, bbox.y, bbox.width, bbox.height);
+      result = FAILURE;
+    }
+
+  gegl_buffer_set_extent (buffer, GEGL_RECTANGLE (0, 0, SIZE, SIZE));
+  g_free (white);
+
+  /* a property change still recomputes everything */
+  gegl_node_set (levels, "out-high", 1.0, NULL);
+
+  if (!check_pixels (levels, &stroke, 1.0, 0.25))
+    result = FAILURE;
+
+  source_class->prepare = buffer_source_prepare;
+
+  g_object_unref (gegl);
+  g_object_unref (buffer);
+
+  gegl_exit ();
+
+  return result;
+}
@@ -0,0 +1,233 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+#include <glib/gstdio.h>
+
+#include "gegl.h"
+#include "gegl-node-private.h"
+
+#define SUCCESS  0
+#define FAILURE -1
+
+#define WIDTH     1000
+#define HEIGHT    700
+#define MAX_LEVEL 4
+
+/* differences allowed between the reduced size decoding of libjpeg and
+ * averaging the full size pixels
+ */
+#define TOLERANCE 4
+
+/* Loads a JPEG at mipmap levels, for which gegl:jpg-load decodes it scaled
+ * down, and compares the pixels with box averages of the full size image.
+ * Rendering a level must not decode the image at full size, which would
+ * leave level 0 tiles in the cache of the load.
+ */
+
+static guchar *
+load (const gchar *path,
+      gint         level)
+{
+  GeglNode *gegl;
+  GeglNode *node;
+  guchar   *pixels;
+  gint      width  = WIDTH >> level;
+  gint      height = HEIGHT >> level;
+
+  gegl   = gegl_node_new ();
+  node   = gegl_node_new_child (gegl,
+                                "operation", "gegl:load",
+                                "path", path,
+                                NULL);
+  pixels = g_malloc0 (width * height * 3);
+
+  gegl_node_blit (node, 1.0 / (1 << level),
+                  GEGL_RECTANGLE (0, 0, width, height),
+                  babl_format ("R'G'B' u8"), pixels,
+                  GEGL_AUTO_ROWSTRIDE, GEGL_BLIT_DEFAULT);
+
+  g_object_unref (gegl);
+
+  return pixels;
+}
+
+static gboolean
+test_level (const gchar  *path,
+            const guchar *full,
+            gint          level)
+{
+  const gint  factor = 1 << level;
+  const gint  width  = WIDTH >> level;
+  const gint  height = HEIGHT >> level;
+  guchar     *scaled = load (path, level);
+  gboolean    success = TRUE;
+  gint        x, y, c;
+
+  for (y = 0; y < height && success; y++)
+    for (x = 0; x < width && success; x++)
+      for (c = 0; c < 3; c++)
+        {
+          gint sum = 0;
+          gint i, j;
+
+          for (j = 0; j < factor; j++)
+            for (i = 0; i < factor; i++)
+              sum += full[((y * factor + j) * WIDTH + x * factor + i) * 3 + c];
+
+          if (ABS (scaled[(y * width + x) * 3 + c] - sum / (factor * factor)) >
+              TOLERANCE)
+            {
+              g_printerr ("pixel %d,%d at level %d is %d instead of %d\n",
+                          x, y, level, scaled[(y * width + x) * 3 + c],
+                          sum / (factor * factor));
+              success = FALSE;
+              break;
+            }
+        }
+
+  g_free (scaled);
+
+  return success;
+}
+
+static gboolean
+test_scaled_decode (const gchar *path)
+{
+  const gint  level  = 3;
+  const gint  width  = WIDTH >> level;
+  const gint  height = HEIGHT >> level;
+  GeglNode   *gegl;
+  GeglNode   *node;
+  GeglCache  *cache;
+  guchar     *pixels;
+  gboolean    success = TRUE;
+  gint        i;
+
+  gegl   = gegl_node_new ();
+  node   = gegl_node_new_child (gegl,
+                                "operation", "gegl:jpg-load",
+                                "path", path,
+                                NULL);
+  pixels = g_malloc0 (WIDTH * HEIGHT * 3);
+
+  gegl_node_blit (node, 1.0 / (1 << level),
+                  GEGL_RECTANGLE (0, 0, width, height),
+                  babl_format ("R'G'B' u8"), pixels,
+                  GEGL_AUTO_ROWSTRIDE, GEGL_BLIT_DEFAULT);
+
+  if (ABS (pixels[2] - 128) > TOLERANCE)
+    {
+      g_printerr ("level %d was not rendered\n", level);
+      success = FALSE;
+    }
+
+  /* tiles that were never written read as empty */
+  cache = gegl_node_get_cache (node);
+  gegl_buffer_get (GEGL_BUFFER (cache),
+                   GEGL_RECTANGLE (0, 0, WIDTH, HEIGHT), 1.0,
+                   babl_format ("R'G'B' u8"), pixels,
+                   GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+  for (i = 0; i < WIDTH * HEIGHT && success; i++)
+    if (pixels[i * 3 + 2] != 0)
+      {
+        g_printerr ("level %d was decoded at full size\n", level);
+        success = FALSE;
+      }
+
+  g_free (pixels);
+  g_object_unref (gegl);
+
+  return success;
+}
+
+int main (int argc, char *argv[])
+{
+  gint        result = SUCCESS;
+  GeglBuffer *buffer;
+  GeglNode   *gegl;
+  GeglNode   *source;
+  GeglNode   *save;
+  guchar     *pixels;
+  gchar      *path;
+  gint        x, y, level;
+
+  /* render levels other than 0 from the levels of the sources */
+  g_setenv ("GEGL_MIPMAP_RENDERING", "1", TRUE);
+
+  gegl_init (&argc, &argv);
+
+  if (!gegl_has_operation ("gegl:jpg-load") ||
+      !gegl_has_operation ("gegl:jpg-save"))
+    {
+      g_print ("skipping, JPEG support not available\n");
+      gegl_exit ();
+      return SUCCESS;
+    }
+
+  path = g_build_filename (g_get_tmp_dir (), "test-jpg-load-scaled.jpg", NULL);
+
+  /* smooth, so that the compression barely changes it */
+  pixels = g_malloc (WIDTH * HEIGHT * 3);
+  for (y = 0; y < HEIGHT; y++)
+    for (x = 0; x < WIDTH; x++)
+      {
+        guchar *pixel = pixels + (y * WIDTH + x) * 3;
+
+        pixel[0] = x * 255 / WIDTH;
+        pixel[1] = y * 255 / HEIGHT;
+        pixel[2] = 128;
+      }
+
+  buffer = gegl_buffer_new (GEGL_RECTANGLE (0, 0, WIDTH, HEIGHT),
+                            babl_format ("R'G'B' u8"));
+  gegl_buffer_set (buffer, NULL, 0, babl_format ("R'G'B' u8"), pixels,
+                   GEGL_AUTO_ROWSTRIDE);
+  g_free (pixels);
+
+  gegl   = gegl_node_new ();
+  source = gegl_node_new_child (gegl,
+                                "operation", "gegl:buffer-source",
+                                "buffer", buffer,
+                                NULL);
+  save   = gegl_node_new_child (gegl,
+                                "operation", "gegl:jpg-save",
+                                "path", path,
+                                "quality", 100,
+                                NULL);
+  gegl_node_link (source, save);
+  gegl_node_process (save);
+  g_object_unref (gegl);
+  g_object_unref (buffer);
+
+  pixels = load (path, 0);
+
+  for (level = 1; level <= MAX_LEVEL; level++)
+    if (!test_level (path, pixels, level))
+      result = FAILURE;
+
+  g_free (pixels);
+
+  if (!test_scaled_decode (path))
+    result = FAILURE;
+
+  g_unlink (path);
+  g_free (path);
+
+  gegl_exit ();
+
+  return result;
+}
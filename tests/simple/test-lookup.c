@@ -0,0 +1,104 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+#include <math.h>
+
+#include "gegl.h"
+#include "gegl-lookup.h"
+
+#define SUCCESS  0
+#define FAILURE -1
+
+#define N_VALUES 100000
+
+static gfloat
+gamma_function (gfloat   value,
+                gpointer data)
+{
+  return value > 0.0f ? powf (value, 1.0f / 2.2f) : value;
+}
+
+/* Map values inside and outside the range of a precomputed lookup with
+ * gegl_lookup_process and gegl_lookup, the results have to stay within
+ * the precision of the table.
+ */
+static gboolean
+test_precomputed (gfloat   start,
+                  gfloat   end,
+                  gfloat   precision,
+                  gboolean threaded)
+{
+  GeglLookup *lookup = gegl_lookup_new_precomputed (gamma_function, NULL,
+                                                    start, end, precision,
+                                                    threaded);
+  gfloat     *src    = g_new (gfloat, N_VALUES);
+  gfloat     *dst    = g_new (gfloat, N_VALUES * 2);
+  gboolean    success = TRUE;
+  gint        i;
+
+  for (i = 0; i < N_VALUES; i++)
+    src[i] = start - 0.5f + (end - start + 1.0f) * i / (N_VALUES - 1);
+
+  gegl_lookup_process (lookup, src, 1, dst, 2, N_VALUES);
+
+  for (i = 0; i < N_VALUES && success; i++)
+    {
+      gfloat expected = gamma_function (src[i], NULL);
+
+      if (fabsf (dst[i * 2] - expected) > 1e-5f)
+        {
+          g_printerr ("test-lookup: gegl_lookup_process (%f) gave %f instead of %f\n",
+                      src[i], dst[i * 2], expected);
+          success = FALSE;
+        }
+      else if (fabsf (gegl_lookup (lookup, src[i]) - expected) > 5e-3f)
+        {
+          g_printerr ("test-lookup: gegl_lookup (%f) gave %f instead of %f\n",
+                      src[i], gegl_lookup (lookup, src[i]), expected);
+          success = FALSE;
+        }
+    }
+
+  g_free (src);
+  g_free (dst);
+  gegl_lookup_free (lookup);
+
+  return success;
+}
+
+int main (int argc, char *argv[])
+{
+  gint result = SUCCESS;
+
+  gegl_init (&argc, &argv);
+
+  g_object_set (gegl_config (),
+                "threads", 4,
+                NULL);
+
+  if (!test_precomputed (0.0, 1.0, 0.000010, TRUE))
+    result = FAILURE;
+
+  if (!test_precomputed (0.0, 1.0, 0.000649, FALSE))
+    result = FAILURE;
+
+  if (!test_precomputed (-1.0, 4.0, 0.000161, TRUE))
+    result = FAILURE;
+
+  gegl_exit ();
+
+  return result;
+}
@@ -0,0 +1,244 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <string.h>
+#include <unistd.h>
+#include <glib/gstdio.h>
+
+#include "gegl.h"
+#include "gegl-plugin.h"
+
+#define SUCCESS  0
+#define FAILURE -1
+
+/* the number of operation types registered by modules */
+static gint
+count_module_types (GType type)
+{
+  GType *children;
+  guint  n_children;
+  guint  i;
+  gint   count = 0;
+
+  children = g_type_children (type, &n_children);
+
+  for (i = 0; i < n_children; i++)
+    {
+      if (g_type_get_plugin (children[i]))
+        count++;
+
+      count += count_module_types (children[i]);
+    }
+
+  g_free (children);
+  return count;
+}
+
+/* gegl:load has to find the loader of @path, which registers its
+ * extension from a module that isn't loaded yet
+ */
+static gint
+test_load (const gchar *path)
+{
+  GeglNode *gegl;
+  GeglNode *load;
+  guchar    pixel[4] = {0, };
+  gint      result   = SUCCESS;
+
+  if (g_strcmp0 (gegl_extension_handler_get_loader (".png"), "gegl:png-load") ||
+      g_strcmp0 (gegl_extension_handler_get_saver (".png"), "gegl:png-save"))
+    {
+      g_printerr ("the handlers of .png weren't registered\n");
+      return FAILURE;
+    }
+
+  gegl = gegl_node_new ();
+  load = gegl_node_new_child (gegl,
+                              "operation", "gegl:load",
+                              "path", path,
+                              NULL);
+
+  gegl_node_blit (load, 1.0, GEGL_RECTANGLE (5, 5, 1, 1),
+                  babl_format ("R'G'B'A u8"), pixel,
+                  GEGL_AUTO_ROWSTRIDE, GEGL_BLIT_DEFAULT);
+
+  if (pixel[0] != 255 || pixel[1] != 0 || pixel[2] != 0 || pixel[3] != 255)
+    {
+      g_printerr ("loaded %d, %d, %d, %d from %s\n",
+                  pixel[0], pixel[1], pixel[2], pixel[3], path);
+      result = FAILURE;
+    }
+
+  g_object_unref (gegl);
+
+  return result;
+}
+
+/* saves a red PNG to load in the process using the registry */
+static gchar *
+save_png (void)
+{
+  GeglBuffer *buffer;
+  GeglColor  *color;
+  GeglNode   *gegl;
+  GeglNode   *source;
+  GeglNode   *save;
+  gchar      *path;
+  gint        fd;
+
+  if (!gegl_has_operation ("gegl:png-load") ||
+      !gegl_has_operation ("gegl:png-save"))
+    return NULL;
+
+  fd = g_file_open_tmp ("gegl-module-registry-XXXXXX.png", &path, NULL);
+  g_assert (fd >= 0);
+  close (fd);
+
+  buffer = gegl_buffer_new (GEGL_RECTANGLE (0, 0, 16, 16),
+                            babl_format ("R'G'B'A u8"));
+  color  = gegl_color_new ("rgb(1.0, 0.0, 0.0)");
+  gegl_buffer_set_color (buffer, NULL, color);
+  g_object_unref (color);
+
+  gegl   = gegl_node_new ();
+  source = gegl_node_new_child (gegl,
+                                "operation", "gegl:buffer-source",
+                                "buffer", buffer,
+                                NULL);
+  save   = gegl_node_new_child (gegl,
+                                "operation", "gegl:png-save",
+                                "path", path,
+                                NULL);
+  gegl_node_link (source, save);
+  gegl_node_process (save);
+
+  g_object_unref (gegl);
+  g_object_unref (buffer);
+
+  return path;
+}
+
+/* run with a registry written by an earlier process, no module should be
+ * loaded before one of its operations is used
+ */
+static gint
+test_deferred (const gchar *png)
+{
+  gchar **operations;
+  gint    loaded;
+
+  if (count_module_types (GEGL_TYPE_OPERATION) != 0)
+    {
+      g_printerr ("modules were loaded at startup\n");
+      return FAILURE;
+    }
+
+  if (!gegl_has_operation ("gegl:invert-linear"))
+    {
+      g_printerr ("gegl:invert-linear is unknown\n");
+      return FAILURE;
+    }
+
+  loaded = count_module_types (GEGL_TYPE_OPERATION);
+  if (loaded == 0)
+    {
+      g_printerr ("no module was loaded for gegl:invert-linear\n");
+      return FAILURE;
+    }
+
+  if (png && test_load (png) != SUCCESS)
+    return FAILURE;
+
+  loaded = count_module_types (GEGL_TYPE_OPERATION);
+
+  operations = gegl_list_operations (NULL);
+  g_free (operations);
+
+  if (count_module_types (GEGL_TYPE_OPERATION) <= loaded)
+    {
+      g_printerr ("listing operations didn't load the other modules\n");
+      return FAILURE;
+    }
+
+  return SUCCESS;
+}
+
+int
+main (int    argc,
+      char **argv)
+{
+  gchar  *registry;
+  gchar  *contents = NULL;
+  gchar  *png;
+  gchar  *child_argv[] = {argv[0], "--deferred", NULL, NULL};
+  GError *error        = NULL;
+  gint    status;
+  gint    result       = SUCCESS;
+  gint    fd;
+
+  if (argc > 1 && !strcmp (argv[1], "--deferred"))
+    {
+      gegl_init (NULL, NULL);
+      result = test_deferred (argv[2]);
+      gegl_exit ();
+
+      return result;
+    }
+
+  fd = g_file_open_tmp ("gegl-module-registry-XXXXXX", &registry, NULL);
+  g_assert (fd >= 0);
+  close (fd);
+  g_unlink (registry);
+
+  g_setenv ("GEGL_MODULE_REGISTRY", registry, TRUE);
+
+  gegl_init (&argc, &argv);
+
+  png = save_png ();
+  child_argv[2] = png;
+
+  if (!g_file_get_contents (registry, &contents, NULL, NULL) ||
+      !strstr (contents, "gegl:invert-linear"))
+    {
+      g_printerr ("the registry lacks gegl:invert-linear\n");
+      result = FAILURE;
+    }
+  else if (png && !strstr (contents, ".png=gegl:png-load"))
+    {
+      g_printerr ("the registry lacks the loader of .png\n");
+      result = FAILURE;
+    }
+  else if (!g_spawn_sync (NULL, child_argv, NULL, 0, NULL, NULL,
+                          NULL, NULL, &status, &error) ||
+           !g_spawn_check_exit_status (status, &error))
+    {
+      g_printerr ("deferred loading failed: %s\n", error->message);
+      g_error_free (error);
+      result = FAILURE;
+    }
+
+  gegl_exit ();
+
+  g_free (contents);
+  if (png)
+    g_unlink (png);
+  g_free (png);
+  g_unlink (registry);
+  g_free (registry);
+
+  return result;
+}
@@ -0,0 +1,95 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+#include <string.h>
+
+#include "gegl.h"
+
+#define SUCCESS  0
+#define FAILURE -1
+
+#define WIDTH  700
+#define HEIGHT 500
+
+/* Render a small chain with an area filter in it, the results have to be
+ * identical whether the graph is evaluated in parallel parts or not.
+ */
+static guchar *
+render_chain (gboolean parallel)
+{
+  GeglNode *gegl;
+  GeglNode *checkerboard;
+  GeglNode *blur;
+  GeglNode *invert;
+  guchar   *pixels = g_malloc0 (WIDTH * HEIGHT * 4);
+
+  g_object_set (gegl_config (),
+                "parallel-graph", parallel,
+                NULL);
+
+  gegl         = gegl_node_new ();
+  checkerboard = gegl_node_new_child (gegl,
+                                      "operation", "gegl:checkerboard",
+                                      "x", 13,
+                                      "y", 7,
+                                      NULL);
+  blur         = gegl_node_new_child (gegl,
+                                      "operation", "gegl:box-blur",
+                                      "radius", 5,
+                                      NULL);
+  invert       = gegl_node_new_child (gegl,
+                                      "operation", "gegl:invert-linear",
+                                      NULL);
+
+  gegl_node_link_many (checkerboard, blur, invert, NULL);
+
+  gegl_node_blit (invert, 1.0, GEGL_RECTANGLE (-30, -20, WIDTH, HEIGHT),
+                  babl_format ("RGBA u8"), pixels,
+                  GEGL_AUTO_ROWSTRIDE, GEGL_BLIT_DEFAULT);
+
+  g_object_unref (gegl);
+
+  return pixels;
+}
+
+int main (int argc, char *argv[])
+{
+  gint    result = SUCCESS;
+  guchar *serial;
+  guchar *parallel;
+
+  gegl_init (&argc, &argv);
+
+  g_object_set (gegl_config (),
+                "threads", 4,
+                NULL);
+
+  serial   = render_chain (FALSE);
+  parallel = render_chain (TRUE);
+
+  if (memcmp (serial, parallel, WIDTH * HEIGHT * 4))
+    {
+      g_printerr ("test-parallel-graph: parallel result differs from serial result\n");
+      result = FAILURE;
+    }
+
+  g_free (serial);
+  g_free (parallel);
+
+  gegl_exit ();
+
+  return result;
+}
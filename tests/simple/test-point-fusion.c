@@ -0,0 +1,156 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+#include <string.h>
+
+#include "gegl.h"
+#include "gegl-graph-traversal.h"
+
+#define SUCCESS  0
+#define FAILURE -1
+
+#define WIDTH  333
+#define HEIGHT 211
+
+/* the point operations following the checkerboard */
+#define N_POINT_OPS 5
+
+/* Render a chain of point operations, with a change of format in the
+ * middle and a composer reading an aux buffer, the results have to be
+ * identical whether the chain is processed as one fused run or operation
+ * by operation. @n_fused is set to the number of operations processed in
+ * fused runs.
+ */
+static gfloat *
+render_chain (gboolean  fused,
+              gint     *n_fused)
+{
+  GeglNode *gegl;
+  GeglNode *checkerboard;
+  GeglNode *contrast;
+  GeglNode *saturation;
+  GeglNode *levels;
+  GeglNode *multiply;
+  GeglNode *pattern;
+  GeglNode *invert;
+  gfloat   *pixels = g_new0 (gfloat, WIDTH * HEIGHT * 4);
+
+  *n_fused = gegl_graph_get_n_fused_ops ();
+
+  g_object_set (gegl_config (),
+                "point-fusion", fused,
+                NULL);
+
+  gegl         = gegl_node_new ();
+  checkerboard = gegl_node_new_child (gegl,
+                                      "operation", "gegl:checkerboard",
+                                      "x", 13,
+                                      "y", 7,
+                                      NULL);
+  contrast     = gegl_node_new_child (gegl,
+                                      "operation", "gegl:brightness-contrast",
+                                      "contrast", 1.3,
+                                      "brightness", 0.1,
+                                      NULL);
+  saturation   = gegl_node_new_child (gegl,
+                                      "operation", "gegl:saturation",
+                                      "scale", 0.6,
+                                      NULL);
+  levels       = gegl_node_new_child (gegl,
+                                      "operation", "gegl:levels",
+                                      "in-low", 0.1,
+                                      "out-high", 0.9,
+                                      NULL);
+  multiply     = gegl_node_new_child (gegl,
+                                      "operation", "gegl:multiply",
+                                      NULL);
+  pattern      = gegl_node_new_child (gegl,
+                                      "operation", "gegl:checkerboard",
+                                      "x", 31,
+                                      "y", 5,
+                                      NULL);
+  invert       = gegl_node_new_child (gegl,
+                                      "operation", "gegl:invert-linear",
+                                      NULL);
+
+  gegl_node_link_many (checkerboard, contrast, saturation, levels,
+                       multiply, invert, NULL);
+  gegl_node_connect_to (pattern, "output", multiply, "aux");
+
+  gegl_node_blit (invert, 1.0, GEGL_RECTANGLE (-30, -20, WIDTH, HEIGHT),
+                  babl_format ("RGBA float"), pixels,
+                  GEGL_AUTO_ROWSTRIDE, GEGL_BLIT_DEFAULT);
+
+  *n_fused = gegl_graph_get_n_fused_ops () - *n_fused;
+
+  g_object_unref (gegl);
+
+  return pixels;
+}
+
+static gint
+compare_chain (gint threads)
+{
+  gint    result = SUCCESS;
+  gfloat *separate;
+  gfloat *fused;
+  gint    n_separate;
+  gint    n_fused;
+
+  g_object_set (gegl_config (),
+                "threads", threads,
+                NULL);
+
+  separate = render_chain (FALSE, &n_separate);
+  fused    = render_chain (TRUE, &n_fused);
+
+  if (n_separate != 0 || n_fused < N_POINT_OPS)
+    {
+      g_printerr ("test-point-fusion: %d operations fused with point-fusion "
+                  "off, %d with it on, with %d threads\n",
+                  n_separate, n_fused, threads);
+      result = FAILURE;
+    }
+
+  if (memcmp (separate, fused, WIDTH * HEIGHT * 4 * sizeof (gfloat)))
+    {
+      g_printerr ("test-point-fusion: fused result differs from separate "
+                  "result with %d threads\n", threads);
+      result = FAILURE;
+    }
+
+  g_free (separate);
+  g_free (fused);
+
+  return result;
+}
+
+int main (int argc, char *argv[])
+{
+  gint result = SUCCESS;
+
+  gegl_init (&argc, &argv);
+
+  if (compare_chain (1) != SUCCESS)
+    result = FAILURE;
+
+  if (compare_chain (4) != SUCCESS)
+    result = FAILURE;
+
+  gegl_exit ();
+
+  return result;
+}
@@ -0,0 +1,229 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include "gegl.h"
+
+#define SUCCESS  0
+#define FAILURE -1
+
+#define WIDTH  1000
+#define HEIGHT 800
+
+typedef struct
+{
+  gint          n_chunks;
+  gint64        area;
+  GeglRectangle first;
+  gboolean      done;
+  gboolean      completed;
+  gint          destroyed;
+} Work;
+
+static void
+chunk_done (GeglProcessor       *processor,
+            const GeglRectangle *rectangle,
+            gpointer             user_data)
+{
+  Work *work = user_data;
+
+  if (work->n_chunks++ == 0)
+    work->first = *rectangle;
+  work->area += (gint64) rectangle->width * rectangle->height;
+}
+
+static void
+cancel_chunk_done (GeglProcessor       *processor,
+                   const GeglRectangle *rectangle,
+                   gpointer             user_data)
+{
+  chunk_done (processor, rectangle, user_data);
+  gegl_processor_cancel (processor);
+}
+
+/* drops the last reference to the processor */
+static void
+unref_chunk_done (GeglProcessor       *processor,
+                  const GeglRectangle *rectangle,
+                  gpointer             user_data)
+{
+  chunk_done (processor, rectangle, user_data);
+  g_object_unref (processor);
+}
+
+static void
+work_done (GeglProcessor *processor,
+           gboolean       completed,
+           gpointer       user_data)
+{
+  Work *work = user_data;
+
+  work->done      = TRUE;
+  work->completed = completed;
+}
+
+static void
+work_destroy (gpointer user_data)
+{
+  Work *work = user_data;
+
+  g_atomic_int_inc (&work->destroyed);
+}
+
+static GeglNode *
+create_graph (GeglNode *gegl)
+{
+  GeglNode *checkerboard;
+  GeglNode *blur;
+
+  checkerboard = gegl_node_new_child (gegl,
+                                      "operation", "gegl:checkerboard",
+                                      NULL);
+  blur         = gegl_node_new_child (gegl,
+                                      "operation", "gegl:box-blur",
+                                      "radius", 3,
+                                      NULL);
+  gegl_node_link (checkerboard, blur);
+
+  return blur;
+}
+
+int
+main (int    argc,
+      char **argv)
+{
+  GeglRectangle  roi      = {0, 0, WIDTH, HEIGHT};
+  GeglRectangle  viewport = {700, 500, 200, 200};
+  GeglNode      *gegl;
+  GeglNode      *output;
+  GeglProcessor *processor;
+  Work           work     = {0, };
+  gint           result   = SUCCESS;
+
+  gegl_init (&argc, &argv);
+
+  /* render everything, the viewport first */
+  gegl      = gegl_node_new ();
+  output    = create_graph (gegl);
+  processor = gegl_node_new_processor (output, &roi);
+
+  gegl_processor_set_priority_rectangle (processor, &viewport);
+  gegl_processor_work_async (processor, chunk_done, work_done, &work,
+                             work_destroy);
+
+  if (!gegl_processor_wait (processor) || !work.done || !work.completed ||
+      work.destroyed != 1)
+    {
+      g_printerr ("asynchronous work wasn't completed\n");
+      result = FAILURE;
+    }
+
+  if (work.area != (gint64) WIDTH * HEIGHT || work.n_chunks < 2)
+    {
+      g_printerr ("rendered %i pixels in %i chunks\n",
+                  (gint) work.area, work.n_chunks);
+      result = FAILURE;
+    }
+
+  if (!gegl_rectangle_intersect (NULL, &work.first, &viewport))
+    {
+      g_printerr ("the priority rectangle wasn't rendered first\n");
+      result = FAILURE;
+    }
+
+  /* nothing is left to do once everything is valid */
+  memset (&work, 0, sizeof (work));
+  gegl_processor_work_async (processor, chunk_done, work_done, &work,
+                             work_destroy);
+
+  if (!gegl_processor_wait (processor) || work.n_chunks != 0)
+    {
+      g_printerr ("rendered %i chunks again\n", work.n_chunks);
+      result = FAILURE;
+    }
+
+  g_object_unref (processor);
+  g_object_unref (gegl);
+
+  /* start again after work that finished without waiting for it */
+  memset (&work, 0, sizeof (work));
+  gegl      = gegl_node_new ();
+  output    = create_graph (gegl);
+  processor = gegl_node_new_processor (output, &roi);
+
+  gegl_processor_work_async (processor, chunk_done, work_done, &work,
+                             work_destroy);
+  while (!g_atomic_int_get (&work.destroyed))
+    g_usleep (1000);
+
+  memset (&work, 0, sizeof (work));
+  gegl_processor_work_async (processor, chunk_done, work_done, &work,
+                             work_destroy);
+
+  if (!gegl_processor_wait (processor) || !work.done || work.n_chunks != 0 ||
+      work.destroyed != 1)
+    {
+      g_printerr ("restarted work wasn't completed\n");
+      result = FAILURE;
+    }
+
+  g_object_unref (processor);
+  g_object_unref (gegl);
+
+  /* cancel after the first chunk */
+  memset (&work, 0, sizeof (work));
+  gegl      = gegl_node_new ();
+  output    = create_graph (gegl);
+  processor = gegl_node_new_processor (output, &roi);
+
+  gegl_processor_work_async (processor, cancel_chunk_done, work_done, &work,
+                             work_destroy);
+
+  if (gegl_processor_wait (processor) || !work.done || work.completed ||
+      work.n_chunks != 1)
+    {
+      g_printerr ("cancelled work rendered %i chunks\n", work.n_chunks);
+      result = FAILURE;
+    }
+
+  g_object_unref (processor);
+  g_object_unref (gegl);
+
+  /* release the processor from the thread doing the work */
+  memset (&work, 0, sizeof (work));
+  gegl      = gegl_node_new ();
+  output    = create_graph (gegl);
+  processor = gegl_node_new_processor (output, &roi);
+
+  gegl_processor_work_async (processor, unref_chunk_done, work_done, &work,
+                             work_destroy);
+  while (!g_atomic_int_get (&work.destroyed))
+    g_usleep (1000);
+
+  if (work.done || work.n_chunks != 1)
+    {
+      g_printerr ("released work rendered %i chunks\n", work.n_chunks);
+      result = FAILURE;
+    }
+
+  g_object_unref (gegl);
+
+  gegl_exit ();
+
+  return result;
+}
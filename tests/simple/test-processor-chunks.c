@@ -0,0 +1,212 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include "gegl.h"
+#include "gegl-processor-private.h"
+
+#define SUCCESS  0
+#define FAILURE -1
+
+/* Check that the chunks planned by a processor cover its rectangle, are
+ * aligned to the tile grid, and that the overlap of area filters is
+ * accounted for.
+ */
+
+typedef struct
+{
+  GeglRectangle roi;
+  gint          n_chunks;
+  gint64        area;
+  gboolean      aligned;
+} Chunks;
+
+static void
+chunk_done (GeglProcessor       *processor,
+            const GeglRectangle *rectangle,
+            gpointer             user_data)
+{
+  Chunks *chunks      = user_data;
+  gint    tile_width  = gegl_config ()->tile_width;
+  gint    tile_height = gegl_config ()->tile_height;
+
+  chunks->n_chunks++;
+  chunks->area += (gint64) rectangle->width * rectangle->height;
+
+  if ((rectangle->x != chunks->roi.x && rectangle->x % tile_width) ||
+      (rectangle->y != chunks->roi.y && rectangle->y % tile_height))
+    chunks->aligned = FALSE;
+}
+
+static gboolean
+check_chunks (gint radius)
+{
+  GeglProcessorPlanStats  stats;
+  GeglProcessor          *processor;
+  GeglNode               *gegl;
+  GeglNode               *source;
+  GeglNode               *output;
+  Chunks                  chunks = {{13, 7, 1000, 700}, 0, 0, TRUE};
+  gboolean                ok     = TRUE;
+
+  gegl   = gegl_node_new ();
+  source = gegl_node_new_child (gegl,
+                                "operation", "gegl:checkerboard",
+                                NULL);
+  output = gegl_node_new_child (gegl,
+                                "operation", "gegl:box-blur",
+                                "radius",    radius,
+                                NULL);
+  gegl_node_link (source, output);
+
+  processor = gegl_node_new_processor (output, &chunks.roi);
+  gegl_processor_work_async (processor, chunk_done, NULL, &chunks, NULL);
+  gegl_processor_wait (processor);
+  gegl_processor_get_plan_stats (processor, &stats);
+
+  if (chunks.area != (gint64) chunks.roi.width * chunks.roi.height)
+    {
+      g_printerr ("radius %i: chunks covered %i pixels\n",
+                  radius, (gint) chunks.area);
+      ok = FALSE;
+    }
+
+  if (!chunks.aligned)
+    {
+      g_printerr ("radius %i: chunks aren't aligned to tiles\n", radius);
+      ok = FALSE;
+    }
+
+  if (stats.n_chunks != chunks.n_chunks || stats.area != chunks.area ||
+      stats.chunk_width  % gegl_config ()->tile_width ||
+      stats.chunk_height % gegl_config ()->tile_height)
+    {
+      g_printerr ("radius %i: planned %i chunks of %i×%i, rendered %i\n",
+                  radius, stats.n_chunks,
+                  stats.chunk_width, stats.chunk_height, chunks.n_chunks);
+      ok = FALSE;
+    }
+
+  if ((stats.overlap_area == 0) != (radius == 0))
+    {
+      g_printerr ("radius %i: overlap of %i pixels\n",
+                  radius, (gint) stats.overlap_area);
+      ok = FALSE;
+    }
+
+  g_object_unref (processor);
+  g_object_unref (gegl);
+
+  return ok;
+}
+
+/* chunks of a band thinner than a tile grow along the band only */
+static gboolean
+check_band (void)
+{
+  GeglProcessorPlanStats  stats;
+  GeglProcessor          *processor;
+  GeglNode               *gegl;
+  GeglNode               *output;
+  Chunks                  chunks = {{0, 0, 4000, 16}, 0, 0, TRUE};
+  gboolean                ok     = TRUE;
+
+  gegl   = gegl_node_new ();
+  output = gegl_node_new_child (gegl,
+                                "operation", "gegl:checkerboard",
+                                NULL);
+
+  processor = gegl_node_new_processor (output, &chunks.roi);
+  gegl_processor_work_async (processor, chunk_done, NULL, &chunks, NULL);
+  gegl_processor_wait (processor);
+  gegl_processor_get_plan_stats (processor, &stats);
+
+  if (stats.chunk_height != gegl_config ()->tile_height ||
+      stats.n_chunks != chunks.n_chunks)
+    {
+      g_printerr ("band: planned %i chunks of %i×%i\n",
+                  stats.n_chunks, stats.chunk_width, stats.chunk_height);
+      ok = FALSE;
+    }
+
+  g_object_unref (processor);
+  g_object_unref (gegl);
+
+  return ok;
+}
+
+/* nodes used by several consumers are only followed once when planning,
+ * a chain of 40 diamonds has 2^40 paths to its source
+ */
+static gboolean
+check_diamonds (void)
+{
+  GeglProcessor *processor;
+  GeglNode      *gegl;
+  GeglNode      *output;
+  Chunks         chunks = {{0, 0, 300, 200}, 0, 0, TRUE};
+  gint           i;
+
+  gegl   = gegl_node_new ();
+  output = gegl_node_new_child (gegl,
+                                "operation", "gegl:checkerboard",
+                                NULL);
+
+  for (i = 0; i < 40; i++)
+    {
+      GeglNode *over = gegl_node_new_child (gegl,
+                                            "operation", "gegl:over",
+                                            NULL);
+
+      gegl_node_connect_to (output, "output", over, "input");
+      gegl_node_connect_to (output, "output", over, "aux");
+      output = over;
+    }
+
+  processor = gegl_node_new_processor (output, &chunks.roi);
+  gegl_processor_work_async (processor, chunk_done, NULL, &chunks, NULL);
+  gegl_processor_wait (processor);
+
+  g_object_unref (processor);
+  g_object_unref (gegl);
+
+  if (chunks.area != (gint64) chunks.roi.width * chunks.roi.height)
+    {
+      g_printerr ("diamonds: chunks covered %i pixels\n", (gint) chunks.area);
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
+int
+main (int    argc,
+      char **argv)
+{
+  gint result = SUCCESS;
+
+  gegl_init (&argc, &argv);
+
+  if (!check_chunks (0) || !check_chunks (20))
+    result = FAILURE;
+
+  if (!check_band () || !check_diamonds ())
+    result = FAILURE;
+
+  gegl_exit ();
+
+  return result;
+}
@@ -0,0 +1,160 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+#include <math.h>
+
+#include "gegl.h"
+
+#define SUCCESS  0
+#define FAILURE -1
+
+#define SIZE      200
+#define N_SAMPLES 500
+
+typedef struct
+{
+  gdouble x, y;
+  gdouble dx, dy;
+} Line;
+
+/* an upscale, a downscale, a rotation and a line leaving the buffer */
+static const Line lines[] =
+{
+  {  3.25,  10.5,   0.25,  0.0  },
+  { -2.0,   40.75,  1.5,   0.0  },
+  {  7.3,    2.1,   0.31,  0.27 },
+  { 150.6, 120.2,   0.7,  -0.45 }
+};
+
+static GeglBuffer *
+noise_buffer (void)
+{
+  GeglBuffer *buffer;
+  GRand      *rand   = g_rand_new_with_seed (42);
+  gfloat     *pixels = g_new (gfloat, SIZE * SIZE * 4);
+  gint        i;
+
+  for (i = 0; i < SIZE * SIZE * 4; i++)
+    pixels[i] = g_rand_double (rand);
+
+  buffer = gegl_buffer_new (GEGL_RECTANGLE (0, 0, SIZE, SIZE),
+                            babl_format ("RGBA float"));
+  gegl_buffer_set (buffer, NULL, 0, babl_format ("RGBA float"), pixels,
+                   GEGL_AUTO_ROWSTRIDE);
+
+  g_free (pixels);
+  g_rand_free (rand);
+
+  return buffer;
+}
+
+/* Sample lines with gegl_sampler_get_span and with one call per sample,
+ * the results have to be the same.
+ */
+static gboolean
+test_sampler (GeglBuffer      *buffer,
+              GeglSamplerType  type,
+              const gchar     *format_name)
+{
+  const Babl  *format  = babl_format (format_name);
+  gint         bpp     = babl_format_get_bytes_per_pixel (format);
+  gboolean     is_u8   = bpp == 4;
+  GeglSampler *single  = gegl_buffer_sampler_new (buffer, format, type);
+  GeglSampler *span    = gegl_buffer_sampler_new (buffer, format, type);
+  guchar      *expected = g_malloc (N_SAMPLES * bpp);
+  guchar      *result   = g_malloc (N_SAMPLES * bpp);
+  gboolean     success  = TRUE;
+  gint         l, i;
+
+  for (l = 0; l < G_N_ELEMENTS (lines) && success; l++)
+    {
+      GeglSamplerGetFun get = gegl_sampler_get_fun (single);
+      gdouble           x   = lines[l].x;
+      gdouble           y   = lines[l].y;
+
+      for (i = 0; i < N_SAMPLES; i++)
+        {
+          get (single, x, y, NULL, expected + i * bpp, GEGL_ABYSS_NONE);
+          x += lines[l].dx;
+          y += lines[l].dy;
+        }
+
+      gegl_sampler_get_span (span, lines[l].x, lines[l].y,
+                             lines[l].dx, lines[l].dy, NULL,
+                             result, N_SAMPLES, GEGL_ABYSS_NONE);
+
+      for (i = 0; i < N_SAMPLES * 4; i++)
+        {
+          gdouble a, b;
+
+          if (is_u8)
+            {
+              a = expected[i];
+              b = result[i];
+            }
+          else
+            {
+              a = ((gfloat *) expected)[i];
+              b = ((gfloat *) result)[i];
+            }
+
+          if (fabs (a - b) > (is_u8 ? 1.0 : 1e-5))
+            {
+              g_printerr ("test-sampler-span: sampler %i, %s, line %i differs at sample %i\n",
+                          type, format_name, l, i / 4);
+              success = FALSE;
+              break;
+            }
+        }
+    }
+
+  g_free (expected);
+  g_free (result);
+  g_object_unref (single);
+  g_object_unref (span);
+
+  return success;
+}
+
+int main (int argc, char *argv[])
+{
+  const GeglSamplerType types[] = {GEGL_SAMPLER_NEAREST,
+                                   GEGL_SAMPLER_LINEAR,
+                                   GEGL_SAMPLER_CUBIC,
+                                   GEGL_SAMPLER_NOHALO,
+                                   GEGL_SAMPLER_LOHALO};
+  GeglBuffer *buffer;
+  gint        result = SUCCESS;
+  gint        i;
+
+  gegl_init (&argc, &argv);
+
+  buffer = noise_buffer ();
+
+  for (i = 0; i < G_N_ELEMENTS (types); i++)
+    {
+      if (!test_sampler (buffer, types[i], "RaGaBaA float"))
+        result = FAILURE;
+      if (!test_sampler (buffer, types[i], "R'G'B'A u8"))
+        result = FAILURE;
+    }
+
+  g_object_unref (buffer);
+
+  gegl_exit ();
+
+  return result;
+}
@@ -0,0 +1,303 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+#include <string.h>
+#include <glib/gstdio.h>
+#ifndef G_OS_WIN32
+#include <unistd.h>
+#endif
+
+#include "gegl.h"
+
+#define SUCCESS  0
+#define FAILURE -1
+
+/* high enough to be saved in several bands */
+#define WIDTH  1000
+#define HEIGHT 700
+
+/* what the target holds before the image is saved over it */
+#define PREVIOUS "previous contents"
+
+/* Whether @path still holds PREVIOUS, and is the only file of @dir,
+ * that is no temporary file was left behind.
+ */
+static gboolean
+check_untouched (const gchar *dir,
+                 const gchar *path)
+{
+  GDir     *d;
+  gchar    *contents = NULL;
+  gint      n_files  = 0;
+  gboolean  success;
+
+  success = g_file_get_contents (path, &contents, NULL, NULL) &&
+            !strcmp (contents, PREVIOUS);
+  g_free (contents);
+
+  d = g_dir_open (dir, 0, NULL);
+  while (g_dir_read_name (d))
+    n_files++;
+  g_dir_close (d);
+
+  return success && n_files == 1;
+}
+
+/* Saves an image with a saver that encodes it band by band as it is
+ * rendered, over an existing file, loads it again and compares the
+ * pixels. The existing file has to stay as it was until the last band
+ * is written, and when the save is abandoned halfway, and its
+ * permissions have to survive the save.
+ */
+static gboolean
+test_save (const gchar  *saver,
+           const gchar  *extension,
+           const guchar *pixels)
+{
+  GeglProcessor *processor;
+  GeglBuffer    *buffer;
+  GeglNode      *gegl;
+  GeglNode      *source;
+  GeglNode      *save;
+  GeglNode      *load;
+  guchar        *loaded;
+  gchar         *dir;
+  gchar         *path;
+  gchar         *name;
+  gboolean       success = TRUE;
+
+  if (!gegl_has_operation (saver))
+    {
+      g_print ("skipping %s, not available\n", saver);
+      return TRUE;
+    }
+
+  dir  = g_dir_make_tmp ("test-streaming-save-XXXXXX", NULL);
+  name = g_strconcat ("test-streaming-save", extension, NULL);
+  path = g_build_filename (dir, name, NULL);
+  g_free (name);
+
+  g_file_set_contents (path, PREVIOUS, -1, NULL);
+  g_chmod (path, 0640);
+
+  buffer = gegl_buffer_new (GEGL_RECTANGLE (0, 0, WIDTH, HEIGHT),
+                            babl_format ("R'G'B'A u8"));
+  gegl_buffer_set (buffer, NULL, 0, babl_format ("R'G'B'A u8"), pixels,
+                   GEGL_AUTO_ROWSTRIDE);
+
+  gegl   = gegl_node_new ();
+  source = gegl_node_new_child (gegl,
+                                "operation", "gegl:buffer-source",
+                                "buffer", buffer,
+                                NULL);
+  save   = gegl_node_new_child (gegl,
+                                "operation", "gegl:save",
+                                "path", path,
+                                NULL);
+  gegl_node_link (source, save);
+
+  /* abandoned after the first band */
+  processor = gegl_node_new_processor (save, NULL);
+  if (!gegl_processor_work (processor, NULL))
+    {
+      g_printerr ("%s saved the image in a single band\n", saver);
+      success = FALSE;
+    }
+  g_object_unref (processor);
+
+  if (!check_untouched (dir, path))
+    {
+      g_printerr ("an abandoned save with %s changed the target\n", saver);
+      success = FALSE;
+    }
+
+  processor = gegl_node_new_processor (save, NULL);
+  gegl_processor_work (processor, NULL);
+
+  if (!check_untouched (dir, path))
+    {
+      g_printerr ("%s changed the target before the last band\n", saver);
+      success = FALSE;
+    }
+
+  while (gegl_processor_work (processor, NULL));
+  g_object_unref (processor);
+
+#ifndef G_OS_WIN32
+  {
+    GStatBuf st;
+
+    if (g_stat (path, &st) != 0 || (st.st_mode & 0777) != 0640)
+      {
+        g_printerr ("%s didn't keep the permissions of the target\n", saver);
+        success = FALSE;
+      }
+  }
+#endif
+
+  g_object_unref (gegl);
+  g_object_unref (buffer);
+
+  gegl   = gegl_node_new ();
+  load   = gegl_node_new_child (gegl,
+                                "operation", "gegl:load",
+                                "path", path,
+                                NULL);
+  loaded = g_malloc0 (WIDTH * HEIGHT * 4);
+
+  gegl_node_blit (load, 1.0, GEGL_RECTANGLE (0, 0, WIDTH, HEIGHT),
+                  babl_format ("R'G'B'A u8"), loaded,
+                  GEGL_AUTO_ROWSTRIDE, GEGL_BLIT_DEFAULT);
+
+  if (memcmp (pixels, loaded, WIDTH * HEIGHT * 4))
+    {
+      g_printerr ("the image saved by %s differs\n", saver);
+      success = FALSE;
+    }
+
+  g_object_unref (gegl);
+  g_free (loaded);
+
+  g_unlink (path);
+  g_rmdir (dir);
+  g_free (path);
+  g_free (dir);
+
+  return success;
+}
+
+/* Saves an image through a symbolic link, which has to stay a link to the
+ * file that now holds the image.
+ */
+static gboolean
+test_save_through_link (const gchar  *saver,
+                        const gchar  *extension,
+                        const guchar *pixels)
+{
+  gboolean success = TRUE;
+#ifndef G_OS_WIN32
+  GeglBuffer *buffer;
+  GeglNode   *gegl;
+  GeglNode   *source;
+  GeglNode   *save;
+  gchar      *dir;
+  gchar      *name;
+  gchar      *path;
+  gchar      *link;
+  gchar      *contents = NULL;
+
+  if (!gegl_has_operation (saver))
+    return TRUE;
+
+  dir  = g_dir_make_tmp ("test-streaming-save-XXXXXX", NULL);
+  name = g_strconcat ("test-streaming-save", extension, NULL);
+  path = g_build_filename (dir, name, NULL);
+  link = g_strconcat (path, ".link", extension, NULL);
+
+  g_file_set_contents (path, PREVIOUS, -1, NULL);
+  if (symlink (name, link) != 0)
+    {
+      g_print ("skipping the link test of %s, no symbolic links\n", saver);
+      g_unlink (path);
+      g_rmdir (dir);
+      g_free (link);
+      g_free (path);
+      g_free (name);
+      g_free (dir);
+      return TRUE;
+    }
+
+  buffer = gegl_buffer_new (GEGL_RECTANGLE (0, 0, WIDTH, HEIGHT),
+                            babl_format ("R'G'B'A u8"));
+  gegl_buffer_set (buffer, NULL, 0, babl_format ("R'G'B'A u8"), pixels,
+                   GEGL_AUTO_ROWSTRIDE);
+
+  gegl   = gegl_node_new ();
+  source = gegl_node_new_child (gegl,
+                                "operation", "gegl:buffer-source",
+                                "buffer", buffer,
+                                NULL);
+  save   = gegl_node_new_child (gegl,
+                                "operation", "gegl:save",
+                                "path", link,
+                                NULL);
+  gegl_node_link (source, save);
+  gegl_node_process (save);
+
+  g_object_unref (gegl);
+  g_object_unref (buffer);
+
+  if (!g_file_test (link, G_FILE_TEST_IS_SYMLINK))
+    {
+      g_printerr ("%s replaced a symbolic link with a file\n", saver);
+      success = FALSE;
+    }
+
+  if (!g_file_get_contents (path, &contents, NULL, NULL) ||
+      !strcmp (contents, PREVIOUS))
+    {
+      g_printerr ("%s didn't save to the file a link points to\n", saver);
+      success = FALSE;
+    }
+  g_free (contents);
+
+  g_unlink (link);
+  g_unlink (path);
+  g_rmdir (dir);
+  g_free (link);
+  g_free (path);
+  g_free (name);
+  g_free (dir);
+#endif
+
+  return success;
+}
+
+int main (int argc, char *argv[])
+{
+  gint    result = SUCCESS;
+  guchar *pixels;
+  gint    x, y;
+
+  gegl_init (&argc, &argv);
+
+  pixels = g_malloc (WIDTH * HEIGHT * 4);
+  for (y = 0; y < HEIGHT; y++)
+    for (x = 0; x < WIDTH; x++)
+      {
+        guchar *pixel = pixels + (y * WIDTH + x) * 4;
+
+        pixel[0] = x;
+        pixel[1] = y;
+        pixel[2] = x + y;
+        pixel[3] = 255;
+      }
+
+  if (!test_save ("gegl:png-save", ".png", pixels))
+    result = FAILURE;
+
+  if (!test_save ("gegl:tiff-save", ".tif", pixels))
+    result = FAILURE;
+
+  if (!test_save_through_link ("gegl:png-save", ".png", pixels))
+    result = FAILURE;
+
+  g_free (pixels);
+
+  gegl_exit ();
+
+  return result;
+}
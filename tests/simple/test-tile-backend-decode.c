@@ -0,0 +1,377 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+#include <string.h>
+#include <glib/gstdio.h>
+
+#ifdef HAVE_TIFF
+#include <tiffio.h>
+#endif
+
+#include "gegl.h"
+#include "gegl-buffer-backend.h"
+#include "gegl-tile-backend-decode.h"
+
+#define SUCCESS  0
+#define FAILURE -1
+
+#define WIDTH       1000
+#define HEIGHT      700
+#define TILE_WIDTH  64
+#define TILE_HEIGHT 32
+
+#define COLUMNS ((WIDTH  + TILE_WIDTH  - 1) / TILE_WIDTH)
+#define ROWS    ((HEIGHT + TILE_HEIGHT - 1) / TILE_HEIGHT)
+
+/* Reads a crop of a buffer on a decoding backend, which has to decode the
+ * tiles under the crop, only once each, and none of the others. Then loads
+ * a crop of a page of a tiled TIFF, which gegl:tiff-load hands out on such
+ * a backend, and compares it with the page loaded in full from strips.
+ */
+
+static gint decoded[ROWS][COLUMNS];
+
+/* every pixel holds its coordinates */
+static gboolean
+decode (gint     x,
+        gint     y,
+        guchar  *data,
+        gpointer user_data)
+{
+  guint16 *pixel = (guint16 *) data;
+  gint     i, j;
+
+  g_atomic_int_inc (&decoded[y][x]);
+
+  for (j = 0; j < TILE_HEIGHT; j++)
+    for (i = 0; i < TILE_WIDTH; i++)
+      {
+        *pixel++ = x * TILE_WIDTH + i;
+        *pixel++ = y * TILE_HEIGHT + j;
+      }
+
+  return TRUE;
+}
+
+static gboolean
+test_decode_backend (void)
+{
+  const GeglRectangle  crop = {300, 200, 150, 100};
+  const Babl          *format;
+  GeglTileBackend     *backend;
+  GeglBuffer          *buffer;
+  guint16             *pixels;
+  gboolean             success = TRUE;
+  gint                 pass, x, y;
+
+  format  = babl_format_n (babl_type ("u16"), 2);
+  backend = gegl_tile_backend_decode_new (WIDTH, HEIGHT,
+                                          TILE_WIDTH, TILE_HEIGHT,
+                                          format, decode, NULL, NULL);
+  buffer  = gegl_buffer_new_for_backend (NULL, backend);
+  g_object_unref (backend);
+
+  if (!gegl_rectangle_equal (gegl_buffer_get_extent (buffer),
+                             GEGL_RECTANGLE (0, 0, WIDTH, HEIGHT)))
+    {
+      g_printerr ("the buffer doesn't have the extent of the image\n");
+      success = FALSE;
+    }
+
+  pixels = g_new (guint16, crop.width * crop.height * 2);
+
+  /* the second time the tiles come from the tile cache */
+  for (pass = 0; pass < 2; pass++)
+    {
+      gegl_buffer_get (buffer, &crop, 1.0, format, pixels,
+                       GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+      for (y = 0; y < crop.height; y++)
+        for (x = 0; x < crop.width; x++)
+          {
+            guint16 *pixel = pixels + (y * crop.width + x) * 2;
+
+            if (pixel[0] != crop.x + x || pixel[1] != crop.y + y)
+              {
+                g_printerr ("pixel %d,%d is %d,%d\n", crop.x + x, crop.y + y,
+                            pixel[0], pixel[1]);
+                success = FALSE;
+                x = crop.width;
+                y = crop.height;
+              }
+          }
+    }
+
+  for (y = 0; y < ROWS; y++)
+    for (x = 0; x < COLUMNS; x++)
+      {
+        gboolean under_crop =
+          gegl_rectangle_intersect (NULL, &crop,
+                                    GEGL_RECTANGLE (x * TILE_WIDTH,
+                                                    y * TILE_HEIGHT,
+                                                    TILE_WIDTH, TILE_HEIGHT));
+
+        if (decoded[y][x] != (under_crop ? 1 : 0))
+          {
+            g_printerr ("tile %d,%d was decoded %d times\n",
+                        x, y, decoded[y][x]);
+            success = FALSE;
+          }
+      }
+
+  g_free (pixels);
+  g_object_unref (buffer);
+
+  return success;
+}
+
+#ifdef HAVE_TIFF
+
+#define TIFF_WIDTH  200
+#define TIFF_HEIGHT 150
+#define TIFF_PAGES  2
+
+/* the pages differ, to tell which one was loaded */
+static void
+tiff_pixel (gint    page,
+            gint    x,
+            gint    y,
+            guchar *pixel)
+{
+  pixel[0] = x;
+  pixel[1] = y;
+  pixel[2] = page * 100;
+}
+
+static gboolean
+write_tiff (const gchar *path,
+            gboolean     tiled)
+{
+  TIFF    *tiff = TIFFOpen (path, "w");
+  guchar  *data;
+  gboolean success = TRUE;
+  gint     page, x, y, i, j;
+
+  if (tiff == NULL)
+    return FALSE;
+
+  data = g_new0 (guchar, TILE_WIDTH * TILE_HEIGHT * 3);
+
+  for (page = 0; page < TIFF_PAGES && success; page++)
+    {
+      TIFFSetField (tiff, TIFFTAG_IMAGEWIDTH, TIFF_WIDTH);
+      TIFFSetField (tiff, TIFFTAG_IMAGELENGTH, TIFF_HEIGHT);
+      TIFFSetField (tiff, TIFFTAG_BITSPERSAMPLE, 8);
+      TIFFSetField (tiff, TIFFTAG_SAMPLESPERPIXEL, 3);
+      TIFFSetField (tiff, TIFFTAG_PHOTOMETRIC, PHOTOMETRIC_RGB);
+      TIFFSetField (tiff, TIFFTAG_PLANARCONFIG, PLANARCONFIG_CONTIG);
+      TIFFSetField (tiff, TIFFTAG_COMPRESSION, COMPRESSION_NONE);
+
+      if (tiled)
+        {
+          TIFFSetField (tiff, TIFFTAG_TILEWIDTH, TILE_WIDTH);
+          TIFFSetField (tiff, TIFFTAG_TILELENGTH, TILE_HEIGHT);
+
+          for (y = 0; y < TIFF_HEIGHT && success; y += TILE_HEIGHT)
+            for (x = 0; x < TIFF_WIDTH && success; x += TILE_WIDTH)
+              {
+                for (j = 0; j < TILE_HEIGHT; j++)
+                  for (i = 0; i < TILE_WIDTH; i++)
+                    tiff_pixel (page, x + i, y + j,
+                                data + (j * TILE_WIDTH + i) * 3);
+
+                success = TIFFWriteTile (tiff, data, x, y, 0, 0) >= 0;
+              }
+        }
+      else
+        {
+          TIFFSetField (tiff, TIFFTAG_ROWSPERSTRIP, 16);
+
+          for (y = 0; y < TIFF_HEIGHT && success; y++)
+            {
+              for (x = 0; x < TIFF_WIDTH; x++)
+                tiff_pixel (page, x, y, data + x * 3);
+
+              success = TIFFWriteScanline (tiff, data, y, 0) >= 0;
+            }
+        }
+
+      success = success && TIFFWriteDirectory (tiff);
+    }
+
+  g_free (data);
+  TIFFClose (tiff);
+
+  return success;
+}
+
+static GeglNode *
+new_tiff_load (GeglNode    *gegl,
+               const gchar *path)
+{
+  return gegl_node_new_child (gegl,
+                              "operation", "gegl:tiff-load",
+                              "path", path,
+                              "directory", TIFF_PAGES,
+                              NULL);
+}
+
+static guchar *
+load_tiff (const gchar         *path,
+           const GeglRectangle *rect)
+{
+  GeglNode *gegl   = gegl_node_new ();
+  GeglNode *node   = new_tiff_load (gegl, path);
+  guchar   *pixels = g_malloc0 (rect->width * rect->height * 3);
+
+  gegl_node_blit (node, 1.0, rect, babl_format ("R'G'B' u8"), pixels,
+                  GEGL_AUTO_ROWSTRIDE, GEGL_BLIT_DEFAULT);
+
+  g_object_unref (gegl);
+
+  return pixels;
+}
+
+/* the buffer of a page loaded lazily has the tiles of the file */
+static gboolean
+loaded_lazily (const gchar *path)
+{
+  GeglBuffer *buffer = NULL;
+  GeglNode   *gegl   = gegl_node_new ();
+  GeglNode   *node   = new_tiff_load (gegl, path);
+  GeglNode   *sink;
+  gint        tile_width  = 0;
+  gint        tile_height = 0;
+
+  sink = gegl_node_new_child (gegl,
+                              "operation", "gegl:buffer-sink",
+                              "buffer", &buffer,
+                              NULL);
+  gegl_node_link (node, sink);
+  gegl_node_process (sink);
+  g_object_unref (gegl);
+
+  if (buffer == NULL)
+    return FALSE;
+
+  g_object_get (buffer,
+                "tile-width",  &tile_width,
+                "tile-height", &tile_height,
+                NULL);
+  g_object_unref (buffer);
+
+  return tile_width == TILE_WIDTH && tile_height == TILE_HEIGHT;
+}
+
+static gboolean
+test_tiled_tiff (void)
+{
+  const GeglRectangle  crop = {70, 40, 90, 50};
+  gchar               *tiled_path;
+  gchar               *striped_path;
+  guchar              *full;
+  guchar              *pixels;
+  gboolean             success = TRUE;
+  gint                 x, y;
+
+  if (!gegl_has_operation ("gegl:tiff-load"))
+    {
+      g_print ("skipping the TIFF test, TIFF support not available\n");
+      return TRUE;
+    }
+
+  tiled_path   = g_build_filename (g_get_tmp_dir (),
+                                   "test-tile-backend-decode-tiled.tif",
+                                   NULL);
+  striped_path = g_build_filename (g_get_tmp_dir (),
+                                   "test-tile-backend-decode-striped.tif",
+                                   NULL);
+
+  if (!write_tiff (tiled_path, TRUE) || !write_tiff (striped_path, FALSE))
+    {
+      g_printerr ("could not write the TIFF files\n");
+      success = FALSE;
+      goto out;
+    }
+
+  if (!loaded_lazily (tiled_path))
+    {
+      g_printerr ("the tiled TIFF was not loaded lazily\n");
+      success = FALSE;
+    }
+
+  full = load_tiff (striped_path,
+                    GEGL_RECTANGLE (0, 0, TIFF_WIDTH, TIFF_HEIGHT));
+
+  for (y = 0; y < TIFF_HEIGHT && success; y++)
+    for (x = 0; x < TIFF_WIDTH; x++)
+      {
+        guchar expected[3];
+
+        tiff_pixel (TIFF_PAGES - 1, x, y, expected);
+
+        if (memcmp (full + (y * TIFF_WIDTH + x) * 3, expected, 3))
+          {
+            g_printerr ("pixel %d,%d of the full load is wrong\n", x, y);
+            success = FALSE;
+            break;
+          }
+      }
+
+  pixels = load_tiff (tiled_path, &crop);
+
+  for (y = 0; y < crop.height && success; y++)
+    if (memcmp (pixels + y * crop.width * 3,
+                full + ((crop.y + y) * TIFF_WIDTH + crop.x) * 3,
+                crop.width * 3))
+      {
+        g_printerr ("row %d of the crop differs from the full load\n",
+                    crop.y + y);
+        success = FALSE;
+      }
+
+  g_free (pixels);
+  g_free (full);
+
+out:
+  g_unlink (tiled_path);
+  g_unlink (striped_path);
+  g_free (tiled_path);
+  g_free (striped_path);
+
+  return success;
+}
+
+#endif
+
+int main (int argc, char *argv[])
+{
+  gint result = SUCCESS;
+
+  gegl_init (&argc, &argv);
+
+  if (!test_decode_backend ())
+    result = FAILURE;
+
+#ifdef HAVE_TIFF
+  if (!test_tiled_tiff ())
+    result = FAILURE;
+#endif
+
+  gegl_exit ();
+
+  return result;
+}
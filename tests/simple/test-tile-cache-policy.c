@@ -0,0 +1,137 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include "gegl.h"
+#include "gegl-buffer-private.h"
+
+#define SUCCESS  0
+#define FAILURE -1
+
+#define CACHE_SIZE (16 * 1024 * 1024)
+
+/* 16 tiles of 64kb each with the default tile size */
+#define WORKING_SET_SIZE 512
+
+static GeglBuffer *
+filled_buffer (gint width,
+               gint height)
+{
+  GeglBuffer *buffer;
+  GeglColor  *color = gegl_color_new ("red");
+
+  buffer = gegl_buffer_new (GEGL_RECTANGLE (0, 0, width, height),
+                            babl_format ("R'G'B'A u8"));
+  gegl_buffer_set_color (buffer, NULL, color);
+
+  g_object_unref (color);
+  return buffer;
+}
+
+static void
+read_buffer (GeglBuffer *buffer)
+{
+  const GeglRectangle *extent = gegl_buffer_get_extent (buffer);
+  guchar              *pixels = g_malloc (extent->width * extent->height * 4);
+
+  gegl_buffer_get (buffer, NULL, 1.0, babl_format ("R'G'B'A u8"), pixels,
+                   GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+  g_free (pixels);
+}
+
+/* Use a small working set twice, with a scan of a buffer larger than the
+ * cache in between, followed by a scan of an even larger buffer, and return
+ * how many tiles of the working set were still cached after that.
+ */
+static guint64
+working_set_hits (const gchar *policy)
+{
+  GeglBuffer *working_set;
+  GeglBuffer *scan;
+  guint64     hits, misses, evictions;
+  guint64     hits_before;
+
+  g_object_set (gegl_config (), "tile-cache-policy", policy, NULL);
+
+  working_set = filled_buffer (WORKING_SET_SIZE, WORKING_SET_SIZE);
+
+  scan = filled_buffer (2048, 3072);
+  g_object_unref (scan);
+
+  read_buffer (working_set);
+
+  scan = filled_buffer (4096, 4096);
+  read_buffer (scan);
+  g_object_unref (scan);
+
+  gegl_tile_cache_get_stats (policy, &hits_before, &misses, &evictions);
+  read_buffer (working_set);
+  gegl_tile_cache_get_stats (policy, &hits, &misses, &evictions);
+
+  g_object_unref (working_set);
+
+  return hits - hits_before;
+}
+
+int
+main (int    argc,
+      char **argv)
+{
+  guint64 lru_hits;
+  guint64 twoq_hits;
+  guint64 hits, misses, evictions;
+  gint    result = SUCCESS;
+
+  gegl_init (&argc, &argv);
+
+  g_object_set (gegl_config (),
+                "tile-cache-size", (guint64) CACHE_SIZE,
+                NULL);
+
+  lru_hits  = working_set_hits ("lru");
+  twoq_hits = working_set_hits ("2q");
+
+  if (twoq_hits < 12)
+    {
+      g_printerr ("2q kept only %i of 16 working set tiles cached\n",
+                  (gint) twoq_hits);
+      result = FAILURE;
+    }
+
+  if (lru_hits >= twoq_hits)
+    {
+      g_printerr ("lru kept %i working set tiles cached, 2q %i\n",
+                  (gint) lru_hits, (gint) twoq_hits);
+      result = FAILURE;
+    }
+
+  if (!gegl_tile_cache_get_stats ("lru", &hits, &misses, &evictions) ||
+      evictions == 0 || misses == 0)
+    {
+      g_printerr ("no evictions or misses were counted for lru\n");
+      result = FAILURE;
+    }
+
+  if (gegl_tile_cache_get_stats ("random", &hits, &misses, &evictions))
+    {
+      g_printerr ("got statistics for an unknown policy\n");
+      result = FAILURE;
+    }
+
+  gegl_exit ();
+
+  return result;
+}
@@ -0,0 +1,129 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include "gegl.h"
+#include "gegl-tile-handler-compress.h"
+
+#define SUCCESS  0
+#define FAILURE -1
+
+#define SIZE 1024
+
+/* Fill a buffer larger than the tile cache with a pattern of flat tiles,
+ * horizontal stripes and noise, and check that it reads back unchanged
+ * with the tiles evicted from the cache kept in the compressed tier.
+ */
+
+static guchar
+pattern (gint x,
+         gint y,
+         gint c)
+{
+  switch ((y / 64) % 3)
+    {
+      case 0:
+        return 200;
+      case 1:
+        return (x / 16) * 8 + c;
+      default:
+        return (x * 7919 + y * 104729 + c * 31) >> 3;
+    }
+}
+
+int
+main (int    argc,
+      char **argv)
+{
+  GeglTileCompressStats  stats;
+  GeglBuffer            *buffer;
+  guchar                *pixels;
+  gint                   result = SUCCESS;
+  gint                   x, y, c;
+
+  gegl_init (&argc, &argv);
+
+  g_object_set (gegl_config (),
+                "tile-cache-size",       (guint64) 512 * 1024,
+                "compressed-cache-size", (guint64) 4 * 1024 * 1024,
+                NULL);
+
+  pixels = g_malloc (SIZE * SIZE * 4);
+
+  for (y = 0; y < SIZE; y++)
+    for (x = 0; x < SIZE; x++)
+      for (c = 0; c < 4; c++)
+        pixels[(y * SIZE + x) * 4 + c] = pattern (x, y, c);
+
+  buffer = gegl_buffer_new (GEGL_RECTANGLE (0, 0, SIZE, SIZE),
+                            babl_format ("R'G'B'A u8"));
+  gegl_buffer_set (buffer, NULL, 0, babl_format ("R'G'B'A u8"), pixels,
+                   GEGL_AUTO_ROWSTRIDE);
+
+  memset (pixels, 0, SIZE * SIZE * 4);
+  gegl_buffer_get (buffer, NULL, 1.0, babl_format ("R'G'B'A u8"), pixels,
+                   GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+  for (y = 0; y < SIZE && result == SUCCESS; y++)
+    for (x = 0; x < SIZE && result == SUCCESS; x++)
+      for (c = 0; c < 4 && result == SUCCESS; c++)
+        if (pixels[(y * SIZE + x) * 4 + c] != pattern (x, y, c))
+          {
+            g_printerr ("pixel %i,%i differs after a round trip\n", x, y);
+            result = FAILURE;
+          }
+
+  gegl_tile_handler_compress_get_stats (&stats);
+
+  if (stats.stored == 0 || stats.uniform == 0 || stats.hits == 0)
+    {
+      g_printerr ("compressed tier stored %i tiles (%i uniform), "
+                  "read back %i\n",
+                  (gint) stats.stored, (gint) stats.uniform,
+                  (gint) stats.hits);
+      result = FAILURE;
+    }
+
+  if (stats.rejected == 0)
+    {
+      g_printerr ("noise tiles were kept in the compressed tier\n");
+      result = FAILURE;
+    }
+
+  if (stats.size > 4 * 1024 * 1024)
+    {
+      g_printerr ("compressed tier holds %i bytes\n", (gint) stats.size);
+      result = FAILURE;
+    }
+
+  g_object_unref (buffer);
+
+  gegl_tile_handler_compress_get_stats (&stats);
+
+  if (stats.size != 0)
+    {
+      g_printerr ("%i bytes left in the compressed tier after unref\n",
+                  (gint) stats.size);
+      result = FAILURE;
+    }
+
+  g_free (pixels);
+  gegl_exit ();
+
+  return result;
+}
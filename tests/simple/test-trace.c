@@ -0,0 +1,106 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <string.h>
+#include <unistd.h>
+#include <glib/gstdio.h>
+
+#include "gegl.h"
+
+#define SUCCESS  0
+#define FAILURE -1
+
+static const gchar *expected[] =
+{
+  "\"traceEvents\":[",
+  "\"cat\":\"graph\"",
+  "\"name\":\"gegl:invert-linear\",\"cat\":\"process\",\"ph\":\"X\"",
+  "\"cat\":\"babl\""
+};
+
+int
+main (int    argc,
+      char **argv)
+{
+  GeglNode   *graph, *src, *invert, *sink;
+  GeglBuffer *input;
+  GeglBuffer *output = NULL;
+  GeglColor  *color;
+  gchar      *path;
+  gchar      *contents = NULL;
+  gint        fd;
+  gint        i;
+  gint        result = SUCCESS;
+
+  fd = g_file_open_tmp ("gegl-trace-XXXXXX.json", &path, NULL);
+  g_assert (fd >= 0);
+  close (fd);
+
+  g_setenv ("GEGL_TRACE", path, TRUE);
+
+  gegl_init (&argc, &argv);
+
+  input = gegl_buffer_new (GEGL_RECTANGLE (0, 0, 256, 256),
+                           babl_format ("R'G'B'A u8"));
+  color = gegl_color_new ("red");
+  gegl_buffer_set_color (input, NULL, color);
+  g_object_unref (color);
+
+  graph  = gegl_node_new ();
+  src    = gegl_node_new_child (graph,
+                                "operation", "gegl:buffer-source",
+                                "buffer", input,
+                                NULL);
+  invert = gegl_node_new_child (graph,
+                                "operation", "gegl:invert-linear",
+                                NULL);
+  sink   = gegl_node_new_child (graph,
+                                "operation", "gegl:buffer-sink",
+                                "buffer", &output,
+                                "format", babl_format ("R'G'B'A u8"),
+                                NULL);
+
+  gegl_node_link_many (src, invert, sink, NULL);
+  gegl_node_process (sink);
+
+  g_object_unref (graph);
+  g_object_unref (input);
+  g_object_unref (output);
+
+  gegl_exit ();
+
+  if (!g_file_get_contents (path, &contents, NULL, NULL))
+    {
+      g_printerr ("no trace was written to %s\n", path);
+      result = FAILURE;
+    }
+  else
+    {
+      for (i = 0; i < G_N_ELEMENTS (expected); i++)
+        if (!strstr (contents, expected[i]))
+          {
+            g_printerr ("the trace lacks %s\n", expected[i]);
+            result = FAILURE;
+          }
+    }
+
+  g_free (contents);
+  g_unlink (path);
+  g_free (path);
+
+  return result;
+}